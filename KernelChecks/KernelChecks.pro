@@ -0,0 +1,16 @@
+######################################################################
+# Console app that runs the kernel self-checks (imec unpack, NI
+# demux, subset, sglz1) and exits nonzero on any mismatch.
+# Builds the SpikeGLX sources with its own main().
+######################################################################
+
+include(../SpikeGLX3B2.pro)
+
+TARGET  = KernelChecks
+DESTDIR =
+
+CONFIG  += console
+CONFIG  -= app_bundle
+
+SOURCES -= $$clean_path($$PWD/../Src-main/main.cpp)
+SOURCES += $$PWD/main.cpp
@@ -0,0 +1,58 @@
+
+#include "Util.h"
+#include "DFZip.h"
+#include "ImUnpack.h"
+#include "NIDemux.h"
+#include "SubsetSIMD.h"
+
+#include <QCoreApplication>
+#include <iostream>
+
+
+/* ---------------------------------------------------------------- */
+/* Checks --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+typedef bool (*CheckFn)( QString &err );
+
+struct Check {
+    const char  *name;
+    CheckFn     fn;
+};
+
+static const Check  checks[] = {
+#ifdef HAVE_IMEC
+    {"imec unpack", imUnpackSelfCheck},
+#endif
+    {"NI demux",    niDemuxSelfCheck},
+    {"subset",      subsetSelfCheck},
+    {"sglz1",       dfzSelfCheck}
+};
+
+/* ---------------------------------------------------------------- */
+/* main ----------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Run every check; exit code is 1 if any failed.
+//
+int main( int argc, char *argv[] )
+{
+    QCoreApplication    app( argc, argv );
+
+    int nFail = 0;
+
+    for( int i = 0, n = sizeof(checks) / sizeof(Check); i < n; ++i ) {
+
+        QString err;
+
+        if( checks[i].fn( err ) )
+            std::cout << checks[i].name << ": ok\n";
+        else {
+            std::cout
+                << checks[i].name << ": FAILED: " << STR2CHR( err ) << "\n";
+            ++nFail;
+        }
+    }
+
+    return (nFail ? 1 : 0);
+}
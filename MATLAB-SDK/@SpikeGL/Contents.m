@@ -74,11 +74,13 @@
 %
 %                Show the SpikeGLX console window.
 %
-%    params = EnumDataDir( myobj )
+%    params = EnumDataDir( myobj, catalog )
 %
 %                Retrieve a listing of files in the data directory.
+%                If optional catalog = 1, instead list the run catalog:
+%                path, run_g_t, stream, probeSN, srate, scanCt.
 %
-%    [daqData,headCt] = Fetch( myObj, streamID, start_scan, scan_ct, channel_subset, downsample_ratio )
+%    [daqData,headCt] = Fetch( myObj, streamID, start_scan, scan_ct, channel_subset, downsample_ratio, hipass, car, volts )
 %
 %                Get MxN matrix of stream data.
 %                M = scan_ct = max samples to fetch.
@@ -90,6 +92,13 @@
 %
 %                downsample_ratio is an integer (default = 1).
 %
+%                Optional server-side processing, done before subsetting:
+%                hipass = 1 applies a 300 Hz highpass to neural channels;
+%                    filter state carries over between consecutive fetches.
+%                car = {0=none, 1=local 2,0, 2=local 8,2, 3=global,
+%                    4=global demux} common average reference per ShankMap.
+%                volts = 1 returns single-precision volts instead of int16.
+%
 %                Also returns headCt = index of first timepoint in matrix.
 %
 %    [daqData,headCt] = FetchLatest( myObj, streamID, scan_ct, channel_subset, downsample_ratio )
@@ -148,6 +157,13 @@
 %                Returns sample rate of selected stream in Hz,
 %                or zero if not enabled.
 %
+%    info = GetShmInfo( myobj, streamID )
+%
+%                For local clients during a run: returns struct
+%                {key, hdrBytes, capScans, nChans} naming the
+%                stream's shared-memory mirror. See the reference
+%                reader Python-SDK/sglx_shm.py for the protocol.
+%
 %    channelSubset = GetSaveChans( myobj, streamID )
 %
 %                Returns a vector containing the indices of
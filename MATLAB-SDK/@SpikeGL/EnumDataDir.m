@@ -1,8 +1,15 @@
-% params = EnumDataDir( myobj )
+% params = EnumDataDir( myobj, catalog )
 %
 %     Retrieve a listing of files in the data directory.
+%     If optional catalog = 1, instead list the run catalog,
+%     one recording per line, tab separated:
+%     path, run_g_t, stream, probeSN, srate, scanCt.
 %
-function [ret] = EnumDataDir( s )
+function [ret] = EnumDataDir( s, varargin )
 
-    ret = DoGetResultsCmd( s, 'ENUMDATADIR' );
+    if( nargin >= 2 && varargin{1} )
+        ret = DoGetResultsCmd( s, sprintf( 'ENUMDATADIR %d', varargin{1} ) );
+    else
+        ret = DoGetResultsCmd( s, 'ENUMDATADIR' );
+    end
 end
@@ -1,4 +1,4 @@
-% [daqData,headCt] = Fetch( myObj, streamID, start_scan, scan_ct, channel_subset, downsample_ratio )
+% [daqData,headCt] = Fetch( myObj, streamID, start_scan, scan_ct, channel_subset, downsample_ratio, hipass, car, volts )
 %
 %     Get MxN matrix of stream data.
 %     M = scan_ct = max samples to fetch.
@@ -10,6 +10,14 @@
 %
 %     downsample_ratio is an integer (default = 1).
 %
+%     Optional server-side processing, done before subsetting:
+%     hipass = 1 applies a 300 Hz highpass to neural channels;
+%         filter state carries over between consecutive fetches
+%         (start_scan = previous headCt + previous scan count).
+%     car = {0=none, 1=local 2,0, 2=local 8,2, 3=global,
+%         4=global demux} common average reference per ShankMap.
+%     volts = 1 returns single-precision volts instead of int16.
+%
 %     Also returns headCt = index of first timepoint in matrix.
 %
 function [mat,headCt] = Fetch( s, streamID, start_scan, scan_ct, varargin )
@@ -46,9 +54,26 @@ function [mat,headCt] = Fetch( s, streamID, start_scan, scan_ct, varargin )
         end
     end
 
+    hipass  = 0;
+    car     = 0;
+    volts   = 0;
+
+    if( nargin >= 7 )
+        hipass = varargin{3};
+    end
+
+    if( nargin >= 8 )
+        car = varargin{4};
+    end
+
+    if( nargin >= 9 )
+        volts = varargin{5};
+    end
+
     ok = CalinsNetMex( 'sendString', s.handle, ...
-            sprintf( 'FETCH %d %ld %d %s %d\n', ...
-            streamID, start_scan, scan_ct, subset, dwnsmp ) );
+            sprintf( 'FETCH %d %ld %d %s %d %d %d %d\n', ...
+            streamID, start_scan, scan_ct, subset, dwnsmp, ...
+            hipass, car, volts ) );
 
     line = CalinsNetMex( 'readLine', s.handle );
 
@@ -66,7 +91,11 @@ function [mat,headCt] = Fetch( s, streamID, start_scan, scan_ct, varargin )
         error( 'Invalid matrix dimensions.' );
     end
 
-    mat = CalinsNetMex( 'readMatrix', s.handle, 'int16', mat_dims );
+    if( volts )
+        mat = CalinsNetMex( 'readMatrix', s.handle, 'single', mat_dims );
+    else
+        mat = CalinsNetMex( 'readMatrix', s.handle, 'int16', mat_dims );
+    end
 
     % transpose
     mat = mat';
@@ -0,0 +1,18 @@
+% info = GetShmInfo( myobj, streamID )
+%
+%     For clients on the same machine as SpikeGLX (run in progress).
+%     Returns a struct describing the selected stream's shared-memory
+%     mirror: {key, hdrBytes, capScans, nChans}. The segment is mapped
+%     read-only by name 'key'; layout and lock-free read protocol are
+%     given in Python-SDK/sglx_shm.py (a reference reader).
+%
+function [info] = GetShmInfo( s, streamID )
+
+    ret = DoQueryCmd( s, sprintf( 'GETSHMINFO %d', streamID ) );
+    C   = textscan( ret, '%s %d %d %d' );
+
+    info.key      = C{1}{1};
+    info.hdrBytes = C{2};
+    info.capScans = C{3};
+    info.nChans   = C{4};
+end
@@ -0,0 +1,242 @@
+"""
+Reference reader for SpikeGLX shared-memory stream mirrors.
+
+A client on the same machine as SpikeGLX can read a running stream
+in place, instead of via FETCH over TCP:
+
+    from sglx_shm import ShmStream
+
+    s = ShmStream( stream_id=0 )        # imec0; -1 = nidq
+    data, ct = s.fetch_latest( 3000 )   # (nScans, nChans) int16
+    s.close()
+
+GETSHMINFO (command server, default port 4142) creates the mirror on
+first request and returns "key hdrBytes capScans nChans". Only scans
+enqueued after that moment are mirrored.
+
+Segment = header (hdrBytes) + ring of capScans x nChans int16.
+Scan ct is at ring index (ct % capScans). Header, little-endian:
+
+    offset  type        field
+    0       char[8]     magic       "SGLSHM1"
+    8       uint32      hdrBytes
+    12      uint32      nChans
+    16      uint32      capScans
+    20      int32       live        0 once the run has ended
+    24      double      sRate
+    32      double      tZero
+    40      uint64      firstCt     earliest scan ever mirrored
+    48      uint64      wrCt        end of write in progress
+    56      uint64      endCt       end of completed writes
+    64      uint32      generation  segment sequence (from 1)
+
+Writer: wrCt = end; copy data; endCt = end.
+Reader: e = endCt; copy [frm, to) with to <= e; the copy is valid
+only if, read afterwards, wrCt - capScans <= frm. Else the writer
+lapped the reader; retry closer to the head.
+
+A new run makes a new segment (new key, new generation); when live
+drops to 0, ask GETSHMINFO again once the next run is going.
+
+Needs numpy. Windows: named file mapping. Other platforms: SysV
+shared memory keyed by ftok( key, 'Q' ), as Qt's QSharedMemory.
+"""
+
+import mmap
+import socket
+import struct
+import sys
+
+import numpy as np
+
+
+MAGIC   = b"SGLSHM1"
+HDRFMT  = "<8sIIIiddQQQI"
+
+
+def get_shm_info( stream_id, host="127.0.0.1", port=4142 ):
+    """Return (key, hdrBytes, capScans, nChans) via GETSHMINFO."""
+
+    with socket.create_connection( (host, port), timeout=10 ) as sock:
+
+        sock.sendall( ("GETSHMINFO %d\n" % stream_id).encode() )
+
+        buf = b""
+
+        while True:
+
+            chunk = sock.recv( 4096 )
+
+            if not chunk:
+                raise IOError( "GETSHMINFO: connection closed" )
+
+            buf += chunk
+            lines = buf.decode().splitlines()
+
+            if lines and lines[-1].startswith( "ERROR" ):
+                raise IOError( lines[-1] )
+
+            if lines and lines[-1] == "OK" and buf.endswith( b"\n" ):
+                break
+
+    key, hdr, cap, nc = lines[0].rsplit( " ", 3 )
+
+    return key, int( hdr ), int( cap ), int( nc )
+
+
+class _SysVMap( object ):
+    """Read-only attach to a Qt SysV segment (non-Windows)."""
+
+    def __init__( self, key, size ):
+
+        import ctypes
+        import ctypes.util
+
+        libc = ctypes.CDLL( ctypes.util.find_library( "c" ), use_errno=True )
+
+        libc.ftok.argtypes      = [ctypes.c_char_p, ctypes.c_int]
+        libc.shmget.argtypes    = [ctypes.c_int, ctypes.c_size_t, ctypes.c_int]
+        libc.shmat.argtypes     = [ctypes.c_int, ctypes.c_void_p, ctypes.c_int]
+        libc.shmat.restype      = ctypes.c_void_p
+        libc.shmdt.argtypes     = [ctypes.c_void_p]
+
+        k = libc.ftok( key.encode(), ord( "Q" ) )
+
+        if k == -1:
+            raise OSError( ctypes.get_errno(), "ftok failed for " + key )
+
+        shmid = libc.shmget( k, 0, 0o400 )
+
+        if shmid == -1:
+            raise OSError( ctypes.get_errno(), "shmget failed for " + key )
+
+        addr = libc.shmat( shmid, None, 0o10000 )     # SHM_RDONLY
+
+        if addr in (None, ctypes.c_void_p( -1 ).value):
+            raise OSError( ctypes.get_errno(), "shmat failed for " + key )
+
+        self._libc  = libc
+        self._addr  = addr
+        self.buf    = (ctypes.c_char * size).from_address( addr )
+
+    def close( self ):
+
+        if self._addr:
+            self._libc.shmdt( self._addr )
+            self._addr = None
+
+
+class ShmStream( object ):
+
+    def __init__( self, stream_id=0, host="127.0.0.1", port=4142 ):
+
+        key, hdr, cap, nc = get_shm_info( stream_id, host, port )
+        size = hdr + cap * nc * 2
+
+        if sys.platform.startswith( "win" ):
+            self._map   = mmap.mmap( -1, size, tagname=key,
+                                     access=mmap.ACCESS_READ )
+            mv          = memoryview( self._map )
+        else:
+            self._map   = _SysVMap( key, size )
+            mv          = memoryview( self._map.buf ).cast( "B" )
+
+        self._hdr   = mv[:hdr]
+        self.key    = key
+        self.cap    = cap
+        self.nc     = nc
+        self.ring   = np.frombuffer( mv, dtype="<i2", offset=hdr,
+                                     count=cap * nc ).reshape( cap, nc )
+
+        h = self.header()
+
+        if h["magic"] != MAGIC or h["nChans"] != nc or h["capScans"] != cap:
+            raise IOError( "Not a SpikeGLX stream mirror: " + key )
+
+        self.sample_rate    = h["sRate"]
+        self.generation     = h["generation"]
+
+    def header( self ):
+
+        f = struct.unpack_from( HDRFMT, self._hdr, 0 )
+
+        return dict(
+            magic=f[0].rstrip( b"\0" ), hdrBytes=f[1], nChans=f[2],
+            capScans=f[3], live=f[4], sRate=f[5], tZero=f[6],
+            firstCt=f[7], wrCt=f[8], endCt=f[9], generation=f[10] )
+
+    def _u64( self, off ):
+
+        return struct.unpack_from( "<Q", self._hdr, off )[0]
+
+    def is_live( self ):
+
+        return struct.unpack_from( "<i", self._hdr, 20 )[0] != 0
+
+    def end_count( self ):
+
+        return self._u64( 56 )
+
+    def fetch( self, frm, n ):
+        """
+        Copy up to n scans from scan frm. Return (data, frm), data
+        shaped (nScans, nChans); None if frm is no longer (or not
+        yet) in the ring.
+        """
+
+        e   = self._u64( 56 )
+        to  = min( frm + n, e )
+
+        if frm < self._u64( 40 ) or frm >= to or frm + self.cap < e:
+            return None
+
+        i0  = frm % self.cap
+        n1  = min( to - frm, self.cap - i0 )
+        out = np.empty( (to - frm, self.nc), dtype=np.int16 )
+
+        out[:n1] = self.ring[i0:i0 + n1]
+        out[n1:] = self.ring[:to - frm - n1]
+
+        if self._u64( 48 ) - self.cap > frm:
+            return None     # lapped by writer
+
+        return out, frm
+
+    def fetch_latest( self, n ):
+        """Copy the newest (up to) n scans; retry if lapped."""
+
+        while True:
+
+            e   = self._u64( 56 )
+            frm = max( e - min( n, self.cap ), self._u64( 40 ) )
+
+            if frm >= e:
+                return None
+
+            r   = self.fetch( frm, e - frm )
+
+            if r is not None or not self.is_live():
+                return r
+
+    def close( self ):
+
+        self.ring   = None
+        self._hdr   = None
+        self._map.close()
+
+
+if __name__ == "__main__":
+
+    import time
+
+    sid = int( sys.argv[1] ) if len( sys.argv ) > 1 else 0
+    s   = ShmStream( sid )
+
+    print( "key %s gen %d: %d chans at %g Hz, ring %d scans"
+           % (s.key, s.generation, s.nc, s.sample_rate, s.cap) )
+
+    e0 = s.end_count()
+    time.sleep( 1.0 )
+    print( "%d scans/s, live %d" % (s.end_count() - e0, s.is_live()) )
+
+    s.close()
@@ -102,7 +102,7 @@ win32 {
 #   "QMAKE_LFLAGS += -Wl,--large-address-aware"
 
     contains(DEFINES, HAVE_IMEC) {
-        QMAKE_LIBDIR += $${_PRO_FILE_PWD_}/IMEC
+        QMAKE_LIBDIR += $$PWD/IMEC
         contains(QT_ARCH, x86_64) {
             LIBS += -lNeuropixAPI_x64_1_15
         }
@@ -113,10 +113,10 @@ win32 {
 
     contains(DEFINES, HAVE_NIDAQmx) {
         contains(QT_ARCH, x86_64) {
-            QMAKE_LIBDIR += $${_PRO_FILE_PWD_}/NI/lib64/msvc
+            QMAKE_LIBDIR += $$PWD/NI/lib64/msvc
         }
         else {
-            QMAKE_LIBDIR += $${_PRO_FILE_PWD_}/NI/lib32/msvc
+            QMAKE_LIBDIR += $$PWD/NI/lib32/msvc
         }
         LIBS += -lNIDAQmx
     }
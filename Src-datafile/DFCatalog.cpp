@@ -0,0 +1,296 @@
+#include "DFCatalog.h"
+#include "DFName.h"
+#include "Util.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QMutex>
+
+
+#define CATMAGIC    "SGLCAT01"
+#define CATNAME     "_catalog.sglc"
+
+
+static QMutex                   catMtx;
+static QMap<QString,DFCatRec>   catMap;     // by absolute binName
+static QString                  catDir;
+static qint64                   catOffset = 0;
+
+/* ---------------------------------------------------------------- */
+/* DFCatRec ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+QString DFCatRec::stream() const
+{
+    switch( fType ) {
+        case 0:  return QString("imec%1.ap").arg( ip );
+        case 1:  return QString("imec%1.lf").arg( ip );
+        default: return "nidq";
+    }
+}
+
+
+// True if the .bin is unchanged since the record was made;
+// costs one stat, no file reads.
+//
+bool DFCatRec::isFresh() const
+{
+    QFileInfo   fi( binName );
+
+    return fi.exists()
+            && fi.size() == binSize
+            && fi.lastModified().toMSecsSinceEpoch() == binMSecs;
+}
+
+/* ---------------------------------------------------------------- */
+/* DFCatalog ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+QString DFCatalog::catalogName( const QString &dataDir )
+{
+    return QString("%1/" CATNAME).arg( dataDir );
+}
+
+
+// Call after the .bin is closed (so its mod time is final)
+// and kvp holds the finalized meta data. dataDir is the one
+// the file was recorded under.
+//
+void DFCatalog::add(
+    const QString   &dataDir,
+    const QString   &binName,
+    const KVParams  &kvp )
+{
+    QString rel = QDir( dataDir ).relativeFilePath( binName );
+
+    if( rel.startsWith( ".." ) || QDir::isAbsolutePath( rel ) )
+        return;
+
+    DFCatRec    R;
+
+    R.fType = DFName::typeAndIP( R.ip, binName, 0 );
+
+    if( R.fType < 0 )
+        return;
+
+    DFRunTag    tag( binName );
+    QFileInfo   fi( binName );
+
+    R.runName       = tag.runName;
+    R.g             = tag.g;
+    R.t             = tag.t;
+    R.appVersion    = kvp["appVersion"].toString();
+    R.nChans        = kvp["nSavedChans"].toInt();
+    R.nIm           = kvp["typeImEnabled"].toInt();
+    R.nNi           = kvp["typeNiEnabled"].toInt();
+    R.firstCt       = kvp["firstSample"].toULongLong();
+    R.binSize       = fi.size();
+    R.binMSecs      = fi.lastModified().toMSecsSinceEpoch();
+
+    if( kvp.contains( "fileScanCount" ) )
+        R.scanCt = kvp["fileScanCount"].toULongLong();
+    else if( R.nChans > 0 )
+        R.scanCt = R.binSize / (sizeof(qint16) * R.nChans);
+
+    if( R.fType < 2 ) {
+        R.srate     = kvp["imSampRate"].toDouble();
+        R.probeSN   = kvp["imDatPrb_sn"].toString();
+    }
+    else
+        R.srate = kvp["niSampRate"].toDouble();
+
+// ------
+// Encode
+// ------
+
+    QByteArray  rec,
+                out;
+
+    {
+        QDataStream ds( &rec, QIODevice::WriteOnly );
+        ds.setVersion( QDataStream::Qt_5_0 );
+
+        ds  << rel << R.runName << R.probeSN << R.appVersion
+            << R.srate << R.scanCt << R.firstCt
+            << R.binSize << R.binMSecs
+            << qint32(R.g) << qint32(R.t) << qint32(R.ip)
+            << qint32(R.fType) << qint32(R.nChans)
+            << qint32(R.nIm) << qint32(R.nNi);
+    }
+
+    {
+        QDataStream ds( &out, QIODevice::WriteOnly );
+        ds.setVersion( QDataStream::Qt_5_0 );
+
+        ds << quint32(rec.size());
+    }
+
+    out.append( rec );
+
+// ------
+// Append
+// ------
+
+    QMutexLocker    ml( &catMtx );
+    QFile           f( catalogName( dataDir ) );
+
+    // Cut any torn tail back to the last whole record
+
+    sync_Locked( dataDir );
+
+    if( !f.open( QIODevice::ReadWrite ) ) {
+        Warning() << "Can't open run catalog [" << f.fileName() << "].";
+        return;
+    }
+
+    if( f.size() > catOffset && !f.resize( catOffset ) ) {
+        Warning() << "Can't repair run catalog [" << f.fileName() << "].";
+        return;
+    }
+
+    f.seek( catOffset );
+
+    if( !catOffset )
+        out.prepend( CATMAGIC );
+
+    if( f.write( out ) != out.size() )
+        Warning() << "Can't write run catalog [" << f.fileName() << "].";
+}
+
+
+// Return true if binName has a record and the file is unchanged.
+//
+bool DFCatalog::find(
+    DFCatRec        &R,
+    const QString   &dataDir,
+    const QString   &binName )
+{
+    QString key = QFileInfo( binName ).absoluteFilePath();
+
+    {
+        QMutexLocker    ml( &catMtx );
+
+        sync_Locked( dataDir );
+
+        QMap<QString,DFCatRec>::const_iterator  it = catMap.find( key );
+
+        if( it == catMap.end() )
+            return false;
+
+        R = it.value();
+    }
+
+    return R.isFresh();
+}
+
+
+// All records, sorted by binName; freshness not checked.
+//
+void DFCatalog::all( QVector<DFCatRec> &vR, const QString &dataDir )
+{
+    QMutexLocker    ml( &catMtx );
+
+    sync_Locked( dataDir );
+
+    vR.clear();
+    vR.reserve( catMap.size() );
+
+    QMap<QString,DFCatRec>::const_iterator  it  = catMap.begin(),
+                                            end = catMap.end();
+
+    for( ; it != end; ++it )
+        vR.push_back( it.value() );
+}
+
+
+// Read any records appended since last call. catOffset ends
+// after the last whole record; a torn magic leaves it at zero.
+//
+void DFCatalog::sync_Locked( const QString &dataDir )
+{
+    QFile   f( catalogName( dataDir ) );
+    qint64  size = (f.exists() ? f.size() : 0);
+
+    if( dataDir != catDir || size < catOffset ) {
+        catMap.clear();
+        catDir      = dataDir;
+        catOffset   = 0;
+    }
+
+    if( size <= catOffset || !f.open( QIODevice::ReadOnly ) )
+        return;
+
+    QByteArray  buf;
+
+    f.seek( catOffset );
+    buf = f.readAll();
+    f.close();
+
+    int off = 0;
+
+    if( !catOffset ) {
+
+        if( buf.size() < 8 && QByteArray( CATMAGIC ).startsWith( buf ) )
+            return;
+
+        if( !buf.startsWith( CATMAGIC ) ) {
+            Warning() << "Unrecognized run catalog [" << f.fileName() << "].";
+            catOffset = size;
+            return;
+        }
+
+        off = 8;
+    }
+
+    QDir    D( dataDir );
+
+    while( buf.size() - off >= 4 ) {
+
+        quint32 nBytes;
+
+        {
+            QDataStream ds( buf.mid( off, 4 ) );
+            ds.setVersion( QDataStream::Qt_5_0 );
+            ds >> nBytes;
+        }
+
+        if( buf.size() - off - 4 < (qint64)nBytes )
+            break;  // torn or still being written
+
+        QDataStream ds( buf.mid( off + 4, nBytes ) );
+        ds.setVersion( QDataStream::Qt_5_0 );
+
+        DFCatRec    R;
+        QString     rel;
+        qint32      g, t, ip, fType, nChans, nIm, nNi;
+
+        ds  >> rel >> R.runName >> R.probeSN >> R.appVersion
+            >> R.srate >> R.scanCt >> R.firstCt
+            >> R.binSize >> R.binMSecs
+            >> g >> t >> ip >> fType >> nChans >> nIm >> nNi;
+
+        off += 4 + nBytes;
+
+        if( ds.status() != QDataStream::Ok )
+            continue;
+
+        R.binName   = QFileInfo( D.filePath( rel ) ).absoluteFilePath();
+        R.g         = g;
+        R.t         = t;
+        R.ip        = ip;
+        R.fType     = fType;
+        R.nChans    = nChans;
+        R.nIm       = nIm;
+        R.nNi       = nNi;
+
+        catMap[R.binName] = R;
+    }
+
+    catOffset += off;
+}
+
+
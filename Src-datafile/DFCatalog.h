@@ -0,0 +1,83 @@
+#ifndef DFCATALOG_H
+#define DFCATALOG_H
+
+#include "KVParams.h"
+
+#include <QVector>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Key facts about one finalized .bin/.meta pair.
+//
+struct DFCatRec {
+    QString binName,        // absolute
+            runName,
+            probeSN,        // imec only
+            appVersion;
+    double  srate;
+    quint64 scanCt,
+            firstCt;
+    qint64  binSize,        // for freshness check
+            binMSecs;       // mod time, ms since epoch
+    int     g,
+            t,
+            ip,             // -1 for nidq
+            fType,          // {0=ap, 1=lf, 2=ni}
+            nChans,
+            nIm,            // typeImEnabled
+            nNi;            // typeNiEnabled
+
+    DFCatRec()
+    :   srate(0), scanCt(0), firstCt(0), binSize(0), binMSecs(0),
+        g(-1), t(-1), ip(-1), fType(-1), nChans(0), nIm(0), nNi(0)  {}
+
+    QString stream() const;
+    bool isFresh() const;
+};
+
+
+// Run catalog for the data directory: '<dataDir>/_catalog.sglc'.
+//
+// Each file DataFile finalizes under the data directory appends
+// one record, so runs can be listed and matched without walking
+// folders or parsing .meta text. A later record for the same file
+// replaces an earlier one. Files recorded before the catalog
+// existed are simply not listed; callers fall back to the .meta.
+//
+// File layout:
+// - header:  "SGLCAT01",
+// - records: quint32 nBytes, then QDataStream-encoded fields,
+//   with binName relative to the data directory.
+//
+// Records are cached in memory and the file is reread from the
+// last offset only when it has grown. A torn final record, e.g.
+// from a crash, is ignored by readers and cut off by the next
+// add(), so later records stay readable. All methods are
+// thread-safe; callers pass the data directory.
+//
+class DFCatalog
+{
+public:
+    static QString catalogName( const QString &dataDir );
+
+    static void add(
+        const QString   &dataDir,
+        const QString   &binName,
+        const KVParams  &kvp );
+
+    static bool find(
+        DFCatRec        &R,
+        const QString   &dataDir,
+        const QString   &binName );
+
+    static void all( QVector<DFCatRec> &vR, const QString &dataDir );
+
+private:
+    static void sync_Locked( const QString &dataDir );
+};
+
+#endif  // DFCATALOG_H
+
+
@@ -0,0 +1,348 @@
+
+#include "DFEdges.h"
+#include "DataFile.h"
+#include "DFName.h"
+#include "Util.h"
+
+#include <QFileInfo>
+#include <QMutex>
+#include <QSet>
+#include <QtEndian>
+
+#include <algorithm>
+
+
+#define EDGEMAGIC   "SGLEDGE1"
+#define HDRBYTES    16
+#define RECBYTES    12
+#define TRAILER     0xFFFF
+#define FLUSHBYTES  (64*1024)
+
+
+// Sidecars already reported incomplete. A file still being
+// recorded is reopened often (viewer follow, remote fetch);
+// it's reported once.
+//
+static QMutex           warnedMtx;
+static QSet<QString>    warned;
+
+
+/* ---------------------------------------------------------------- */
+/* DFEdges -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+QString DFEdges::sidecarName( const QString &binName )
+{
+    return DFName::chopExtension( binName ) + ".edges";
+}
+
+/* ---------------------------------------------------------------- */
+/* Output --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Index every saved digital word of df.
+// Return false (no sidecar) if there are none.
+//
+bool DFEdges::openForWrite( const DataFile *df )
+{
+    close( nScans );
+
+    const QVector<uint> &ids = df->channelIDs();
+    int                 c0   = firstDigChan( df );
+
+    for( int ic = 0, nc = ids.size(); ic < nc; ++ic ) {
+
+        if( int(ids[ic]) >= c0 ) {
+            vCol.push_back( ic );
+            vID.push_back( ids[ic] );
+        }
+    }
+
+    if( !vCol.size() )
+        return false;
+
+    nC = ids.size();
+
+    f.setFileName( sidecarName( df->binFileName() ) );
+
+    if( !f.open( QIODevice::WriteOnly ) ) {
+        Warning() << "Can't open edge index [" << f.fileName() << "].";
+        vCol.clear();
+        vID.clear();
+        return false;
+    }
+
+// Header
+
+    buf.append( EDGEMAGIC, 8 );
+
+    quint32 u32[2] = {
+                qToLittleEndian( quint32(vCol.size()) ),
+                0};
+
+    buf.append( (const char*)u32, 2*sizeof(quint32) );
+
+    for( int iw = 0, nw = vID.size(); iw < nw; ++iw ) {
+        u32[0] = qToLittleEndian( quint32(vID[iw]) );
+        buf.append( (const char*)u32, sizeof(quint32) );
+    }
+
+    return true;
+}
+
+
+// Called by the file writer with each block of saved scans.
+//
+void DFEdges::scan( const vec_i16 &scans )
+{
+    int nw = vCol.size();
+
+    if( !nw || !f.isOpen() )
+        return;
+
+    int             ntpts   = (int)scans.size() / nC;
+    const qint16    *d      = &scans[0];
+
+    if( !nScans ) {
+
+        // Initial levels
+
+        vPrev.resize( nw );
+
+        for( int iw = 0; iw < nw; ++iw ) {
+            vPrev[iw] = d[vCol[iw]];
+            addRec( 0, iw, vPrev[iw] );
+        }
+    }
+
+    for( int it = 0; it < ntpts; ++it, d += nC ) {
+
+        for( int iw = 0; iw < nw; ++iw ) {
+
+            quint16 v = d[vCol[iw]];
+
+            if( v != vPrev[iw] ) {
+                addRec( nScans + it, iw, v );
+                vPrev[iw] = v;
+            }
+        }
+    }
+
+    nScans += ntpts;
+
+    if( buf.size() >= FLUSHBYTES )
+        flush();
+}
+
+
+// Append trailer, which marks the index as complete.
+//
+bool DFEdges::close( quint64 scanCt )
+{
+    bool    ok = true;
+
+    if( f.isOpen() ) {
+
+        addRec( scanCt, TRAILER, 0 );
+        ok = flush();
+        f.close();
+    }
+
+    buf.clear();
+    vCol.clear();
+    vPrev.clear();
+    vID.clear();
+    nScans  = 0;
+    nC      = 0;
+
+    return ok;
+}
+
+/* ---------------------------------------------------------------- */
+/* Input ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Load whole sidecar of df (it's small).
+// Return true if present, complete and consistent with df.
+//
+bool DFEdges::openForRead( const DataFile *df )
+{
+    vID.clear();
+    vW.clear();
+
+    QFile   fi( sidecarName( df->binFileName() ) );
+
+    if( !fi.exists() || !fi.open( QIODevice::ReadOnly ) )
+        return false;
+
+    QByteArray  B = fi.readAll();
+
+    if( B.size() < HDRBYTES || !B.startsWith( EDGEMAGIC ) )
+        return false;
+
+    const char  *p      = B.constData(),
+                *lim    = p + B.size();
+    int         nw      = qFromLittleEndian<quint32>( (const uchar*)p + 8 );
+
+    p += HDRBYTES;
+
+    if( lim - p < nw * 4 )
+        return false;
+
+    for( int iw = 0; iw < nw; ++iw, p += 4 )
+        vID.push_back( qFromLittleEndian<quint32>( (const uchar*)p ) );
+
+    vW.resize( nw );
+
+    for( ; lim - p >= RECBYTES; p += RECBYTES ) {
+
+        quint64 ct  = qFromLittleEndian<quint64>( (const uchar*)p );
+        int     iw  = qFromLittleEndian<quint16>( (const uchar*)p + 8 );
+
+        if( iw == TRAILER ) {
+
+            if( ct == df->scanCount() )
+                return true;
+
+            break;
+        }
+
+        if( iw >= nw )
+            break;
+
+        vW[iw].ct.push_back( ct );
+        vW[iw].val.push_back(
+            qFromLittleEndian<quint16>( (const uchar*)p + 10 ) );
+    }
+
+    {
+        QMutexLocker    ml( &warnedMtx );
+        QString         path = QFileInfo( fi ).absoluteFilePath();
+
+        if( !warned.contains( path ) ) {
+
+            warned.insert( path );
+
+            Warning() <<
+                QString("Edge index '%1' incomplete; ignored.")
+                .arg( fi.fileName() );
+        }
+    }
+
+    vID.clear();
+    vW.clear();
+    return false;
+}
+
+
+// Return in vX the counts at which given bit
+// of given word goes high (rising) or low.
+//
+void DFEdges::bitEdges(
+    std::vector<qint64> &vX,
+    int                 acqChan,
+    int                 bit,
+    bool                rising ) const
+{
+    vX.clear();
+
+    int iw = vID.indexOf( acqChan );
+
+    if( iw < 0 )
+        return;
+
+    const Word  &W      = vW[iw];
+    quint16     mask    = 1 << bit;
+
+    for( int i = 1, n = W.ct.size(); i < n; ++i ) {
+
+        if( (W.val[i] ^ W.val[i-1]) & mask ) {
+
+            if( ((W.val[i] & mask) != 0) == rising )
+                vX.push_back( W.ct[i] );
+        }
+    }
+}
+
+
+// Return first count > fromCt at which word changes, or -1.
+//
+qint64 DFEdges::nextChange( int acqChan, qint64 fromCt ) const
+{
+    int iw = vID.indexOf( acqChan );
+
+    if( iw < 0 )
+        return -1;
+
+    const std::vector<quint64>  &C = vW[iw].ct;
+
+    if( C.size() < 2 )
+        return -1;
+
+    std::vector<quint64>::const_iterator    it =
+        std::upper_bound( C.begin() + 1, C.end(), quint64(qMax( 0LL, fromCt )) );
+
+    return (it != C.end() ? qint64(*it) : -1);
+}
+
+
+// Return last count < fromCt at which word changes, or -1.
+//
+qint64 DFEdges::prevChange( int acqChan, qint64 fromCt ) const
+{
+    int iw = vID.indexOf( acqChan );
+
+    if( iw < 0 || fromCt <= 0 )
+        return -1;
+
+    const std::vector<quint64>  &C = vW[iw].ct;
+
+    if( C.size() < 2 )
+        return -1;
+
+    std::vector<quint64>::const_iterator    it =
+        std::lower_bound( C.begin() + 1, C.end(), quint64(fromCt) );
+
+    return (it != C.begin() + 1 ? qint64(*(it - 1)) : -1);
+}
+
+/* ---------------------------------------------------------------- */
+/* Private -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+int DFEdges::firstDigChan( const DataFile *df )
+{
+    if( df->subtypeFromObj() == "nidq" )
+        return df->cumTypCnt()[CniCfg::niSumAnalog];
+
+    return df->cumTypCnt()[CimCfg::imSumNeural];
+}
+
+
+void DFEdges::addRec( quint64 ct, int iw, quint16 val )
+{
+    char    rec[RECBYTES];
+
+    qToLittleEndian( quint64(ct), (uchar*)rec );
+    qToLittleEndian( quint16(iw), (uchar*)rec + 8 );
+    qToLittleEndian( quint16(val), (uchar*)rec + 10 );
+
+    buf.append( rec, RECBYTES );
+}
+
+
+bool DFEdges::flush()
+{
+    if( !buf.size() )
+        return true;
+
+    bool    ok = (f.write( buf ) == buf.size());
+
+    if( !ok )
+        Warning() << "Edge index write error: " << f.error();
+
+    buf.clear();
+    return ok;
+}
+
+
@@ -0,0 +1,91 @@
+#ifndef DFEDGES_H
+#define DFEDGES_H
+
+#include "SGLTypes.h"
+
+#include <QFile>
+#include <QVector>
+
+class DataFile;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Digital-event sidecar for a .bin file: 'xxx.edges'.
+//
+// While recording, each saved digital word (imec SY, NI XD) is
+// watched and every change of value is logged as {ct, word}.
+// Rising and falling edges of any bit are then recovered by
+// post-hoc tools without rescanning the binary.
+//
+// File layout (little-endian):
+// - header:  "SGLEDGE1", quint32 nWords, quint32 reserved,
+// - nWords x quint32 acquisition channel ID,
+// - records: quint64 ct, quint16 iWord, quint16 value,
+// - trailer: record with iWord = 0xFFFF and ct = file scan count.
+//
+// Readers trust the sidecar only if the trailer is present and
+// its count matches the .bin scan count.
+//
+class DFEdges
+{
+private:
+    struct Word {
+        std::vector<quint64>    ct;
+        std::vector<quint16>    val;
+    };
+
+private:
+    // Output mode
+    QFile                   f;
+    QByteArray              buf;
+    std::vector<int>        vCol;   // column in scan
+    std::vector<quint16>    vPrev;
+    quint64                 nScans;
+    int                     nC;
+
+    // Input mode
+    QVector<uint>           vID;    // acq chan per word
+    std::vector<Word>       vW;
+
+public:
+    DFEdges() : nScans(0), nC(0)    {}
+    virtual ~DFEdges()              {close( nScans );}
+
+    static QString sidecarName( const QString &binName );
+
+    // ------
+    // Output
+    // ------
+
+    bool openForWrite( const DataFile *df );
+    void scan( const vec_i16 &scans );
+    bool close( quint64 scanCt );
+
+    // -----
+    // Input
+    // -----
+
+    bool openForRead( const DataFile *df );
+
+    bool isIndexed( int acqChan ) const {return vID.contains( acqChan );}
+
+    void bitEdges(
+        std::vector<qint64> &vX,
+        int                 acqChan,
+        int                 bit,
+        bool                rising ) const;
+
+    qint64 nextChange( int acqChan, qint64 fromCt ) const;
+    qint64 prevChange( int acqChan, qint64 fromCt ) const;
+
+private:
+    static int firstDigChan( const DataFile *df );
+    void addRec( quint64 ct, int iw, quint16 val );
+    bool flush();
+};
+
+#endif  // DFEDGES_H
+
+
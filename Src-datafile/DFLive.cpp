@@ -0,0 +1,171 @@
+#include "DFLive.h"
+#include "DataFile.h"
+#include "DFName.h"
+#include "Util.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+
+
+#define LIVE_SECS   1.0
+#define STALE_SECS  30
+
+
+/* ---------------------------------------------------------------- */
+/* DFLive --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+QString DFLive::sidecarName( const QString &binName )
+{
+    return DFName::chopExtension( binName ) + ".live";
+}
+
+/* ---------------------------------------------------------------- */
+/* Output --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+bool DFLive::openForWrite( const DataFile *df )
+{
+    name            = sidecarName( df->binFileName() );
+    sRate           = df->samplingRateHz();
+    bytesPerScan    = df->numChans() * sizeof(qint16);
+    tLast           = 0;
+    haveFirst       = false;
+
+    if( sRate <= 0 )
+        sRate = 1;
+
+    if( bytesPerScan <= 0 )
+        bytesPerScan = 1;
+
+    return true;
+}
+
+
+// Called by the producer thread.
+//
+void DFLive::setFirstSample( quint64 firstCt )
+{
+    QMutexLocker    ml( &ctMtx );
+
+    this->firstCt   = firstCt;
+    haveFirst       = true;
+}
+
+
+// Called by the writing thread after each write; does nothing
+// until LIVE_SECS have passed since the last update.
+//
+// The sidecar is written to a temp file that is renamed over
+// the old one, so readers never see a partial rewrite. If the
+// rename fails (reader holding it on Windows) the old sidecar
+// stays, and the next update tries again.
+//
+// zScans: scans on disk if compressed (whole chunks only).
+//
+void DFLive::update( QFile &bin, qint64 zScans )
+{
+    if( name.isEmpty() )
+        return;
+
+    double  t = getTime();
+
+    if( t - tLast < LIVE_SECS )
+        return;
+
+    tLast = t;
+
+    if( !bin.flush() )
+        return;
+
+    quint64     bytes = bin.size();
+    KVParams    kvp;
+
+    if( zScans >= 0 ) {
+        kvp["fileSizeBytes"]    = bytes;
+        kvp["fileTimeSecs"]     = zScans / sRate;
+        kvp["fileScanCount"]    = zScans;
+    }
+    else {
+        bytes -= bytes % bytesPerScan;
+
+        kvp["fileSizeBytes"]    = bytes;
+        kvp["fileTimeSecs"]     = bytes / bytesPerScan / sRate;
+    }
+
+    ctMtx.lock();
+
+    if( haveFirst )
+        kvp["firstSample"] = firstCt;
+
+    ctMtx.unlock();
+
+    kvp["liveUpdated"] =
+        QDateTime::currentDateTime().toString( Qt::ISODate );
+
+    QSaveFile   f( name );
+
+    if( !f.open( QIODevice::WriteOnly | QIODevice::Text ) )
+        return;
+
+    QTextStream ts( &f );
+
+    ts << kvp.toString();
+    ts.flush();
+
+    if( ts.status() == QTextStream::Ok )
+        f.commit();
+    else
+        f.cancelWriting();
+}
+
+
+// Remove sidecar; final .meta is authoritative now.
+//
+void DFLive::close()
+{
+    if( !name.isEmpty() ) {
+        QFile::remove( name );
+        name.clear();
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* Input ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Return true if a sidecar for binName exists and reports a size.
+//
+bool DFLive::read( KVParams &kvp, const QString &binName )
+{
+    QString sName = sidecarName( binName );
+
+    kvp.clear();
+
+    if( !QFileInfo( sName ).exists() )
+        return false;
+
+    if( !kvp.fromMetaFile( sName ) || !kvp.contains( "fileSizeBytes" ) ) {
+        kvp.clear();
+        return false;
+    }
+
+    return true;
+}
+
+
+// True if kvp (from read) has no valid liveUpdated, or that is
+// more than STALE_SECS old.
+//
+bool DFLive::isStale( const KVParams &kvp )
+{
+    QDateTime   t = QDateTime::fromString(
+                        kvp["liveUpdated"].toString(), Qt::ISODate );
+
+    return !t.isValid()
+            || t.secsTo( QDateTime::currentDateTime() ) > STALE_SECS;
+}
+
+
@@ -0,0 +1,71 @@
+#ifndef DFLIVE_H
+#define DFLIVE_H
+
+#include "KVParams.h"
+
+#include <QMutex>
+
+class DataFile;
+class QFile;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Progress sidecar for a .bin still being recorded: 'xxx.live'.
+//
+// The .meta lacks its {size, duration, SHA1} tallies until the
+// file is closed. Meanwhile, the writing thread flushes the .bin
+// and rewrites this small key=value file about once per second:
+//
+//   fileSizeBytes=<bytes flushed to disk, whole scans>
+//   fileTimeSecs=<same as seconds>
+//   fileScanCount=<scans on disk; compressed files only>
+//   firstSample=<as in .meta, once known>
+//   liveUpdated=<ISO date-time>
+//
+// The sidecar is deleted after the final .meta is written. Readers
+// may use fileSizeBytes as a safe lower bound on readable data.
+// A sidecar not rewritten for a while (isStale) was left by a
+// writer that quit without finalizing; the file is not live.
+//
+class DFLive
+{
+private:
+    // Output mode
+    QMutex      ctMtx;
+    QString     name;
+    double      tLast,
+                sRate;
+    quint64     firstCt;
+    int         bytesPerScan;
+    bool        haveFirst;
+
+public:
+    DFLive()
+    :   tLast(0), sRate(1), firstCt(0),
+        bytesPerScan(1), haveFirst(false)   {}
+    virtual ~DFLive()                       {close();}
+
+    static QString sidecarName( const QString &binName );
+
+    // ------
+    // Output
+    // ------
+
+    bool openForWrite( const DataFile *df );
+    void setFirstSample( quint64 firstCt );
+    void update( QFile &bin, qint64 zScans = -1 );
+    void close();
+
+    // -----
+    // Input
+    // -----
+
+    static bool read( KVParams &kvp, const QString &binName );
+    static bool isStale( const KVParams &kvp );
+};
+
+#endif  // DFLIVE_H
+
+
@@ -0,0 +1,151 @@
+#include "DFMetaCache.h"
+#include "ChanMap.h"
+#include "CimCfg.h"
+#include "ShankMap.h"
+#include "Subset.h"
+
+#include <QHash>
+#include <QMutex>
+
+
+#define CACHE_MAX   32
+
+
+/* ---------------------------------------------------------------- */
+/* StrCache ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Parsed objects keyed by source text.
+// Caller holds cacheMtx.
+//
+template<class T>
+class StrCache
+{
+private:
+    QHash<QString,T>    map;
+
+public:
+    bool get( T &t, const QString &s ) const
+    {
+        typename QHash<QString,T>::const_iterator   it = map.find( s );
+
+        if( it == map.end() )
+            return false;
+
+        t = it.value();
+        return true;
+    }
+
+    void put( const QString &s, const T &t )
+    {
+        if( map.size() >= CACHE_MAX )
+            map.clear();
+
+        map.insert( s, t );
+    }
+};
+
+
+static QMutex                   cacheMtx;
+static StrCache<QVector<uint> > subCache;
+static StrCache<IMROTbl>        roCache;
+static StrCache<ShankMap>       shCache;
+static StrCache<ChanMapIM>      cmIMCache;
+static StrCache<ChanMapNI>      cmNICache;
+
+/* ---------------------------------------------------------------- */
+/* DFMetaCache ---------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Return true if s is 'all' or a valid range string.
+//
+bool DFMetaCache::chanIds(
+    QVector<uint>   &v,
+    const QString   &s,
+    int             nSavedChans )
+{
+    if( Subset::isAllChansStr( s ) ) {
+        Subset::defaultVec( v, nSavedChans );
+        return true;
+    }
+
+    {
+        QMutexLocker    ml( &cacheMtx );
+
+        if( subCache.get( v, s ) )
+            return true;
+    }
+
+    if( !Subset::rngStr2Vec( v, s ) )
+        return false;
+
+    QMutexLocker    ml( &cacheMtx );
+    subCache.put( s, v );
+    return true;
+}
+
+
+void DFMetaCache::imroTbl( IMROTbl &T, const QString &s )
+{
+    {
+        QMutexLocker    ml( &cacheMtx );
+
+        if( roCache.get( T, s ) )
+            return;
+    }
+
+    T.fromString( s );
+
+    QMutexLocker    ml( &cacheMtx );
+    roCache.put( s, T );
+}
+
+
+void DFMetaCache::shankMap( ShankMap &M, const QString &s )
+{
+    {
+        QMutexLocker    ml( &cacheMtx );
+
+        if( shCache.get( M, s ) )
+            return;
+    }
+
+    M.fromString( s );
+
+    QMutexLocker    ml( &cacheMtx );
+    shCache.put( s, M );
+}
+
+
+void DFMetaCache::chanMap( ChanMapIM &M, const QString &s )
+{
+    {
+        QMutexLocker    ml( &cacheMtx );
+
+        if( cmIMCache.get( M, s ) )
+            return;
+    }
+
+    M.fromString( s );
+
+    QMutexLocker    ml( &cacheMtx );
+    cmIMCache.put( s, M );
+}
+
+
+void DFMetaCache::chanMap( ChanMapNI &M, const QString &s )
+{
+    {
+        QMutexLocker    ml( &cacheMtx );
+
+        if( cmNICache.get( M, s ) )
+            return;
+    }
+
+    M.fromString( s );
+
+    QMutexLocker    ml( &cacheMtx );
+    cmNICache.put( s, M );
+}
+
+
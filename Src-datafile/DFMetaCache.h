@@ -0,0 +1,41 @@
+#ifndef DFMETACACHE_H
+#define DFMETACACHE_H
+
+#include <QString>
+#include <QVector>
+
+struct ChanMapIM;
+struct ChanMapNI;
+struct IMROTbl;
+struct ShankMap;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Typed forms of the heavy .meta fields, cached by their text.
+//
+// The subset, imroTbl and map strings are parsed with regular
+// expressions, entry by entry. Files from one run, and reopened
+// or linked files, repeat the same strings, so each distinct
+// string is parsed once and later requests get a copy of the
+// stored object. Copies are plain vector copies.
+//
+// Caches are bounded and thread-safe.
+//
+class DFMetaCache
+{
+public:
+    static bool chanIds(
+        QVector<uint>   &v,
+        const QString   &s,
+        int             nSavedChans );
+    static void imroTbl( IMROTbl &T, const QString &s );
+    static void shankMap( ShankMap &M, const QString &s );
+    static void chanMap( ChanMapIM &M, const QString &s );
+    static void chanMap( ChanMapNI &M, const QString &s );
+};
+
+#endif  // DFMETACACHE_H
+
+
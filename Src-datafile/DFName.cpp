@@ -1,5 +1,6 @@
 
 #include "DFName.h"
+#include "DFLive.h"
 #include "KVParams.h"
 
 #include <QDir>
@@ -248,14 +249,23 @@ qint64 DFName::fileSize( const QFileInfo &fi, QString *error )
 }
 
 
+// If (live) is non-null, a file still being recorded is also
+// accepted (its fresh .live sidecar stands in for the finalization
+// keys) and *live reports which kind this is. A stale sidecar,
+// left by a crash, is ignored: the file must then pass as usual.
+//
 bool DFName::isValidInputFile(
     const QString   &name,
     QString         *error,
-    const QString   &reqVers )
+    const QString   &reqVers,
+    bool            *live )
 {
     if( error )
         error->clear();
 
+    if( live )
+        *live = false;
+
     int ip;
 
     if( -1 == typeAndIP( ip, name, error ) )
@@ -373,6 +383,23 @@ bool DFName::isValidInputFile(
 
     QString key;
 
+    if( live
+        && kvp.contains( "typeImEnabled" )
+        && !kvp.contains( "fileSizeBytes" ) ) {
+
+        KVParams    kvl;
+
+        if( DFLive::read( kvl, bFile ) && !DFLive::isStale( kvl ) ) {
+
+            qint64  liveSize = kvl["fileSizeBytes"].toLongLong();
+
+            if( liveSize >= 0 && liveSize <= binSize ) {
+                *live = true;
+                return true;
+            }
+        }
+    }
+
     if( !kvp.contains( (key = "typeImEnabled") )
         || !kvp.contains( (key = "fileSHA1") )
         || !kvp.contains( (key = "fileTimeSecs") )
@@ -47,7 +47,8 @@ public:
     static bool isValidInputFile(
         const QString   &name,
         QString         *error,
-        const QString   &reqVers = "20160120" );
+        const QString   &reqVers = "20160120",
+        bool            *live = 0 );
 };
 
 #endif  // DFNAME_H
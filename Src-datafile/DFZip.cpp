@@ -0,0 +1,1018 @@
+
+#include "DFZip.h"
+#include "KernelTest.h"
+#include "Util.h"
+
+#include "SHA1.h"
+#undef TCHAR
+
+#include <QDir>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QSettings>
+#include <QtEndian>
+
+#include <string.h>
+
+
+#define ZMAGIC      "SGLZ"
+#define ZVERSION    1
+#define HDRBYTES    16
+#define CHKBYTES    12
+#define ENDBYTES    12
+#define RAWMODE     0xFF
+#define QESC        24      // unary limit; escape to raw value
+#define ZBITS       17      // zigzag delta of two int16
+
+
+/* ---------------------------------------------------------------- */
+/* Helpers -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+static void put16( QByteArray &b, quint16 v )
+{
+    uchar   c[2];
+
+    qToLittleEndian<quint16>( v, c );
+    b.append( (const char*)c, 2 );
+}
+
+
+static void put32( QByteArray &b, quint32 v )
+{
+    uchar   c[4];
+
+    qToLittleEndian<quint32>( v, c );
+    b.append( (const char*)c, 4 );
+}
+
+
+static void put64( QByteArray &b, quint64 v )
+{
+    uchar   c[8];
+
+    qToLittleEndian<quint64>( v, c );
+    b.append( (const char*)c, 8 );
+}
+
+
+// MSB-first bit packer.
+//
+class BitOut {
+private:
+    QByteArray  &out;
+    quint64     acc;
+    int         nb;
+public:
+    BitOut( QByteArray &out ) : out(out), acc(0), nb(0) {}
+    void put( quint32 v, int n )
+    {
+        acc = (acc << n) | v;
+        nb += n;
+        while( nb >= 8 ) {
+            nb -= 8;
+            out.append( char(acc >> nb) );
+        }
+    }
+    void flush()
+    {
+        if( nb ) {
+            out.append( char(acc << (8 - nb)) );
+            nb = 0;
+        }
+    }
+};
+
+
+// MSB-first bit reader; overrun() if asked past the end.
+//
+class BitIn {
+private:
+    const uchar *p,
+                *end;
+    quint64     acc;
+    int         nb;
+    bool        over;
+public:
+    BitIn( const uchar *p, const uchar *end )
+    :   p(p), end(end), acc(0), nb(0), over(false)  {}
+    bool overrun() const    {return over;}
+    quint32 get( int n )
+    {
+        while( nb < n ) {
+            if( p < end )
+                acc = (acc << 8) | *p++;
+            else {
+                acc <<= 8;
+                over = true;
+            }
+            nb += 8;
+        }
+        nb -= n;
+        return quint32(acc >> nb) & ((quint32(1) << n) - 1);
+    }
+    int unary()
+    {
+        int q = 0;
+        while( q < QESC && get( 1 ) )
+            ++q;
+        return q;
+    }
+};
+
+/* ---------------------------------------------------------------- */
+/* DFZPolicy ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+void DFZPolicy::loadSettings()
+{
+    STDSETTINGS( settings, "dfzip" );
+    settings.beginGroup( "DFZip" );
+
+    enable      = settings.value( "enable", false ).toBool();
+    streams     = settings.value( "streams", "ap" ).toString();
+    chunkScans  = qBound( 256,
+                    settings.value( "chunkScans", 16384 ).toInt(),
+                    1024*1024 );
+    threads     = qBound( 1, settings.value( "threads", 2 ).toInt(), 16 );
+}
+
+
+// subtype: {imec.ap, imec.lf, nidq}.
+//
+bool DFZPolicy::wants( const QString &subtype ) const
+{
+    if( !enable )
+        return false;
+
+    QString s = subtype;
+
+    if( s == "nidq" )
+        s = "ni";
+    else
+        s.remove( "imec." );
+
+    foreach( const QString &t, streams.split( ",", QString::SkipEmptyParts ) ) {
+
+        if( t.trimmed() == s )
+            return true;
+    }
+
+    return false;
+}
+
+/* ---------------------------------------------------------------- */
+/* DFZCodec ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Append one whole chunk, header included.
+//
+void DFZCodec::encode(
+    QByteArray      &out,
+    const qint16    *src,
+    int             nScans,
+    int             nC )
+{
+    QByteArray              pay;
+    QVector<quint32>        len( nC );
+    std::vector<quint32>    z( nScans );
+
+    for( int ic = 0; ic < nC; ++ic ) {
+
+        int     start   = pay.size();
+        quint64 sum     = 0;
+
+        // Zigzag deltas
+
+        const qint16    *S      = src + ic;
+        int             prev    = *S;
+
+        z[0] = 0;
+
+        for( int is = 1; is < nScans; ++is ) {
+
+            S += nC;
+
+            int d = *S - prev;
+
+            prev    = *S;
+            z[is]   = quint32(d) << 1 ^ quint32(d >> 31);
+            sum    += z[is];
+        }
+
+        // Rice parameter ~ log2( mean )
+
+        quint64 mean    = (nScans > 1 ? sum / (nScans - 1) : 0);
+        int     k       = 0;
+
+        while( k < 16 && (quint64(2) << k) <= mean )
+            ++k;
+
+        pay.append( char(k) );
+        put16( pay, quint16(src[ic]) );
+
+        BitOut  B( pay );
+
+        for( int is = 1; is < nScans; ++is ) {
+
+            quint32 v = z[is],
+                    q = v >> k;
+
+            if( q < QESC ) {
+                B.put( ((quint32(1) << q) - 1) << 1, q + 1 );
+                if( k )
+                    B.put( v & ((quint32(1) << k) - 1), k );
+            }
+            else {
+                B.put( (quint32(1) << QESC) - 1, QESC );
+                B.put( v, ZBITS );
+            }
+        }
+
+        B.flush();
+
+        // Raw if no gain
+
+        if( pay.size() - start > 3 + 2 * nScans ) {
+
+            pay.truncate( start );
+            pay.append( char(RAWMODE) );
+
+            S = src + ic;
+
+            for( int is = 0; is < nScans; ++is, S += nC )
+                put16( pay, quint16(*S) );
+        }
+
+        len[ic] = pay.size() - start;
+    }
+
+    out.append( "ZCHK", 4 );
+    put32( out, 4 * nC + pay.size() );
+    put32( out, nScans );
+
+    for( int ic = 0; ic < nC; ++ic )
+        put32( out, len[ic] );
+
+    out.append( pay );
+}
+
+
+// Decode payload (after chunk header) into interleaved scans.
+//
+bool DFZCodec::decode(
+    vec_i16         &dst,
+    const uchar     *src,
+    int             bytes,
+    int             nScans,
+    int             nC )
+{
+    if( bytes < 4 * nC )
+        return false;
+
+    dst.resize( nScans * nC );
+
+    const uchar *lim    = src + bytes,
+                *C      = src + 4 * nC;
+
+    for( int ic = 0; ic < nC; ++ic ) {
+
+        quint32 n = qFromLittleEndian<quint32>( src + 4 * ic );
+
+        if( n < 3 || C + n > lim )
+            return false;
+
+        int     k   = C[0];
+        qint16  *D  = &dst[ic];
+
+        if( k == RAWMODE ) {
+
+            if( n < 1 + 2 * quint32(nScans) )
+                return false;
+
+            for( int is = 0; is < nScans; ++is, D += nC )
+                *D = qint16(qFromLittleEndian<quint16>( C + 1 + 2 * is ));
+        }
+        else if( k > 16 )
+            return false;
+        else {
+
+            int     prev = qint16(qFromLittleEndian<quint16>( C + 1 ));
+            BitIn   B( C + 3, C + n );
+
+            *D = prev;
+
+            for( int is = 1; is < nScans; ++is ) {
+
+                int     q = B.unary();
+                quint32 v;
+
+                if( q < QESC )
+                    v = (quint32(q) << k) | (k ? B.get( k ) : 0);
+                else
+                    v = B.get( ZBITS );
+
+                prev += int(v >> 1) ^ -int(v & 1);
+                D    += nC;
+                *D    = prev;
+            }
+
+            // Truncated payload
+
+            if( B.overrun() )
+                return false;
+        }
+
+        C += n;
+    }
+
+    return true;
+}
+
+/* ---------------------------------------------------------------- */
+/* DFZTask -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+class DFZTask : public QRunnable
+{
+public:
+    vec_i16     raw;
+    QByteArray  out;
+    QSemaphore  done;
+    int         nC,
+                nScans;
+
+public:
+    DFZTask( int nC ) : QRunnable(), nC(nC), nScans(0) {setAutoDelete( false );}
+
+    virtual void run()
+    {
+        DFZCodec::encode( out, &raw[0], nScans, nC );
+        done.release();
+    }
+};
+
+/* ---------------------------------------------------------------- */
+/* DFZWriter ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+DFZWriter::DFZWriter(
+    QFile           &f,
+    CSHA1           *sha,
+    int             nC,
+    const DFZPolicy &pol )
+    :   f(f), sha(sha), fileOff(0), diskScans(0), nC(nC),
+        chunkScans(pol.chunkScans), maxInFlight(2 * pol.threads), ok(true)
+{
+    pool.setMaxThreadCount( pol.threads );
+}
+
+
+DFZWriter::~DFZWriter()
+{
+    pool.waitForDone();
+    qDeleteAll( inFlight );
+}
+
+
+bool DFZWriter::open()
+{
+    QByteArray  b( ZMAGIC, 4 );
+
+    put16( b, ZVERSION );
+    put16( b, 0 );
+    put32( b, nC );
+    put32( b, chunkScans );
+
+    return put( b );
+}
+
+
+// Return bytes reaching the file, or -1 if error.
+//
+qint64 DFZWriter::write( const vec_i16 &scans )
+{
+    const qint16    *src    = &scans[0];
+    int             nS      = scans.size() / nC,
+                    full    = chunkScans * nC;
+
+    while( nS > 0 ) {
+
+        int n = qMin( chunkScans - int(pend.size()) / nC, nS );
+
+        pend.insert( pend.end(), src, src + n * nC );
+        src += n * nC;
+        nS  -= n;
+
+        if( int(pend.size()) == full )
+            submit();
+    }
+
+    return drain( false );
+}
+
+
+// Encode tail, then write remaining chunks, index and trailer.
+// Return bytes written, or -1 if error.
+//
+qint64 DFZWriter::close()
+{
+    if( pend.size() )
+        submit();
+
+    qint64  bytes = drain( true );
+
+    if( bytes < 0 )
+        return -1;
+
+    QByteArray  b( "ZIDX", 4 );
+    qint64      idxOff = fileOff;
+
+    put32( b, index.size() );
+
+    foreach( qint64 off, index )
+        put64( b, off );
+
+    put64( b, idxOff );
+    b.append( "ZEND", 4 );
+
+    if( !put( b ) )
+        return -1;
+
+    return bytes + b.size();
+}
+
+
+void DFZWriter::submit()
+{
+    DFZTask *T = new DFZTask( nC );
+
+    T->nScans = pend.size() / nC;
+    T->raw.swap( pend );
+    pend.reserve( chunkScans * nC );
+
+    inFlight.push_back( T );
+    pool.start( T );
+}
+
+
+// Write finished chunks in order; wait for the oldest if
+// too many are pending (or all if requested).
+//
+qint64 DFZWriter::drain( bool all )
+{
+    qint64  bytes = 0;
+
+    while( inFlight.size() ) {
+
+        DFZTask *T = inFlight.front();
+
+        if( all || inFlight.size() > maxInFlight )
+            T->done.acquire();
+        else if( !T->done.tryAcquire() )
+            break;
+
+        qint64  off = fileOff;
+
+        if( !put( T->out ) )
+            bytes = -1;
+        else {
+            index.push_back( off );
+            diskScans += T->nScans;
+
+            if( bytes >= 0 )
+                bytes += T->out.size();
+        }
+
+        inFlight.pop_front();
+        delete T;
+    }
+
+    return (ok ? bytes : -1);
+}
+
+
+bool DFZWriter::put( const QByteArray &b )
+{
+    if( !ok )
+        return false;
+
+    qint64  n = f.write( b );
+
+    if( n != b.size() ) {
+        Error() << "DFZWriter: write error [" << f.errorString() << "].";
+        ok = false;
+        return false;
+    }
+
+    if( sha )
+        sha->Update( (const UINT_8*)b.constData(), b.size() );
+
+    fileOff += n;
+    return true;
+}
+
+/* ---------------------------------------------------------------- */
+/* DFZReader ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+bool DFZReader::open(
+    QString         &error,
+    const QString   &binName,
+    qint64          maxBytes )
+{
+    f.setFileName( binName );
+
+    if( !f.open( QIODevice::ReadOnly ) ) {
+        error = QString("Can't open [%1].").arg( binName );
+        return false;
+    }
+
+    QByteArray  h = f.read( HDRBYTES );
+    const uchar *H = (const uchar*)h.constData();
+
+    if( h.size() != HDRBYTES
+        || !h.startsWith( ZMAGIC )
+        || qFromLittleEndian<quint16>( H + 4 ) != ZVERSION ) {
+
+        error = QString("Not an sglz1 file [%1].").arg( binName );
+        return false;
+    }
+
+    nC          = qFromLittleEndian<quint32>( H + 8 );
+    chunkScans  = qFromLittleEndian<quint32>( H + 12 );
+
+    if( nC <= 0 || chunkScans <= 0 ) {
+        error = QString("Bad sglz1 header [%1].").arg( binName );
+        return false;
+    }
+
+    maxChunks   = qMax( qint64(2), maxBytes / (qint64(chunkScans) * nC * 2) );
+    walkOff     = HDRBYTES;
+
+    if( !loadIndex() )
+        walk();
+
+    return true;
+}
+
+
+// Same contract as DataFile::readScans with all channels,
+// but caller sizes dst.
+//
+qint64 DFZReader::read( qint16 *dst, quint64 scan0, quint64 num2read )
+{
+    quint64 sLim = scan0 + num2read;
+
+    for( quint64 s = scan0; s < sLim; ) {
+
+        int             ic  = s / chunkScans;
+        const Chunk     *C  = chunk( ic );
+
+        if( !C )
+            return -1;
+
+        quint64 c0      = quint64(ic) * chunkScans,
+                cLim    = c0 + C->data.size() / nC;
+
+        if( s >= cLim )
+            return -1;
+
+        quint64 n = qMin( sLim, cLim ) - s;
+
+        memcpy( dst, &C->data[(s - c0) * nC], n * nC * sizeof(qint16) );
+
+        dst += n * nC;
+        s   += n;
+    }
+
+    return num2read;
+}
+
+
+// Closed file: index from trailer.
+//
+bool DFZReader::loadIndex()
+{
+    qint64  size = f.size();
+
+    if( size < HDRBYTES + 8 + ENDBYTES || !f.seek( size - ENDBYTES ) )
+        return false;
+
+    QByteArray  e = f.read( ENDBYTES );
+
+    if( e.size() != ENDBYTES || !e.endsWith( "ZEND" ) )
+        return false;
+
+    qint64  idxOff = qFromLittleEndian<quint64>( (const uchar*)e.constData() );
+
+    if( idxOff < HDRBYTES || idxOff > size - ENDBYTES - 8 || !f.seek( idxOff ) )
+        return false;
+
+    QByteArray  b = f.read( size - ENDBYTES - idxOff );
+    const uchar *B = (const uchar*)b.constData();
+
+    if( b.size() < 8 || !b.startsWith( "ZIDX" ) )
+        return false;
+
+    int n = qFromLittleEndian<quint32>( B + 4 );
+
+    if( b.size() != 8 + 8 * n )
+        return false;
+
+    index.resize( n );
+
+    for( int i = 0; i < n; ++i )
+        index[i] = qFromLittleEndian<quint64>( B + 8 + 8 * i );
+
+    walkOff = -1;
+    return true;
+}
+
+
+// Growing file: index any whole chunks written since last walk.
+//
+void DFZReader::walk()
+{
+    if( walkOff < 0 )
+        return;
+
+    qint64  size = f.size();
+
+    while( walkOff + CHKBYTES <= size && f.seek( walkOff ) ) {
+
+        QByteArray  h = f.read( CHKBYTES );
+
+        if( h.size() != CHKBYTES || !h.startsWith( "ZCHK" ) )
+            break;
+
+        qint64  next = walkOff + CHKBYTES
+                        + qFromLittleEndian<quint32>(
+                            (const uchar*)h.constData() + 4 );
+
+        if( next > size )
+            break;
+
+        index.push_back( walkOff );
+        walkOff = next;
+    }
+}
+
+
+// Decoded chunk ic, from cache or file; evicts LRU.
+//
+const DFZReader::Chunk *DFZReader::chunk( int ic )
+{
+    QMap<int,Chunk*>::iterator  it = cache.find( ic );
+
+    if( it != cache.end() ) {
+        it.value()->used = ++tick;
+        return it.value();
+    }
+
+    if( ic >= index.size() )
+        walk();
+
+    if( ic >= index.size() )
+        return 0;
+
+    QByteArray  h;
+
+    if( !f.seek( index[ic] )
+        || (h = f.read( CHKBYTES )).size() != CHKBYTES
+        || !h.startsWith( "ZCHK" ) ) {
+
+        Error() << "DFZReader: Bad chunk [" << ic << "] in " << f.fileName();
+        return 0;
+    }
+
+    const uchar *H      = (const uchar*)h.constData();
+    int         bytes   = qFromLittleEndian<quint32>( H + 4 ),
+                nScans  = qFromLittleEndian<quint32>( H + 8 );
+    QByteArray  pay     = f.read( bytes );
+    Chunk       *C      = new Chunk;
+
+    if( pay.size() != bytes
+        || nScans <= 0 || nScans > chunkScans
+        || !DFZCodec::decode(
+                C->data, (const uchar*)pay.constData(),
+                bytes, nScans, nC ) ) {
+
+        Error() << "DFZReader: Bad chunk [" << ic << "] in " << f.fileName();
+        delete C;
+        return 0;
+    }
+
+    while( cache.size() >= maxChunks ) {
+
+        QMap<int,Chunk*>::iterator  it  = cache.begin(),
+                                    lru = it;
+
+        for( ++it; it != cache.end(); ++it ) {
+
+            if( it.value()->used < lru.value()->used )
+                lru = it;
+        }
+
+        delete lru.value();
+        cache.erase( lru );
+    }
+
+    C->used     = ++tick;
+    cache[ic]   = C;
+
+    return C;
+}
+
+/* ---------------------------------------------------------------- */
+/* Self-check and bench ------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#define TSTCHANS    5
+#define TSTCHUNK    256
+#define TSTSCANS    (6 * TSTCHUNK + 100)
+
+
+// Channel (ic % 5):
+// 0: uniform random; never shrinks, so raw mode.
+// 1: alternating full scale; deltas need all ZBITS.
+// 2: constant.
+// 3: noise at negative full scale, rare spikes to positive full
+//    scale; escapes that need all ZBITS.
+// 4: slow ramp.
+//
+static void dfzTestData( vec_i16 &v, int nS, int nC, quint32 seed )
+{
+    KTRand  R( seed );
+
+    v.resize( nS * nC );
+
+    qint16  *d = &v[0];
+
+    for( int is = 0; is < nS; ++is ) {
+
+        for( int ic = 0; ic < nC; ++ic, ++d ) {
+
+            quint32 r = R.next();
+
+            switch( ic % 5 ) {
+                case 0:
+                    *d = qint16(r >> 16);
+                    break;
+                case 1:
+                    *d = (is & 1 ? 32767 : -32768);
+                    break;
+                case 2:
+                    *d = -1234;
+                    break;
+                case 3:
+                    *d = (is % 97 == 50 ? 32767 : -32768 + int(r >> 29));
+                    break;
+                default:
+                    *d = qint16((7 * is) % 20000 - 10000);
+            }
+        }
+    }
+}
+
+
+static bool dfzCheckCodec( QString &err, const vec_i16 &src )
+{
+    int nC = TSTCHANS;
+
+    for( int s0 = 0; s0 < TSTSCANS; s0 += TSTCHUNK ) {
+
+        int         nS = qMin( TSTCHUNK, TSTSCANS - s0 );
+        QByteArray  b;
+        vec_i16     dst;
+
+        DFZCodec::encode( b, &src[s0 * nC], nS, nC );
+
+        const uchar *pay    = (const uchar*)b.constData() + CHKBYTES;
+        int         bytes   = b.size() - CHKBYTES;
+
+        if( !DFZCodec::decode( dst, pay, bytes, nS, nC ) ) {
+            err = QString("sglz1 decode failed at scan %1.").arg( s0 );
+            return false;
+        }
+
+        if( !ktCompare(
+                err, "sglz1 codec", &src[s0 * nC], &dst[0], nS * nC, nC ) ) {
+
+            return false;
+        }
+
+        // Coding modes exercised
+
+        const uchar *C      = pay + 4 * nC;
+        quint32     len0    = qFromLittleEndian<quint32>( pay ),
+                    len1    = qFromLittleEndian<quint32>( pay + 4 ),
+                    len2    = qFromLittleEndian<quint32>( pay + 8 );
+        int         k3      = C[len0 + len1 + len2];
+
+        if( C[0] != RAWMODE || k3 == RAWMODE
+            || (quint32(131000) >> k3) < QESC ) {
+
+            err = QString("sglz1 modes not exercised at scan %1.").arg( s0 );
+            return false;
+        }
+
+        // Truncation rejected: last channel one byte short,
+        // lengths consistent, so the bit reader overruns.
+
+        QByteArray  T       = b.mid( CHKBYTES, bytes - 1 );
+        uchar       *L4     = (uchar*)T.data() + 4 * (nC - 1);
+
+        qToLittleEndian<quint32>( qFromLittleEndian<quint32>( L4 ) - 1, L4 );
+
+        if( DFZCodec::decode(
+                dst, (const uchar*)T.constData(), T.size(), nS, nC ) ) {
+
+            err = QString("sglz1 truncated chunk accepted at scan %1.")
+                    .arg( s0 );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+static bool dfzCheckRead(
+    QString         &err,
+    const char      *where,
+    const QString   &name,
+    const vec_i16   &src,
+    quint64         nS )
+{
+    DFZReader   R;
+    QString     e;
+    int         nC = TSTCHANS;
+
+    if( !R.open( e, name ) ) {
+        err = QString("sglz1 %1: %2").arg( where ).arg( e );
+        return false;
+    }
+
+    if( !nS )
+        return true;
+
+    vec_i16 dst( nS * nC );
+
+    if( R.read( &dst[0], 0, nS ) != qint64(nS) ) {
+        err = QString("sglz1 %1: read failed.").arg( where );
+        return false;
+    }
+
+    QString what = QString("sglz1 %1").arg( where );
+
+    if( !ktCompare( err, what, &src[0], &dst[0], int(nS) * nC, nC ) )
+        return false;
+
+    // Random access across a chunk boundary
+
+    quint64 s0 = TSTCHUNK - 17,
+            n  = qMin( quint64(40), nS - qMin( nS, s0 ) );
+
+    if( n ) {
+
+        if( R.read( &dst[0], s0, n ) != qint64(n) ) {
+            err = QString("sglz1 %1: seek read failed.").arg( where );
+            return false;
+        }
+
+        if( !ktCompare( err, what, &src[s0 * nC], &dst[0], int(n) * nC, nC ) )
+            return false;
+    }
+
+    return true;
+}
+
+
+static bool dfzCheckFile( QString &err, const vec_i16 &src )
+{
+    QString     name = QDir::temp().filePath( "SpikeGLX_sglz1_check.bin" );
+    QFile       f( name );
+    DFZPolicy   pol;
+    bool        ok = false;
+    int         nC = TSTCHANS;
+
+    pol.chunkScans  = TSTCHUNK;
+    pol.threads     = 2;
+
+    if( !f.open( QIODevice::WriteOnly | QIODevice::Truncate ) ) {
+        err = QString("sglz1 check: can't open [%1].").arg( name );
+        return false;
+    }
+
+    {
+        DFZWriter   W( f, 0, nC, pol );
+
+        if( !W.open() )
+            goto fail;
+
+        // Uneven blocks, as from a run
+
+        for( int s0 = 0; s0 < TSTSCANS; s0 += 100 ) {
+
+            int     nS = qMin( 100, TSTSCANS - s0 );
+            vec_i16 B( src.begin() + s0 * nC,
+                       src.begin() + (s0 + nS) * nC );
+
+            if( W.write( B ) < 0 )
+                goto fail;
+        }
+
+        // More chunks than maxInFlight, so some are on disk
+
+        f.flush();
+
+        if( W.scansOnDisk() < TSTCHUNK ) {
+            err = "sglz1 growing: no chunks on disk.";
+            goto close;
+        }
+
+        if( !dfzCheckRead( err, "growing", name, src, W.scansOnDisk() ) )
+            goto close;
+
+        if( W.close() < 0 )
+            goto fail;
+    }
+
+    f.close();
+
+    ok = dfzCheckRead( err, "closed", name, src, TSTSCANS );
+    goto close;
+
+fail:
+    err = QString("sglz1 check: write failed [%1].").arg( name );
+
+close:
+    f.close();
+    QFile::remove( name );
+    return ok;
+}
+
+
+bool dfzSelfCheck( QString &err )
+{
+    vec_i16 src;
+
+    dfzTestData( src, TSTSCANS, TSTCHANS, 12345 );
+
+    return dfzCheckCodec( err, src ) && dfzCheckFile( err, src );
+}
+
+
+// 384 noisy channels + sync word, one default chunk.
+//
+void dfzBench( QStringList &sl )
+{
+    const int   nC      = 385,
+                nS      = 16384,
+                nReps   = 5;
+
+    vec_i16     src( nS * nC ),
+                dst;
+    QByteArray  b;
+    KTRand      R;
+    KTTimer     T;
+    double      usEnc, usDec;
+
+    for( int is = 0; is < nS; ++is ) {
+
+        for( int ic = 0; ic < nC; ++ic ) {
+            quint32 r = R.next();
+            src[is * nC + ic] = (ic < nC - 1 ? qint16(int(r >> 25) - 64) : 0);
+        }
+    }
+
+    T.start();
+
+    for( int r = 0; r < nReps; ++r ) {
+        b.clear();
+        DFZCodec::encode( b, &src[0], nS, nC );
+    }
+
+    usEnc = T.usPer( nReps );
+
+    T.start();
+
+    for( int r = 0; r < nReps; ++r ) {
+        DFZCodec::decode(
+            dst, (const uchar*)b.constData() + CHKBYTES,
+            b.size() - CHKBYTES, nS, nC );
+    }
+
+    usDec = T.usPer( nReps );
+
+    double  MB = double(nS) * nC * sizeof(qint16) / (1024*1024);
+
+    sl.append(
+        QString("  sglz1 encode %1 MB/s, decode %2 MB/s, size %3%")
+        .arg( MB / (1e-6 * usEnc), 0, 'f', 0 )
+        .arg( MB / (1e-6 * usDec), 0, 'f', 0 )
+        .arg( 100.0 * b.size() / (MB * 1024*1024), 0, 'f', 1 ) );
+}
+
+
@@ -0,0 +1,181 @@
+#ifndef DFZIP_H
+#define DFZIP_H
+
+#include "SGLTypes.h"
+
+#include <QFile>
+#include <QList>
+#include <QMap>
+#include <QThreadPool>
+#include <QVector>
+
+class CSHA1;
+class DFZTask;
+
+class QStringList;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Which streams are recorded compressed, and how.
+//
+// enable:      off by default; files are then plain int16.
+// streams:     any of {ap, lf, ni}, comma separated (default ap).
+// chunkScans:  scans per chunk, the unit of random access.
+// threads:     encoder threads per file.
+//
+// Settings: dfzip.ini [DFZip] {enable, streams, chunkScans, threads}.
+//
+struct DFZPolicy {
+    QString streams;
+    int     chunkScans,
+            threads;
+    bool    enable;
+
+    DFZPolicy()
+    :   streams("ap"), chunkScans(16384), threads(2), enable(false) {}
+
+    void loadSettings();
+    bool wants( const QString &subtype ) const;
+};
+
+
+// Lossless compressed .bin, format "sglz1".
+//
+// Scans are cut into chunks of chunkScans (the last may be short).
+// Within a chunk each channel is coded on its own: first sample
+// as is, then zigzagged sample-to-sample deltas, Rice coded with
+// a per-channel parameter. A channel that would not shrink is
+// stored raw. Chunks are encoded in parallel and written in order.
+//
+// File layout (little-endian):
+// - header:  "SGLZ", quint16 version, quint16 reserved,
+//            quint32 nChans, quint32 chunkScans,
+// - chunks:  "ZCHK", quint32 payloadBytes, quint32 nScans, payload,
+//   payload: nChans x quint32 chanBytes, then per channel:
+//            quint8 k (0xFF = raw), qint16 first, Rice bits...
+// - index:   "ZIDX", quint32 nChunks, nChunks x quint64 offset,
+// - trailer: quint64 index offset, "ZEND".
+//
+// The index is written on close. A file still being recorded has
+// only whole chunks; readers then walk the chunk headers instead.
+//
+// The .meta records fileFormat=sglz1 and fileScanCount, since the
+// scan count no longer follows from the file size. fileSizeBytes
+// and fileSHA1 describe the compressed file as written.
+//
+class DFZCodec
+{
+public:
+    static QString formatName()     {return "sglz1";}
+
+    static void encode(
+        QByteArray      &out,
+        const qint16    *src,
+        int             nScans,
+        int             nC );
+
+    static bool decode(
+        vec_i16         &dst,
+        const uchar     *src,
+        int             bytes,
+        int             nScans,
+        int             nC );
+};
+
+
+// Output side; called from the DataFile writing thread.
+//
+class DFZWriter
+{
+private:
+    QFile               &f;
+    CSHA1               *sha;
+    QThreadPool         pool;
+    QList<DFZTask*>     inFlight;   // submit order
+    QVector<qint64>     index;      // chunk offsets
+    vec_i16             pend;       // part of next chunk
+    qint64              fileOff;
+    quint64             diskScans;
+    int                 nC,
+                        chunkScans,
+                        maxInFlight;
+    bool                ok;
+
+public:
+    DFZWriter(
+        QFile           &f,
+        CSHA1           *sha,
+        int             nC,
+        const DFZPolicy &pol );
+    virtual ~DFZWriter();
+
+    bool open();
+    qint64 write( const vec_i16 &scans );
+    qint64 close();
+
+    quint64 scansOnDisk() const {return diskScans;}
+
+private:
+    void submit();
+    qint64 drain( bool all );
+    bool put( const QByteArray &b );
+};
+
+
+// Input side: random access by scan, with an LRU cache of
+// decoded chunks (maxBytes).
+//
+class DFZReader
+{
+private:
+    struct Chunk {
+        vec_i16 data;
+        quint64 used;
+    };
+
+    QFile               f;
+    QVector<qint64>     index;
+    QMap<int,Chunk*>    cache;
+    qint64              walkOff;
+    quint64             tick;
+    int                 nC,
+                        chunkScans,
+                        maxChunks;
+
+public:
+    DFZReader() : walkOff(0), tick(0), nC(0), chunkScans(0), maxChunks(0) {}
+    virtual ~DFZReader()    {qDeleteAll( cache );}
+
+    bool open(
+        QString         &error,
+        const QString   &binName,
+        qint64          maxBytes = 64*1024*1024 );
+
+    int numChans() const    {return nC;}
+
+    qint64 read( qint16 *dst, quint64 scan0, quint64 num2read );
+
+private:
+    bool loadIndex();
+    void walk();
+    const Chunk *chunk( int ic );
+};
+
+
+// Round-trip random, full-scale, constant, spiky and ramp channels
+// (raw mode, escapes, short last chunk) through DFZCodec, then
+// through a DFZWriter file read back by DFZReader, both growing
+// (chunk walk) and closed (trailer index). Also checks that a
+// truncated chunk is rejected. Return false and describe first
+// mismatch. Run by the KernelChecks test app.
+bool dfzSelfCheck( QString &err );
+
+// Time encode and decode of a typical AP chunk;
+// append report lines to sl.
+void dfzBench( QStringList &sl );
+
+#endif  // DFZIP_H
+
+
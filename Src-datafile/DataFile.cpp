@@ -1,9 +1,16 @@
 
 #include "DataFile.h"
 #include "DataFile_Helpers.h"
+#include "DFCatalog.h"
+#include "DFEdges.h"
+#include "DFLive.h"
+#include "DFMetaCache.h"
+#include "DFZip.h"
+#include "Instr.h"
 #include "DFName.h"
 #include "Util.h"
 #include "MainApp.h"
+#include "Replay.h"
 #include "Subset.h"
 #include "Version.h"
 
@@ -16,8 +23,9 @@
 
 DataFile::DataFile( int iProbe )
     :   scanCt(0), mode(Undefined),
-        trgStream("nidq"), trgChan(-1),
-        dfw(0), wrAsync(true), sRate(0),
+        trgStream("nidq"), zr(0), trgChan(-1), following(false),
+        dfw(0), edx(0), live(0), zw(0), hWrite(0), gQFull(0), cBytes(0),
+        gapScans(0), zeroPend(0), wrAsync(true), sRate(0),
         iProbe(iProbe), nSavedChans(0)
 {
 }
@@ -29,13 +37,36 @@ DataFile::~DataFile()
         delete dfw;
         dfw = 0;
     }
+
+    if( edx ) {
+        delete edx;
+        edx = 0;
+    }
+
+    if( live ) {
+        delete live;
+        live = 0;
+    }
+
+    if( zw ) {
+        delete zw;
+        zw = 0;
+    }
+
+    if( zr ) {
+        delete zr;
+        zr = 0;
+    }
 }
 
 /* ---------------------------------------------------------------- */
 /* openForRead ---------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
-bool DataFile::openForRead( const QString &filename, QString &error )
+bool DataFile::openForRead(
+    const QString   &filename,
+    QString         &error,
+    bool            follow )
 {
 // ----
 // Init
@@ -47,9 +78,11 @@ bool DataFile::openForRead( const QString &filename, QString &error )
 // Valid?
 // ------
 
-    QString bFile = DFName::forceBinSuffix( filename );
+    QString bFile   = DFName::forceBinSuffix( filename );
+    bool    isLive  = false;
 
-    if( !DFName::isValidInputFile( bFile, &error ) ) {
+    if( !DFName::isValidInputFile(
+            bFile, &error, "20160120", (follow ? &isLive : 0) ) ) {
         error = "openForRead error: " + error;
         Error() << error;
         return false;
@@ -77,8 +110,36 @@ bool DataFile::openForRead( const QString &filename, QString &error )
 
     subclassParseMetaData();
 
-    scanCt = kvp["fileSizeBytes"].toULongLong()
-                / (sizeof(qint16) * nSavedChans);
+    if( kvp["fileFormat"].toString() == DFZCodec::formatName() ) {
+
+        zr = new DFZReader;
+
+        if( !zr->open( error, bFile ) || zr->numChans() != nSavedChans ) {
+            error = "openForRead error: " + error;
+            Error() << error;
+            delete zr;
+            zr = 0;
+            return false;
+        }
+    }
+
+    following = isLive;
+
+    if( following ) {
+
+        // Size so far from progress sidecar
+
+        KVParams    kvl;
+
+        DFLive::read( kvl, bFile );
+
+        scanCt = scansFromMeta( kvl );
+
+        if( kvl.contains( "firstSample" ) )
+            kvp["firstSample"] = kvl["firstSample"];
+    }
+    else
+        scanCt = scansFromMeta( kvp );
 
 // -----------
 // Channel ids
@@ -98,9 +159,7 @@ bool DataFile::openForRead( const QString &filename, QString &error )
         return false;
     }
 
-    if( Subset::isAllChansStr( it->toString() ) )
-        Subset::defaultVec( chanIds, nSavedChans );
-    else if( !Subset::rngStr2Vec( chanIds, it->toString() ) ) {
+    if( !DFMetaCache::chanIds( chanIds, it->toString(), nSavedChans ) ) {
         error =
         QString("openForRead error: Bad snsSaveChanSubset tag '%1'.")
             .arg( filename );
@@ -146,7 +205,8 @@ bool DataFile::openForRead( const QString &filename, QString &error )
         << QFileInfo( bFile ).fileName() << "] "
         << nSavedChans << " chans @"
         << sRate  << " Hz, "
-        << scanCt << " scans total.";
+        << scanCt << " scans total"
+        << (following ? " (recording in progress)." : ".");
 
     mode = Input;
 
@@ -210,19 +270,21 @@ bool DataFile::openForWrite(
 
     QString bName;
 
+    catDir = mainApp()->dataDir();
+
     if( !forceName.isEmpty() )
         bName = brevname;
     else if( !p.sns.fldPerPrb || subtypeFromObj() == "nidq" ) {
 
         bName = QString("%1/%2_g%3/%4")
-                .arg( mainApp()->dataDir() )
+                .arg( catDir )
                 .arg( p.sns.runName ).arg( ig )
                 .arg( brevname );
     }
     else {
 
         bName = QString("%1/%2_g%3/%2_g%3_%4")
-                .arg( mainApp()->dataDir() )
+                .arg( catDir )
                 .arg( p.sns.runName ).arg( ig )
                 .arg( streamFromObj() );
 
@@ -243,6 +305,32 @@ bool DataFile::openForWrite(
         return false;
     }
 
+// -----------
+// Compression
+// -----------
+
+    DFZPolicy   zPol;
+
+    zPol.loadSettings();
+
+    if( zPol.wants( subtypeFromObj() ) ) {
+
+        zw = new DFZWriter( binFile, &sha, nSaved, zPol );
+
+        if( !zw->open() ) {
+            Error() << "openForWrite error: Can't write [" << bName << "]";
+            return false;
+        }
+
+        kvp["fileFormat"] = DFZCodec::formatName();
+
+        Log() <<
+            QString("%1 compressed (%2), %3 encoder threads.")
+            .arg( fileLblFromObj() )
+            .arg( DFZCodec::formatName() )
+            .arg( zPol.threads );
+    }
+
 // ---------
 // Meta data
 // ---------
@@ -351,6 +439,16 @@ bool DataFile::openForWrite(
     kvp["typeImEnabled"]    = p.im.get_nProbes();
     kvp["typeNiEnabled"]    = (p.ni.enabled ? 1 : 0);
 
+    // Data replayed from files are marked as such
+
+    {
+        ReplayParams    R;
+        R.loadSettings();
+
+        if( R.isEnabled() )
+            kvp["replaySource"] = R.binFile;
+    }
+
     // All metadata are single lines of text
     QString noReturns = p.sns.notes;
     noReturns.replace( QRegExp("[\r\n]"), "\\n" );
@@ -405,6 +503,34 @@ bool DataFile::openForWrite(
 
     mode = Output;
 
+    hWrite = Instr::hist( QString("%1.write").arg( fileLblFromObj() ) );
+    gQFull = Instr::gauge( QString("%1.wrQueuePct").arg( fileLblFromObj() ) );
+    cBytes = Instr::counter( QString("%1.wrBytes").arg( fileLblFromObj() ) );
+
+    qPol.loadSettings();
+
+// -------------------
+// Digital-event index
+// -------------------
+
+    edx = new DFEdges;
+
+    if( !edx->openForWrite( this ) ) {
+        delete edx;
+        edx = 0;
+    }
+
+// ----------------
+// Progress sidecar
+// ----------------
+
+    live = new DFLive;
+
+    if( !live->openForWrite( this ) ) {
+        delete live;
+        live = 0;
+    }
+
 // ---------------------
 // Preliminary meta data
 // ---------------------
@@ -447,6 +573,8 @@ bool DataFile::openForExport(
 
     mainApp()->makePathAbsolute( bName );
 
+    catDir = mainApp()->dataDir();
+
     metaName = DFName::forceMetaSuffix( bName );
 
     Debug() << "Outfile: " << bName;
@@ -474,6 +602,11 @@ bool DataFile::openForExport(
     kvp["fileName"]     = bName;
     kvp["nSavedChans"]  = nSavedChans;
 
+    // Exports are written uncompressed
+
+    kvp.remove( "fileFormat" );
+    kvp.remove( "fileScanCount" );
+
 // Build channel ID list
 
     chanIds.clear();
@@ -508,6 +641,16 @@ bool DataFile::openForExport(
 
     mode = Output;
 
+// --------
+// Sidecars
+// --------
+
+// Exports get no edge index or progress sidecar; remove any
+// left by an earlier file of the same name.
+
+    QFile::remove( DFEdges::sidecarName( bName ) );
+    QFile::remove( DFLive::sidecarName( bName ) );
+
     return true;
 }
 
@@ -531,6 +674,35 @@ bool DataFile::closeAndFinalize()
             dfw = 0;
         }
 
+        if( zeroPend && !writeZeros( false ) )
+            ok = false;
+
+        if( edx ) {
+            edx->close( scanCt );
+            delete edx;
+            edx = 0;
+        }
+
+        if( zw ) {
+
+            if( zw->close() < 0 )
+                ok = false;
+
+            delete zw;
+            zw = 0;
+
+            kvp["fileScanCount"] = scanCt;
+
+            if( scanCt ) {
+                Log() <<
+                    QString("%1 compressed to %2% of raw size.")
+                    .arg( fileLblFromObj() )
+                    .arg( 100.0 * binFile.size()
+                        / (scanCt * nSavedChans * sizeof(qint16)),
+                        0, 'f', 1 );
+            }
+        }
+
         sha.Final();
 
         std::basic_string<char> hStr;
@@ -541,7 +713,34 @@ bool DataFile::closeAndFinalize()
         kvp["fileSizeBytes"]    = binFile.size();
         kvp["appVersion"]       = QString("%1").arg( VERSION, 0, 16 );
 
-        ok = kvp.toMetaFile( metaName );
+        if( gapScans ) {
+
+            QString s;
+
+            for( int i = 0, n = gaps.size(); i < n; ++i ) {
+                s += QString("(%1,%2)")
+                        .arg( gaps[i].first ).arg( gaps[i].second );
+            }
+
+            kvp["wrQueueDropScans"] = gapScans;
+            kvp["~wrQueueGaps"]     = s;
+        }
+
+        ok = kvp.toMetaFile( metaName ) && ok;
+
+        // Sidecar removed only after final meta is in place
+
+        if( live ) {
+            delete live;
+            live = 0;
+        }
+
+        // Catalog after close, when .bin mod time is final
+
+        binFile.close();
+
+        if( ok )
+            DFCatalog::add( catDir, binFile.fileName(), kvp );
 
         Log() << ">> Completed " << binFile.fileName();
     }
@@ -550,19 +749,28 @@ bool DataFile::closeAndFinalize()
 // Reset
 // -----
 
+    if( zr ) {
+        delete zr;
+        zr = 0;
+    }
+
     binFile.close();
     metaName.clear();
 
     statsBytes.clear();
     kvp.clear();
     chanIds.clear();
+    gaps.clear();
     sha.Reset();
 
     scanCt      = 0;
     mode        = Undefined;
     trgStream   = "nidq";
     trgChan     = -1;
+    following   = false;
     dfw         = 0;
+    gapScans    = 0;
+    zeroPend    = 0;
     wrAsync     = true;
     sRate       = 0;
     nSavedChans = 0;
@@ -614,11 +822,7 @@ bool DataFile::writeAndInvalScans( vec_i16 &scans )
         return false;
     }
 
-// --------------
-// Update counter
-// --------------
-
-    scanCt += scans.size() / nSavedChans;
+    quint64 nScans = scans.size() / nSavedChans;
 
 // -----
 // Write
@@ -626,12 +830,62 @@ bool DataFile::writeAndInvalScans( vec_i16 &scans )
 
     if( wrAsync ) {
 
-        if( !dfw )
+        if( !dfw ) {
+
             dfw = new DFWriter( this, 4000 );
+            dfw->worker->setMaxBytes( quint64(qPol.capMB) * 1024*1024 );
+            dfw->worker->setLatencyHist(
+                Instr::hist(
+                    QString("%1.wrQueueLat").arg( fileLblFromObj() ) ) );
+
+            if( qPol.policy != DFQPolicy::qpStop || qPol.capMB ) {
+                Log() <<
+                    QString("%1 write queue: %2, capacity %3 MB.")
+                    .arg( fileLblFromObj() )
+                    .arg( qPol.policyStr() )
+                    .arg( qPol.capMB );
+            }
+        }
+
+        switch( qPol.policy ) {
+
+            case DFQPolicy::qpBlock:
+
+                if( !dfw->worker->enqueueWait( scans, qPol.blockMS ) ) {
+
+                    Error() <<
+                        QString("Datafile queue full for %1 ms;"
+                        " stopping run.")
+                        .arg( qPol.blockMS );
+                    return false;
+                }
+                break;
 
-        dfw->worker->enqueue( scans );
+            case DFQPolicy::qpDrop:
 
-        if( dfw->worker->percentFull() >= 95.0 ) {
+                // Owed zeros go first, keeping file order
+
+                if( zeroPend )
+                    writeZeros( true );
+
+                if( zeroPend || dfw->worker->isFull() )
+                    dropScans( nScans );
+                else
+                    dfw->worker->enqueue( scans );
+                break;
+
+            default:
+                dfw->worker->enqueue( scans );
+        }
+
+        scanCt += nScans;
+
+        double  pctFull = dfw->worker->percentFull();
+
+        if( gQFull && Instr::isEnabled() )
+            gQFull->set( pctFull );
+
+        if( qPol.policy == DFQPolicy::qpStop && pctFull >= 95.0 ) {
 
             Error() << "Datafile queue overflow; stopping run.";
             return false;
@@ -640,6 +894,8 @@ bool DataFile::writeAndInvalScans( vec_i16 &scans )
         return true;
     }
 
+    scanCt += nScans;
+
     return doFileWrite( scans );
 }
 
@@ -663,10 +919,7 @@ bool DataFile::writeAndInvalSubset( const DAQ::Params &p, vec_i16 &scans )
 
 // Read num2read scans starting from file offset scan0.
 // Note that (scan0 == 0) is the start of this file.
-//
-// To apply 'const' to this method, seek() and read()
-// have to strip constness from binFile, since they
-// move the file pointer.
+// Compressed files decode through zr's chunk cache.
 //
 qint64 DataFile::readScans(
     vec_i16         &dst,
@@ -683,6 +936,52 @@ qint64 DataFile::readScans(
 
     num2read = qMin( num2read, scanCt - scan0 );
 
+// ----
+// Read
+// ----
+
+    if( zr ) {
+
+        dst.resize( num2read * nSavedChans );
+
+        if( zr->read( &dst[0], scan0, num2read ) < 0 ) {
+            dst.clear();
+            return -1;
+        }
+    }
+    else if( !readBin( dst, scan0, num2read ) )
+        return -1;
+
+// ------
+// Subset
+// ------
+
+    if( keepBits.size() && keepBits.count( true ) < nSavedChans ) {
+
+        QVector<uint>   iKeep;
+
+        Subset::bits2Vec( iKeep, keepBits );
+        Subset::subset( dst, dst, iKeep, nSavedChans );
+    }
+
+    return num2read;
+}
+
+/* ---------------------------------------------------------------- */
+/* readBin -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Plain int16 file: num2read (already clipped) scans at scan0.
+//
+// To apply 'const' to this method, seek() and read()
+// have to strip constness from binFile, since they
+// move the file pointer.
+//
+bool DataFile::readBin(
+    vec_i16         &dst,
+    quint64         scan0,
+    quint64         num2read ) const
+{
 // ----
 // Seek
 // ----
@@ -697,7 +996,7 @@ qint64 DataFile::readScans(
             << "] file size ["
             << binFile.size()
             << "].";
-        return -1;
+        return false;
     }
 
 // ----
@@ -756,22 +1055,67 @@ qint64 DataFile::readScans(
             << "].";
 
         dst.clear();
-        return -1;
+        return false;
     }
 
-// ------
-// Subset
-// ------
+    return true;
+}
 
-    if( keepBits.size() && keepBits.count( true ) < nSavedChans ) {
+/* ---------------------------------------------------------------- */
+/* followGrowth --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
 
-        QVector<uint>   iKeep;
+// While recording, the .live sidecar gives the flushed size.
+// Once the sidecar is gone, the final .meta is reloaded; if it
+// is not complete yet, we just try again on the next poll.
+// If the sidecar goes stale, the writer quit without finalizing;
+// we stop following and keep the scans seen so far.
+//
+bool DataFile::followGrowth()
+{
+    if( !isFollowing() )
+        return false;
 
-        Subset::bits2Vec( iKeep, keepBits );
-        Subset::subset( dst, dst, iKeep, nSavedChans );
+    quint64     oldCt = scanCt;
+    KVParams    kvl;
+
+    if( DFLive::read( kvl, binFile.fileName() ) ) {
+
+        scanCt = qMax( scanCt, scansFromMeta( kvl ) );
+
+        if( kvl.contains( "firstSample" ) )
+            kvp["firstSample"] = kvl["firstSample"];
+
+        if( DFLive::isStale( kvl ) ) {
+
+            following = false;
+
+            Warning()
+                << "Recording stopped without finalizing ["
+                << QFileInfo( binFile.fileName() ).fileName() << "] "
+                << scanCt << " scans readable.";
+        }
     }
+    else if( !QFileInfo( DFLive::sidecarName( binFile.fileName() ) ).exists() ) {
 
-    return num2read;
+        KVParams    kvm;
+
+        if( kvm.fromMetaFile( metaName )
+            && kvm.contains( "fileSHA1" )
+            && kvm.contains( "fileSizeBytes" ) ) {
+
+            kvp         = kvm;
+            scanCt      = scansFromMeta( kvp );
+            following   = false;
+
+            Debug()
+                << "Recording completed ["
+                << QFileInfo( binFile.fileName() ).fileName() << "] "
+                << scanCt << " scans total.";
+        }
+    }
+
+    return scanCt != oldCt;
 }
 
 /* ---------------------------------------------------------------- */
@@ -784,6 +1128,9 @@ qint64 DataFile::readScans(
 void DataFile::setFirstSample( quint64 firstCt )
 {
     kvp["firstSample"] = firstCt;
+
+    if( live )
+        live->setFirstSample( firstCt );
 }
 
 /* ---------------------------------------------------------------- */
@@ -912,6 +1259,22 @@ double DataFile::percentFull() const
     return (dfw ? dfw->worker->percentFull() : 0);
 }
 
+/* ---------------------------------------------------------------- */
+/* wrQueuePeakLatency --------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Peak seconds a block waited in the write queue since last call.
+//
+double DataFile::wrQueuePeakLatency()
+{
+    double  last = 0, peak = 0;
+
+    if( dfw )
+        dfw->worker->latency( last, peak );
+
+    return peak;
+}
+
 /* ---------------------------------------------------------------- */
 /* writeSpeedBps -------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -934,17 +1297,127 @@ double DataFile::writtenBytes() const
     return sum;
 }
 
+/* ---------------------------------------------------------------- */
+/* scansFromMeta -------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Compressed files state their scan count; else the count
+// follows from the size.
+//
+quint64 DataFile::scansFromMeta( const KVParams &kv ) const
+{
+    if( zr )
+        return kv["fileScanCount"].toULongLong();
+
+    return kv["fileSizeBytes"].toULongLong()
+            / (sizeof(qint16) * nSavedChans);
+}
+
+/* ---------------------------------------------------------------- */
+/* dropScans ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+// Record a gap at file scan (scanCt); adjacent drops merge.
+// Warn once per gap. The caller still advances scanCt; the
+// span is owed to the file as zeros (zeroPend).
+//
+void DataFile::dropScans( quint64 nScans )
+{
+    if( gaps.size() && gaps.last().first + gaps.last().second == scanCt )
+        gaps.last().second += nScans;
+    else {
+
+        gaps.push_back( QPair<quint64,quint64>( scanCt, nScans ) );
+
+        Warning() <<
+            QString("%1 write queue full; dropping data at file scan %2.")
+            .arg( fileLblFromObj() )
+            .arg( scanCt );
+    }
+
+    gapScans += nScans;
+    zeroPend += nScans;
+}
+
+/* ---------------------------------------------------------------- */
+/* writeZeros ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Pay down zeroPend in blocks of up to one second.
+// async: enqueue while the queue has room.
+// else:  write directly (queue already drained).
+//
+bool DataFile::writeZeros( bool async )
+{
+    quint64 blk = qMax( 1, int(sRate) );
+
+    while( zeroPend ) {
+
+        if( async && dfw->worker->isFull() )
+            return true;
+
+        quint64 n = qMin( zeroPend, blk );
+        vec_i16 Z( n * nSavedChans, 0 );
+
+        if( async )
+            dfw->worker->enqueue( Z );
+        else if( !doFileWrite( Z ) )
+            return false;
+
+        zeroPend -= n;
+    }
+
+    return true;
+}
+
 /* ---------------------------------------------------------------- */
 /* doFileWrite ---------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
+// Compressed: zw encodes whole chunks in parallel, writes those
+// done (so nWrit varies), and hashes what it writes.
+//
 bool DataFile::doFileWrite( const vec_i16 &scans )
 {
     int n2Write = (int)scans.size() * sizeof(qint16);
 
+    double  tInstr = Instr::startT();
+
+    if( zw ) {
+
+        qint64  nWrit = zw->write( scans );
+
+        if( hWrite && tInstr > 0 ) {
+            hWrite->addSince( tInstr );
+            cBytes->add( qMax( nWrit, qint64(0) ) );
+        }
+
+        statsMtx.lock();
+            statsBytes.push_back( qMax( nWrit, qint64(0) ) );
+        statsMtx.unlock();
+
+        if( nWrit < 0 ) {
+            Error() << "File writing error: " << binFile.error();
+            return false;
+        }
+
+        if( edx )
+            edx->scan( scans );
+
+        if( live )
+            live->update( binFile, zw->scansOnDisk() );
+
+        return true;
+    }
+
 //    int nWrit = writeChunky( binFile, &scans[0], n2Write );
     int nWrit = binFile.write( (char*)&scans[0], n2Write );
 
+    if( hWrite && tInstr > 0 ) {
+        hWrite->addSince( tInstr );
+        cBytes->add( qMax( nWrit, 0 ) );
+    }
+
     statsMtx.lock();
         statsBytes.push_back( nWrit );
     statsMtx.unlock();
@@ -956,6 +1429,12 @@ bool DataFile::doFileWrite( const vec_i16 &scans )
 
     sha.Update( (const UINT_8*)&scans[0], n2Write );
 
+    if( edx )
+        edx->scan( scans );
+
+    if( live )
+        live->update( binFile );
+
     return true;
 }
 
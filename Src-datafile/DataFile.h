@@ -9,13 +9,55 @@
 
 #include <QFile>
 #include <QMutex>
+#include <QPair>
 
 class DFWriter;
+class DFEdges;
+class DFLive;
+class DFZReader;
+class DFZWriter;
+class InstrCounter;
+class InstrHist;
+class InstrGauge;
 
 /* ---------------------------------------------------------------- */
 /* Types ---------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
+// Write-queue backpressure, what to do when a file's queue fills:
+//
+// qpStop:  Stop the run at 95% full (default).
+// qpBlock: Hold the producer (trigger thread) up to blockMS for
+//          room; the stream's AIQ absorbs the delay. Stop the
+//          run if no room by then.
+// qpDrop:  Discard the block and carry on. The dropped span is
+//          written as zeros once the queue has room, so file scans
+//          stay aligned with stream time. Each gap is logged and
+//          listed in the .meta as ~wrQueueGaps=(fileScan,nScans)..
+//          where fileScan is the first zero-filled scan.
+//
+// capMB limits queued bytes per file (0 = buffer count only).
+//
+// Settings: dfqueue.ini [DFQueue] {policy, capMB, blockMS}.
+//
+struct DFQPolicy {
+    enum Policy {
+        qpStop  = 0,
+        qpBlock = 1,
+        qpDrop  = 2
+    };
+
+    int policy,
+        capMB,
+        blockMS;
+
+    DFQPolicy() : policy(qpStop), capMB(0), blockMS(2000)   {}
+
+    void loadSettings();
+    QString policyStr() const;
+};
+
+
 // virtual base class
 //
 class DataFile
@@ -32,19 +74,32 @@ private:
 
     // Input and Output mode
     QFile                   binFile;
-    QString                 metaName;
+    QString                 metaName,
+                            catDir;     // output: catalog under here
     quint64                 scanCt;
     IOMode                  mode;
 
     // Input mode
     QString                 trgStream;
+    DFZReader               *zr;
     int                     trgChan;    // neg if not using
+    bool                    following;  // still being recorded
 
     // Output mode only
     mutable QMutex          statsMtx;
     mutable QVector<uint>   statsBytes;
     CSHA1                   sha;
     DFWriter                *dfw;
+    DFEdges                 *edx;
+    DFLive                  *live;
+    DFZWriter               *zw;
+    InstrHist               *hWrite;
+    InstrGauge              *gQFull;
+    InstrCounter            *cBytes;
+    DFQPolicy               qPol;
+    QVector<QPair<quint64,quint64> >    gaps;   // (fileScan,nScans)
+    quint64                 gapScans,
+                            zeroPend;   // gap scans owed to file
     int                     nMeasMax;
     bool                    wrAsync;
 
@@ -65,7 +120,13 @@ public:
     // Open/close
     // ----------
 
-    bool openForRead( const QString &filename, QString &error );
+    // follow: Also accept a file still being recorded; see
+    // isFollowing() and followGrowth().
+
+    bool openForRead(
+        const QString   &filename,
+        QString         &error,
+        bool            follow = false );
     bool openForWrite(
         const DAQ::Params   &p,
         int                 ig,
@@ -94,6 +155,7 @@ public:
 
     QString binFileName() const         {return binFile.fileName();}
     const QString &metaFileName() const {return metaName;}
+    bool isCompressed() const           {return zr || zw;}
 
     bool closeAndFinalize();
 
@@ -122,6 +184,13 @@ public:
         quint64         num2read,
         const QBitArray &keepBits ) const;
 
+    // For a file opened (follow) while still being recorded,
+    // re-poll its progress. Return true if scanCount() grew.
+    // isFollowing() goes false once the recording is closed.
+
+    bool isFollowing() const    {return isOpenForRead() && following;}
+    bool followGrowth();
+
     // ---------
     // Meta data
     // ---------
@@ -158,6 +227,8 @@ public:
     // ----------------------
 
     double percentFull() const;
+    double wrQueuePeakLatency();
+    quint64 droppedScans() const    {return gapScans;}
     double writtenBytes() const;
     double requiredBps() const  {return sRate*nSavedChans*sizeof(qint16);}
 
@@ -180,6 +251,13 @@ protected:
         const QVector<uint> &idxOtherChans ) = 0;
 
 private:
+    bool readBin(
+        vec_i16         &dst,
+        quint64         scan0,
+        quint64         num2read ) const;
+    quint64 scansFromMeta( const KVParams &kv ) const;
+    void dropScans( quint64 nScans );
+    bool writeZeros( bool async );
     bool doFileWrite( const vec_i16 &scans );
 };
 
@@ -3,6 +3,7 @@
 #include "MainApp.h"
 #include "ConfigCtl.h"
 #include "DataFileIMAP.h"
+#include "DFMetaCache.h"
 #include "Subset.h"
 
 
@@ -49,7 +50,7 @@ ChanMap* DataFileIMAP::chanMap() const
     KVParams::const_iterator    it;
 
     if( (it = kvp.find( "~snsChanMap" )) != kvp.end() )
-        chanMap->fromString( it.value().toString() );
+        DFMetaCache::chanMap( *chanMap, it.value().toString() );
 
     return chanMap;
 }
@@ -64,7 +65,7 @@ ShankMap* DataFileIMAP::shankMap() const
     KVParams::const_iterator    it;
 
     if( (it = kvp.find( "~snsShankMap" )) != kvp.end() )
-        shankMap->fromString( it.value().toString() );
+        DFMetaCache::shankMap( *shankMap, it.value().toString() );
     else {
 
         // Assume single shank, two columns, only saved channels
@@ -89,7 +90,7 @@ void DataFileIMAP::subclassParseMetaData()
 
 // subclass
     parseChanCounts();
-    roTbl.fromString( kvp["~imroTbl"].toString() );
+    DFMetaCache::imroTbl( roTbl, kvp["~imroTbl"].toString() );
 }
 
 
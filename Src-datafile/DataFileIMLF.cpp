@@ -3,6 +3,7 @@
 #include "MainApp.h"
 #include "ConfigCtl.h"
 #include "DataFileIMLF.h"
+#include "DFMetaCache.h"
 #include "Subset.h"
 
 
@@ -49,7 +50,7 @@ ChanMap* DataFileIMLF::chanMap() const
     KVParams::const_iterator    it;
 
     if( (it = kvp.find( "~snsChanMap" )) != kvp.end() )
-        chanMap->fromString( it.value().toString() );
+        DFMetaCache::chanMap( *chanMap, it.value().toString() );
 
     return chanMap;
 }
@@ -68,7 +69,7 @@ void DataFileIMLF::subclassParseMetaData()
 
 // subclass
     parseChanCounts();
-    roTbl.fromString( kvp["~imroTbl"].toString() );
+    DFMetaCache::imroTbl( roTbl, kvp["~imroTbl"].toString() );
 }
 
 
@@ -1,5 +1,6 @@
 
 #include "DataFileNI.h"
+#include "DFMetaCache.h"
 #include "Subset.h"
 
 
@@ -47,7 +48,7 @@ ChanMap* DataFileNI::chanMap() const
     KVParams::const_iterator    it;
 
     if( (it = kvp.find( "~snsChanMap" )) != kvp.end() )
-        chanMap->fromString( it.value().toString() );
+        DFMetaCache::chanMap( *chanMap, it.value().toString() );
 
     return chanMap;
 }
@@ -62,7 +63,7 @@ ShankMap* DataFileNI::shankMap() const
     KVParams::const_iterator    it;
 
     if( (it = kvp.find( "~snsShankMap" )) != kvp.end() )
-        shankMap->fromString( it.value().toString() );
+        DFMetaCache::shankMap( *shankMap, it.value().toString() );
     else {
 
         // Assume single shank, two columns, only saved channels
@@ -1,11 +1,37 @@
 
 #include "DataFile_Helpers.h"
 #include "DataFile.h"
+#include "Instr.h"
 #include "Util.h"
 
+#include <QSettings>
 #include <QThread>
 
 
+/* ---------------------------------------------------------------- */
+/* DFQPolicy ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+void DFQPolicy::loadSettings()
+{
+    STDSETTINGS( settings, "dfqueue" );
+    settings.beginGroup( "DFQueue" );
+
+    policy  = qBound( 0, settings.value( "policy", 0 ).toInt(), 2 );
+    capMB   = qMax( 0, settings.value( "capMB", 0 ).toInt() );
+    blockMS = qBound( 0, settings.value( "blockMS", 2000 ).toInt(), 60000 );
+}
+
+
+QString DFQPolicy::policyStr() const
+{
+    switch( policy ) {
+        case qpBlock:   return QString("block %1 ms").arg( blockMS );
+        case qpDrop:    return "drop";
+        default:        return "stop";
+    }
+}
+
 /* ---------------------------------------------------------------- */
 /* DFWriterWorker ------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -14,10 +40,14 @@ void DFWriterWorker::run()
 {
     Debug() << "DFWriter started for " << d->binFileName();
 
+    InstrThreadCPU  cpu( d->fileLblFromObj() + ".writer" );
+
     for(;;) {
 
         vec_i16 buf;
 
+        cpu.sample();
+
         if( dequeue( buf, waitData() ) )
             write( buf );
         else if( isStopped() )
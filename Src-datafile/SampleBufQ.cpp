@@ -1,18 +1,30 @@
 
 #include "SampleBufQ.h"
+#include "Instr.h"
 #include "Util.h"
 
 
 
 
+void SampleBufQ::latency( double &last, double &peak )
+{
+    QMutexLocker    ml( &dataQMtx );
+
+    last    = lastLat;
+    peak    = peakLat;
+    peakLat = lastLat;
+}
+
+
 void SampleBufQ::enqueue( vec_i16 &src )
 {
     QMutexLocker    ml( &dataQMtx );
 
-    if( dataQ.size() >= maxQSize )
+    if( isFull_Locked() )
         overflowWarning();
 
-    dataQ.push_back( SampleBuf( src ) );
+    qBytes += src.size() * sizeof(qint16);
+    dataQ.push_back( SampleBuf( src, getTime() ) );
 
 // Have an entry; wake a waiting dequeue caller
 
@@ -20,6 +32,36 @@ void SampleBufQ::enqueue( vec_i16 &src )
 }
 
 
+// Wait up to (ms) for room, then enqueue.
+// Return false, leaving src intact, if still full.
+//
+bool SampleBufQ::enqueueWait( vec_i16 &src, int ms )
+{
+    QMutexLocker    ml( &dataQMtx );
+
+    if( isFull_Locked() ) {
+
+        double  tEnd = getTime() + 0.001 * ms;
+
+        do {
+            int rem = int(1000 * (tEnd - getTime()));
+
+            if( rem <= 0 )
+                return false;
+
+            condBufQHasRoom.wait( &dataQMtx, rem );
+
+        } while( isFull_Locked() );
+    }
+
+    qBytes += src.size() * sizeof(qint16);
+    dataQ.push_back( SampleBuf( src, getTime() ) );
+
+    condBufQIsEntry.wakeAll();
+    return true;
+}
+
+
 // Returns true if data ready to be written...
 // ...if true, dst is swapped for a data buffer in the deque.
 //
@@ -42,6 +84,18 @@ bool SampleBufQ::dequeue( vec_i16 &dst, bool wait )
 
     if( N ) {
 
+        // Latency of oldest block
+
+        double  lat = getTime() - dataQ.front().tEnq;
+
+        lastLat = lat;
+
+        if( lat > peakLat )
+            peakLat = lat;
+
+        if( hLat )
+            hLat->add( lat );
+
         // First, dequeue one block
 
         dst.swap( dataQ.front().data );
@@ -74,10 +128,15 @@ bool SampleBufQ::dequeue( vec_i16 &dst, bool wait )
                 --N;
             }
         }
+
+        qBytes -= qMin( qBytes, quint64(dst.size() * sizeof(qint16)) );
+        condBufQHasRoom.wakeAll();
     }
 
-    if( !dataQ.size() )
+    if( !dataQ.size() ) {
+        qBytes = 0;
         condBufQIsEmpty.wakeAll();
+    }
 
     dataQMtx.unlock();
     return dataReady;
@@ -119,7 +178,27 @@ void SampleBufQ::overflowWarning()
     Error()
         << "Write queue overflow (capacity: "
         << maxQSize
-        << " buffers).";
+        << " buffers, "
+        << maxQBytes / (1024*1024)
+        << " MB).";
+}
+
+
+double SampleBufQ::pctFull_Locked() const
+{
+    double  pct = (100.0 * dataQ.size()) / maxQSize;
+
+    if( maxQBytes )
+        pct = qMax( pct, (100.0 * qBytes) / maxQBytes );
+
+    return pct;
+}
+
+
+bool SampleBufQ::isFull_Locked() const
+{
+    return dataQ.size() >= maxQSize
+            || (maxQBytes && qBytes >= maxQBytes);
 }
 
 
@@ -7,6 +7,8 @@
 #include <QWaitCondition>
 #include <deque>
 
+class InstrHist;
+
 /* ---------------------------------------------------------------- */
 /* Types ---------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -20,7 +22,8 @@ class SampleBufQ
 private:
     struct SampleBuf {
         vec_i16 data;
-        SampleBuf( vec_i16 &src )   {data.swap( src );}
+        double  tEnq;
+        SampleBuf( vec_i16 &src, double t ) : tEnq(t)   {data.swap( src );}
     };
 
 /* ---- */
@@ -31,7 +34,13 @@ private:
     std::deque<SampleBuf>   dataQ;
     mutable QMutex          dataQMtx;
     mutable QWaitCondition  condBufQIsEntry,
-                            condBufQIsEmpty;
+                            condBufQIsEmpty,
+                            condBufQHasRoom;
+    InstrHist               *hLat;
+    quint64                 qBytes,
+                            maxQBytes;  // 0 = no byte limit
+    double                  lastLat,
+                            peakLat;
     const uint              maxQSize;
 
 /* ------- */
@@ -39,26 +48,50 @@ private:
 /* ------- */
 
 public:
-    SampleBufQ( int maxQSize ) : maxQSize(maxQSize) {}
+    SampleBufQ( int maxQSize )
+    :   hLat(0), qBytes(0), maxQBytes(0),
+        lastLat(0), peakLat(0), maxQSize(maxQSize)  {}
 
     void wake()
     {
         condBufQIsEntry.wakeAll();
         condBufQIsEmpty.wakeAll();
+        condBufQHasRoom.wakeAll();
     }
 
+    void setMaxBytes( quint64 bytes )
+        {QMutexLocker ml( &dataQMtx ); maxQBytes = bytes;}
+    void setLatencyHist( InstrHist *h )
+        {QMutexLocker ml( &dataQMtx ); hLat = h;}
+
+    // Greater of buffer count and byte fill.
     double percentFull() const
     {
         QMutexLocker ml( &dataQMtx );
-        return (100.0 * dataQ.size()) / maxQSize;
+        return pctFull_Locked();
     }
 
+    bool isFull() const
+    {
+        QMutexLocker ml( &dataQMtx );
+        return isFull_Locked();
+    }
+
+    // Seconds from enqueue to dequeue: most recent and peak
+    // since last call.
+    void latency( double &last, double &peak );
+
     void enqueue( vec_i16 &src );
+    bool enqueueWait( vec_i16 &src, int ms );
     bool dequeue( vec_i16 &dst, bool wait = false );
     bool waitForEmpty( int ms = -1 );
 
 protected:
     virtual void overflowWarning();
+
+private:
+    double pctFull_Locked() const;
+    bool isFull_Locked() const;
 };
 
 #endif  // SAMPLEBUFQ_H
@@ -5,7 +5,12 @@ HEADERS += \
     $$PWD/DataFileIMAP.h \
     $$PWD/DataFileIMLF.h \
     $$PWD/DataFileNI.h \
+    $$PWD/DFCatalog.h \
+    $$PWD/DFEdges.h \
+    $$PWD/DFLive.h \
+    $$PWD/DFMetaCache.h \
     $$PWD/DFName.h \
+    $$PWD/DFZip.h \
     $$PWD/ExportCtl.h \
     $$PWD/SampleBufQ.h
 
@@ -15,7 +20,12 @@ SOURCES += \
     $$PWD/DataFileIMAP.cpp \
     $$PWD/DataFileIMLF.cpp \
     $$PWD/DataFileNI.cpp \
+    $$PWD/DFCatalog.cpp \
+    $$PWD/DFEdges.cpp \
+    $$PWD/DFLive.cpp \
+    $$PWD/DFMetaCache.cpp \
     $$PWD/DFName.cpp \
+    $$PWD/DFZip.cpp \
     $$PWD/ExportCtl.cpp \
     $$PWD/SampleBufQ.cpp
 
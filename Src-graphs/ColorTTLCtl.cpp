@@ -9,6 +9,7 @@
 #include "HelpButDialog.h"
 #include "SignalBlocker.h"
 #include "Subset.h"
+#include "EdgeIndex.h"
 
 #include <QMessageBox>
 #include <QSettings>
@@ -225,8 +226,11 @@ void ColorTTLCtl::ItemGrp::analogChanged( TTLClrEach &C, bool algCBChanged )
 /* ---------------------------------------------------------------- */
 
 ColorTTLCtl::ColorTTLCtl( QObject *parent, const DAQ::Params &p )
-    :   QObject(parent), p(p)
+    :   QObject(parent), p(p), edges(0)
 {
+    for( int i = 0; i < 4; ++i )
+        watch[i] = -1;
+
     resetState();
     loadSettings();
 
@@ -302,12 +306,24 @@ void ColorTTLCtl::setClients(
     MGraphX     *Xa,
     int         ipb,
     const AIQ   *Qb,
-    MGraphX     *Xb )
+    MGraphX     *Xb,
+    EdgeIndex   *edges )
 {
     setMtx.lock();
-        resetState();
+
+        // Watches belong to previous index (if any)
+        if( edges != this->edges ) {
+
+            for( int i = 0; i < 4; ++i )
+                watch[i] = -1;
+
+            this->edges = edges;
+        }
+
         A.init( Xa, Qa, ipa, p );
         B.init( Xb, Qb, ipb, p );
+        resetState();
+
     setMtx.unlock();
 }
 
@@ -386,8 +402,8 @@ void ColorTTLCtl::scanBlock(
 
     setMtx.lock();
 
-    if( eventsScanningThisStream( X, vClr, ip ) )
-        processEvents( data, headCt, nC, vClr, ip );
+    if( edges && eventsScanningThisStream( X, vClr, ip ) )
+        processEvents( headCt, (int)data.size() / nC, vClr, ip );
 
     setMtx.unlock();
 }
@@ -529,9 +545,46 @@ void ColorTTLCtl::saveSettings() const
 }
 
 
+// Register an edge watch for each enabled color
+// whose stream is currently displayed.
+//
 void ColorTTLCtl::resetState()
 {
-    memset( state, 0, 4*sizeof(int) );
+    for( int i = 0; i < 4; ++i ) {
+
+        if( edges && watch[i] >= 0 )
+            edges->unwatch( watch[i] );
+
+        watch[i]    = -1;
+        lastRise[i] = 0;
+    }
+
+    if( !edges )
+        return;
+
+    for( int i = 0; i < 4; ++i ) {
+
+        const TTLClrEach    &C = set.clr[i];
+
+        if( !C.isOn )
+            continue;
+
+        const Stream    *S = 0;
+
+        if( A.Q && C.stream == (A.ip >= 0 ? QString("imec%1").arg( A.ip ) : "nidq") )
+            S = &A;
+        else if( B.Q && C.stream == (B.ip >= 0 ? QString("imec%1").arg( B.ip ) : "nidq") )
+            S = &B;
+        else
+            continue;
+
+        int chan, bit, thresh;
+
+        if( getChan( chan, bit, thresh, i, S->ip ) )
+            bit = -1;
+
+        watch[i] = edges->watch( S->Q, chan, bit, thresh, set.inarow );
+    }
 }
 
 
@@ -595,252 +648,21 @@ bool ColorTTLCtl::getChan(
 }
 
 
-bool ColorTTLCtl::findRisingEdge(
-    int         &outCt,
-    const short *data,
-    int         ntpts,
-    int         offset,
-    int         nchans,
-    int         chan,
-    qint16      T ) const
-{
-    const short *d      = &data[chan + offset*nchans],
-                *dlim   = &data[chan +  ntpts*nchans];
-    int         nok     = 0;
-
-// -------------------
-// Must start on a low
-// -------------------
-
-    if( *d >= T ) {
-
-        while( (d += nchans) < dlim ) {
-
-            if( *d < T )
-                goto seek_edge;
-        }
-
-        return false;
-    }
-
-// -------------------
-// Seek edge candidate
-// -------------------
-
-seek_edge:
-    while( (d += nchans) < dlim ) {
-
-        if( *d >= T ) {
-
-            // Mark edge start
-            outCt   = (d - &data[chan]) / nchans;
-            nok     = 1;
-
-            if( set.inarow == 1 )
-                return true;
-
-            // Check extended run length
-            while( (d += nchans) < dlim ) {
-
-                if( *d >= T ) {
-
-                    if( ++nok >= set.inarow )
-                        return true;
-                }
-                else
-                    break;
-            }
-        }
-    }
-
-// ----
-// Fail
-// ----
-
-    return false;
-}
-
-
-bool ColorTTLCtl::findBitRisingEdge(
-    int         &outCt,
-    const short *data,
-    int         ntpts,
-    int         offset,
-    int         nchans,
-    int         chan,
-    int         bit ) const
-{
-    const short *d      = &data[chan + offset*nchans],
-                *dlim   = &data[chan +  ntpts*nchans];
-    int         nok     = 0;
-
-// -------------------
-// Must start on a low
-// -------------------
-
-    if( (*d >> bit) & 1 ) {
-
-        while( (d += nchans) < dlim ) {
-
-            if( !((*d >> bit) & 1))
-                goto seek_edge;
-        }
-
-        return false;
-    }
-
-// -------------------
-// Seek edge candidate
-// -------------------
-
-seek_edge:
-    while( (d += nchans) < dlim ) {
-
-        if( (*d >> bit) & 1 ) {
-
-            // Mark edge start
-            outCt   = (d - &data[chan]) / nchans;
-            nok     = 1;
-
-            if( set.inarow == 1 )
-                return true;
-
-            // Check extended run length
-            while( (d += nchans) < dlim ) {
-
-                if( (*d >> bit) & 1 ) {
-
-                    if( ++nok >= set.inarow )
-                        return true;
-                }
-                else
-                    break;
-            }
-        }
-    }
-
-// ----
-// Fail
-// ----
-
-    return false;
-}
-
-
-bool ColorTTLCtl::findFallingEdge(
-    int         &outCt,
-    const short *data,
-    int         ntpts,
-    int         offset,
-    int         nchans,
-    int         chan,
-    qint16      T ) const
-{
-    const short *d      = &data[chan + offset*nchans],
-                *dlim   = &data[chan +  ntpts*nchans];
-    int         nok     = 0;
-
-// -------------------
-// Seek edge candidate
-// -------------------
-
-    while( (d += nchans) < dlim ) {
-
-        if( *d < T ) {
-
-            // Mark edge start
-            outCt   = (d - &data[chan]) / nchans;
-            nok     = 1;
-
-            if( set.inarow == 1 )
-                return true;
-
-            // Check extended run length
-            while( (d += nchans) < dlim ) {
-
-                if( *d < T ) {
-
-                    if( ++nok >= set.inarow )
-                        return true;
-                }
-                else
-                    break;
-            }
-        }
-    }
-
-// ----
-// Fail
-// ----
-
-    return false;
-}
-
-
-bool ColorTTLCtl::findBitFallingEdge(
-    int         &outCt,
-    const short *data,
-    int         ntpts,
-    int         offset,
-    int         nchans,
-    int         chan,
-    int         bit ) const
-{
-    const short *d      = &data[chan + offset*nchans],
-                *dlim   = &data[chan +  ntpts*nchans];
-    int         nok     = 0;
-
-// -------------------
-// Seek edge candidate
-// -------------------
-
-    while( (d += nchans) < dlim ) {
-
-        if( !((*d >> bit) & 1) ) {
-
-            // Mark edge start
-            outCt   = (d - &data[chan]) / nchans;
-            nok     = 1;
-
-            if( set.inarow == 1 )
-                return true;
-
-            // Check extended run length
-            while( (d += nchans) < dlim ) {
-
-                if( !((*d >> bit) & 1) ) {
-
-                    if( ++nok >= set.inarow )
-                        return true;
-                }
-                else
-                    break;
-            }
-        }
-    }
-
-// ----
-// Fail
-// ----
-
-    return false;
-}
-
-
 #define DST_TREL( ct )  (syncDstTAbs( ct, src, dst, p ) - dst->Q->tZero())
 
 
-// On each call whole data block is scanned.
-// The state[] variables bridge action across blocks.
+// Edges are detected by the shared EdgeIndex; here we
+// convert those overlapping this block into paint spans.
+// lastRise[] bridges action across blocks.
 //
 void ColorTTLCtl::processEvents(
-    const vec_i16       &data,
     quint64             headCt,
-    int                 nC,
+    int                 ntpts,
     std::vector<int>    &vClr,
     int                 ip )
 {
-    const int ntpts = (int)data.size() / nC;
+    std::vector<EdgeRec>    vE;
+    quint64                 endCt = headCt + ntpts;
 
     Stream  *src,
             *dst = 0;
@@ -858,72 +680,50 @@ void ColorTTLCtl::processEvents(
 
     for( int i = 0, ni = vClr.size(); i < ni; ++i ) {
 
-        int     clr     = vClr[i],
-                nextCt  = 0,
-                chan, bit, thresh;
-        bool    isAnalog,
-                found;
+        int clr = vClr[i];
 
-        isAnalog = getChan( chan, bit, thresh, clr, ip );
+        if( watch[clr] < 0 )
+            continue;
 
-        while( nextCt < ntpts ) {
+        // Ignore edges preceding first block
 
-            if( !state[clr] ) {
+        if( !lastRise[clr] && headCt )
+            lastRise[clr] = headCt - 1;
 
-                // Low, seeking high
+        edges->getEdges( vE, watch[clr], lastRise[clr], endCt );
 
-                if( isAnalog ) {
-                    found = findRisingEdge(
-                                nextCt, &data[0], ntpts,
-                                nextCt, nC, chan, thresh );
-                }
-                else {
-                    found = findBitRisingEdge(
-                                nextCt, &data[0], ntpts,
-                                nextCt, nC, chan, bit );
-                }
+        for( int ie = 0, ne = vE.size(); ie < ne; ++ie ) {
 
-                if( found ) {
+            const EdgeRec   &E = vE[ie];
 
-                    quint64 ct      = headCt + nextCt;
-                    double  start   = ct / src->Q->sRate();
+            if( E.riseCt > lastRise[clr] ) {
 
-                    state[clr]  = 1;
-                    nextCt     += set.inarow;
+                // New high
 
-                    src->X->spanMtx.lock();
-                    src->X->evQ[clr].push_back(
-                        EvtSpan( start, start + set.minSecs ) );
-                    src->X->spanMtx.unlock();
-
-                    if( dst ) {
-                        start = DST_TREL( ct );
-                        dst->X->spanMtx.lock();
-                        dst->X->evQ[clr].push_back(
-                            EvtSpan( start, start + set.minSecs ) );
-                        dst->X->spanMtx.unlock();
-                    }
-                }
-                else
-                    goto next_clr;
-            }
+                quint64 ct      = E.riseCt;
+                double  start   = ct / src->Q->sRate();
 
-            // high, seeking low
+                lastRise[clr] = ct;
 
-            if( isAnalog ) {
-                found = findFallingEdge(
-                            nextCt, &data[0], ntpts,
-                            nextCt, nC, chan, thresh );
-            }
-            else {
-                found = findBitFallingEdge(
-                            nextCt, &data[0], ntpts,
-                            nextCt, nC, chan, bit );
+                src->X->spanMtx.lock();
+                src->X->evQ[clr].push_back(
+                    EvtSpan( start, start + set.minSecs ) );
+                src->X->spanMtx.unlock();
+
+                if( dst ) {
+                    start = DST_TREL( ct );
+                    dst->X->spanMtx.lock();
+                    dst->X->evQ[clr].push_back(
+                        EvtSpan( start, start + set.minSecs ) );
+                    dst->X->spanMtx.unlock();
+                }
             }
+            else if( E.riseCt < lastRise[clr] )
+                continue;
 
             // always update painting
 
-            quint64 ct  = headCt + (found ? nextCt : ntpts-1);
+            quint64 ct  = (E.fallCt && E.fallCt < endCt ? E.fallCt : endCt - 1);
             double  end = ct / src->Q->sRate();
 
             src->X->spanMtx.lock();
@@ -936,15 +736,7 @@ void ColorTTLCtl::processEvents(
                 dst->X->evQExtendLast( end, set.minSecs, clr );
                 dst->X->spanMtx.unlock();
             }
-
-            if( found ) {
-                nextCt     += set.inarow;
-                state[clr]  = 0;
-            }
-            else
-                goto next_clr;
         }
-next_clr:;
     }
 }
 
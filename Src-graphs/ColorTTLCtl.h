@@ -13,6 +13,7 @@ class ColorTTLDialog;
 }
 
 class HelpButDialog;
+class EdgeIndex;
 class MGraphX;
 
 class QLabel;
@@ -87,7 +88,9 @@ private:
     TTLClrSet           set,
                         uiSet;
     mutable QMutex      setMtx;
-    int                 state[4];   // {0,1}=seek{high,low}
+    EdgeIndex           *edges;
+    quint64             lastRise[4];
+    int                 watch[4];
 
 public:
     ColorTTLCtl( QObject *parent, const DAQ::Params &p );
@@ -99,7 +102,8 @@ public:
         MGraphX     *Xa,
         int         ipb,
         const AIQ   *Qb,
-        MGraphX     *Xb );
+        MGraphX     *Xb,
+        EdgeIndex   *edges );
 
     bool valid( QString &err, bool checkStored = true );
 
@@ -141,46 +145,9 @@ private:
         int     clr,
         int     ip ) const;
 
-    bool findRisingEdge(
-        int         &outCt,
-        const short *data,
-        int         ntpts,
-        int         offset,
-        int         nchans,
-        int         chan,
-        qint16      T ) const;
-
-    bool findBitRisingEdge(
-        int         &outCt,
-        const short *data,
-        int         ntpts,
-        int         offset,
-        int         nchans,
-        int         chan,
-        int         bit ) const;
-
-    bool findFallingEdge(
-        int         &outCt,
-        const short *data,
-        int         ntpts,
-        int         offset,
-        int         nchans,
-        int         chan,
-        qint16      T ) const;
-
-    bool findBitFallingEdge(
-        int         &outCt,
-        const short *data,
-        int         ntpts,
-        int         offset,
-        int         nchans,
-        int         chan,
-        int         bit ) const;
-
     void processEvents(
-        const vec_i16       &data,
         quint64             headCt,
-        int                 nC,
+        int                 ntpts,
         std::vector<int>    &vClr,
         int                 ip );
 };
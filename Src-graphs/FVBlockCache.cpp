@@ -0,0 +1,365 @@
+
+#include "FVBlockCache.h"
+#include "DFZip.h"
+#include "Util.h"
+
+#include <QThread>
+
+#include <string.h>
+
+
+/* ---------------------------------------------------------------- */
+/* FVPrefetchWorker ----------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+FVPrefetchWorker::FVPrefetchWorker(
+    FVBlockCache    *C,
+    const QString   &binName )
+    :   QObject(0), C(C), zr(0), reqB0(0), reqBLim(0), pleaseStop(false)
+{
+    f.setFileName( binName );
+
+    if( C->zipped )
+        zr = C->openZip( binName );
+}
+
+
+FVPrefetchWorker::~FVPrefetchWorker()
+{
+    if( zr )
+        delete zr;
+}
+
+
+// Replaces whatever remains of the previous request.
+//
+void FVPrefetchWorker::request( qint64 b0, qint64 bLim )
+{
+    QMutexLocker    ml( &reqMtx );
+
+    reqB0   = b0;
+    reqBLim = bLim;
+    reqCond.wakeAll();
+}
+
+
+void FVPrefetchWorker::stop()
+{
+    QMutexLocker    ml( &reqMtx );
+
+    pleaseStop = true;
+    reqCond.wakeAll();
+}
+
+
+// Take one block at a time so a new request is seen promptly.
+//
+void FVPrefetchWorker::run()
+{
+    if( f.open( QIODevice::ReadOnly ) ) {
+
+        for(;;) {
+
+            qint64  ib;
+
+            reqMtx.lock();
+
+            while( !pleaseStop && reqB0 >= reqBLim )
+                reqCond.wait( &reqMtx );
+
+            if( pleaseStop ) {
+                reqMtx.unlock();
+                break;
+            }
+
+            ib = reqB0++;
+
+            reqMtx.unlock();
+
+            if( !C->haveBlock( ib ) ) {
+
+                vec_i16 buf;
+
+                if( C->loadBlock( buf, f, zr, ib ) )
+                    C->insertBlock( ib, buf );
+            }
+        }
+
+        f.close();
+    }
+
+    emit finished();
+}
+
+/* ---------------------------------------------------------------- */
+/* FVBlockCache --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Blocks of about 4 MB.
+//
+FVBlockCache::FVBlockCache(
+    const QString   &binName,
+    int             nC,
+    qint64          scanCt,
+    bool            zipped,
+    qint64          maxBytes )
+    :   zr(0), scanCt(scanCt), tick(0), nC(nC), zipped(zipped)
+{
+    blkScans    = qMax( qint64(1024), qint64(4*1024*1024) / (nC*2) );
+    maxBlocks   = qMax( qint64(4), maxBytes / (blkScans*nC*2) );
+
+    f.setFileName( binName );
+    f.open( QIODevice::ReadOnly );
+
+    if( zipped )
+        zr = openZip( binName );
+
+    thread  = new QThread;
+    worker  = new FVPrefetchWorker( this, binName );
+
+    worker->moveToThread( thread );
+
+    Connect( thread, SIGNAL(started()), worker, SLOT(run()) );
+    Connect( worker, SIGNAL(finished()), worker, SLOT(deleteLater()) );
+    Connect( worker, SIGNAL(destroyed()), thread, SLOT(quit()), Qt::DirectConnection );
+
+    thread->start();
+}
+
+
+FVBlockCache::~FVBlockCache()
+{
+// worker object auto-deleted asynchronously
+// thread object manually deleted synchronously (so we can call wait())
+
+    if( thread->isRunning() ) {
+
+        worker->stop();
+        thread->wait();
+    }
+
+    delete thread;
+
+    qDeleteAll( blocks );
+    blocks.clear();
+
+    if( zr )
+        delete zr;
+}
+
+
+void FVBlockCache::setScanCount( qint64 scanCt )
+{
+    QMutexLocker    ml( &blkMtx );
+
+    this->scanCt = scanCt;
+}
+
+
+// Same contract as DataFile::readScans with all channels.
+//
+qint64 FVBlockCache::read( vec_i16 &dst, qint64 scan0, qint64 num2read )
+{
+    qint64  scanCt = scanCount();
+
+    if( scan0 < 0 || scan0 >= scanCt || num2read <= 0 )
+        return -1;
+
+    num2read = qMin( num2read, scanCt - scan0 );
+
+    dst.resize( num2read * nC );
+
+    qint16  *D      = &dst[0];
+    qint64  sLim    = scan0 + num2read,
+            bLim    = (sLim - 1) / blkScans + 1;
+
+    for( qint64 ib = scan0 / blkScans; ib < bLim; ++ib ) {
+
+        qint64  bStart  = ib * blkScans,
+                s0      = qMax( scan0, bStart ) - bStart,
+                s1      = qMin( sLim, bStart + blkScans ) - bStart;
+        int     nCopy   = (s1 - s0) * nC;
+
+        blkMtx.lock();
+
+        QMap<qint64,Block*>::iterator   it = blocks.find( ib );
+
+        if( it != blocks.end()
+            && qint64(it.value()->data.size()) >= s1 * nC ) {
+
+            it.value()->used = ++tick;
+            memcpy( D, &it.value()->data[s0*nC], nCopy*sizeof(qint16) );
+            blkMtx.unlock();
+        }
+        else {
+
+            blkMtx.unlock();
+
+            vec_i16 buf;
+
+            if( !loadBlock( buf, f, zr, ib ) ) {
+                dst.clear();
+                return -1;
+            }
+
+            memcpy( D, &buf[s0*nC], nCopy*sizeof(qint16) );
+            insertBlock( ib, buf );
+        }
+
+        D += nCopy;
+    }
+
+    return num2read;
+}
+
+
+void FVBlockCache::prefetch( qint64 scan0, qint64 nScans )
+{
+    if( scan0 < 0 ) {
+        nScans += scan0;
+        scan0   = 0;
+    }
+
+    nScans = qMin( nScans, scanCount() - scan0 );
+
+    if( nScans <= 0 )
+        return;
+
+    worker->request(
+        scan0 / blkScans,
+        (scan0 + nScans - 1) / blkScans + 1 );
+}
+
+
+// Return 0 if error.
+//
+DFZReader *FVBlockCache::openZip( const QString &binName ) const
+{
+    DFZReader   *Z = new DFZReader;
+    QString     error;
+
+    if( !Z->open( error, binName, 0 ) ) {
+        Error() << "FVBlockCache: " << error;
+        delete Z;
+        Z = 0;
+    }
+
+    return Z;
+}
+
+
+bool FVBlockCache::loadBlock(
+    vec_i16         &dst,
+    QFile           &fsrc,
+    DFZReader       *zsrc,
+    qint64          ib ) const
+{
+    qint64  bStart  = ib * blkScans,
+            n       = qMin( blkScans, scanCount() - bStart ),
+            bytes   = n * nC * sizeof(qint16);
+
+    if( n <= 0 )
+        return false;
+
+    dst.resize( n * nC );
+
+    if( zipped ) {
+
+        if( !zsrc || zsrc->read( &dst[0], bStart, n ) != n ) {
+
+            Error()
+                << "FVBlockCache: Failed decode of block ["
+                << ib
+                << "].";
+
+            dst.clear();
+            return false;
+        }
+
+        return true;
+    }
+
+    if( !fsrc.seek( bStart * nC * sizeof(qint16) )
+        || fsrc.read( (char*)&dst[0], bytes ) != bytes ) {
+
+        Error()
+            << "FVBlockCache: Failed read of block ["
+            << ib
+            << "] msg ["
+            << fsrc.errorString()
+            << "].";
+
+        dst.clear();
+        return false;
+    }
+
+    return true;
+}
+
+
+qint64 FVBlockCache::scanCount() const
+{
+    QMutexLocker    ml( &blkMtx );
+
+    return scanCt;
+}
+
+
+// Only if whole, or the current tail.
+//
+bool FVBlockCache::haveBlock( qint64 ib ) const
+{
+    QMutexLocker    ml( &blkMtx );
+
+    QMap<qint64,Block*>::const_iterator it = blocks.find( ib );
+
+    return it != blocks.end()
+            && qint64(it.value()->data.size())
+                >= qMin( blkScans, scanCt - ib * blkScans ) * nC;
+}
+
+
+// Evict least recently used blocks to make room.
+//
+void FVBlockCache::insertBlock( qint64 ib, vec_i16 &src )
+{
+    QMutexLocker    ml( &blkMtx );
+
+    QMap<qint64,Block*>::iterator   it = blocks.find( ib );
+
+    if( it != blocks.end() ) {
+
+        // Replace a shorter tail block
+
+        if( src.size() > it.value()->data.size() ) {
+            it.value()->data.swap( src );
+            it.value()->used = ++tick;
+        }
+
+        return;
+    }
+
+    while( blocks.size() >= maxBlocks ) {
+
+        QMap<qint64,Block*>::iterator   it  = blocks.begin(),
+                                        lru = it;
+
+        for( ++it; it != blocks.end(); ++it ) {
+
+            if( it.value()->used < lru.value()->used )
+                lru = it;
+        }
+
+        delete lru.value();
+        blocks.erase( lru );
+    }
+
+    Block   *B = new Block;
+
+    B->data.swap( src );
+    B->used = ++tick;
+
+    blocks[ib] = B;
+}
+
+
@@ -0,0 +1,115 @@
+#ifndef FVBLOCKCACHE_H
+#define FVBLOCKCACHE_H
+
+#include "SGLTypes.h"
+
+#include <QFile>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QWaitCondition>
+
+class DFZReader;
+class FVBlockCache;
+class QThread;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+class FVPrefetchWorker : public QObject
+{
+    Q_OBJECT
+
+private:
+    FVBlockCache    *C;
+    QFile           f;
+    DFZReader       *zr;
+    QMutex          reqMtx;
+    QWaitCondition  reqCond;
+    qint64          reqB0,      // block range yet to load
+                    reqBLim;
+    bool            pleaseStop;
+
+public:
+    FVPrefetchWorker( FVBlockCache *C, const QString &binName );
+    virtual ~FVPrefetchWorker();
+
+    void request( qint64 b0, qint64 bLim );
+    void stop();
+
+signals:
+    void finished();
+
+public slots:
+    void run();
+};
+
+
+// Scan-block cache for FileViewerWindow reads of one .bin file.
+//
+// The file is cut into blocks of blkScans whole scans; blocks are
+// keyed by index and kept in LRU order up to maxBytes. read()
+// assembles any scan range from blocks, loading misses from its
+// own file handle. prefetch() asks a background thread, with a
+// second file handle, to load a range before it is needed; a new
+// prefetch request supersedes an unfinished one.
+//
+// A file still being recorded may grow (setScanCount); a short
+// tail block is then reloaded when more of it is wanted.
+//
+// Compressed (sglz1) files are read through a DFZReader per
+// file handle; these keep only a couple of decoded chunks since
+// the blocks here are the cache.
+//
+class FVBlockCache
+{
+    friend class FVPrefetchWorker;
+
+private:
+    struct Block {
+        vec_i16 data;
+        quint64 used;
+    };
+
+    QMap<qint64,Block*> blocks;
+    mutable QMutex      blkMtx;
+    QFile               f;
+    DFZReader           *zr;
+    QThread             *thread;
+    FVPrefetchWorker    *worker;
+    qint64              scanCt,
+                        blkScans,
+                        maxBlocks;
+    quint64             tick;
+    int                 nC;
+    bool                zipped;
+
+public:
+    FVBlockCache(
+        const QString   &binName,
+        int             nC,
+        qint64          scanCt,
+        bool            zipped = false,
+        qint64          maxBytes = 256*1024*1024 );
+    virtual ~FVBlockCache();
+
+    void setScanCount( qint64 scanCt );
+    qint64 read( vec_i16 &dst, qint64 scan0, qint64 num2read );
+    void prefetch( qint64 scan0, qint64 nScans );
+
+private:
+    DFZReader *openZip( const QString &binName ) const;
+    bool loadBlock(
+        vec_i16         &dst,
+        QFile           &fsrc,
+        DFZReader       *zsrc,
+        qint64          ib ) const;
+    qint64 scanCount() const;
+    bool haveBlock( qint64 ib ) const;
+    void insertBlock( qint64 ib, vec_i16 &src );
+};
+
+#endif  // FVBLOCKCACHE_H
+
+
@@ -0,0 +1,799 @@
+
+#include "FVRender.h"
+#include "FVBlockCache.h"
+#include "Biquad.h"
+#include "Util.h"
+
+#include <QRunnable>
+#include <QThread>
+
+#include <string.h>
+
+
+#define V_S_AVE( d_ig )                                         \
+    (sAveLocal ? sAveApplyLocal( d_ig, ig ) : *d_ig)
+
+/* ---------------------------------------------------------------- */
+/* FVRenderTask --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+class FVRenderTask : public QRunnable
+{
+private:
+    FVRenderWorker  *W;
+    int             k;
+    bool            flt;
+public:
+    FVRenderTask( FVRenderWorker *W, int k, bool flt )
+    :   W(W), k(k), flt(flt)    {setAutoDelete( true );}
+    void run()
+        {
+            if( flt )
+                W->filterSlice( k );
+            else
+                W->fillSlice( k );
+        }
+};
+
+/* ---------------------------------------------------------------- */
+/* class DCAve ---------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void FVRenderWorker::DCAve::init( int nChannels, int nNeural )
+{
+    nC  = nChannels;
+    nN  = nNeural;
+    lvl.assign( nN, 0 );
+}
+
+
+void FVRenderWorker::DCAve::updateLvl(
+    FVBlockCache    *cache,
+    qint64          xpos,
+    qint64          nRem,
+    qint64          chunk,
+    int             dwnSmp )
+{
+    if( nN <= 0 )
+        return;
+
+    std::vector<float>  sum( nN, 0.0F );
+
+    int     *L      = &lvl[0];
+    float   *S      = &sum[0];
+    int     dStep   = nC * dwnSmp,
+            nSamp   = 0;
+
+    for(;;) {
+
+        if( nRem <= 0 )
+            break;
+
+        // read this block
+
+        vec_i16 data;
+        qint64  nthis = qMin( chunk, nRem );
+        int     ntpts;
+
+        ntpts = cache->read( data, xpos, nthis );
+
+        if( ntpts <= 0 )
+            break;
+
+        // update counting
+
+        xpos    += ntpts;
+        nRem    -= ntpts;
+        nSamp   += (ntpts + dwnSmp - 1) / dwnSmp;
+
+        // accumulate sums
+
+        const qint16    *d = &data[0];
+
+        for( int it = 0; it < ntpts; it += dwnSmp, d += dStep ) {
+
+            for( int ig = 0; ig < nN; ++ig )
+                S[ig] += d[ig];
+        }
+    }
+
+    if( nSamp ) {
+
+        for( int ig = 0; ig < nN; ++ig )
+            L[ig] = S[ig]/nSamp;
+    }
+}
+
+
+void FVRenderWorker::DCAve::apply(
+    qint16          *d,
+    int             ntpts,
+    int             dwnSmp )
+{
+    if( nN <= 0 )
+        return;
+
+    int *L      = &lvl[0];
+    int dStep   = nC * dwnSmp;
+
+    for( int it = 0; it < ntpts; it += dwnSmp, d += dStep ) {
+
+        for( int ig = 0; ig < nN; ++ig )
+            d[ig] -= L[ig];
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* FVRenderWorker ------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// The worker thread takes slice 0 of each parallel step itself.
+//
+FVRenderWorker::FVRenderWorker( QObject *notify )
+    :   QObject(0), notify(notify), done(0), gen(0),
+        havePend(false), busy(false), pleaseStop(false), O(0)
+{
+    pool.setMaxThreadCount( qMax( 1, QThread::idealThreadCount() - 1 ) );
+}
+
+
+FVRenderWorker::~FVRenderWorker()
+{
+    if( done )
+        delete done;
+}
+
+
+// Replaces a request not yet started; a running one
+// sees superseded() at its next chunk.
+//
+int FVRenderWorker::submit( const FVRenderReq &req )
+{
+    QMutexLocker    ml( &reqMtx );
+
+    pend        = req;
+    havePend    = true;
+    reqCond.wakeAll();
+
+    return ++gen;
+}
+
+
+void FVRenderWorker::cancel()
+{
+    QMutexLocker    ml( &reqMtx );
+
+    havePend = false;
+    ++gen;
+
+    if( done ) {
+        delete done;
+        done = 0;
+    }
+}
+
+
+void FVRenderWorker::waitIdle()
+{
+    QMutexLocker    ml( &reqMtx );
+
+    while( busy )
+        idleCond.wait( &reqMtx );
+}
+
+
+void FVRenderWorker::stop()
+{
+    QMutexLocker    ml( &reqMtx );
+
+    pleaseStop  = true;
+    havePend    = false;
+    ++gen;
+    reqCond.wakeAll();
+}
+
+
+// Caller owns result.
+//
+FVRenderOut *FVRenderWorker::take()
+{
+    QMutexLocker    ml( &reqMtx );
+
+    FVRenderOut *out = done;
+
+    done = 0;
+
+    if( out && out->gen != gen ) {
+        delete out;
+        out = 0;
+    }
+
+    return out;
+}
+
+
+void FVRenderWorker::run()
+{
+    for(;;) {
+
+        reqMtx.lock();
+
+        while( !pleaseStop && !havePend )
+            reqCond.wait( &reqMtx );
+
+        if( pleaseStop ) {
+            reqMtx.unlock();
+            break;
+        }
+
+        R           = pend;
+        havePend    = false;
+        busy        = true;
+
+        O       = new FVRenderOut;
+        O->gen  = gen;
+
+        reqMtx.unlock();
+
+        bool    ok = render();
+
+        reqMtx.lock();
+
+        if( ok && O->gen == gen ) {
+
+            if( done )
+                delete done;
+
+            done    = O;
+            O       = 0;
+        }
+        else {
+            delete O;
+            O  = 0;
+            ok = false;
+        }
+
+        busy = false;
+        idleCond.wakeAll();
+
+        reqMtx.unlock();
+
+        if( ok )
+            QMetaObject::invokeMethod( notify, "renderDone", Qt::QueuedConnection );
+    }
+
+    emit finished();
+}
+
+
+bool FVRenderWorker::superseded()
+{
+    QMutexLocker    ml( &reqMtx );
+
+    return O->gen != gen;
+}
+
+
+// Notes:
+//
+// - User has random access to file data, and if filter is enabled,
+// the first xflt data points of any block would ordinarily show a
+// transient artifact. Therefore, we always load an extra xflt
+// scans, process the larger block, and trim the lead portion off
+// when passing ybuf data to graph.
+//
+// - We treat a long span as several short chunks to limit memory
+// paging. Filter and DC state is retained across chunks, so chunks
+// are done in order; the work within a chunk is split across cores.
+//
+// - A newer request abandons this one between chunks.
+//
+bool FVRenderWorker::render()
+{
+    int nVis = R.iv2ig.size();
+
+    O->iv2ig    = R.iv2ig;
+    O->gtpts    = R.gtpts;
+    O->nFill    = 0;
+    O->y.resize( nVis );
+    O->y2.resize( nVis );
+    O->drawBM.assign( nVis, -1 );
+    O->skip.assign( nVis, 0 );
+
+    for( int iv = 0; iv < nVis; ++iv ) {
+
+        O->y[iv].assign( R.gtpts, 0.0F );
+
+        if( R.binMax )
+            O->y2[iv].assign( R.gtpts, 0.0F );
+    }
+
+    sAveLocal = (R.sAveSel == 1 || R.sAveSel == 2);
+
+    initSlices();
+
+// ----
+// -<T>
+// ----
+
+    // Not applied if hipass filtered.
+    // Reads are cached, so the chunk loop below rereads memory.
+
+    if( R.dcChk && !R.hp300 ) {
+
+        dc.init( R.nG, R.nNeurChans );
+        dc.updateLvl( R.cache, R.xpos, R.ntpts, R.chunk, R.dwnSmp );
+    }
+
+// --------------
+// Process chunks
+// --------------
+
+    qint64  xpos    = R.xpos,
+            nRem    = R.ntpts,
+            chunk   = R.chunk;
+    int     dwnSmp  = R.dwnSmp,
+            dcSmp   = (R.binMax ? R.binMax : dwnSmp);
+    bool    ok      = true;
+
+    xoff = (R.ntpts + dwnSmp - 1) / dwnSmp - R.gtpts;
+
+    for(;;) {
+
+        if( nRem <= 0 )
+            break;
+
+        if( superseded() ) {
+            ok = false;
+            break;
+        }
+
+        // ---------------
+        // Read this block
+        // ---------------
+
+        if( xoff && (chunk + dwnSmp - 1) / dwnSmp <= xoff )
+            chunk = (xoff + 1) * dwnSmp;
+
+        ntpts = R.cache->read( data, xpos, qMin( chunk, nRem ) );
+
+        if( ntpts <= 0 )
+            break;
+
+        dtpts = (ntpts + dwnSmp - 1) / dwnSmp;
+
+        if( dtpts <= xoff )
+            break;
+
+        // update counting
+
+        xpos    += ntpts;
+        nRem    -= ntpts;
+
+        // ------
+        // Hipass
+        // ------
+
+        if( R.hp300 && R.nuLim > R.nuLo )
+            runSlices( fltLim.size() - 1, true );
+
+        // ------------------------------------
+        // -<T>; not applied if hipass filtered
+        // ------------------------------------
+
+        if( R.dcChk && !R.hp300 )
+            dc.apply( &data[0], ntpts, dcSmp );
+
+        // -----------
+        // Global -<S>
+        // -----------
+
+        if( R.sAveSel == 3 ) {
+            sAveApplyGlobal(
+                &data[0], ntpts, R.nG, R.nSpikeChans, dcSmp );
+        }
+        else if( R.sAveSel == 4 ) {
+            sAveApplyGlobalStride(
+                &data[0], ntpts, R.nG, R.nSpikeChans,
+                R.stride, dcSmp );
+        }
+
+        // ----------
+        // Fill grafs
+        // ----------
+
+        runSlices( grfLim.size() - 1, false );
+
+        O->nFill    += dtpts - xoff;
+        xoff        = 0;    // only first chunk includes offset
+    }
+
+    freeSlices();
+
+    return ok;
+}
+
+
+// Filter slices split [nuLo,nuLim) evenly; each has its own
+// Biquad, hence its own state. Graph slices split visible list.
+//
+void FVRenderWorker::initSlices()
+{
+    int nThd    = pool.maxThreadCount() + 1,
+        nFlt    = R.nuLim - R.nuLo,
+        nVis    = R.iv2ig.size(),
+        n;
+
+    fltLim.clear();
+    grfLim.clear();
+
+    if( R.hp300 && nFlt > 0 ) {
+
+        n = qMin( nThd, nFlt );
+
+        for( int k = 0; k <= n; ++k ) {
+
+            fltLim.push_back( R.nuLo + k * nFlt / n );
+
+            if( k < n )
+                hp.push_back( new Biquad( bq_type_highpass, 300.0 / R.srate ) );
+        }
+    }
+
+    n = qMax( 1, qMin( nThd, nVis ) );
+
+    for( int k = 0; k <= n; ++k )
+        grfLim.push_back( k * nVis / n );
+}
+
+
+void FVRenderWorker::freeSlices()
+{
+    for( int k = 0, n = hp.size(); k < n; ++k )
+        delete hp[k];
+
+    hp.clear();
+    data.clear();
+}
+
+
+// Slice 0 is done on this thread.
+//
+void FVRenderWorker::runSlices( int n, bool flt )
+{
+    if( n <= 0 )
+        return;
+
+    for( int k = 1; k < n; ++k )
+        pool.start( new FVRenderTask( this, k, flt ) );
+
+    if( flt )
+        filterSlice( 0 );
+    else
+        fillSlice( 0 );
+
+    if( n > 1 )
+        pool.waitForDone();
+}
+
+
+void FVRenderWorker::filterSlice( int k )
+{
+    hp[k]->applyBlockwiseMem(
+            &data[0], R.maxInt, ntpts, R.nG, fltLim[k], fltLim[k+1] );
+}
+
+
+void FVRenderWorker::fillSlice( int k )
+{
+    std::vector<float>  ybuf( dtpts ),
+                        ybuf2( R.binMax ? dtpts : 0 );
+
+    for( int iv = grfLim[k], lim = grfLim[k+1]; iv < lim; ++iv )
+        fillGraph( ybuf, ybuf2, iv );
+}
+
+
+// Writes this chunk's points for graph iv at O->nFill.
+//
+void FVRenderWorker::fillGraph(
+    std::vector<float>  &ybuf,
+    std::vector<float>  &ybuf2,
+    int                 iv )
+{
+    int     ig      = R.iv2ig[iv],
+            nG      = R.nG,
+            dwnSmp  = R.dwnSmp,
+            binMax  = R.binMax,
+            dstep   = dwnSmp * nG,
+            ny      = 0;
+    float   ysc     = R.ysc;
+    qint16  *d      = &data[ig];
+
+    if( R.usrType[iv] == 0 ) {
+
+        // ---------------
+        // Neural channels
+        // ---------------
+
+        // ---------------
+        // Skip references
+        // ---------------
+
+        if( R.hasSM && !R.SM.e[ig].u ) {
+            O->skip[iv] = 1;
+            return;
+        }
+
+        // -------------------
+        // Neural downsampling
+        // -------------------
+
+        // Within each bin, report both max and min
+        // values. This ensures spikes aren't missed.
+        // Max in ybuf, min in ybuf2.
+
+        if( binMax ) {
+
+            int ndRem = ntpts;
+
+            O->drawBM[iv] = 1;
+
+            for(
+                int it = 0;
+                it < ntpts;
+                it += dwnSmp, d = &data[ig + it*nG] ) {
+
+                int val     = V_S_AVE( d ),
+                    vmax    = val,
+                    vmin    = val,
+                    binWid  = dwnSmp;
+
+                d += binMax*nG;
+
+                if( ndRem < binWid )
+                    binWid = ndRem;
+
+                for(
+                    int ib = binMax;
+                    ib < binWid;
+                    ib += binMax, d += binMax*nG ) {
+
+                    val = V_S_AVE( d );
+
+                    if( val > vmax )
+                        vmax = val;
+                    else if( val < vmin )
+                        vmin = val;
+                }
+
+                ndRem -= binWid;
+
+                ybuf[ny]  = vmax * ysc;
+                ybuf2[ny] = vmin * ysc;
+                ++ny;
+            }
+
+            memcpy( &O->y2[iv][O->nFill], &ybuf2[xoff],
+                (dtpts - xoff) * sizeof(float) );
+        }
+        else if( sAveLocal ) {
+
+            O->drawBM[iv] = 0;
+
+            for( int it = 0; it < ntpts; it += dwnSmp, d += dstep )
+                ybuf[ny++] = sAveApplyLocal( d, ig ) * ysc;
+        }
+        else {
+            O->drawBM[iv] = 0;
+            goto draw_analog;
+        }
+    }
+    else if( R.usrType[iv] == 1 ) {
+
+        // -----------------
+        // Analog: LF or Aux
+        // -----------------
+
+draw_analog:
+        for( int it = 0; it < ntpts; it += dwnSmp, d += dstep )
+            ybuf[ny++] = *d * ysc;
+    }
+    else {
+
+        // -------
+        // Digital
+        // -------
+
+        for( int it = 0; it < ntpts; it += dwnSmp, d += dstep )
+            ybuf[ny++] = *d;
+    }
+
+    // -------------
+    // Copy to graph
+    // -------------
+
+    memcpy( &O->y[iv][O->nFill], &ybuf[xoff],
+        (dtpts - xoff) * sizeof(float) );
+}
+
+
+// Space averaging for value: d_ig = &data[ig].
+//
+int FVRenderWorker::sAveApplyLocal( const qint16 *d_ig, int ig )
+{
+    const std::vector<int>  &V = R.TSM[ig];
+
+    int nv = V.size();
+
+    if( nv ) {
+
+        const qint16    *d  = d_ig - ig;
+        const int       *v  = &V[0];
+        int             sum = 0;
+
+        for( int iv = 0; iv < nv; ++iv )
+            sum += d[v[iv]];
+
+        return *d_ig - sum/nv;
+    }
+
+    return *d_ig;
+}
+
+
+// Space averaging for all values.
+//
+void FVRenderWorker::sAveApplyGlobal(
+    qint16  *d,
+    int     ntpts,
+    int     nC,
+    int     nAP,
+    int     dwnSmp )
+{
+    if( nAP <= 0 || !R.hasSM )
+        return;
+
+    const ShankMapDesc  *E = &R.SM.e[0];
+
+    int                 ns      = R.SM.ns,
+                        dStep   = nC * dwnSmp;
+    std::vector<int>    _A( ns ),
+                        _N( ns );
+    std::vector<float>  _S( ns );
+    int                 *A  = &_A[0],
+                        *N  = &_N[0];
+    float               *S  = &_S[0];
+
+    for( int it = 0; it < ntpts; it += dwnSmp, d += dStep ) {
+
+        for( int is = 0; is < ns; ++is ) {
+            S[is] = 0;
+            N[is] = 0;
+            A[is] = 0;
+        }
+
+        for( int ig = 0; ig < nAP; ++ig ) {
+
+            const ShankMapDesc  *e = &E[ig];
+
+            if( e->u ) {
+                S[e->s] += d[ig];
+                ++N[e->s];
+            }
+        }
+
+        for( int is = 0; is < ns; ++is ) {
+
+            if( N[is] )
+                A[is] = S[is] / N[is];
+        }
+
+        for( int ig = 0; ig < nAP; ++ig )
+            d[ig] -= A[E[ig].s];
+    }
+}
+
+
+// Space averaging for all values.
+//
+void FVRenderWorker::sAveApplyGlobalStride(
+    qint16  *d,
+    int     ntpts,
+    int     nC,
+    int     nAP,
+    int     stride,
+    int     dwnSmp )
+{
+    if( nAP <= 0 || !R.hasSM )
+        return;
+
+    nAP = R.ig2ic[nAP-1];   // highest acquired channel saved
+
+    const ShankMapDesc  *E = &R.SM.e[0];
+
+    int                 ns      = R.SM.ns,
+                        dStep   = nC * dwnSmp;
+    std::vector<int>    _A( ns ),
+                        _N( ns );
+    std::vector<float>  _S( ns );
+    int                 *A  = &_A[0],
+                        *N  = &_N[0];
+    float               *S  = &_S[0];
+
+    for( int it = 0; it < ntpts; it += dwnSmp, d += dStep ) {
+
+        for( int ic0 = 0; ic0 < stride; ++ic0 ) {
+
+            for( int is = 0; is < ns; ++is ) {
+                S[is] = 0;
+                N[is] = 0;
+                A[is] = 0;
+            }
+
+            for( int ic = ic0; ic <= nAP; ic += stride ) {
+
+                int ig = R.ic2ig[ic];
+
+                if( ig >= 0 ) {
+
+                    const ShankMapDesc  *e = &E[ig];
+
+                    if( e->u ) {
+                        S[e->s] += d[ig];
+                        ++N[e->s];
+                    }
+                }
+            }
+
+            for( int is = 0; is < ns; ++is ) {
+
+                if( N[is] )
+                    A[is] = S[is] / N[is];
+            }
+
+            for( int ic = ic0; ic <= nAP; ic += stride ) {
+
+                int ig = R.ic2ig[ic];
+
+                if( ig >= 0 )
+                    d[ig] -= A[E[ig].s];
+            }
+        }
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* FVRender ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+FVRender::FVRender( QObject *notify )
+{
+    thread  = new QThread;
+    worker  = new FVRenderWorker( notify );
+
+    worker->moveToThread( thread );
+
+    Connect( thread, SIGNAL(started()), worker, SLOT(run()) );
+    Connect( worker, SIGNAL(finished()), worker, SLOT(deleteLater()) );
+    Connect( worker, SIGNAL(destroyed()), thread, SLOT(quit()), Qt::DirectConnection );
+
+    thread->start();
+}
+
+
+FVRender::~FVRender()
+{
+// worker object auto-deleted asynchronously
+// thread object manually deleted synchronously (so we can call wait())
+
+    if( thread->isRunning() ) {
+
+        worker->stop();
+        thread->wait();
+    }
+
+    delete thread;
+}
+
+
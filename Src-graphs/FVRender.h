@@ -0,0 +1,203 @@
+#ifndef FVRENDER_H
+#define FVRENDER_H
+
+#include "SGLTypes.h"
+#include "ShankMap.h"
+
+#include <QMutex>
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <vector>
+
+class FVBlockCache;
+class Biquad;
+class QThread;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Everything one FileViewerWindow redraw needs, copied on the
+// GUI thread so the window can change while the job runs.
+//
+struct FVRenderReq {
+    ShankMap                        SM;
+    std::vector<std::vector<int> >  TSM;        // local -<S> annuli
+    QVector<uint>                   iv2ig;      // visible graphs
+    QVector<int>                    ig2ic,
+                                    ic2ig;
+    std::vector<int>                usrType;    // per iv
+    FVBlockCache                    *cache;
+    qint64                          xpos,       // first scan read
+                                    ntpts,      // scans to read
+                                    gtpts;      // graph points
+    float                           ysc;
+    int                             xflt,       // lead trimmed
+                                    dwnSmp,
+                                    binMax,
+                                    chunk,
+                                    nG,
+                                    nSpikeChans,
+                                    nNeurChans,
+                                    nuLo,       // hipass range
+                                    nuLim,
+                                    maxInt,
+                                    stride,
+                                    sAveSel;
+    double                          srate;
+    bool                            hasSM,
+                                    hp300,
+                                    dcChk;
+
+    FVRenderReq() : cache(0)    {}
+};
+
+
+// Ready-to-draw y-values per visible graph, nFill of gtpts.
+// drawBM[iv]: {-1=leave as is, 0=off, 1=on}.
+// skip[iv] set for references (left zero-filled).
+//
+struct FVRenderOut {
+    QVector<uint>                       iv2ig;
+    std::vector<std::vector<float> >    y,
+                                        y2;     // binMax mins
+    std::vector<char>                   drawBM,
+                                        skip;
+    qint64                              gtpts,
+                                        nFill;
+    int                                 gen;
+};
+
+
+class FVRenderWorker : public QObject
+{
+    Q_OBJECT
+
+    friend class FVRenderTask;
+
+private:
+    // -<T> levels over the whole span
+    class DCAve {
+    private:
+        int                 nC,
+                            nN;
+    public:
+        std::vector<int>    lvl;
+    public:
+        void init( int nChannels, int nNeural );
+        void updateLvl(
+            FVBlockCache    *cache,
+            qint64          xpos,
+            qint64          nRem,
+            qint64          chunk,
+            int             dwnSmp );
+        void apply(
+            qint16          *d,
+            int             ntpts,
+            int             dwnSmp );
+    };
+
+    QObject                 *notify;
+    QThreadPool             pool;
+    QMutex                  reqMtx;
+    QWaitCondition          reqCond,
+                            idleCond;
+    FVRenderReq             pend;
+    FVRenderOut             *done;
+    int                     gen;        // latest submitted
+    bool                    havePend,
+                            busy,
+                            pleaseStop;
+
+// Current job
+
+    FVRenderReq             R;
+    FVRenderOut             *O;
+    DCAve                   dc;
+    std::vector<Biquad*>    hp;         // one per filter slice
+    std::vector<int>        fltLim,     // slice k: [lim[k],lim[k+1])
+                            grfLim;
+    vec_i16                 data;
+    qint64                  ntpts,      // this chunk
+                            dtpts,
+                            xoff;
+    bool                    sAveLocal;
+
+public:
+    FVRenderWorker( QObject *notify );
+    virtual ~FVRenderWorker();
+
+    int submit( const FVRenderReq &req );
+    void cancel();
+    void waitIdle();
+    void stop();
+    FVRenderOut *take();
+
+signals:
+    void finished();
+
+public slots:
+    void run();
+
+private:
+    bool superseded();
+    bool render();
+    void initSlices();
+    void freeSlices();
+    void runSlices( int n, bool flt );
+    void filterSlice( int k );
+    void fillSlice( int k );
+    void fillGraph(
+        std::vector<float>  &ybuf,
+        std::vector<float>  &ybuf2,
+        int                 iv );
+    int sAveApplyLocal( const qint16 *d_ig, int ig );
+    void sAveApplyGlobal(
+        qint16  *d,
+        int     ntpts,
+        int     nC,
+        int     nAP,
+        int     dwnSmp );
+    void sAveApplyGlobalStride(
+        qint16  *d,
+        int     ntpts,
+        int     nC,
+        int     nAP,
+        int     stride,
+        int     dwnSmp );
+};
+
+
+// Background renderer for one FileViewerWindow.
+//
+// submit() queues a request, replacing any not yet started; a job
+// in progress stops at its next chunk when superseded. When a job
+// completes, notify's renderDone() slot is invoked (queued) and
+// take() hands over the result if it is still the latest. Call
+// cancelWait() before deleting anything a request points to.
+//
+// Within a job, chunks are processed in order (filter state runs
+// forward in time); each chunk's hipass and graph filling are
+// split across a private thread pool by channel and by graph.
+//
+class FVRender
+{
+private:
+    QThread         *thread;
+    FVRenderWorker  *worker;
+
+public:
+    FVRender( QObject *notify );
+    virtual ~FVRender();
+
+    int submit( const FVRenderReq &req )    {return worker->submit( req );}
+    void cancelWait()                       {worker->cancel(); worker->waitIdle();}
+    FVRenderOut *take()                     {return worker->take();}
+};
+
+#endif  // FVRENDER_H
+
+
@@ -16,7 +16,10 @@
 #include "DataFileIMAP.h"
 #include "DataFileIMLF.h"
 #include "DataFileNI.h"
+#include "DFEdges.h"
 #include "DFName.h"
+#include "FVBlockCache.h"
+#include "FVRender.h"
 #include "MGraph.h"
 #include "Biquad.h"
 #include "ExportCtl.h"
@@ -58,94 +61,6 @@ public:
     int tag() const         {return mtag;}
 };
 
-/* ---------------------------------------------------------------- */
-/* class DCAve ---------------------------------------------------- */
-/* ---------------------------------------------------------------- */
-
-void FileViewerWindow::DCAve::init( int nChannels, int nNeural )
-{
-    nC  = nChannels;
-    nN  = nNeural;
-    lvl.assign( nN, 0 );
-}
-
-
-void FileViewerWindow::DCAve::updateLvl(
-    const DataFile  *df,
-    qint64          xpos,
-    qint64          nRem,
-    qint64          chunk,
-    int             dwnSmp )
-{
-    if( nN <= 0 )
-        return;
-
-    std::vector<float>  sum( nN, 0.0F );
-
-    int     *L      = &lvl[0];
-    float   *S      = &sum[0];
-    int     dStep   = nC * dwnSmp,
-            nSamp   = 0;
-
-    for(;;) {
-
-        if( nRem <= 0 )
-            break;
-
-        // read this block
-
-        vec_i16 data;
-        qint64  nthis = qMin( chunk, nRem );
-        int     ntpts;
-
-        ntpts = df->readScans( data, xpos, nthis, QBitArray() );
-
-        if( ntpts <= 0 )
-            break;
-
-        // update counting
-
-        xpos    += ntpts;
-        nRem    -= ntpts;
-        nSamp   += (ntpts + dwnSmp - 1) / dwnSmp;
-
-        // accumulate sums
-
-        const qint16    *d = &data[0];
-
-        for( int it = 0; it < ntpts; it += dwnSmp, d += dStep ) {
-
-            for( int ig = 0; ig < nN; ++ig )
-                S[ig] += d[ig];
-        }
-    }
-
-    if( nSamp ) {
-
-        for( int ig = 0; ig < nN; ++ig )
-            L[ig] = S[ig]/nSamp;
-    }
-}
-
-
-void FileViewerWindow::DCAve::apply(
-    qint16          *d,
-    int             ntpts,
-    int             dwnSmp )
-{
-    if( nN <= 0 )
-        return;
-
-    int *L      = &lvl[0];
-    int dStep   = nC * dwnSmp;
-
-    for( int it = 0; it < ntpts; it += dwnSmp, d += dStep ) {
-
-        for( int ig = 0; ig < nN; ++ig )
-            d[ig] -= L[ig];
-    }
-}
-
 /* ---------------------------------------------------------------- */
 /* Statics -------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -164,10 +79,13 @@ static bool     _linkManUpdt, _linkCanDraw = true;
 
 FileViewerWindow::FileViewerWindow()
     :   QMainWindow(0), tMouseOver(-1.0), yMouseOver(-1.0),
-        df(0), shankMap(0), chanMap(0), hipass(0),
+        lastPos(0), df(0), edx(0), cache(0), renderer(0),
+        shankMap(0), chanMap(0),
         igSelected(-1), igMaximized(-1), igMouseOver(-1),
         didLayout(false), selDrag(false), zoomDrag(false)
 {
+    renderer = new FVRender( this );
+
     initDataIndepStuff();
 
     setAttribute( Qt::WA_DeleteOnClose, false );
@@ -177,17 +95,23 @@ FileViewerWindow::FileViewerWindow()
 
 FileViewerWindow::~FileViewerWindow()
 {
+    if( renderer )
+        delete renderer;
+
+    if( cache )
+        delete cache;
+
     if( df )
         delete df;
 
+    if( edx )
+        delete edx;
+
     if( shankMap )
         delete shankMap;
 
     if( chanMap )
         delete chanMap;
-
-    if( hipass )
-        delete hipass;
 }
 
 
@@ -219,7 +143,6 @@ bool FileViewerWindow::viewFile( const QString &fname, QString *errMsg )
     addToolBar( tbar = new FVToolbar( this, fType ) );
     scanGrp->setRanges( true );
     scanGrp->enableManualUpdate( sav.all.manualUpdate );
-    initHipass();
 
 // --------------------------
 // Manage previous array data
@@ -1185,6 +1108,18 @@ void FileViewerWindow::shankmap_Restore()
     }
 }
 
+
+void FileViewerWindow::edges_Next()
+{
+    edgesGoTo( true );
+}
+
+
+void FileViewerWindow::edges_Prev()
+{
+    edgesGoTo( false );
+}
+
 /* ---------------------------------------------------------------- */
 /* Mouse ---------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -1469,6 +1404,52 @@ void FileViewerWindow::layoutGraphs()
     updateGraphs();
 }
 
+
+// Tail-follow a file still being recorded: if the view reached
+// the old end, it moves to the new end; else just redraw, since
+// the view may extend past the old end.
+//
+void FileViewerWindow::followTimeout()
+{
+    if( !df || !df->isFollowing() ) {
+        followTimer->stop();
+        return;
+    }
+
+    bool    atEnd = scanGrp->curPos() >= scanGrp->maxPos();
+
+    if( df->followGrowth() ) {
+
+        dfCount = df->scanCount();
+        cache->setScanCount( dfCount );
+        scanGrp->setRanges( false );
+
+        if( atEnd )
+            scanGrp->guiSetPos( scanGrp->maxPos() );
+        else
+            updateGraphs();
+    }
+
+    if( !df->isFollowing() ) {
+
+        followTimer->stop();
+
+        // Edge index is complete now
+
+        if( !edx ) {
+
+            edx = new DFEdges;
+
+            if( !edx->openForRead( df ) ) {
+                delete edx;
+                edx = 0;
+            }
+        }
+    }
+
+    updateTitle();
+}
+
 /* ---------------------------------------------------------------- */
 /* Stream linking ------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -1645,6 +1626,18 @@ void FileViewerWindow::initContextMenu()
     A->setSeparator( true );
     theM->addAction( A );
 
+    A = new QAction( "Digital: Next Event This Word", this );
+    ConnectUI( A, SIGNAL(triggered()), this, SLOT(edges_Next()) );
+    theM->addAction( A );
+
+    A = new QAction( "Digital: Prev Event This Word", this );
+    ConnectUI( A, SIGNAL(triggered()), this, SLOT(edges_Prev()) );
+    theM->addAction( A );
+
+    A = new QAction( this );
+    A->setSeparator( true );
+    theM->addAction( A );
+
     A = new QAction( "Export...", this );
     ConnectUI( A, SIGNAL(triggered()), this, SLOT(file_Export()) );
     theM->addAction( A );
@@ -1720,6 +1713,12 @@ void FileViewerWindow::initDataIndepStuff()
     initCloseLbl();
 
     exportCtl = new ExportCtl( this );
+
+// Polls a file still being recorded
+
+    followTimer = new QTimer( this );
+    followTimer->setInterval( 1000 );
+    ConnectUI( followTimer, SIGNAL(timeout()), this, SLOT(followTimeout()) );
 }
 
 /* ---------------------------------------------------------------- */
@@ -1748,6 +1747,13 @@ bool FileViewerWindow::openFile( const QString &fname, QString *errMsg )
 // Create new file of correct type/IP
 // ----------------------------------
 
+    renderer->cancelWait();
+
+    if( cache ) {
+        delete cache;
+        cache = 0;
+    }
+
     if( df )
         delete df;
 
@@ -1761,7 +1767,7 @@ bool FileViewerWindow::openFile( const QString &fname, QString *errMsg )
 // Open and read key data items
 // ----------------------------
 
-    if( !df->openForRead( fname, error ) ) {
+    if( !df->openForRead( fname, error, true ) ) {
 
         if( errMsg )
             *errMsg = error;
@@ -1781,6 +1787,11 @@ bool FileViewerWindow::openFile( const QString &fname, QString *errMsg )
         return false;
     }
 
+    cache   = new FVBlockCache(
+                df->binFileName(), df->numChans(),
+                dfCount, df->isCompressed() );
+    lastPos = 0;
+
     if( shankMap )
         delete shankMap;
 
@@ -1803,17 +1814,26 @@ bool FileViewerWindow::openFile( const QString &fname, QString *errMsg )
         return false;
     }
 
-    double  srate   = df->samplingRateHz(),
-            t0      = df->firstCt() / srate,
-            dt      = dfCount / srate;
+// Digital-event index, if recorded
 
-    setWindowTitle(
-        QString(APPNAME " File Viewer: %1 [%2 chans @ %3 Hz] (t0, dt)=(%4, %5)")
-        .arg( fname_no_path )
-        .arg( df->numChans() )
-        .arg( srate )
-        .arg( t0, 0, 'f', 3 )
-        .arg( dt, 0, 'f', 3 ) );
+    if( edx )
+        delete edx;
+
+    edx = new DFEdges;
+
+    if( !edx->openForRead( df ) ) {
+        delete edx;
+        edx = 0;
+    }
+
+// Still recording?
+
+    if( df->isFollowing() )
+        followTimer->start();
+    else
+        followTimer->stop();
+
+    updateTitle();
 
     mainApp()->modelessOpened( this );
     linkAddMe( fname );
@@ -1822,13 +1842,20 @@ bool FileViewerWindow::openFile( const QString &fname, QString *errMsg )
 }
 
 
-void FileViewerWindow::initHipass()
+void FileViewerWindow::updateTitle()
 {
-    if( hipass )
-        delete hipass;
+    double  srate   = df->samplingRateHz(),
+            t0      = df->firstCt() / srate,
+            dt      = dfCount / srate;
 
-    hipass =
-    new Biquad( bq_type_highpass, 300.0 / df->samplingRateHz() );
+    setWindowTitle(
+        QString(APPNAME " File Viewer: %1 [%2 chans @ %3 Hz] (t0, dt)=(%4, %5)%6")
+        .arg( QFileInfo( df->binFileName() ).fileName() )
+        .arg( df->numChans() )
+        .arg( srate )
+        .arg( t0, 0, 'f', 3 )
+        .arg( dt, 0, 'f', 3 )
+        .arg( df->isFollowing() ? " RECORDING" : "" ) );
 }
 
 
@@ -2274,6 +2301,37 @@ void FileViewerWindow::toggleMaximized()
 }
 
 
+// Scroll so that next (or previous) change of the digital
+// word under the mouse lies a quarter-page from the left.
+// Requires the word's edge index (.edges sidecar).
+//
+void FileViewerWindow::edgesGoTo( bool next )
+{
+    if( !edx || igMouseOver < 0 )
+        return;
+
+    int ic = ig2ic[igMouseOver];
+
+    if( !edx->isIndexed( ic ) ) {
+        statusBar()->showMessage( "No event index for this channel.", 2000 );
+        return;
+    }
+
+    qint64  marg    = nScansPerGraph() / 4,
+            ref     = scanGrp->curPos() + marg,
+            ct      = (next ?
+                        edx->nextChange( ic, ref ) :
+                        edx->prevChange( ic, ref ));
+
+    if( ct < 0 ) {
+        statusBar()->showMessage( "No more events.", 2000 );
+        return;
+    }
+
+    scanGrp->guiSetPos( qMax( 0LL, ct - marg ) );
+}
+
+
 // For each channel [0,nSpikeChan), calculate an 8-way
 // neighborhood of indices into a timepoint's channels.
 // - Annulus with {inner, outer} radii {self, 2} or {2, 8}.
@@ -2371,152 +2429,6 @@ void FileViewerWindow::sAveTable( int sel )
 }
 
 
-// Space averaging for value: d_ig = &data[ig].
-//
-int FileViewerWindow::sAveApplyLocal( const qint16 *d_ig, int ig )
-{
-    const std::vector<int>  &V = TSM[ig];
-
-    int nv = V.size();
-
-    if( nv ) {
-
-        const qint16    *d  = d_ig - ig;
-        const int       *v  = &V[0];
-        int             sum = 0;
-
-        for( int iv = 0; iv < nv; ++iv )
-            sum += d[v[iv]];
-
-        return *d_ig - sum/nv;
-    }
-
-    return *d_ig;
-}
-
-
-// Space averaging for all values.
-//
-void FileViewerWindow::sAveApplyGlobal(
-    qint16  *d,
-    int     ntpts,
-    int     nC,
-    int     nAP,
-    int     dwnSmp )
-{
-    if( nAP <= 0 )
-        return;
-
-    const ShankMapDesc  *E = &shankMap->e[0];
-
-    int                 ns      = shankMap->ns,
-                        dStep   = nC * dwnSmp;
-    std::vector<int>    _A( ns ),
-                        _N( ns );
-    std::vector<float>  _S( ns );
-    int                 *A  = &_A[0],
-                        *N  = &_N[0];
-    float               *S  = &_S[0];
-
-    for( int it = 0; it < ntpts; it += dwnSmp, d += dStep ) {
-
-        for( int is = 0; is < ns; ++is ) {
-            S[is] = 0;
-            N[is] = 0;
-            A[is] = 0;
-        }
-
-        for( int ig = 0; ig < nAP; ++ig ) {
-
-            const ShankMapDesc  *e = &E[ig];
-
-            if( e->u ) {
-                S[e->s] += d[ig];
-                ++N[e->s];
-            }
-        }
-
-        for( int is = 0; is < ns; ++is ) {
-
-            if( N[is] )
-                A[is] = S[is] / N[is];
-        }
-
-        for( int ig = 0; ig < nAP; ++ig )
-            d[ig] -= A[E[ig].s];
-    }
-}
-
-
-// Space averaging for all values.
-//
-void FileViewerWindow::sAveApplyGlobalStride(
-    qint16  *d,
-    int     ntpts,
-    int     nC,
-    int     nAP,
-    int     stride,
-    int     dwnSmp )
-{
-    if( nAP <= 0 )
-        return;
-
-    nAP = ig2ic[nAP-1];    // highest acquired channel saved
-
-    const ShankMapDesc  *E = &shankMap->e[0];
-
-    int                 ns      = shankMap->ns,
-                        dStep   = nC * dwnSmp;
-    std::vector<int>    _A( ns ),
-                        _N( ns );
-    std::vector<float>  _S( ns );
-    int                 *A  = &_A[0],
-                        *N  = &_N[0];
-    float               *S  = &_S[0];
-
-    for( int it = 0; it < ntpts; it += dwnSmp, d += dStep ) {
-
-        for( int ic0 = 0; ic0 < stride; ++ic0 ) {
-
-            for( int is = 0; is < ns; ++is ) {
-                S[is] = 0;
-                N[is] = 0;
-                A[is] = 0;
-            }
-
-            for( int ic = ic0; ic <= nAP; ic += stride ) {
-
-                int ig = ic2ig[ic];
-
-                if( ig >= 0 ) {
-
-                    const ShankMapDesc  *e = &E[ig];
-
-                    if( e->u ) {
-                        S[e->s] += d[ig];
-                        ++N[e->s];
-                    }
-                }
-            }
-
-            for( int is = 0; is < ns; ++is ) {
-
-                if( N[is] )
-                    A[is] = S[is] / N[is];
-            }
-
-            for( int ic = ic0; ic <= nAP; ic += stride ) {
-
-                int ig = ic2ig[ic];
-
-                if( ig >= 0 )
-                    d[ig] -= A[E[ig].s];
-            }
-        }
-    }
-}
-
-
 void FileViewerWindow::updateXSel()
 {
     MGraphX *theX = mscroll->theX;
@@ -2563,25 +2475,10 @@ void FileViewerWindow::zoomTime()
 #define MAX10BIT    512
 #define MAX16BIT    32768
 
-#define V_S_AVE( d_ig )                                         \
-    (sAveLocal ? sAveApplyLocal( d_ig, ig ) : *d_ig)
-
-
-// Notes:
-//
-// - User has random access to file data, and if filter is enabled,
-// the first xflt data points of any block would ordinarily show a
-// transient artifact. Therefore, we will always load an extra xflt
-// scans, process the larger block, and trim the lead portion off
-// when passing ybuf data to graph.
-//
-// - The code is simpler if we load a timespan, then process the
-// data channel-by-channel. That is, we go over all the timepoints
-// again and again. However, if the span is large this causes lots
-// of memory paging and that's very slow.
-//
-// - Rather, we treat a long span as several short chunks. We have to
-// retain state data for filters and DC calcs across chunks.
+// Data preparation runs on the FVRender job (see notes there);
+// here we snapshot what it needs and submit. A new submission
+// supersedes an unfinished one, so rapid scrolling and zooming
+// only pay for the last view. renderDone() swaps the result in.
 //
 void FileViewerWindow::updateGraphs()
 {
@@ -2592,66 +2489,57 @@ void FileViewerWindow::updateGraphs()
 // Channel setup
 // -------------
 
-    float   ysc,
-            srate   = df->samplingRateHz();
-    int     maxInt  = (fType < 2 ? MAX10BIT : MAX16BIT),
-            stride  = (fType < 2 ? 24 : df->getParam("niMuxFactor").toInt()),
-            nG      = df->numChans(),
-            nVis    = grfVisBits.count( true );
+    FVRenderReq R;
 
-    ysc = 1.0F / maxInt;
+    R.srate     = df->samplingRateHz();
+    R.maxInt    = (fType < 2 ? MAX10BIT : MAX16BIT);
+    R.stride    = (fType < 2 ? 24 : df->getParam("niMuxFactor").toInt());
+    R.nG        = df->numChans();
+    R.ysc       = 1.0F / R.maxInt;
 
-    QVector<uint>   iv2ig;
+    Subset::bits2Vec( R.iv2ig, grfVisBits );
 
-    Subset::bits2Vec( iv2ig, grfVisBits );
+    int nVis = R.iv2ig.size();
 
 // -----------
 // Scans setup
 // -----------
 
     qint64  pos         = scanGrp->curPos(),
-            xpos, num2Read;
-    int     xflt,
-            dwnSmp,
-            binMax;
-    bool    sAveLocal   = false;
-
-    if( tbGet300HzOn() )
-        xflt = qMin( (qint64)BIQUAD_TRANS_WIDE, pos );
+            num2Read;
+
+    R.hp300     = tbGet300HzOn();
+    R.dcChk     = tbGetDCChkOn();
+
+    if( R.hp300 )
+        R.xflt = qMin( (qint64)BIQUAD_TRANS_WIDE, pos );
     else
-        xflt = 0;
+        R.xflt = 0;
 
-    xpos        = pos - xflt;
-    num2Read    = xflt + sav.all.xSpan * srate;
-    dwnSmp      = num2Read / (2 * mscroll->viewport()->width());
+    R.xpos      = pos - R.xflt;
+    num2Read    = R.xflt + sav.all.xSpan * R.srate;
+    R.dwnSmp    = num2Read / (2 * mscroll->viewport()->width());
 
 // Note: dwnSmp oversamples by 2X.
 
-    if( dwnSmp < 1 )
-        dwnSmp = 1;
+    if( R.dwnSmp < 1 )
+        R.dwnSmp = 1;
 
-    binMax = (dwnSmp > 1 ? tbGetBinMax() : 0);
+    R.binMax = (R.dwnSmp > 1 ? tbGetBinMax() : 0);
 
 // -----------
 // Size graphs
 // -----------
 
-    if( xpos >= dfCount )
+    if( R.xpos >= dfCount )
         return;
 
-    qint64  ntpts   = qMin( num2Read, dfCount - xpos ),
-            dtpts   = (ntpts + dwnSmp - 1) / dwnSmp,
-            gtpts   = (ntpts - xflt + dwnSmp - 1) / dwnSmp,
-            xoff    = dtpts - gtpts;
+    R.ntpts = qMin( num2Read, dfCount - R.xpos );
+    R.gtpts = (R.ntpts - R.xflt + R.dwnSmp - 1) / R.dwnSmp;
 
-    if( gtpts <= 0 )
+    if( R.gtpts <= 0 )
         return;
 
-    for( int iv = 0; iv < nVis; ++iv )
-        grfY[iv2ig[iv]].resize( gtpts );
-
-    mscroll->theX->initVerts( gtpts );
-
 // -----------------
 // Pick a chunk size
 // -----------------
@@ -2660,228 +2548,130 @@ void FileViewerWindow::updateGraphs()
 // Smaller chunks reduce memory thrashing, but at the penalty
 // of more indexing.
 
-    qint64  chunk =
-            qMax( 1, int((tbGet300HzOn() ? 0.05 : 0.02)*srate/dwnSmp) )
-            * dwnSmp;
+    R.chunk =
+        qMax( 1, int((R.hp300 ? 0.05 : 0.02)*R.srate/R.dwnSmp) )
+        * R.dwnSmp;
 
 // ------------
 // Filter setup
 // ------------
 
-    hipass->clearMem();
-
-    // -<T>; not applied if hipass filtered
+    // Hipass only neural channels that are visible, or are in
+    // a visible channel's local -<S> annulus; global -<S> needs
+    // all of them.
 
-    if( tbGetDCChkOn() && !tbGet300HzOn() ) {
+    R.nuLo      = nSpikeChans;
+    R.nuLim     = 0;
+    R.sAveSel   = tbGetSAveSel();
 
-        dc.init( nG, nNeurChans );
-        dc.updateLvl( df, xpos, ntpts, chunk, dwnSmp );
+    if( R.sAveSel >= 3 ) {
+        R.nuLo  = 0;
+        R.nuLim = nSpikeChans;
     }
+    else {
 
-// --------------
-// Process chunks
-// --------------
-
-    qint64  nRem = ntpts;
-
-    for(;;) {
-
-        if( nRem <= 0 )
-            break;
-
-        // ---------------
-        // Read this block
-        // ---------------
-
-        if( xoff && (chunk + dwnSmp - 1) / dwnSmp <= xoff )
-            chunk = (xoff + 1) * dwnSmp;
-
-        vec_i16 data;
-        qint64  nthis = qMin( chunk, nRem );
-
-        ntpts = df->readScans( data, xpos, nthis, QBitArray() );
-
-        if( ntpts <= 0 )
-            break;
-
-        dtpts = (ntpts + dwnSmp - 1) / dwnSmp;
-
-        if( dtpts <= xoff )
-            break;
-
-        // update counting
-
-        xpos    += ntpts;
-        nRem    -= ntpts;
-
-        // --------------
-        // Filters ------
-        // --------------
-
-        // --------
-        // Bandpass
-        // --------
+        for( int iv = 0; iv < nVis; ++iv ) {
 
-        if( tbGet300HzOn() ) {
-            hipass->applyBlockwiseMem(
-                    &data[0], maxInt, ntpts, nG, 0, nSpikeChans );
-        }
+            int ig = R.iv2ig[iv];
 
-        // ------------------------------------
-        // -<T>; not applied if hipass filtered
-        // ------------------------------------
+            if( ig >= nSpikeChans )
+                continue;
 
-        if( tbGetDCChkOn() && !tbGet300HzOn() )
-            dc.apply( &data[0], ntpts, (binMax ? binMax : dwnSmp) );
+            R.nuLo  = qMin( R.nuLo, ig );
+            R.nuLim = qMax( R.nuLim, ig + 1 );
 
-        // ----
-        // -<S>
-        // ----
+            if( ig < (int)TSM.size() ) {
 
-        switch( tbGetSAveSel() ) {
+                const std::vector<int>  &V = TSM[ig];
 
-            case 1:
-            case 2:
-                sAveLocal = true;
-                break;
-            case 3:
-                sAveApplyGlobal(
-                    &data[0], ntpts, nG, nSpikeChans,
-                    (binMax ? binMax : dwnSmp) );
-                break;
-            case 4:
-                sAveApplyGlobalStride(
-                    &data[0], ntpts, nG, nSpikeChans,
-                    stride, (binMax ? binMax : dwnSmp) );
-                break;
-            default:
-                ;
+                for( int i = 0, n = V.size(); i < n; ++i ) {
+                    R.nuLo  = qMin( R.nuLo, V[i] );
+                    R.nuLim = qMax( R.nuLim, V[i] + 1 );
+                }
+            }
         }
+    }
 
-        // -------------
-        // Result buffer
-        // -------------
-
-        std::vector<float>  ybuf( dtpts ),
-                            ybuf2( binMax ? dtpts : 0 );
-
-        // -------------------------
-        // For each shown channel...
-        // -------------------------
-
-        for( int iv = 0; iv < nVis; ++iv ) {
-
-            int     ig      = iv2ig[iv],
-                    dstep   = dwnSmp * nG,
-                    ny      = 0;
-            qint16  *d      = &data[ig];
-
-            if( grfY[ig].usrType == 0 ) {
-
-                // ---------------
-                // Neural channels
-                // ---------------
+// --------
+// Snapshot
+// --------
 
-                // ---------------
-                // Skip references
-                // ---------------
+    R.cache         = cache;
+    R.nSpikeChans   = nSpikeChans;
+    R.nNeurChans    = nNeurChans;
+    R.hasSM         = (shankMap != 0);
+    R.ig2ic         = ig2ic;
+    R.ic2ig         = ic2ig;
 
-                if( shankMap && !shankMap->e[ig].u )
-                    continue;
+    if( R.hasSM )
+        R.SM = *shankMap;
 
-                // -------------------
-                // Neural downsampling
-                // -------------------
+    if( R.sAveSel == 1 || R.sAveSel == 2 )
+        R.TSM = TSM;
 
-                // Within each bin, report both max and min
-                // values. This ensures spikes aren't missed.
-                // Max in ybuf, min in ybuf2.
+    R.usrType.resize( nVis );
 
-                if( binMax ) {
+    for( int iv = 0; iv < nVis; ++iv )
+        R.usrType[iv] = grfY[R.iv2ig[iv]].usrType;
 
-                    int ndRem = ntpts;
+    renderer->submit( R );
 
-                    grfY[ig].drawBinMax = true;
+// ----------------------------------------
+// Prefetch next window in scroll direction
+// ----------------------------------------
 
-                    for(
-                        int it = 0;
-                        it < ntpts;
-                        it += dwnSmp, d = &data[ig + it*nG] ) {
+    cache->prefetch(
+        (pos >= lastPos ? R.xpos + num2Read : R.xpos - num2Read),
+        num2Read );
 
-                        int val     = V_S_AVE( d ),
-                            vmax    = val,
-                            vmin    = val,
-                            binWid  = dwnSmp;
+    lastPos = pos;
+}
 
-                        d += binMax*nG;
 
-                        if( ndRem < binWid )
-                            binWid = ndRem;
+// Swap in the latest finished render, if still current.
+//
+void FileViewerWindow::renderDone()
+{
+    FVRenderOut *O = renderer->take();
 
-                        for(
-                            int ib = binMax;
-                            ib < binWid;
-                            ib += binMax, d += binMax*nG ) {
+    if( !O )
+        return;
 
-                            val = V_S_AVE( d );
+    int nVis    = O->iv2ig.size(),
+        nG      = grfY.size();
 
-                            if( val > vmax )
-                                vmax = val;
-                            else if( val < vmin )
-                                vmin = val;
-                        }
+    for( int iv = 0; iv < nVis; ++iv ) {
 
-                        ndRem -= binWid;
+        int ig = O->iv2ig[iv];
 
-                        ybuf[ny]  = vmax * ysc;
-                        ybuf2[ny] = vmin * ysc;
-                        ++ny;
-                    }
+        if( ig < nG )
+            grfY[ig].resize( O->gtpts );
+    }
 
-                    grfY[ig].yval2.putData( &ybuf2[xoff], dtpts - xoff );
-                }
-                else if( sAveLocal ) {
+    mscroll->theX->initVerts( O->gtpts );
 
-                    grfY[ig].drawBinMax = false;
+    if( O->nFill > 0 ) {
 
-                    for( int it = 0; it < ntpts; it += dwnSmp, d += dstep )
-                        ybuf[ny++] = sAveApplyLocal( d, ig ) * ysc;
-                }
-                else {
-                    grfY[ig].drawBinMax = false;
-                    goto draw_analog;
-                }
-            }
-            else if( grfY[ig].usrType == 1 ) {
+        for( int iv = 0; iv < nVis; ++iv ) {
 
-                // -----------------
-                // Analog: LF or Aux
-                // -----------------
+            int ig = O->iv2ig[iv];
 
-draw_analog:
-                for( int it = 0; it < ntpts; it += dwnSmp, d += dstep )
-                    ybuf[ny++] = *d * ysc;
-            }
-            else {
+            if( ig >= nG || O->skip[iv] )
+                continue;
 
-                // -------
-                // Digital
-                // -------
+            MGraphY &Y = grfY[ig];
 
-                for( int it = 0; it < ntpts; it += dwnSmp, d += dstep )
-                    ybuf[ny++] = *d;
-            }
+            if( O->drawBM[iv] >= 0 )
+                Y.drawBinMax = O->drawBM[iv];
 
-            // -------------
-            // Copy to graph
-            // -------------
+            Y.yval.putData( &O->y[iv][0], O->nFill );
 
-            grfY[ig].yval.putData( &ybuf[xoff], dtpts - xoff );
+            if( O->drawBM[iv] > 0 )
+                Y.yval2.putData( &O->y2[iv][0], O->nFill );
         }
+    }
 
-        xoff = 0;   // only first chunk includes offset
-
-    }   // end chunks
+    delete O;
 
 // -----------------
 // Select and redraw
@@ -3073,16 +2863,7 @@ bool FileViewerWindow::linkOpenName(
     QString         errorMsg;
     ConsoleWindow*  cons = mainApp()->console();
 
-    if( !DFName::isValidInputFile( name, &errorMsg ) ) {
-
-        QMessageBox::critical(
-            cons,
-            "Error Opening File",
-            QString("File cannot be used for input '%1':\n[%2]")
-            .arg( QFileInfo( name ).fileName() )
-            .arg( errorMsg ) );
-        return false;
-    }
+    // viewFile validates (accepting files still being recorded)
 
     FileViewerWindow    *fvw = new FileViewerWindow;
 
@@ -10,11 +10,13 @@ class FileViewerWindow;
 class FVToolbar;
 class FVScanGrp;
 class DataFile;
+class DFEdges;
+class FVBlockCache;
+class FVRender;
 struct ShankMap;
 struct ChanMap;
 class MGraphY;
 class MGScroll;
-class Biquad;
 class ExportCtl;
 class TaggableLabel;
 
@@ -94,30 +96,9 @@ private:
         GraphParams() : gain(1.0)   {}
     };
 
-    class DCAve {
-    private:
-        int                 nC,
-                            nN;
-    public:
-        std::vector<int>    lvl;
-    public:
-        void init( int nChannels, int nNeural );
-        void updateLvl(
-            const DataFile  *df,
-            qint64          xpos,
-            qint64          nRem,
-            qint64          chunk,
-            int             dwnSmp );
-        void apply(
-            qint16          *d,
-            int             ntpts,
-            int             dwnSmp );
-    };
-
     FVToolbar               *tbar;
     FVScanGrp               *scanGrp;
     SaveSet                 sav;
-    DCAve                   dc;
     QString                 cmChanStr;
     double                  tMouseOver,
                             yMouseOver;
@@ -126,16 +107,20 @@ private:
                             dragL,              // or -1
                             dragR,
                             savedDragL,         // zoom: temp save sel
-                            savedDragR;
+                            savedDragR,
+                            lastPos;            // scroll direction
     DataFile                *df;
+    DFEdges                 *edx;
+    FVBlockCache            *cache;
+    FVRender                *renderer;
     ShankMap                *shankMap;
     ChanMap                 *chanMap;
-    Biquad                  *hipass;
     ExportCtl               *exportCtl;
     QMenu                   *channelsMenu;
     MGScroll                *mscroll;
     TaggableLabel           *closeLbl;
-    QTimer                  *hideCloseTimer;
+    QTimer                  *hideCloseTimer,
+                            *followTimer;       // file being recorded
     std::vector<MGraphY>    grfY;
     std::vector<GraphParams>grfParams;          // per-graph params
     std::vector<QMenu*>     chanSubMenus;
@@ -261,6 +246,8 @@ private slots:
     void shankmap_Tog();
     void shankmap_Edit();
     void shankmap_Restore();
+    void edges_Next();
+    void edges_Prev();
 
 // Mouse
     void mouseOverGraph( double x, double y, int iy );
@@ -276,6 +263,7 @@ private slots:
 
 // Timer targets
     void layoutGraphs();
+    void followTimeout();
 
 // Stream linking
     void linkRecvPos( double t0, double tSpan, int fChanged );
@@ -283,6 +271,9 @@ private slots:
     void linkRecvManualUpdate( bool manualUpdate );
     void linkRecvDraw();
 
+// FVRender
+    void renderDone();
+
 protected:
     virtual bool eventFilter( QObject *obj, QEvent *e );
     virtual void closeEvent( QCloseEvent *e );
@@ -296,7 +287,7 @@ private:
 
 // Data-dependent inits
     bool openFile( const QString &fname, QString *errMsg );
-    void initHipass();
+    void updateTitle();
     void killActions();
     void initGraphs();
 
@@ -313,21 +304,8 @@ private:
     void showGraph( int ig );
     void selectGraph( int ig, bool updateGraph = true );
     void toggleMaximized();
+    void edgesGoTo( bool next );
     void sAveTable( int sel );
-    int sAveApplyLocal( const qint16 *d_ig, int ig );
-    void sAveApplyGlobal(
-        qint16  *d,
-        int     ntpts,
-        int     nC,
-        int     nAP,
-        int     dwnSmp );
-    void sAveApplyGlobalStride(
-        qint16  *d,
-        int     ntpts,
-        int     nC,
-        int     nAP,
-        int     stride,
-        int     dwnSmp );
     void updateXSel();
     void zoomTime();
     void updateGraphs();
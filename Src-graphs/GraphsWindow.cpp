@@ -576,7 +576,7 @@ void GraphsWindow::initColorTTL()
         Xb = rW->getTheX();
     }
 
-    TTLCC->setClients( lType, Qa, Xa, rType, Qb, Xb );
+    TTLCC->setClients( lType, Qa, Xa, rType, Qb, Xb, run->getEdgeIndex() );
 }
 
 
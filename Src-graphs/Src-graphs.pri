@@ -2,6 +2,8 @@
 HEADERS += \
     $$PWD/ColorTTLCtl.h \
     $$PWD/FileViewerWindow.h \
+    $$PWD/FVBlockCache.h \
+    $$PWD/FVRender.h \
     $$PWD/FVScanGrp.h \
     $$PWD/FVToolbar.h \
     $$PWD/GraphFetcher.h \
@@ -29,6 +31,8 @@ HEADERS += \
 SOURCES += \
     $$PWD/ColorTTLCtl.cpp \
     $$PWD/FileViewerWindow.cpp \
+    $$PWD/FVBlockCache.cpp \
+    $$PWD/FVRender.cpp \
     $$PWD/FVScanGrp.cpp \
     $$PWD/FVToolbar.cpp \
     $$PWD/GraphFetcher.cpp \
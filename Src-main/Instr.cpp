@@ -0,0 +1,436 @@
+
+#include "Instr.h"
+#include "Util.h"
+
+#include <QFile>
+#include <QTextStream>
+
+#include <math.h>
+
+
+/* ---------------------------------------------------------------- */
+/* Statics -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+std::vector<Instr::Named<InstrCounter> >    Instr::vC;
+std::vector<Instr::Named<InstrGauge> >      Instr::vG;
+std::vector<Instr::Named<InstrHist> >       Instr::vH;
+std::vector<Instr::Named<InstrBins> >       Instr::vB;
+QMutex                                      Instr::regMtx;
+volatile bool                               Instr::_enabled = false;
+
+/* ---------------------------------------------------------------- */
+/* InstrHist ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+InstrHist::InstrHist()
+    :   n(0), sumUs(0), maxUs(0)
+{
+    for( int i = 0; i < nBins; ++i )
+        bin[i].store( 0 );
+}
+
+
+void InstrHist::add( double secs )
+{
+    quint32 us  = quint32(qBound( 0.0, 1e6 * secs, 4e9 ));
+    int     ib  = 0;
+
+    for( quint32 u = us; u && ib < nBins - 1; u >>= 1 )
+        ++ib;
+
+    bin[ib].fetchAndAddRelaxed( 1 );
+    n.fetchAndAddRelaxed( 1 );
+    sumUs.fetchAndAddRelaxed( us );
+
+    quint32 m = maxUs.load();
+    while( us > m && !maxUs.testAndSetRelaxed( m, us ) )
+        m = maxUs.load();
+}
+
+
+void InstrHist::addSince( double t0 )
+{
+    if( t0 > 0 )
+        add( getTime() - t0 );
+}
+
+
+double InstrHist::meanUs() const
+{
+    quint64 N = n.load();
+
+    return (N ? double(sumUs.load()) / N : 0);
+}
+
+
+// Return upper edge of bin holding given percentile.
+//
+double InstrHist::pctileUs( double pct ) const
+{
+    quint64 N = n.load();
+
+    if( !N )
+        return 0;
+
+    quint64 lim = quint64(ceil( pct/100.0 * N )),
+            cum = 0;
+
+    for( int ib = 0; ib < nBins; ++ib ) {
+
+        cum += bin[ib].load();
+
+        if( cum >= lim )
+            return qMin( double(quint64(1) << ib), maxUsecs() );
+    }
+
+    return maxUsecs();
+}
+
+
+void InstrHist::reset()
+{
+    for( int i = 0; i < nBins; ++i )
+        bin[i].store( 0 );
+
+    n.store( 0 );
+    sumUs.store( 0 );
+    maxUs.store( 0 );
+}
+
+/* ---------------------------------------------------------------- */
+/* InstrBins ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+InstrBins::InstrBins( int lo, int width, int nBins )
+    :   n(0), lo(lo), width(qMax( 1, width )), nBins(nBins)
+{
+    bin = new QAtomicInteger<quint64>[nBins + 2];
+    reset();
+}
+
+
+// Nonzero bins only, as "lo:count" items separated by sep.
+// Underflow shows as "<lo", overflow as ">=hi".
+//
+QString InstrBins::toString( QChar sep ) const
+{
+    QString s;
+
+    for( int ib = 0; ib < nBins + 2; ++ib ) {
+
+        quint64 c = bin[ib].load();
+
+        if( !c )
+            continue;
+
+        if( !s.isEmpty() )
+            s += sep;
+
+        if( !ib )
+            s += QString("<%1").arg( lo );
+        else if( ib > nBins )
+            s += QString(">=%1").arg( lo + nBins * width );
+        else
+            s += QString("%1").arg( lo + (ib - 1) * width );
+
+        s += QString(":%1").arg( c );
+    }
+
+    return s;
+}
+
+
+void InstrBins::reset()
+{
+    for( int i = 0; i < nBins + 2; ++i )
+        bin[i].store( 0 );
+
+    n.store( 0 );
+}
+
+/* ---------------------------------------------------------------- */
+/* InstrThreadCPU ------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+InstrThreadCPU::InstrThreadCPU( const QString &name )
+    :   c(Instr::counter( name + ".cpuUs" )), lastCPU(-1), lastT(0)
+{
+}
+
+
+// First sample on the owning thread sets the baseline.
+//
+void InstrThreadCPU::sample()
+{
+    if( !Instr::isEnabled() )
+        return;
+
+    double  t = getTime();
+
+    if( lastCPU >= 0 && t - lastT < 1.0 )
+        return;
+
+    double  cpu = getThreadCPUSecs();
+
+    if( lastCPU >= 0 && cpu > lastCPU )
+        c->add( quint64(1e6 * (cpu - lastCPU)) );
+
+    lastCPU = cpu;
+    lastT   = t;
+}
+
+/* ---------------------------------------------------------------- */
+/* Instr ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void Instr::setEnabled( bool on )
+{
+    if( on && !_enabled )
+        reset();
+
+    _enabled = on;
+}
+
+
+double Instr::startT()
+{
+    return (_enabled ? getTime() : 0);
+}
+
+
+InstrCounter *Instr::counter( const QString &name )
+{
+    QMutexLocker    ml( &regMtx );
+
+    for( int i = 0, n = vC.size(); i < n; ++i ) {
+
+        if( vC[i].name == name )
+            return vC[i].probe;
+    }
+
+    vC.push_back( Named<InstrCounter>( name, new InstrCounter ) );
+    return vC.back().probe;
+}
+
+
+InstrGauge *Instr::gauge( const QString &name )
+{
+    QMutexLocker    ml( &regMtx );
+
+    for( int i = 0, n = vG.size(); i < n; ++i ) {
+
+        if( vG[i].name == name )
+            return vG[i].probe;
+    }
+
+    vG.push_back( Named<InstrGauge>( name, new InstrGauge ) );
+    return vG.back().probe;
+}
+
+
+InstrHist *Instr::hist( const QString &name )
+{
+    QMutexLocker    ml( &regMtx );
+
+    for( int i = 0, n = vH.size(); i < n; ++i ) {
+
+        if( vH[i].name == name )
+            return vH[i].probe;
+    }
+
+    vH.push_back( Named<InstrHist>( name, new InstrHist ) );
+    return vH.back().probe;
+}
+
+
+// Bin geometry is fixed by first registration.
+//
+InstrBins *Instr::bins(
+    const QString   &name,
+    int             lo,
+    int             width,
+    int             nBins )
+{
+    QMutexLocker    ml( &regMtx );
+
+    for( int i = 0, n = vB.size(); i < n; ++i ) {
+
+        if( vB[i].name == name )
+            return vB[i].probe;
+    }
+
+    vB.push_back(
+        Named<InstrBins>( name, new InstrBins( lo, width, nBins ) ) );
+    return vB.back().probe;
+}
+
+
+// Zero all values (probes remain registered).
+//
+void Instr::reset()
+{
+    QMutexLocker    ml( &regMtx );
+
+    for( int i = 0, n = vC.size(); i < n; ++i )
+        vC[i].probe->reset();
+
+    for( int i = 0, n = vG.size(); i < n; ++i )
+        vG[i].probe->reset();
+
+    for( int i = 0, n = vH.size(); i < n; ++i )
+        vH[i].probe->reset();
+
+    for( int i = 0, n = vB.size(); i < n; ++i )
+        vB[i].probe->reset();
+}
+
+
+// Fill m with counters whose names end in suffix,
+// keyed by name with suffix removed.
+//
+void Instr::counterVals(
+    QMap<QString,quint64>   &m,
+    const QString           &suffix )
+{
+    QMutexLocker    ml( &regMtx );
+
+    for( int i = 0, n = vC.size(); i < n; ++i ) {
+
+        const QString   &name = vC[i].name;
+
+        if( name.endsWith( suffix ) )
+            m[name.left( name.size() - suffix.size() )] = vC[i].probe->value();
+    }
+}
+
+
+// One human-readable line per active probe.
+//
+void Instr::report( QStringList &sl )
+{
+    QMutexLocker    ml( &regMtx );
+
+    for( int i = 0, n = vH.size(); i < n; ++i ) {
+
+        const InstrHist *H = vH[i].probe;
+
+        if( !H->count() )
+            continue;
+
+        sl.append(
+            QString("%1  n %2  us: mean %3  p50 %4  p99 %5  max %6")
+            .arg( vH[i].name, -20 )
+            .arg( H->count() )
+            .arg( H->meanUs(), 0, 'f', 1 )
+            .arg( H->pctileUs( 50 ) )
+            .arg( H->pctileUs( 99 ) )
+            .arg( H->maxUsecs() ) );
+    }
+
+    for( int i = 0, n = vB.size(); i < n; ++i ) {
+
+        const InstrBins *B = vB[i].probe;
+
+        if( !B->count() )
+            continue;
+
+        sl.append(
+            QString("%1  n %2  %3")
+            .arg( vB[i].name, -20 )
+            .arg( B->count() )
+            .arg( B->toString( ' ' ) ) );
+    }
+
+    for( int i = 0, n = vG.size(); i < n; ++i ) {
+
+        const InstrGauge    *G = vG[i].probe;
+
+        sl.append(
+            QString("%1  now %2  max %3")
+            .arg( vG[i].name, -20 )
+            .arg( G->value() )
+            .arg( G->maxVal() ) );
+    }
+
+    for( int i = 0, n = vC.size(); i < n; ++i ) {
+
+        sl.append(
+            QString("%1  %2")
+            .arg( vC[i].name, -20 )
+            .arg( vC[i].probe->value() ) );
+    }
+}
+
+
+// Columns: kind,name,n,mean,p50,p99,max,bins
+// - hist:    n=count, stats in microseconds.
+// - bins:    n=count, bins="lo:count;..." nonzero only.
+// - gauge:   n=value, max=running max.
+// - counter: n=value.
+//
+QString Instr::csv()
+{
+    QString     s;
+    QTextStream ts( &s );
+
+    ts << "kind,name,n,mean_us,p50_us,p99_us,max,bins\n";
+
+    QMutexLocker    ml( &regMtx );
+
+    for( int i = 0, n = vH.size(); i < n; ++i ) {
+
+        const InstrHist *H = vH[i].probe;
+
+        ts  << "hist," << vH[i].name << ","
+            << H->count() << ","
+            << H->meanUs() << ","
+            << H->pctileUs( 50 ) << ","
+            << H->pctileUs( 99 ) << ","
+            << H->maxUsecs() << ",\n";
+    }
+
+    for( int i = 0, n = vB.size(); i < n; ++i ) {
+
+        const InstrBins *B = vB[i].probe;
+
+        ts  << "bins," << vB[i].name << ","
+            << B->count() << ",,,,,"
+            << B->toString( ';' ) << "\n";
+    }
+
+    for( int i = 0, n = vG.size(); i < n; ++i ) {
+
+        ts  << "gauge," << vG[i].name << ","
+            << vG[i].probe->value() << ",,,,"
+            << vG[i].probe->maxVal() << ",\n";
+    }
+
+    for( int i = 0, n = vC.size(); i < n; ++i ) {
+
+        ts  << "counter," << vC[i].name << ","
+            << vC[i].probe->value() << ",,,,,\n";
+    }
+
+    ts.flush();
+    return s;
+}
+
+
+bool Instr::writeCSV( const QString &path )
+{
+    QFile   f( path );
+
+    if( !f.open( QIODevice::WriteOnly | QIODevice::Text ) ) {
+        Warning() << "Instrumentation: Can't write [" << path << "].";
+        return false;
+    }
+
+    QTextStream ts( &f );
+    ts << csv();
+
+    Log() << "Instrumentation written [" << path << "].";
+    return true;
+}
+
+
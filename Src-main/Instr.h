@@ -0,0 +1,192 @@
+#ifndef INSTR_H
+#define INSTR_H
+
+#include <QAtomicInteger>
+#include <QMap>
+#include <QMutex>
+#include <QStringList>
+
+#include <vector>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Runtime instrumentation registry.
+//
+// Probes are named, created once, and never deleted, so hot-path
+// code can look one up at setup and keep the pointer. All updates
+// are relaxed atomics: no locks in acquisition/writer threads.
+//
+// Instrumentation is off by default. While off, timing call sites
+// reduce to one flag test:
+//
+//  double  t0 = Instr::startT();   // 0 if disabled
+//  ...work...
+//  hist->addSince( t0 );           // no-op if t0 == 0
+//
+// Output: MetricsWindow, CSV in run folder, CmdServer query.
+//
+
+// Monotonic event count.
+//
+class InstrCounter
+{
+private:
+    QAtomicInteger<quint64> n;
+
+public:
+    InstrCounter() : n(0)   {}
+
+    void add( quint64 k = 1 )   {n.fetchAndAddRelaxed( k );}
+    quint64 value() const       {return n.load();}
+    void reset()                {n.store( 0 );}
+};
+
+
+// Last value and running max, e.g. queue depth.
+//
+class InstrGauge
+{
+private:
+    QAtomicInt  val,
+                max;
+
+public:
+    InstrGauge() : val(0), max(0)   {}
+
+    void set( int v )
+        {
+            val.store( v );
+            int m = max.load();
+            while( v > m && !max.testAndSetRelaxed( m, v ) )
+                m = max.load();
+        }
+    int value() const   {return val.load();}
+    int maxVal() const  {return max.load();}
+    void reset()        {val.store( 0 ); max.store( 0 );}
+};
+
+
+// Latency histogram with log2 microsecond bins:
+// bin 0: [0,1) us, bin k: [2^(k-1), 2^k) us.
+//
+class InstrHist
+{
+public:
+    enum {nBins = 32};
+
+private:
+    QAtomicInteger<quint64> bin[nBins],
+                            n,
+                            sumUs;
+    QAtomicInteger<quint32> maxUs;
+
+public:
+    InstrHist();
+
+    void add( double secs );
+    void addSince( double t0 );
+
+    quint64 count() const   {return n.load();}
+    double meanUs() const;
+    double maxUsecs() const {return maxUs.load();}
+    double pctileUs( double pct ) const;
+    void reset();
+};
+
+
+// Linear histogram of integer values, e.g. packet counts:
+// bin k: [lo + k*width, lo + (k+1)*width), plus under/over bins.
+//
+class InstrBins
+{
+private:
+    QAtomicInteger<quint64> *bin,   // [under, 0..nBins-1, over]
+                            n;
+    int                     lo,
+                            width,
+                            nBins;
+
+public:
+    InstrBins( int lo, int width, int nBins );
+    virtual ~InstrBins()    {delete [] bin;}
+
+    void add( int v, quint64 k = 1 )
+        {
+            int ib = (v < lo ? 0 : qMin( 1 + (v - lo) / width, nBins + 1 ));
+            bin[ib].fetchAndAddRelaxed( k );
+            n.fetchAndAddRelaxed( k );
+        }
+
+    quint64 count() const   {return n.load();}
+    QString toString( QChar sep ) const;
+    void reset();
+};
+
+
+// CPU time of one thread, accumulated into counter "<name>.cpuUs"
+// (microseconds). Call sample() from that thread's loop; it reads
+// the thread clock at most once per second, and only if enabled.
+//
+class InstrThreadCPU
+{
+private:
+    InstrCounter    *c;
+    double          lastCPU,
+                    lastT;
+
+public:
+    InstrThreadCPU( const QString &name );
+
+    void sample();
+};
+
+
+class Instr
+{
+private:
+    template<class T>
+    struct Named {
+        QString name;
+        T       *probe;
+        Named( const QString &name, T *probe )
+        :   name(name), probe(probe)    {}
+    };
+
+private:
+    static std::vector<Named<InstrCounter> >    vC;
+    static std::vector<Named<InstrGauge> >      vG;
+    static std::vector<Named<InstrHist> >       vH;
+    static std::vector<Named<InstrBins> >       vB;
+    static QMutex                               regMtx;
+    static volatile bool                        _enabled;
+
+public:
+    static bool isEnabled()             {return _enabled;}
+    static void setEnabled( bool on );
+    static double startT();
+
+    static InstrCounter *counter( const QString &name );
+    static InstrGauge *gauge( const QString &name );
+    static InstrHist *hist( const QString &name );
+    static InstrBins *bins(
+        const QString   &name,
+        int             lo,
+        int             width,
+        int             nBins );
+
+    static void reset();
+
+    static void counterVals(
+        QMap<QString,quint64>   &m,
+        const QString           &suffix );
+
+    static void report( QStringList &sl );
+    static QString csv();
+    static bool writeCSV( const QString &path );
+};
+
+#endif  // INSTR_H
+
+
@@ -0,0 +1,86 @@
+
+#include "KernelTest.h"
+#include "Util.h"
+
+
+/* ---------------------------------------------------------------- */
+/* KTRand --------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void KTRand::fill( qint16 *dst, int n )
+{
+    for( int i = 0; i < n; ++i )
+        dst[i] = i16();
+}
+
+
+void KTRand::fill( vec_i16 &v )
+{
+    if( v.size() )
+        fill( &v[0], v.size() );
+}
+
+/* ---------------------------------------------------------------- */
+/* KTTimer -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void KTTimer::start()
+{
+    t0 = getTime();
+}
+
+
+double KTTimer::usPer( int nReps ) const
+{
+    return 1e6 * (getTime() - t0) / qMax( 1, nReps );
+}
+
+/* ---------------------------------------------------------------- */
+/* ktCompare ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+bool ktCompare(
+    QString         &err,
+    const QString   &what,
+    const qint16    *A,
+    const qint16    *B,
+    int             n,
+    int             nC )
+{
+    for( int i = 0; i < n; ++i ) {
+
+        if( A[i] == B[i] )
+            continue;
+
+        if( nC > 0 ) {
+            err = QString("%1 mismatch: scan %2 chan %3 (%4 vs %5).")
+                    .arg( what ).arg( i / nC ).arg( i % nC )
+                    .arg( A[i] ).arg( B[i] );
+        }
+        else {
+            err = QString("%1 mismatch: sample %2 (%3 vs %4).")
+                    .arg( what ).arg( i ).arg( A[i] ).arg( B[i] );
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+
+bool ktCompare(
+    QString         &err,
+    const QString   &what,
+    const vec_i16   &A,
+    const vec_i16   &B,
+    int             nC )
+{
+    if( A.size() != B.size() ) {
+        err = QString("%1 mismatch: size %2 vs %3.")
+                .arg( what ).arg( A.size() ).arg( B.size() );
+        return false;
+    }
+
+    return !A.size() || ktCompare( err, what, &A[0], &B[0], A.size(), nC );
+}
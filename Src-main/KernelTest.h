@@ -0,0 +1,78 @@
+#ifndef KERNELTEST_H
+#define KERNELTEST_H
+
+#include "SGLTypes.h"
+
+#include <QString>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Scaffolding shared by the kernel self-checks (KernelChecks app)
+// and throughput benchmarks (BenchRun):
+//
+//  KTRand  R( 12345 );             // same data on every platform
+//  R.fill( src );
+//
+//  KTTimer T;
+//  for( int r = 0; r < nReps; ++r ) ...kernel...
+//  double  us = T.usPer( nReps );
+//
+//  if( !ktCompare( err, "what", ref, out ) ) return false;
+//
+
+// Linear congruential generator (Numerical Recipes constants).
+//
+class KTRand
+{
+private:
+    quint32 seed;
+
+public:
+    KTRand( quint32 seed = 12345 ) : seed(seed)   {}
+
+    quint32 next()  {return (seed = 1664525 * seed + 1013904223);}
+    qint16 i16()    {return qint16(next() >> 16);}
+
+    void fill( qint16 *dst, int n );
+    void fill( vec_i16 &v );
+};
+
+
+// Microseconds per repetition since construction or start().
+//
+class KTTimer
+{
+private:
+    double  t0;
+
+public:
+    KTTimer()   {start();}
+
+    void start();
+    double usPer( int nReps ) const;
+};
+
+/* ---------------------------------------------------------------- */
+/* Functions ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+// Return true if A and B match; else describe first mismatch
+// in err. If nC > 0, samples are reported as scan and channel.
+bool ktCompare(
+    QString         &err,
+    const QString   &what,
+    const qint16    *A,
+    const qint16    *B,
+    int             n,
+    int             nC = 0 );
+
+bool ktCompare(
+    QString         &err,
+    const QString   &what,
+    const vec_i16   &A,
+    const vec_i16   &B,
+    int             nC = 0 );
+
+#endif  // KERNELTEST_H
@@ -13,7 +13,9 @@
 #include "CmdSrvDlg.h"
 #include "RgtSrvDlg.h"
 #include "Run.h"
+#include "Replay.h"
 #include "CalSRateCtl.h"
+#include "BenchRun.h"
 #include "IMBISTCtl.h"
 #include "IMFirmCtl.h"
 #include "Sha1Verifier.h"
@@ -27,6 +29,7 @@
 #include <QAction>
 #include <QDir>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QPushButton>
 #include <QSettings>
 #include <QTimer>
@@ -41,7 +44,7 @@ MainApp::MainApp( int &argc, char **argv )
         consoleWindow(0), mxWin(0), par2Win(0),
         configCtl(0), aoCtl(0),
         cmdSrv(new CmdSrvDlg), rgtSrv(new RgtSrvDlg),
-        calSRRun(0), runInitingDlg(0), initialized(false)
+        calSRRun(0), benchRun(0), runInitingDlg(0), initialized(false)
 {
 // --------------
 // App attributes
@@ -168,6 +171,8 @@ MainApp::~MainApp()
         delete run;
         run = 0;
     }
+
+    CimCfg::warmRelease();
 }
 
 /* ---------------------------------------------------------------- */
@@ -246,6 +251,7 @@ void MainApp::saveSettings() const
     settings.setValue( "lastViewedFile", appData.lastViewedFile );
     settings.setValue( "debug", appData.debug );
     settings.setValue( "editLog", appData.editLog );
+    settings.setValue( "headless", appData.headless );
 
     remoteMtx.lock();
     settings.setValue( "dataDir", appData.dataDir );
@@ -369,6 +375,8 @@ void MainApp::file_Open()
 // Valid?
 // ------
 
+// A file still being recorded passes; the viewer follows it.
+
     QString errorMsg;
 
     if( !DFName::isValidInputFile( fname, &errorMsg ) ) {
@@ -554,6 +562,69 @@ void MainApp::options_AODlg()
 }
 
 
+// Headless runs create no graphs windows or fetchers.
+// Takes effect at next run start.
+//
+void MainApp::options_ToggleHeadless()
+{
+    appData.headless = !appData.headless;
+
+    Log() << "Headless runs: " << (appData.headless ? "on" : "off");
+
+    saveSettings();
+}
+
+
+// Checking: pick any .bin of a recorded run set, and speed.
+// Unchecking: back to hardware (or simulated) acquisition.
+//
+void MainApp::options_ReplaySource()
+{
+    ReplayParams    R;
+    R.loadSettings();
+
+    if( act.replayAct->isChecked() ) {
+
+        QString f = QFileDialog::getOpenFileName(
+                        consoleWindow,
+                        "Choose Any Binary File of Run to Replay",
+                        (R.lastBin.isEmpty() ? dataDir() : R.lastBin),
+                        "Bin files (*.bin)" );
+
+        bool    ok = false;
+
+        if( !f.isEmpty() ) {
+
+            double  speed = QInputDialog::getDouble(
+                                consoleWindow,
+                                "Replay Speed",
+                                "Multiple of recorded sample rate:",
+                                R.speed, 0.1, 100.0, 1, &ok );
+
+            if( ok ) {
+                R.binFile   = f;
+                R.speed     = speed;
+            }
+        }
+
+        if( !ok ) {
+            act.replayAct->setChecked( R.isEnabled() );
+            return;
+        }
+
+        Log() <<
+            QString("Replay source: '%1' at %2x.")
+            .arg( R.binFile ).arg( R.speed );
+    }
+    else {
+        R.binFile.clear();
+        Log() << "Replay source: off.";
+    }
+
+    R.saveSettings();
+}
+
+
 void MainApp::tools_VerifySha1()
 {
 // Sha1Verifier is self-deleting object
@@ -593,6 +664,60 @@ void MainApp::tools_CalSRate()
 }
 
 
+// Record current configuration for a fixed time into a chosen
+// folder, then report throughput (see BenchRun).
+//
+void MainApp::tools_Benchmark()
+{
+    if( run->isRunning() ) {
+
+        QMessageBox::critical(
+            consoleWindow,
+            "Run in Progress",
+            "Stop the current run before starting a benchmark." );
+        return;
+    }
+
+    if( !configCtl->validated ) {
+
+        QMessageBox::critical(
+            consoleWindow,
+            "Run Parameters Not Validated",
+            "Configure and verify a run before benchmarking." );
+        return;
+    }
+
+    bool    ok;
+    int     secs = QInputDialog::getInt(
+                    consoleWindow,
+                    "Throughput Benchmark",
+                    "Recording duration (seconds):",
+                    60, 5, 3600, 1, &ok );
+
+    if( !ok )
+        return;
+
+    QString dir = QFileDialog::getExistingDirectory(
+                    consoleWindow,
+                    "Choose Benchmark Data Directory",
+                    dataDir(),
+                    QFileDialog::DontResolveSymlinks
+                    | QFileDialog::ShowDirsOnly );
+
+    if( dir.isEmpty() )
+        return;
+
+    benchRun = new BenchRun( dir, secs );
+    benchRun->initRun();
+
+    if( !runCmdStart() ) {
+        benchRun->restore();
+        delete benchRun;
+        benchRun = 0;
+    }
+}
+
+
 void MainApp::tools_ImClose()
 {
 #ifdef HAVE_IMEC
@@ -965,6 +1090,13 @@ void MainApp::runStarted()
         runInitingDlg = 0;
     }
 
+    if( benchRun ) {
+        benchRun->initTimer();
+        QTimer::singleShot(
+            benchRun->targetMS(),
+            this, SLOT(runBenchTimeout()) );
+    }
+
     if( calSRRun ) {
         // Due to limited accuracy, long intervals are
         // best implemented as sequences of short ones.
@@ -996,6 +1128,15 @@ void MainApp::runStopped()
             calSRRun, "finish",
             Qt::QueuedConnection );
     }
+
+    if( benchRun ) {
+
+        benchRun->stopTimer();
+
+        QMetaObject::invokeMethod(
+            benchRun, "finish",
+            Qt::QueuedConnection );
+    }
 }
 
 
@@ -1045,6 +1186,22 @@ void MainApp::runCalFinished()
     calSRRun = 0;
 }
 
+
+void MainApp::runBenchTimeout()
+{
+    if( benchRun && run->isRunning() ) {
+        benchRun->stopTimer();
+        remoteStopsRun();
+    }
+}
+
+
+void MainApp::runBenchFinished()
+{
+    benchRun->deleteLater();
+    benchRun = 0;
+}
+
 /* ---------------------------------------------------------------- */
 /* Private -------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -1116,6 +1273,8 @@ void MainApp::loadSettings()
         settings.value( "debug", false ).toBool();
     appData.editLog =
         settings.value( "editLog", false ).toBool();
+    appData.headless =
+        settings.value( "headless", false ).toBool();
 
     settings.endGroup();
 
@@ -16,6 +16,7 @@ class AOCtl;
 class CmdSrvDlg;
 class RgtSrvDlg;
 class CalSRRun;
+class BenchRun;
 
 class QProgressDialog;
 class QSettings;
@@ -28,7 +29,8 @@ struct AppData {
     QString dataDir,
             lastViewedFile;
     bool    debug,
-            editLog;
+            editLog,
+            headless;
 };
 
 /* ---------------------------------------------------------------- */
@@ -58,6 +60,7 @@ private:
     CmdSrvDlg       *cmdSrv;
     RgtSrvDlg       *rgtSrv;
     CalSRRun        *calSRRun;
+    BenchRun        *benchRun;
     QProgressDialog *runInitingDlg;
     mutable QMutex  remoteMtx;
     AppData         appData;
@@ -111,6 +114,7 @@ public:
     bool isConsoleHidden() const;
     bool isShiftPressed() const;
     bool isLogEditable() const          {return appData.editLog;}
+    bool isHeadless() const             {return appData.headless;}
 
     bool remoteSetsDataDir( const QString &path );
     QString dataDir() const
@@ -141,11 +145,14 @@ public slots:
     void options_PickDataDir();
     void options_ExploreRunDir();
     void options_AODlg();
+    void options_ToggleHeadless();
+    void options_ReplaySource();
 
 // Tools
     void tools_VerifySha1();
     void tools_ShowPar2Win();
     void tools_CalSRate();
+    void tools_Benchmark();
     void tools_ImClose();
     void tools_ImBist();
     void tools_ImFirmware();
@@ -196,6 +203,8 @@ public slots:
     void runLogErrorToDisk( const QString &e );
     void runUpdateCalTimer();
     void runCalFinished();
+    void runBenchTimeout();
+    void runBenchFinished();
 
 // -------
 // Private
@@ -3,6 +3,7 @@
 #include "MainApp.h"
 #include "CmdSrvDlg.h"
 #include "RgtSrvDlg.h"
+#include "Replay.h"
 #include "Version.h"
 
 #include <QMenuBar>
@@ -57,6 +58,21 @@ void Main_Actions::initActions()
     aoDlgAct->setShortcutContext( Qt::ApplicationShortcut );
     ConnectUI( aoDlgAct, SIGNAL(triggered()), app, SLOT(options_AODlg()) );
 
+    headlessAct = new QAction( "&Headless Runs (No Graphs)", this );
+    headlessAct->setCheckable( true );
+    headlessAct->setChecked( app->isHeadless() );
+    ConnectUI( headlessAct, SIGNAL(triggered()), app, SLOT(options_ToggleHeadless()) );
+
+    {
+        ReplayParams    R;
+        R.loadSettings();
+
+        replayAct = new QAction( "&Replay Recorded Files...", this );
+        replayAct->setCheckable( true );
+        replayAct->setChecked( R.isEnabled() );
+        ConnectUI( replayAct, SIGNAL(triggered()), app, SLOT(options_ReplaySource()) );
+    }
+
     cmdSrvOptAct = new QAction( "&Command Server Settings...", this );
     ConnectUI( cmdSrvOptAct, SIGNAL(triggered()), app->cmdSrv, SLOT(showOptionsDlg()) );
 
@@ -76,6 +92,9 @@ void Main_Actions::initActions()
     calSRateAct = new QAction( "Sample &Rates From Run...", this );
     ConnectUI( calSRateAct, SIGNAL(triggered()), app, SLOT(tools_CalSRate()) );
 
+    benchAct = new QAction( "Throughput Benc&hmark...", this );
+    ConnectUI( benchAct, SIGNAL(triggered()), app, SLOT(tools_Benchmark()) );
+
     imCloseAct = new QAction( "&Close All Imec Slots", this );
     ConnectUI( imCloseAct, SIGNAL(triggered()), app, SLOT(tools_ImClose()) );
 
@@ -169,6 +188,8 @@ void Main_Actions::initMenus( QMainWindow *w )
     m->addAction( exploreDataDirAct );
     m->addSeparator();
     m->addAction( aoDlgAct );
+    m->addAction( headlessAct );
+    m->addAction( replayAct );
     m->addSeparator();
     m->addAction( cmdSrvOptAct );
     m->addAction( rgtSrvOptAct );
@@ -178,6 +199,7 @@ void Main_Actions::initMenus( QMainWindow *w )
     m->addAction( par2Act );
     m->addSeparator();
     m->addAction( calSRateAct );
+    m->addAction( benchAct );
     m->addSeparator();
 #ifdef HAVE_IMEC
     m->addAction( imCloseAct );
@@ -28,12 +28,15 @@ public:
         *selDataDirAct,
         *exploreDataDirAct,
         *aoDlgAct,
+        *headlessAct,
+        *replayAct,
         *cmdSrvOptAct,
         *rgtSrvOptAct,
     // Tools
         *sha1Act,
         *par2Act,
         *calSRateAct,
+        *benchAct,
         *imCloseAct,
         *imBistAct,
         *imFirmAct,
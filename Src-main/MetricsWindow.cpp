@@ -5,7 +5,9 @@
 #include "Util.h"
 #include "MainApp.h"
 #include "ConfigCtl.h"
+#include "Instr.h"
 
+#include <QDir>
 #include <QFileDialog>
 #include <QKeyEvent>
 #include <QScrollBar>
@@ -40,6 +42,7 @@ MetricsWindow::MetricsWindow( QWidget *parent )
     mxUI->setupUi( this );
     ConnectUI( mxUI->helpBut, SIGNAL(clicked()), this, SLOT(help()) );
     ConnectUI( mxUI->saveBut, SIGNAL(clicked()), this, SLOT(save()) );
+    ConnectUI( mxUI->instrCB, SIGNAL(clicked(bool)), this, SLOT(instrSetEnabled(bool)) );
 
     mxTimer.setTimerType( Qt::CoarseTimer );
     mxTimer.setInterval( 2000 );
@@ -79,6 +82,8 @@ void MetricsWindow::runInit()
     prf.init();
     dsk.init();
 
+    Instr::reset();
+
     setWindowTitle(
         QString("Metrics: %1")
         .arg( mainApp()->cfgCtl()->acceptedParams.sns.runName ) );
@@ -104,6 +109,7 @@ void MetricsWindow::runEnd()
     isRun = false;
     mxTimer.stop();
     updateMx();
+    saveInstrCSV();
 }
 
 
@@ -160,6 +166,21 @@ void MetricsWindow::logAppendText( const QString &txt, const QColor &clr )
 }
 
 
+// Checkbox or remote SETINSTRUMENTATION.
+//
+void MetricsWindow::instrSetEnabled( bool on )
+{
+    mxUI->instrCB->setChecked( on );
+    Instr::setEnabled( on );
+
+    STDSETTINGS( settings, "metrics" );
+    settings.setValue( "instrEnabled", on );
+
+    if( isVisible() )
+        updateMx();
+}
+
+
 void MetricsWindow::updateMx()
 {
     QTextEdit   *te = mxUI->mxTE;
@@ -357,6 +378,13 @@ void MetricsWindow::updateMx()
         te->setTextColor( defColor );
     }
 
+// Layout
+
+    if( !prf.layout.isEmpty() ) {
+        te->append( "Stream-i (worker-thread layout):" );
+        te->append( "  " + prf.layout );
+    }
+
 // ----
 // Disk
 // ----
@@ -446,6 +474,30 @@ void MetricsWindow::updateMx()
         te->setTextColor( defColor );
     }
 
+// ---------------
+// Instrumentation
+// ---------------
+
+    if( Instr::isEnabled() ) {
+
+        QStringList sl;
+
+        Instr::report( sl );
+
+        te->setFontPointSize( 12 );
+        te->setFontWeight( QFont::Bold );
+        te->append( "Instrumentation" );
+        te->setFontPointSize( defSize );
+        te->setFontWeight( defWeight );
+
+        if( sl.isEmpty() )
+            te->append( "No samples yet." );
+        else {
+            foreach( const QString &s, sl )
+                te->append( s );
+        }
+    }
+
 // Restore user cursor
 
     S = te->horizontalScrollBar();
@@ -585,13 +637,46 @@ void MetricsWindow::saveScreenState()
 
 void MetricsWindow::restoreScreenState()
 {
-    STDSETTINGS( settings, "windowlayout" );
+    {
+        STDSETTINGS( settings, "windowlayout" );
+
+        if( !restoreGeometry(
+            settings.value( "WinLayout_Metrics/geometry" ).toByteArray() ) ) {
+
+            // Get size from form, or do nothing.
+        }
+    }
+
+    {
+        STDSETTINGS( settings, "metrics" );
 
-    if( !restoreGeometry(
-        settings.value( "WinLayout_Metrics/geometry" ).toByteArray() ) ) {
+        bool    on = settings.value( "instrEnabled", false ).toBool();
 
-        // Get size from form, or do nothing.
+        mxUI->instrCB->setChecked( on );
+        Instr::setEnabled( on );
     }
 }
 
 
+// Write instrumentation summary next to the run's data files:
+// dataDir/run_gN/run_gN.instr.csv
+//
+void MetricsWindow::saveInstrCSV()
+{
+    if( !Instr::isEnabled() || dsk.g < 0 )
+        return;
+
+    QString runName = mainApp()->cfgCtl()->acceptedParams.sns.runName,
+            dir     = QString("%1/%2_g%3")
+                        .arg( mainApp()->dataDir() )
+                        .arg( runName ).arg( dsk.g );
+
+    if( !QDir( dir ).exists() )
+        dir = mainApp()->dataDir();
+
+    Instr::writeCSV(
+        QString("%1/%2_g%3.instr.csv")
+        .arg( dir ).arg( runName ).arg( dsk.g ) );
+}
+
+
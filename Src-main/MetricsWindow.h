@@ -53,7 +53,8 @@ private:
     struct MXPrfRec {
         QMap<int,int>   fifoPct;
         QMap<int,int>   awakePct;
-        void init() {fifoPct.clear(); awakePct.clear();}
+        QString         layout;
+        void init() {fifoPct.clear(); awakePct.clear(); layout.clear();}
         void setFifo( int ip, int maxFifo )
             {fifoPct[ip]=maxFifo;}
         void setAwake( int ip0, int ipN, int pct )
@@ -124,6 +125,8 @@ public slots:
         {prf.setFifo( ip, maxFifo );}
     void prfUpdateAwake( int ip0, int ipN, int pct )
         {prf.setAwake( ip0, ipN, pct );}
+    void prfUpdateLayout( const QString &s )
+        {prf.layout = s;}
 
     void dskUpdateGT( int g, int t )
         {dsk.setGT( g, t );}
@@ -137,6 +140,7 @@ public slots:
         {dsk.setLag( pct, ip );}
 
     void logAppendText( const QString &txt, const QColor &clr );
+    void instrSetEnabled( bool on );
 
 private slots:
     void updateMx();
@@ -153,6 +157,7 @@ protected:
 private:
     void saveScreenState();
     void restoreScreenState();
+    void saveInstrCSV();
 };
 
 #endif  // METRICSWINDOW_H
@@ -1,6 +1,8 @@
 
 HEADERS += \
     $$PWD/ConsoleWindow.h \
+    $$PWD/Instr.h \
+    $$PWD/KernelTest.h \
     $$PWD/Main_Actions.h \
     $$PWD/Main_Msg.h \
     $$PWD/Main_WinMenu.h \
@@ -12,6 +14,8 @@ HEADERS += \
 
 SOURCES += \
     $$PWD/ConsoleWindow.cpp \
+    $$PWD/Instr.cpp \
+    $$PWD/KernelTest.cpp \
     $$PWD/main.cpp \
     $$PWD/Main_Actions.cpp \
     $$PWD/Main_Msg.cpp \
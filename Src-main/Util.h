@@ -301,12 +301,16 @@ int getNProcessors();
 // Which processor calling thread is running on
 int getCurProcessorIdx();
 
+// NUMA node of that processor; -1 if unknown (Windows only)
+int getCurNumaNode();
+
 // Mask-bits set which processors to run on
 void setProcessAffinityMask( uint mask );
 
-// Mask-bits set which processors to run on.
+// Mask-bits set which processors (of up to 64 in the
+// thread's processor group) to run on.
 // Return previous mask, or zero if error.
-uint setCurrentThreadAffinityMask( uint mask );
+quint64 setCurrentThreadAffinityMask( quint64 mask );
 
 // Installed RAM as seen by 32-bit application
 double getRAMBytes32BitApp();
@@ -314,6 +318,32 @@ double getRAMBytes32BitApp();
 // Installed RAM as seen by 64-bit application
 double getRAMBytes64BitApp();
 
+// This process's CPU time (user + kernel), all threads
+double getProcessCPUSecs();
+
+// Calling thread's CPU time (user + kernel)
+double getThreadCPUSecs();
+
+// This process's resident memory; current or peak
+double getProcessMemBytes( bool peak = false );
+
+// Page-aligned, untouched block for big ring buffers.
+// hugePages {0=no, 1=transparent, 2=explicit}; falls back to
+// normal pages if unavailable. Windows: 1 and 2 both mean large
+// pages, which are committed at once on numaNode (-1 = caller's
+// node); elsewhere placement is by first touch. On return, bytes
+// is the mapped size to pass to freeBigBlock, and huge tells if
+// huge pages were obtained (or advised). Return 0 if error.
+void *allocBigBlock(
+    size_t  &bytes,
+    int     hugePages,
+    bool    &huge,
+    int     numaNode = -1 );
+void freeBigBlock( void *p, size_t bytes );
+
+// CPU and OS support AVX2 (x86 only)
+bool cpuHasAVX2();
+
 /* ---------------------------------------------------------------- */
 /* Misc OS helpers ------------------------------------------------ */
 /* ---------------------------------------------------------------- */
@@ -19,6 +19,11 @@
 
 #ifdef Q_OS_WIN
     #include <QDir>
+    #include <windows.h>
+    #include <psapi.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
 #elif defined(Q_WS_X11)
     #include <GL/gl.h>
     #include <GL/glx.h>
@@ -50,6 +55,7 @@
 #endif
 
 #if !defined(Q_OS_WIN)
+    #include <sys/resource.h>
     #include <sys/socket.h>
     #include <netinet/in.h>
     #include <netinet/tcp.h>
@@ -688,6 +694,34 @@ int getCurProcessorIdx()
 
 #endif
 
+/* ---------------------------------------------------------------- */
+/* getCurNumaNode ------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef Q_OS_WIN
+
+int getCurNumaNode()
+{
+    PROCESSOR_NUMBER    pn;
+    USHORT              node;
+
+    GetCurrentProcessorNumberEx( &pn );
+
+    if( !GetNumaProcessorNodeEx( &pn, &node ) || node == 0xFFFF )
+        return -1;
+
+    return node;
+}
+
+#else
+
+int getCurNumaNode()
+{
+    return -1;
+}
+
+#endif
+
 /* ---------------------------------------------------------------- */
 /* setProcessAffinityMask ----------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -763,16 +797,16 @@ void setProcessAffinityMask( uint )
 
 #ifdef Q_OS_WIN
 
-uint setCurrentThreadAffinityMask( uint mask )
+quint64 setCurrentThreadAffinityMask( quint64 mask )
 {
     return
-        static_cast<uint>(
+        static_cast<quint64>(
         SetThreadAffinityMask( GetCurrentThread(), (DWORD_PTR)mask ));
 }
 
 #else /* !Q_OS_WIN */
 
-uint setCurrentThreadAffinityMask( uint )
+quint64 setCurrentThreadAffinityMask( quint64 )
 {
     Warning() << "setCurrentThreadAffinityMask not implemented.";
     return 0;
@@ -857,6 +891,368 @@ double getRAMBytes64BitApp()
 
 #endif
 
+/* ---------------------------------------------------------------- */
+/* getProcessCPUSecs ---------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef Q_OS_WIN
+
+double getProcessCPUSecs()
+{
+    FILETIME    tCreate, tExit, tKernel, tUser;
+
+    if( !GetProcessTimes(
+            GetCurrentProcess(),
+            &tCreate, &tExit, &tKernel, &tUser ) ) {
+
+        return 0.0;
+    }
+
+    // FILETIME units are 100 ns
+
+    quint64 k = (quint64(tKernel.dwHighDateTime) << 32)
+                    + tKernel.dwLowDateTime,
+            u = (quint64(tUser.dwHighDateTime) << 32)
+                    + tUser.dwLowDateTime;
+
+    return 1e-7 * (k + u);
+}
+
+#else /* !Q_OS_WIN */
+
+double getProcessCPUSecs()
+{
+    struct rusage   R;
+
+    if( getrusage( RUSAGE_SELF, &R ) )
+        return 0.0;
+
+    return R.ru_utime.tv_sec + 1e-6 * R.ru_utime.tv_usec
+            + R.ru_stime.tv_sec + 1e-6 * R.ru_stime.tv_usec;
+}
+
+#endif
+
+/* ---------------------------------------------------------------- */
+/* getThreadCPUSecs ----------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef Q_OS_WIN
+
+double getThreadCPUSecs()
+{
+    FILETIME    tCreate, tExit, tKernel, tUser;
+
+    if( !GetThreadTimes(
+            GetCurrentThread(),
+            &tCreate, &tExit, &tKernel, &tUser ) ) {
+
+        return 0.0;
+    }
+
+    // FILETIME units are 100 ns
+
+    quint64 k = (quint64(tKernel.dwHighDateTime) << 32)
+                    + tKernel.dwLowDateTime,
+            u = (quint64(tUser.dwHighDateTime) << 32)
+                    + tUser.dwLowDateTime;
+
+    return 1e-7 * (k + u);
+}
+
+#elif defined(Q_OS_LINUX)
+
+double getThreadCPUSecs()
+{
+    struct timespec ts;
+
+    if( clock_gettime( CLOCK_THREAD_CPUTIME_ID, &ts ) )
+        return 0.0;
+
+    return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+#else
+
+double getThreadCPUSecs()
+{
+    return 0.0;
+}
+
+#endif
+
+/* ---------------------------------------------------------------- */
+/* getProcessMemBytes --------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef Q_OS_WIN
+
+double getProcessMemBytes( bool peak )
+{
+    PROCESS_MEMORY_COUNTERS info;
+
+    if( !GetProcessMemoryInfo(
+            GetCurrentProcess(), &info, sizeof(info) ) ) {
+
+        return 0.0;
+    }
+
+    return double(peak ? info.PeakWorkingSetSize : info.WorkingSetSize);
+}
+
+#elif defined(Q_OS_LINUX)
+
+// Current from /proc/self/statm (pages), peak from rusage (KB).
+//
+double getProcessMemBytes( bool peak )
+{
+    if( !peak ) {
+
+        QFile   f( "/proc/self/statm" );
+
+        if( f.open( QIODevice::ReadOnly | QIODevice::Text ) ) {
+
+            QStringList sl = QString( f.readLine() ).split( ' ' );
+
+            if( sl.size() > 1 )
+                return sl[1].toDouble() * sysconf( _SC_PAGESIZE );
+        }
+    }
+
+    struct rusage   R;
+
+    if( getrusage( RUSAGE_SELF, &R ) )
+        return 0.0;
+
+    return 1024.0 * R.ru_maxrss;
+}
+
+#else /* !Q_OS_WIN && !Q_OS_LINUX */
+
+// Peak only; macOS reports ru_maxrss in bytes.
+//
+double getProcessMemBytes( bool )
+{
+    struct rusage   R;
+
+    if( getrusage( RUSAGE_SELF, &R ) )
+        return 0.0;
+
+    return double(R.ru_maxrss);
+}
+
+#endif
+
+/* ---------------------------------------------------------------- */
+/* allocBigBlock -------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef Q_OS_WIN
+
+// Large pages need SeLockMemoryPrivilege granted to the user.
+//
+static bool enableLockMemPrivilege()
+{
+    HANDLE              tok;
+    TOKEN_PRIVILEGES    tp;
+    bool                ok = false;
+
+    if( !OpenProcessToken(
+            GetCurrentProcess(),
+            TOKEN_ADJUST_PRIVILEGES | TOKEN_QUERY, &tok ) ) {
+
+        return false;
+    }
+
+    if( LookupPrivilegeValue( NULL, SE_LOCK_MEMORY_NAME,
+            &tp.Privileges[0].Luid ) ) {
+
+        tp.PrivilegeCount           = 1;
+        tp.Privileges[0].Attributes = SE_PRIVILEGE_ENABLED;
+
+        ok = AdjustTokenPrivileges( tok, FALSE, &tp, 0, NULL, NULL )
+                && GetLastError() == ERROR_SUCCESS;
+    }
+
+    CloseHandle( tok );
+    return ok;
+}
+
+
+static void *winAlloc( SIZE_T bytes, DWORD type, int numaNode )
+{
+    if( numaNode >= 0 ) {
+        return VirtualAllocExNuma( GetCurrentProcess(), NULL, bytes,
+                type, PAGE_READWRITE, numaNode );
+    }
+
+    return VirtualAlloc( NULL, bytes, type, PAGE_READWRITE );
+}
+
+
+// Windows has no transparent huge pages, so hugePages 1 and 2
+// both ask for large pages. These are locked and committed here,
+// on numaNode if given (else the calling thread's node), not at
+// first touch.
+//
+void *allocBigBlock( size_t &bytes, int hugePages, bool &huge, int numaNode )
+{
+    huge = false;
+
+    if( hugePages >= 1 ) {
+
+        SIZE_T  lp = GetLargePageMinimum();
+
+        if( lp && enableLockMemPrivilege() ) {
+
+            SIZE_T  lb  = (bytes + lp - 1) / lp * lp;
+            void    *p  = winAlloc( lb,
+                            MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+                            numaNode );
+
+            if( p ) {
+                bytes   = lb;
+                huge    = true;
+                return p;
+            }
+        }
+    }
+
+    return winAlloc( bytes, MEM_RESERVE | MEM_COMMIT, numaNode );
+}
+
+
+void freeBigBlock( void *p, size_t )
+{
+    if( p )
+        VirtualFree( p, 0, MEM_RELEASE );
+}
+
+#elif defined(Q_OS_LINUX)
+
+#define HUGEPAGEBYTES   (2*1024*1024)
+
+// Explicit pages come from the hugetlbfs pool (vm.nr_hugepages).
+// Placement is by first touch; numaNode is not used.
+//
+void *allocBigBlock( size_t &bytes, int hugePages, bool &huge, int )
+{
+    void    *p;
+
+    huge = false;
+
+#ifdef MAP_HUGETLB
+    if( hugePages >= 2 ) {
+
+        size_t  hb = (bytes + HUGEPAGEBYTES - 1)
+                        / HUGEPAGEBYTES * HUGEPAGEBYTES;
+
+        p = mmap( 0, hb, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0 );
+
+        if( p != MAP_FAILED ) {
+            bytes   = hb;
+            huge    = true;
+            return p;
+        }
+    }
+#endif
+
+    p = mmap( 0, bytes, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+
+    if( p == MAP_FAILED )
+        return 0;
+
+#ifdef MADV_HUGEPAGE
+    if( hugePages >= 1 && !madvise( p, bytes, MADV_HUGEPAGE ) )
+        huge = true;
+#endif
+
+    return p;
+}
+
+
+void freeBigBlock( void *p, size_t bytes )
+{
+    if( p )
+        munmap( p, bytes );
+}
+
+#else /* !Q_OS_WIN && !Q_OS_LINUX */
+
+void *allocBigBlock( size_t &bytes, int, bool &huge, int )
+{
+    huge = false;
+    return malloc( bytes );
+}
+
+
+void freeBigBlock( void *p, size_t )
+{
+    free( p );
+}
+
+#endif
+
+/* ---------------------------------------------------------------- */
+/* cpuHasAVX2 ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+
+// CPU reports AVX2 and OS saves YMM state.
+//
+static bool _cpuHasAVX2()
+{
+    int r[4];
+
+    __cpuid( r, 0 );
+
+    if( r[0] < 7 )
+        return false;
+
+    __cpuid( r, 1 );
+
+    if( !(r[2] & (1 << 27)) || !(r[2] & (1 << 28)) )    // OSXSAVE, AVX
+        return false;
+
+    if( (_xgetbv( 0 ) & 6) != 6 )
+        return false;
+
+    __cpuidex( r, 7, 0 );
+
+    return (r[1] & (1 << 5)) != 0;
+}
+
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+static bool _cpuHasAVX2()
+{
+    __builtin_cpu_init();
+    return __builtin_cpu_supports( "avx2" );
+}
+
+#else
+
+static bool _cpuHasAVX2()
+{
+    return false;
+}
+
+#endif
+
+
+bool cpuHasAVX2()
+{
+    static int  have = -1;
+
+    if( have < 0 )
+        have = _cpuHasAVX2();
+
+    return have;
+}
+
 /* ---------------------------------------------------------------- */
 /* isMouseDown ---------------------------------------------------- */
 /* ---------------------------------------------------------------- */
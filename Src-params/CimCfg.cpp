@@ -1,6 +1,7 @@
 
 #include "Util.h"
 #include "CimCfg.h"
+#include "ImCalCache.h"
 #include "Subset.h"
 #include "SignalBlocker.h"
 
@@ -14,6 +15,7 @@
 #include <QBitArray>
 #include <QDir>
 #include <QFileInfo>
+#include <QMutex>
 #include <QSettings>
 #include <QTableWidget>
 
@@ -1158,8 +1160,73 @@ void CimCfg::saveSettings( QSettings &S ) const
 }
 
 
+// Warm hardware: basestations a finished run left open and
+// configured (see CimAcqImec), so an identical next run can
+// skip setup. Anything else that opens or closes basestations
+// must call warmRelease() first.
+//
+static QMutex       warmMtx;
+static QString      warmKey;
+static QVector<int> warmSlots;
+static double       warmCfgSecs = 0;
+
+
+void CimCfg::warmSet(
+    const QString       &key,
+    const QVector<int>  &slots,
+    double              cfgSecs )
+{
+    QMutexLocker    ml( &warmMtx );
+
+    warmKey     = key;
+    warmSlots   = slots;
+    warmCfgSecs = cfgSecs;
+}
+
+
+// Return true if warm hardware matches key; caller then owns it.
+// Otherwise any warm hardware is closed.
+//
+bool CimCfg::warmTake( const QString &key, double &cfgSecs )
+{
+    {
+        QMutexLocker    ml( &warmMtx );
+
+        if( !warmKey.isEmpty() && warmKey == key ) {
+            cfgSecs = warmCfgSecs;
+            warmKey.clear();
+            warmSlots.clear();
+            return true;
+        }
+    }
+
+    warmRelease();
+    return false;
+}
+
+
+void CimCfg::warmRelease()
+{
+    QMutexLocker    ml( &warmMtx );
+
+    if( warmKey.isEmpty() )
+        return;
+
+#ifdef HAVE_IMEC
+    foreach( int slot, warmSlots )
+        closeBS( slot );
+#endif
+
+    warmKey.clear();
+    warmSlots.clear();
+    Log() << "IMEC warm hardware released.";
+}
+
+
 void CimCfg::closeAllBS()
 {
+    warmRelease();
+
 #ifdef HAVE_IMEC
     QString s = "Manually closing hardware; about 4 seconds...";
 
@@ -1194,6 +1261,8 @@ bool CimCfg::detect(
 // Close all
 // ---------
 
+    warmRelease();
+
 #ifdef HAVE_IMEC
     for( int is = 2; is <= 8; ++is )
         closeBS( is );
@@ -1571,6 +1640,11 @@ bool CimCfg::detect(
         QString path = QString("%1/%2").arg( calibPath() ).arg( P.sn );
 
         P.cal = QDir( path ).exists();
+
+        // Verify files now so run start finds them cached
+
+        if( P.cal )
+            ImCalCache::haveAll( P.sn );
 #else
         P.cal = 1;
 #endif
@@ -1631,6 +1705,8 @@ void CimCfg::forceProbeData(
     const QString   &sn,
     const QString   &pn )
 {
+    warmRelease();
+
 #ifdef HAVE_IMEC
     if( SUCCESS == openBS( slot ) &&
         SUCCESS == openProbe( slot, port ) ) {
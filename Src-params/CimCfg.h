@@ -312,6 +312,12 @@ public:
     // ------
 
     static void closeAllBS();
+    static void warmSet(
+        const QString       &key,
+        const QVector<int>  &slots,
+        double              cfgSecs );
+    static bool warmTake( const QString &key, double &cfgSecs );
+    static void warmRelease();
     static bool detect(
         QStringList     &slVers,
         QStringList     &slBIST,
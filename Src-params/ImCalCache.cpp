@@ -0,0 +1,144 @@
+
+#include "ImCalCache.h"
+#include "Util.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QMap>
+#include <QMutex>
+
+
+struct ImCalRec {
+    QString     path;   // API form
+    QByteArray  sha1;
+    qint64      size,
+                msecs;
+
+    ImCalRec() : size(-1), msecs(-1) {}
+};
+
+
+static QMutex                               calMtx;
+static QMap<QPair<quint64,int>,ImCalRec>    calMap;
+
+/* ---------------------------------------------------------------- */
+/* ImCalCache ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+static QString calFileName( quint64 sn, ImCalCache::CalFile f )
+{
+    return QString("%1/%2/%2_%3")
+            .arg( calibPath() )
+            .arg( sn )
+            .arg( f == ImCalCache::calADC ?
+                    "ADCCalibration.csv" : "gainCalValues.csv" );
+}
+
+
+// Return true if file verified; path is in API form.
+//
+bool ImCalCache::path(
+    QString     &path,
+    QString     &error,
+    quint64     sn,
+    CalFile     f )
+{
+    QString     name = calFileName( sn, f );
+    QFileInfo   fi( name );
+    qint64      size    = fi.size(),
+                msecs   = fi.lastModified().toMSecsSinceEpoch();
+
+// --------------
+// Unchanged hit?
+// --------------
+
+    QMutexLocker    ml( &calMtx );
+
+    ImCalRec    &R = calMap[qMakePair( sn, int(f) )];
+
+    if( fi.exists() && R.size == size && R.msecs == msecs ) {
+        path = R.path;
+        return true;
+    }
+
+// ---------------
+// Load and verify
+// ---------------
+
+    if( !fi.exists() ) {
+
+        QString dir = calibPath();
+
+        if( !QDir().mkpath( dir ) )
+            error = QString("Failed to create folder '%1'.").arg( dir );
+        else
+            error = QString("Can't find file '%1'.").arg( name );
+
+        calMap.remove( qMakePair( sn, int(f) ) );
+        return false;
+    }
+
+    QFile   F( name );
+
+    if( !F.open( QIODevice::ReadOnly ) ) {
+        error = QString("Can't open file '%1'.").arg( name );
+        calMap.remove( qMakePair( sn, int(f) ) );
+        return false;
+    }
+
+    QByteArray  data = F.readAll();
+
+    if( data.trimmed().isEmpty() ) {
+        error = QString("Calibration file '%1' is empty.").arg( name );
+        calMap.remove( qMakePair( sn, int(f) ) );
+        return false;
+    }
+
+    // First row holds the probe serial number
+
+    QByteArray  id = data.left( data.indexOf( '\n' ) ).trimmed();
+    int         ic = id.indexOf( ',' );
+    bool        isNum;
+    quint64     idSN;
+
+    if( ic >= 0 )
+        id = id.left( ic ).trimmed();
+
+    idSN = id.toULongLong( &isNum );
+
+    if( isNum && idSN != sn ) {
+        error =
+            QString("Calibration file '%1' is for probe %2.")
+            .arg( name ).arg( idSN );
+        calMap.remove( qMakePair( sn, int(f) ) );
+        return false;
+    }
+
+    QByteArray  sha1 =
+        QCryptographicHash::hash( data, QCryptographicHash::Sha1 );
+
+    if( !R.sha1.isEmpty() && R.sha1 != sha1 )
+        Log() << QString("IMEC calibration file changed '%1'.").arg( name );
+
+    R.path  = QString(name).replace( "/", "\\" );
+    R.sha1  = sha1;
+    R.size  = size;
+    R.msecs = msecs;
+
+    path = R.path;
+    return true;
+}
+
+
+bool ImCalCache::haveAll( quint64 sn )
+{
+    QString path, err;
+
+    return ImCalCache::path( path, err, sn, calADC )
+            && ImCalCache::path( path, err, sn, calGain );
+}
+
+
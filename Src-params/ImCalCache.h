@@ -0,0 +1,41 @@
+#ifndef IMCALCACHE_H
+#define IMCALCACHE_H
+
+#include <QString>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Session cache of probe calibration files, keyed by serial number.
+//
+// NeuropixAPI loads ADC and gain calibration from the csv files in
+// '_Calibration/<sn>/'. The first lookup for a file checks that it
+// exists, is non-empty and, when its first field is numeric,
+// that it names this probe. It then records the file's SHA1 and
+// {size, mod time}. Later lookups cost one stat. A file whose stat
+// changed is re-read and re-verified; a changed SHA1 is logged.
+// Lookups that failed are retried on the next call.
+//
+// Thread-safe; probes may be configured concurrently.
+//
+class ImCalCache
+{
+public:
+    enum CalFile {
+        calADC  = 0,
+        calGain = 1
+    };
+
+public:
+    static bool path(
+        QString     &path,
+        QString     &error,
+        quint64     sn,
+        CalFile     f );
+    static bool haveAll( quint64 sn );
+};
+
+#endif  // IMCALCACHE_H
+
+
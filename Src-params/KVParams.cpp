@@ -2,14 +2,70 @@
 #include "KVParams.h"
 #include "Util.h"
 
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+
+
+/* ---------------------------------------------------------------- */
+/* Statics -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#define META_CACHE_MAX      64
+#define META_SETTLE_MSECS   2000
+
+// Parsed meta files keyed by path. An entry is used only while
+// the file's {size, mod time} are unchanged. Files modified within
+// META_SETTLE_MSECS of reading are not cached, because a rewrite
+// in the same clock tick could keep both the same.
+//
+struct MetaCacheEntry {
+    KVParams    kvp;
+    qint64      size,
+                msecs;
+};
+
+static QMutex                       metaCacheMtx;
+static QMap<QString,MetaCacheEntry> metaCache;
+
+
+static bool containsNoCase(
+    const QChar     *b,
+    const QChar     *e,
+    const char      *pat,
+    int             np )
+{
+    for( e -= np - 1; b < e; ++b ) {
 
+        int i = 0;
 
+        while( i < np && b[i].toLower() == QLatin1Char(pat[i]) )
+            ++i;
 
-bool KVParams::parseOneLine( QString &line )
+        if( i == np )
+            return true;
+    }
+
+    return false;
+}
+
+/* ---------------------------------------------------------------- */
+/* KVParams ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Single pass over [b,e), no temporaries until key and value
+// are stored. On return [b,e) spans the trimmed, comment-free
+// line, as reported in errors.
+//
+bool KVParams::parseRange( const QChar* &b, const QChar* &e )
 {
-    line = line.trimmed();
+    while( b < e && b->isSpace() )
+        ++b;
 
-    if( !line.length() )
+    while( e > b && e[-1].isSpace() )
+        --e;
+
+    if( b == e )
         return true;
 
 /* ------------------------------------------ */
@@ -20,48 +76,94 @@ bool KVParams::parseOneLine( QString &line )
 // ChanMap strings might include them, so exception is
 // made for anything called 'map'.
 
-    QRegExp comment("(\\[|;|#|//).*");
+    if( !containsNoCase( b, e, "notes", 5 )
+        && !containsNoCase( b, e, "map", 3 ) ) {
 
-    if( !line.contains( "notes", Qt::CaseInsensitive )
-        && !line.contains( "map", Qt::CaseInsensitive )
-        && line.contains( comment ) ) {
+        for( const QChar *c = b; c < e; ++c ) {
 
-        Debug() << "Params comment skipped: '" << comment.cap(0) << "'";
-        line.replace( comment, QString::null );
-        line = line.trimmed();
+            ushort  u = c->unicode();
 
-        if( !line.length() )
-            return true;
+            if( u == '[' || u == ';' || u == '#'
+                || (u == '/' && c + 1 < e && c[1] == QLatin1Char('/')) ) {
+
+                Debug()
+                    << "Params comment skipped: '"
+                    << QString( c, e - c ) << "'";
+
+                e = c;
+
+                while( e > b && e[-1].isSpace() )
+                    --e;
+
+                if( b == e )
+                    return true;
+
+                break;
+            }
+        }
     }
 
 /* -------------------------- */
 /* Capture (name)=(val) pairs */
 /* -------------------------- */
 
-    QRegExp re("([^=]+)=(.*)");
+    const QChar *eq = b;
 
-    if( re.exactMatch( line ) ) {
+    while( eq < e && *eq != QLatin1Char('=') )
+        ++eq;
 
-        (*this)[re.cap(1).trimmed()] = re.cap(2).trimmed();
-        return true;
-    }
-    else {
-        Error() << "Bad params line [" << line << "].";
+    if( eq == b || eq == e ) {
+        Error() << "Bad params line [" << QString( b, e - b ) << "].";
         return false;
     }
+
+    const QChar *kE = eq,
+                *vB = eq + 1;
+
+    while( kE[-1].isSpace() )
+        --kE;
+
+    while( vB < e && vB->isSpace() )
+        ++vB;
+
+    insert( QString( b, kE - b ), QString( vB, e - vB ) );
+    return true;
 }
 
 
+bool KVParams::parseOneLine( QString &line )
+{
+    const QChar *b  = line.constData(),
+                *e  = b + line.size();
+    bool        ok  = parseRange( b, e );
+
+    line = QString( b, e - b );
+    return ok;
+}
+
+
+// Lines end with '\n'; a trailing '\r' is trimmed as space.
+//
 bool KVParams::fromString( const QString &s )
 {
-    QTextStream ts( (QString*)&s, QIODevice::ReadOnly | QIODevice::Text );
-    QString     line;
-    bool        ok = true;
+    const QChar *p  = s.constData(),
+                *E  = p + s.size();
+    bool        ok  = true;
 
     clear();
 
-    while( !(line = ts.readLine()).isNull() )
-        ok &= parseOneLine( line );
+    while( p < E ) {
+
+        const QChar *b = p,
+                    *e = p;
+
+        while( e < E && *e != QLatin1Char('\n') )
+            ++e;
+
+        p = e + 1;
+
+        ok &= parseRange( b, e );
+    }
 
     return ok;
 }
@@ -81,6 +183,25 @@ QString KVParams::toString() const
 
 bool KVParams::fromMetaFile( const QString &metaFile )
 {
+    QFileInfo   fi( metaFile );
+    qint64      size    = fi.size(),
+                msecs   = fi.lastModified().toMSecsSinceEpoch();
+
+    if( fi.exists() ) {
+
+        QMutexLocker    ml( &metaCacheMtx );
+
+        QMap<QString,MetaCacheEntry>::const_iterator
+            it = metaCache.find( fi.absoluteFilePath() );
+
+        if( it != metaCache.end()
+            && it->size == size && it->msecs == msecs ) {
+
+            *this = it->kvp;
+            return true;
+        }
+    }
+
     QFile   f( metaFile );
 
     if( f.open( QIODevice::ReadOnly | QIODevice::Text ) ) {
@@ -90,8 +211,25 @@ bool KVParams::fromMetaFile( const QString &metaFile )
 
         if( ts.status() == QTextStream::Ok ) {
 
-            if( fromString( s ) )
+            if( fromString( s ) ) {
+
+                if( QDateTime::currentMSecsSinceEpoch() - msecs
+                    >= META_SETTLE_MSECS ) {
+
+                    QMutexLocker    ml( &metaCacheMtx );
+
+                    if( metaCache.size() >= META_CACHE_MAX )
+                        metaCache.clear();
+
+                    MetaCacheEntry  &E = metaCache[fi.absoluteFilePath()];
+
+                    E.kvp   = *this;
+                    E.size  = size;
+                    E.msecs = msecs;
+                }
+
                 return true;
+            }
         }
         else {
             Error()
@@ -115,6 +253,11 @@ bool KVParams::fromMetaFile( const QString &metaFile )
 
 bool KVParams::toMetaFile( const QString &metaFile ) const
 {
+    {
+        QMutexLocker    ml( &metaCacheMtx );
+        metaCache.remove( QFileInfo( metaFile ).absoluteFilePath() );
+    }
+
     QFile   f( metaFile );
 
     if( f.open( QIODevice::WriteOnly | QIODevice::Text ) ) {
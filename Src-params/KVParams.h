@@ -16,6 +16,11 @@ typedef QMap<QString,QVariant>  KeyValMap;
 // ('key=value' pairs) between an in-memory QMap
 // and QString or disk-file versions.
 //
+// Text is tokenized in one hand-written pass. Parsed meta
+// files are cached process-wide by path, {size, mod time},
+// so validating then opening a file, or reopening it, does
+// not reparse. Returned maps are implicitly shared copies.
+//
 class KVParams : public KeyValMap
 {
 public:
@@ -31,6 +36,9 @@ public:
 
     bool fromMetaFile( const QString &metaFile );
     bool toMetaFile( const QString &metaFile ) const;
+
+private:
+    bool parseRange( const QChar* &b, const QChar* &e );
 };
 
 #endif  // KVPARAMS_H
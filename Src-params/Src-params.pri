@@ -6,13 +6,15 @@ HEADERS += \
     $$PWD/CniCfg.h \
     $$PWD/ConfigCtl.h \
     $$PWD/DAQ.h \
+    $$PWD/ImCalCache.h \
     $$PWD/IMROEditor.h \
     $$PWD/KVParams.h \
     $$PWD/SGLTypes.h \
     $$PWD/ShankMap.h \
     $$PWD/ShankMapCtl.h \
     $$PWD/SnsMaps.h \
-    $$PWD/Subset.h
+    $$PWD/Subset.h \
+    $$PWD/SubsetSIMD.h
 
 SOURCES += \
     $$PWD/ChanMap.cpp \
@@ -21,11 +23,13 @@ SOURCES += \
     $$PWD/CniCfg.cpp \
     $$PWD/ConfigCtl.cpp \
     $$PWD/DAQ.cpp \
+    $$PWD/ImCalCache.cpp \
     $$PWD/IMROEditor.cpp \
     $$PWD/KVParams.cpp \
     $$PWD/ShankMap.cpp \
     $$PWD/ShankMapCtl.cpp \
     $$PWD/SnsMaps.cpp \
-    $$PWD/Subset.cpp
+    $$PWD/Subset.cpp \
+    $$PWD/SubsetSIMD.cpp
 
 
@@ -1,5 +1,6 @@
 
 #include "Subset.h"
+#include "SubsetSIMD.h"
 
 #include <QStringList>
 #include <QTextStream>
@@ -353,6 +354,9 @@ bool Subset::rngStr2Vec( QVector<uint> &v, const QString &s )
 //
 // In-place operation (dst == src) is allowed.
 //
+// Ascending runs in iKeep[] are copied as blocks when they
+// average at least 4 channels; else per-channel gather.
+//
 void Subset::subset(
     vec_i16             &dst,
     vec_i16             &src,
@@ -371,6 +375,11 @@ void Subset::subset(
 
     int ntpts = (int)src.size() / nchans;
 
+    if( !nk || !ntpts ) {
+        dst.clear();
+        return;
+    }
+
     if( &dst != &src )
         dst.resize( ntpts * nk );
 
@@ -378,10 +387,50 @@ void Subset::subset(
     qint16      *D = &dst[0],
                 *S = &src[0];
 
-    for( int it = 0; it < ntpts; ++it, S += nchans ) {
+// ----------
+// Build runs
+// ----------
+
+    std::vector<int>    run;    // (src offset, length) pairs
+
+    for( int ik = 0; ik < nk; ++ik ) {
+
+        if( ik && K[ik] == K[ik-1] + 1 )
+            ++run.back();
+        else {
+            run.push_back( K[ik] );
+            run.push_back( 1 );
+        }
+    }
+
+    int nrun = run.size() / 2;
+
+// -----
+// Apply
+// -----
+
+    if( 4 * nrun <= nk ) {
+
+        const int   *R = &run[0];
+
+        for( int it = 0; it < ntpts; ++it, S += nchans ) {
+
+            for( int ir = 0; ir < 2*nrun; ir += 2 ) {
+
+                // memmove: src and dst overlap in-place
+
+                memmove( D, S + R[ir], R[ir+1]*sizeof(qint16) );
+                D += R[ir+1];
+            }
+        }
+    }
+    else {
+
+        for( int it = 0; it < ntpts; ++it, S += nchans ) {
 
-        for( int ik = 0; ik < nk; ++ik )
-            *D++ = S[K[ik]];
+            for( int ik = 0; ik < nk; ++ik )
+                *D++ = S[K[ik]];
+        }
     }
 
     if( &dst == &src )
@@ -436,6 +485,8 @@ void Subset::subsetBlock(
 
 // All src channels are downsampled/averaged.
 //
+// Bins up to 65536 sum in int32 with the SIMD kernels.
+//
 // In-place operation (dst == src) is allowed.
 //
 // Return count of resulting dst timepoints.
@@ -461,24 +512,31 @@ uint Subset::downsample(
     if( &dst != &src )
         dst.resize( dtpts * nchans );
 
-    qint16              *D = &dst[0],
-                        *S = &src[0];
-    std::vector<double> sum( nchans );
+    if( dnsmp <= 65536 ) {
+        subsetDsMean(
+            subsetKernels( nchans ), &dst[0], &src[0], ntpts, nchans, dnsmp );
+    }
+    else {
+
+        qint16              *D = &dst[0],
+                            *S = &src[0];
+        std::vector<double> sum( nchans );
+
+        for( int it = 0; it < ntpts; it += dnsmp, D += nchans ) {
 
-    for( int it = 0; it < ntpts; it += dnsmp, D += nchans ) {
+            int ns = std::min( ntpts - it, dnsmp );
 
-        int ns = std::min( ntpts - it, dnsmp );
+            memset( &sum[0], 0, nchans*sizeof(double) );
 
-        memset( &sum[0], 0, nchans*sizeof(double) );
+            for( int is = 0; is < ns; ++is, S += nchans ) {
 
-        for( int is = 0; is < ns; ++is, S += nchans ) {
+                for( int ic = 0; ic < nchans; ++ic )
+                    sum[ic] += S[ic];
+            }
 
             for( int ic = 0; ic < nchans; ++ic )
-                sum[ic] += S[ic];
+                D[ic] = qint16(sum[ic] / ns);
         }
-
-        for( int ic = 0; ic < nchans; ++ic )
-            D[ic] = qint16(sum[ic] / ns);
     }
 
     if( &dst == &src )
@@ -519,40 +577,8 @@ uint Subset::downsampleNeural(
     if( &dst != &src )
         dst.resize( dtpts * nchans );
 
-    qint16  *D = &dst[0],
-            *S = &src[0];
-    vec_i16 bMin( nchans ),
-            bMax( nchans );
-
-    for( int it = 0; it < ntpts; it += dnsmp, D += nchans ) {
-
-        int ns = std::min( ntpts - it, dnsmp );
-
-        memcpy( &bMin[0], S, nchans*sizeof(qint16) );
-        memcpy( &bMax[0], S, nchans*sizeof(qint16) );
-        S += nchans;
-
-        for( int is = 1; is < ns; ++is, S += nchans ) {
-
-            for( int ic = 0; ic < nchans; ++ic ) {
-
-                int val = S[ic];
-
-                if( val <= bMin[ic] )
-                    bMin[ic] = val;
-                else if( val > bMax[ic] )
-                    bMax[ic] = val;
-            }
-        }
-
-        for( int ic = 0; ic < nchans; ++ic ) {
-
-            if( abs( bMax[ic] ) >= abs( bMin[ic] ) )
-                D[ic] = bMax[ic];
-            else
-                D[ic] = bMin[ic];
-        }
-    }
+    subsetDsNeural(
+        subsetKernels( nchans ), &dst[0], &src[0], ntpts, nchans, dnsmp );
 
     if( &dst == &src )
         dst.resize( dtpts * nchans );
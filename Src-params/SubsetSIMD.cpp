@@ -0,0 +1,428 @@
+
+#include "SubsetSIMD.h"
+#include "Subset.h"
+#include "KernelTest.h"
+#include "Util.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define SUBSET_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #define TARGET_AVX2
+    #else
+        #define TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+
+/* ---------------------------------------------------------------- */
+/* Scalar kernels ------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+static void sumScalar( qint32 *sum, const qint16 *S, int n )
+{
+    for( int i = 0; i < n; ++i )
+        sum[i] += S[i];
+}
+
+
+static void minMaxScalar(
+    qint16          *bMin,
+    qint16          *bMax,
+    const qint16    *S,
+    int             n )
+{
+    for( int i = 0; i < n; ++i ) {
+
+        int val = S[i];
+
+        if( val <= bMin[i] )
+            bMin[i] = val;
+        else if( val > bMax[i] )
+            bMax[i] = val;
+    }
+}
+
+
+static void pickScalar(
+    qint16          *D,
+    const qint16    *bMin,
+    const qint16    *bMax,
+    int             n )
+{
+    for( int i = 0; i < n; ++i ) {
+
+        if( abs( bMax[i] ) >= abs( bMin[i] ) )
+            D[i] = bMax[i];
+        else
+            D[i] = bMin[i];
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* AVX2 kernels --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef SUBSET_X86
+
+// 16 channels per step: widen to two int32 lanes and add.
+//
+TARGET_AVX2 static void sumAVX2( qint32 *sum, const qint16 *S, int n )
+{
+    int i = 0;
+
+    for( ; i + 16 <= n; i += 16 ) {
+
+        __m256i s   = _mm256_loadu_si256( (const __m256i*)(S + i) ),
+                lo  = _mm256_cvtepi16_epi32(
+                        _mm256_castsi256_si128( s ) ),
+                hi  = _mm256_cvtepi16_epi32(
+                        _mm256_extracti128_si256( s, 1 ) );
+
+        _mm256_storeu_si256(
+            (__m256i*)(sum + i),
+            _mm256_add_epi32(
+                _mm256_loadu_si256( (const __m256i*)(sum + i) ), lo ) );
+
+        _mm256_storeu_si256(
+            (__m256i*)(sum + i + 8),
+            _mm256_add_epi32(
+                _mm256_loadu_si256( (const __m256i*)(sum + i + 8) ), hi ) );
+    }
+
+    for( ; i < n; ++i )
+        sum[i] += S[i];
+}
+
+
+TARGET_AVX2 static void minMaxAVX2(
+    qint16          *bMin,
+    qint16          *bMax,
+    const qint16    *S,
+    int             n )
+{
+    int i = 0;
+
+    for( ; i + 16 <= n; i += 16 ) {
+
+        __m256i s = _mm256_loadu_si256( (const __m256i*)(S + i) );
+
+        _mm256_storeu_si256(
+            (__m256i*)(bMin + i),
+            _mm256_min_epi16(
+                _mm256_loadu_si256( (const __m256i*)(bMin + i) ), s ) );
+
+        _mm256_storeu_si256(
+            (__m256i*)(bMax + i),
+            _mm256_max_epi16(
+                _mm256_loadu_si256( (const __m256i*)(bMax + i) ), s ) );
+    }
+
+    minMaxScalar( bMin + i, bMax + i, S + i, n - i );
+}
+
+
+// Compare |values| as unsigned so |-32768| = 32768, like abs(int).
+//
+TARGET_AVX2 static void pickAVX2(
+    qint16          *D,
+    const qint16    *bMin,
+    const qint16    *bMax,
+    int             n )
+{
+    int i = 0;
+
+    for( ; i + 16 <= n; i += 16 ) {
+
+        __m256i mn  = _mm256_loadu_si256( (const __m256i*)(bMin + i) ),
+                mx  = _mm256_loadu_si256( (const __m256i*)(bMax + i) ),
+                amn = _mm256_abs_epi16( mn ),
+                amx = _mm256_abs_epi16( mx ),
+                ge  = _mm256_cmpeq_epi16(
+                        _mm256_max_epu16( amx, amn ), amx );
+
+        _mm256_storeu_si256(
+            (__m256i*)(D + i),
+            _mm256_blendv_epi8( mn, mx, ge ) );
+    }
+
+    pickScalar( D + i, bMin + i, bMax + i, n - i );
+}
+
+#endif
+
+/* ---------------------------------------------------------------- */
+/* Selection ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+static const SubsetKernels  kScalar =
+    {"scalar", sumScalar, minMaxScalar, pickScalar};
+
+#ifdef SUBSET_X86
+static const SubsetKernels  kAVX2 =
+    {"AVX2", sumAVX2, minMaxAVX2, pickAVX2};
+#endif
+
+
+const SubsetKernels &subsetKernelsScalar()
+{
+    return kScalar;
+}
+
+
+// Rows narrower than one AVX2 vector stay scalar.
+//
+const SubsetKernels &subsetKernels( int nchans )
+{
+#ifdef SUBSET_X86
+    if( nchans >= 16 && cpuHasAVX2() )
+        return kAVX2;
+#endif
+
+    return kScalar;
+}
+
+/* ---------------------------------------------------------------- */
+/* Downsample loops ----------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Each dst bin is written after all its src rows are read,
+// and never lies beyond them, so D == S is safe.
+//
+void subsetDsMean(
+    const SubsetKernels &K,
+    qint16              *D,
+    const qint16        *S,
+    int                 ntpts,
+    int                 nchans,
+    int                 dnsmp )
+{
+    std::vector<qint32> sum( nchans );
+
+    for( int it = 0; it < ntpts; it += dnsmp, D += nchans ) {
+
+        int ns = qMin( ntpts - it, dnsmp );
+
+        memset( &sum[0], 0, nchans*sizeof(qint32) );
+
+        for( int is = 0; is < ns; ++is, S += nchans )
+            K.sum( &sum[0], S, nchans );
+
+        for( int ic = 0; ic < nchans; ++ic )
+            D[ic] = qint16(sum[ic] / ns);
+    }
+}
+
+
+void subsetDsNeural(
+    const SubsetKernels &K,
+    qint16              *D,
+    const qint16        *S,
+    int                 ntpts,
+    int                 nchans,
+    int                 dnsmp )
+{
+    vec_i16 bMin( nchans ),
+            bMax( nchans );
+
+    for( int it = 0; it < ntpts; it += dnsmp, D += nchans ) {
+
+        int ns = qMin( ntpts - it, dnsmp );
+
+        memcpy( &bMin[0], S, nchans*sizeof(qint16) );
+        memcpy( &bMax[0], S, nchans*sizeof(qint16) );
+        S += nchans;
+
+        for( int is = 1; is < ns; ++is, S += nchans )
+            K.minMax( &bMin[0], &bMax[0], S, nchans );
+
+        K.pick( D, &bMin[0], &bMax[0], nchans );
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* Self-check and bench ------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// imec 385, 770; NI 8..64.
+static const int    tstNCh[]    = {385, 770, 8, 16, 32, 64},
+                    tstNNCh     = sizeof(tstNCh) / sizeof(int);
+
+#define TSTDNSMP    30
+
+
+// Keep all but a block of 20 and every 16th channel above
+// the middle: a few long runs then many short ones.
+//
+static void subsetTestKeep( QVector<uint> &iKeep, int nchans )
+{
+    iKeep.clear();
+
+    for( int ic = 0; ic < nchans; ++ic ) {
+
+        if( ic >= nchans / 4 && ic < nchans / 4 + 20 )
+            continue;
+
+        if( ic > nchans / 2 && !(ic % 16) )
+            continue;
+
+        iKeep.push_back( ic );
+    }
+}
+
+
+static void subsetGatherRef(
+    vec_i16             &D,
+    const vec_i16       &S,
+    const QVector<uint> &iKeep,
+    int                 nchans )
+{
+    int nk      = iKeep.size(),
+        ntpts   = S.size() / nchans;
+
+    D.resize( ntpts * nk );
+
+    const qint16    *s = &S[0];
+    qint16          *d = &D[0];
+
+    for( int it = 0; it < ntpts; ++it, s += nchans ) {
+
+        for( int ik = 0; ik < nk; ++ik )
+            *d++ = s[iKeep[ik]];
+    }
+}
+
+
+// Partial last bin (ntpts % TSTDNSMP != 0), and in-place
+// downsampling as the graph fetchers use it.
+//
+bool subsetSelfCheck( QString &err )
+{
+    const SubsetKernels &KS = subsetKernelsScalar();
+
+    for( int iv = 0; iv < tstNNCh; ++iv ) {
+
+        int             nchans  = tstNCh[iv],
+                        ntpts   = 10 * TSTDNSMP + 7;
+        vec_i16         src( ntpts * nchans ),
+                        d1, d2;
+        QVector<uint>   iKeep;
+        QString         what;
+        KTRand          R( 12345 + nchans );
+
+        const SubsetKernels &KB = subsetKernels( nchans );
+
+        R.fill( src );
+        subsetTestKeep( iKeep, nchans );
+
+        subsetGatherRef( d1, src, iKeep, nchans );
+        Subset::subset( d2, src, iKeep, nchans );
+
+        what = QString("subset %1 ch").arg( nchans );
+
+        if( !ktCompare( err, what, d1, d2, iKeep.size() ) )
+            return false;
+
+        for( int neural = 0; neural < 2; ++neural ) {
+
+            d1 = src;
+            d2 = src;
+
+            if( neural ) {
+                subsetDsNeural( KS, &d1[0], &d1[0], ntpts, nchans, TSTDNSMP );
+                subsetDsNeural( KB, &d2[0], &d2[0], ntpts, nchans, TSTDNSMP );
+            }
+            else {
+                subsetDsMean( KS, &d1[0], &d1[0], ntpts, nchans, TSTDNSMP );
+                subsetDsMean( KB, &d2[0], &d2[0], ntpts, nchans, TSTDNSMP );
+            }
+
+            what = QString("subset %1 %2 ch")
+                    .arg( neural ? "neural" : "mean" ).arg( nchans );
+
+            if( !ktCompare( err, what, d1, d2, nchans ) )
+                return false;
+        }
+    }
+
+    return true;
+}
+
+
+// About 1M samples per channel count.
+//
+void subsetBench( QStringList &sl )
+{
+    const int   nReps = 20;
+
+    sl.append(
+        QString("  subset kernels: %1 (us per ~1M samples, scalar/best)")
+        .arg( subsetKernels( 1 << 16 ).name ) );
+
+    for( int iv = 0; iv < tstNNCh; ++iv ) {
+
+        int             nchans  = tstNCh[iv],
+                        ntpts   = (1 << 20) / nchans;
+        vec_i16         src( ntpts * nchans ),
+                        d;
+        QVector<uint>   iKeep;
+        KTRand          R;
+        KTTimer         T;
+        double          us[6];
+
+        const SubsetKernels &KS = subsetKernelsScalar(),
+                            &KB = subsetKernels( nchans );
+
+        R.fill( src );
+        subsetTestKeep( iKeep, nchans );
+
+        // Subset: scalar gather vs Subset::subset
+
+        T.start();
+
+        for( int r = 0; r < nReps; ++r )
+            subsetGatherRef( d, src, iKeep, nchans );
+
+        us[0] = T.usPer( nReps );
+        T.start();
+
+        for( int r = 0; r < nReps; ++r )
+            Subset::subset( d, src, iKeep, nchans );
+
+        us[1] = T.usPer( nReps );
+
+        // Mean and neural, scalar vs best
+
+        d.resize( src.size() );
+
+        for( int k = 0; k < 2; ++k ) {
+
+            const SubsetKernels &K = (k ? KB : KS);
+
+            T.start();
+
+            for( int r = 0; r < nReps; ++r )
+                subsetDsMean( K, &d[0], &src[0], ntpts, nchans, TSTDNSMP );
+
+            us[2 + k] = T.usPer( nReps );
+            T.start();
+
+            for( int r = 0; r < nReps; ++r )
+                subsetDsNeural( K, &d[0], &src[0], ntpts, nchans, TSTDNSMP );
+
+            us[4 + k] = T.usPer( nReps );
+        }
+
+        sl.append(
+            QString("  %1 ch: subset %2/%3  mean %4/%5  neural %6/%7")
+            .arg( nchans, 3 )
+            .arg( us[0], 0, 'f', 0 ).arg( us[1], 0, 'f', 0 )
+            .arg( us[2], 0, 'f', 0 ).arg( us[3], 0, 'f', 0 )
+            .arg( us[4], 0, 'f', 0 ).arg( us[5], 0, 'f', 0 ) );
+    }
+}
+
+
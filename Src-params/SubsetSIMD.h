@@ -0,0 +1,80 @@
+#ifndef SUBSETSIMD_H
+#define SUBSETSIMD_H
+
+#include "SGLTypes.h"
+
+#include <QStringList>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Per-row kernels behind Subset::downsample/downsampleNeural.
+// Each operates across n channels of one timepoint:
+//
+// sum:     sum[i] += S[i]
+// minMax:  bMin[i] = min( bMin[i], S[i] ), bMax likewise
+// pick:    D[i] = (|bMax[i]| >= |bMin[i]| ? bMax[i] : bMin[i])
+//
+// All kernel sets produce identical output.
+//
+struct SubsetKernels
+{
+    const char  *name;
+
+    void (*sum)( qint32 *sum, const qint16 *S, int n );
+
+    void (*minMax)(
+        qint16          *bMin,
+        qint16          *bMax,
+        const qint16    *S,
+        int             n );
+
+    void (*pick)(
+        qint16          *D,
+        const qint16    *bMin,
+        const qint16    *bMax,
+        int             n );
+};
+
+/* ---------------------------------------------------------------- */
+/* Functions ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+const SubsetKernels &subsetKernelsScalar();
+
+// Fastest set this CPU supports for rows of nchans
+const SubsetKernels &subsetKernels( int nchans );
+
+// Bin-average ntpts timepoints of nchans by dnsmp into D.
+// D may equal S. dnsmp must be <= 65536 (int32 sums).
+void subsetDsMean(
+    const SubsetKernels &K,
+    qint16              *D,
+    const qint16        *S,
+    int                 ntpts,
+    int                 nchans,
+    int                 dnsmp );
+
+// Bin by dnsmp keeping each channel's largest amplitude.
+// D may equal S.
+void subsetDsNeural(
+    const SubsetKernels &K,
+    qint16              *D,
+    const qint16        *S,
+    int                 ntpts,
+    int                 nchans,
+    int                 dnsmp );
+
+// Compare Subset::subset to a plain gather, and best to scalar
+// downsample kernels, for common channel counts (imec 385, 770;
+// NI 8..64). Return false and describe first mismatch. Run by
+// the KernelChecks test app.
+bool subsetSelfCheck( QString &err );
+
+// Time the same kernels; append report lines to sl.
+void subsetBench( QStringList &sl );
+
+#endif  // SUBSETSIMD_H
+
+
@@ -4,8 +4,12 @@
 #include "MainApp.h"
 #include "Version.h"
 #include "ConfigCtl.h"
+#include "Instr.h"
+#include "MetricsWindow.h"
 #include "AOCtl.h"
 #include "AIQ.h"
+#include "DFCatalog.h"
+#include "FetchFlt.h"
 #include "Run.h"
 #include "Sync.h"
 #include "Subset.h"
@@ -15,16 +19,19 @@
 #include <QDir>
 #include <QDirIterator>
 #include <QThread>
+#include <QThreadPool>
 
 
 /* ---------------------------------------------------------------- */
 /* Statics -------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
-static QMutex   kilMtx;
-static bool     allstop = false;
-static void     stopAll()   {QMutexLocker ml(&kilMtx); allstop=true;}
-static bool     allStop()   {QMutexLocker ml(&kilMtx); return allstop;}
+static QMutex       kilMtx;
+static bool         allstop = false;
+static void         stopAll()   {QMutexLocker ml(&kilMtx); allstop=true;}
+static bool         allStop()   {QMutexLocker ml(&kilMtx); return allstop;}
+
+static QThreadPool  *_jobPool = 0;
 
 /* ---------------------------------------------------------------- */
 /* class CmdServer ------------------------------------------------ */
@@ -45,6 +52,8 @@ bool CmdServer::beginListening(
 
     timeout_msecs = timeout_ms;
 
+    jobPool();  // create from GUI thread before any worker
+
     if( iface == "0.0.0.0" )
         haddr = QHostAddress::Any;
     else if( iface == "localhost" || iface == "127.0.0.1" )
@@ -74,6 +83,20 @@ void CmdServer::deleteAllActiveConnections()
 }
 
 
+// Shared by all connections; never deleted.
+//
+QThreadPool *CmdServer::jobPool()
+{
+    if( !_jobPool ) {
+        _jobPool = new QThreadPool;
+        _jobPool->setMaxThreadCount(
+            qMax( 2, QThread::idealThreadCount() / 2 ) );
+    }
+
+    return _jobPool;
+}
+
+
 // Create and start a self-destructing connection worker.
 //
 void CmdServer::incomingConnection( qintptr sockFd )
@@ -91,6 +114,259 @@ void CmdServer::incomingConnection( qintptr sockFd )
     thread->start();
 }
 
+/* ---------------------------------------------------------------- */
+/* class CmdJob --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Run on the pool; block calling thread until done,
+// relaying posted values as they arrive.
+//
+void CmdJob::exec()
+{
+    QVector<int>    V;
+    bool            fin;
+
+    done    = false;
+    tSubmit = Instr::startT();
+
+    CmdServer::jobPool()->start( this );
+
+    do {
+        mtx.lock();
+
+        while( !done && posted.isEmpty() )
+            cond.wait( &mtx );
+
+        fin = done;
+        V.swap( posted );
+        mtx.unlock();
+
+        for( int i = 0, n = V.size(); i < n; ++i )
+            relay( V[i] );
+
+        V.clear();
+
+    } while( !fin );
+}
+
+
+// Setting done is the last touch of this object from the pool
+// thread; values posted earlier are relayed first.
+//
+void CmdJob::run()
+{
+    if( tSubmit )
+        Instr::hist( "cmdsrv.jobWait" )->addSince( tSubmit );
+
+    work();
+
+    QMutexLocker    ml( &mtx );
+    done = true;
+    cond.wakeAll();
+}
+
+
+// Called by work() on the pool thread.
+//
+void CmdJob::post( int val )
+{
+    QMutexLocker    ml( &mtx );
+    posted.push_back( val );
+    cond.wakeAll();
+}
+
+/* ---------------------------------------------------------------- */
+/* Jobs ----------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Whole timepoints from queue, optional filter/CAR (flt),
+// then subset and downsample, optionally to volts.
+//
+class FetchJob : public CmdJob
+{
+public:
+    vec_i16             data;
+    std::vector<float>  volts;
+    QString             errMsg;
+    QBitArray           chanBits;
+    const AIQ           *aiQ;
+    FetchFlt            *flt;
+    quint64             fromCt;
+    int                 nChans,
+                        nMax;
+    uint                dnsmp;
+    bool                f32;
+
+public:
+    FetchJob(
+        const AIQ       *aiQ,
+        FetchFlt        *flt,
+        const QBitArray &chanBits,
+        quint64         fromCt,
+        int             nMax,
+        uint            dnsmp,
+        bool            f32 )
+    :   chanBits(chanBits), aiQ(aiQ), flt(flt), fromCt(fromCt),
+        nChans(aiQ->nChans()), nMax(nMax), dnsmp(dnsmp), f32(f32)  {}
+
+protected:
+    void work();
+};
+
+
+void FetchJob::work()
+{
+    try {
+        data.reserve( nChans * nMax );
+    }
+    catch( const std::exception& ) {
+        Warning() << (errMsg = "FETCH: Low mem.");
+        return;
+    }
+
+    int ret = aiQ->getNScansFromCt( data, fromCt, nMax );
+
+    if( ret < 0 ) {
+        Warning() << (errMsg = "FETCH: Too late.");
+        return;
+    }
+
+    if( ret == 0 ) {
+        Warning() << (errMsg = "FETCH: Low mem.");
+        return;
+    }
+
+    if( !data.size() ) {
+        Warning() << (errMsg = "FETCH: No data read from queue.");
+        return;
+    }
+
+// ----------
+// Filter/CAR
+// ----------
+
+    if( flt && flt->isActive() )
+        flt->apply( &data[0], fromCt, data.size() / nChans );
+
+// ----------------
+// Requested subset
+// ----------------
+
+    QVector<uint>   iKeep;
+
+    Subset::bits2Vec( iKeep, chanBits );
+
+    if( iKeep.size() < nChans ) {
+
+        Subset::subset( data, data, iKeep, nChans );
+        nChans = iKeep.size();
+    }
+
+// ----------
+// Downsample
+// ----------
+
+    if( dnsmp > 1 )
+        Subset::downsample( data, data, nChans, dnsmp );
+
+// -----
+// Volts
+// -----
+
+    if( f32 && flt ) {
+
+        try {
+            flt->toVolts( volts, data, iKeep );
+        }
+        catch( const std::exception& ) {
+            Warning() << (errMsg = "FETCH: Low mem.");
+            return;
+        }
+    }
+}
+
+
+Sha1Job::Sha1Job( QObject *cmdWorker, Sha1Worker *v )
+    :   QObject(0), cmdWorker(cmdWorker), v(v), res(Sha1Worker::Failure)
+{
+    Connect( v, SIGNAL(progress(int)),
+        this, SLOT(progress(int)), Qt::DirectConnection );
+    Connect( v, SIGNAL(result(int)),
+        this, SLOT(result(int)), Qt::DirectConnection );
+}
+
+
+void Sha1Job::work()
+{
+    v->run();
+}
+
+
+// On the connection thread.
+//
+void Sha1Job::relay( int pct )
+{
+    QMetaObject::invokeMethod(
+        cmdWorker, "sha1Progress",
+        Qt::DirectConnection,
+        Q_ARG(int, pct) );
+}
+
+
+// Recursive file listing.
+//
+class EnumJob : public CmdJob
+{
+public:
+    QStringList entries;
+    QString     errMsg;
+    QString     path;
+
+public:
+    EnumJob( const QString &path ) : path(path)   {}
+
+protected:
+    void work()     {scan( path );}
+
+private:
+    bool scan( const QString &path );
+};
+
+
+bool EnumJob::scan( const QString &path )
+{
+    QDir    dir( path );
+
+    if( !dir.exists() ) {
+        errMsg = "ENUMDATADIR: Directory not found: " + path;
+        return false;
+    }
+
+    QDirIterator    it( path );
+    QString         pth = path + "/";
+
+    while( it.hasNext() ) {
+
+        it.next();
+
+        QFileInfo   fi      = it.fileInfo();
+        QString     entry   = fi.fileName();
+
+        if( fi.isDir() ) {
+
+            if( entry == "." || entry == ".." )
+                continue;
+
+            if( !scan( pth + entry ) )
+                return false;
+        }
+        else
+            entries.append( pth + entry );
+    }
+
+    return true;
+}
+
 /* ---------------------------------------------------------------- */
 /* class CmdWorker ------------------------------------------------ */
 /* ---------------------------------------------------------------- */
@@ -104,6 +380,11 @@ CmdWorker::~CmdWorker()
         par2 = 0;
     }
 
+    if( flt ) {
+        delete flt;
+        flt = 0;
+    }
+
     SockUtil::shutdown( sock );
 
     if( sock ) {
@@ -173,13 +454,6 @@ void CmdWorker::sha1Progress( int pct )
 }
 
 
-void CmdWorker::sha1Result( int res )
-{
-    if( Sha1Worker::Success != res )
-        errMsg = "SHA1: Sum does not match sum in meta file.";
-}
-
-
 void CmdWorker::par2Report( const QString &s )
 {
     if( s.size() && !SU.send( QString("%1\n").arg( s ), true ) )
@@ -426,6 +700,56 @@ void CmdWorker::isConsoleHidden( QString &resp )
 }
 
 
+// Response is CSV, header line first:
+// kind,name,n,mean_us,p50_us,p99_us,max,bins
+//
+void CmdWorker::getInstrumentation( QString &resp )
+{
+    if( !Instr::isEnabled() ) {
+        errMsg = "GETINSTRUMENTATION: Instrumentation is disabled.";
+        return;
+    }
+
+    resp = Instr::csv();
+}
+
+
+// Negotiate zero-copy reads for a client on this machine.
+// Creates the stream's shared-memory mirror on first request.
+//
+// Response: "nativeKey hdrBytes capScans nChans\n".
+// Layout and lock-free read protocol: see ShmRing.h.
+//
+void CmdWorker::getShmInfo( QString &resp, int ip )
+{
+    if( !okCfgStreamID( "GETSHMINFO", ip ) )
+        return;
+
+    if( !sock->peerAddress().isLoopback() ) {
+        errMsg = "GETSHMINFO: Shared memory is for local clients only.";
+        return;
+    }
+
+    Run         *run = mainApp()->getRun();
+    const AIQ   *aiQ = (ip >= 0 ? run->getImQ( ip ) : run->getNiQ());
+    QString     key,
+                stream = (ip >= 0 ? QString("imec%1").arg( ip ) : "nidq");
+    int         hdrBytes,
+                capScans;
+
+    if( !aiQ ) {
+        errMsg = "GETSHMINFO: Not running.";
+        return;
+    }
+
+    if( !aiQ->shmMirror( errMsg, key, hdrBytes, capScans, stream ) )
+        return;
+
+    resp = QString("%1 %2 %3 %4\n")
+            .arg( key ).arg( hdrBytes ).arg( capScans ).arg( aiQ->nChans() );
+}
+
+
 // Expected tok params:
 // 0) dst stream
 // 1) src scan index
@@ -510,40 +834,58 @@ void CmdWorker::setDataDir( const QString &path )
 }
 
 
-bool CmdWorker::enumDir( const QString &path )
+// Scan on pool, then send listing.
+//
+// With argument 1, instead list the run catalog, one recording
+// per line: path, run_g_t, stream, probeSN, srate, scanCt, tab
+// separated. Only files unchanged since they were recorded are
+// listed; no folders are walked.
+//
+void CmdWorker::enumDir( const QString &path, const QStringList &toks )
 {
-    QDir    dir( path );
+    if( toks.size() && toks.front().toInt() == 1 ) {
 
-    if( !dir.exists() ) {
-        errMsg = "ENUMDATADIR: Directory not found: " + path;
-        return false;
-    }
-    else {
-
-        QDirIterator    it( path );
-        QString         pth = path + "/";
+        QVector<DFCatRec>   vR;
 
-        while( it.hasNext() ) {
+        DFCatalog::all( vR, path );
 
-            it.next();
+        for( int i = 0, n = vR.size(); i < n; ++i ) {
 
-            QFileInfo   fi      = it.fileInfo();
-            QString     entry   = fi.fileName();
+            const DFCatRec  &R = vR[i];
 
-            if( fi.isDir() ) {
+            if( !R.isFresh() )
+                continue;
 
-                if( entry == "." || entry == ".." )
-                    continue;
+            QString line =
+                QString("%1\t%2_g%3_t%4\t%5\t%6\t%7\t%8\n")
+                .arg( R.binName )
+                .arg( R.runName ).arg( R.g ).arg( R.t )
+                .arg( R.stream() )
+                .arg( R.probeSN )
+                .arg( R.srate, 0, 'f', 6 )
+                .arg( R.scanCt );
 
-                if( !enumDir( pth + entry ) )
-                    return false;
-            }
-            else if( !SU.send( QString("%1\n").arg( pth + entry ), true ) )
-                return false;
+            if( !SU.send( line, true ) )
+                return;
         }
+
+        return;
     }
 
-    return true;
+    EnumJob job( path );
+
+    job.exec();
+
+    if( !job.errMsg.isEmpty() ) {
+        errMsg = job.errMsg;
+        return;
+    }
+
+    foreach( const QString &entry, job.entries ) {
+
+        if( !SU.send( QString("%1\n").arg( entry ), true ) )
+            return;
+    }
 }
 
 
@@ -671,6 +1013,30 @@ void CmdWorker::setRecordingEnabled( const QStringList &toks )
 }
 
 
+// Expected tok parameter is Boolean 0/1.
+//
+void CmdWorker::setInstrumentation( const QStringList &toks )
+{
+    MainApp *app = okAppValidated( "SETINSTRUMENTATION" );
+
+    if( !app )
+        return;
+
+    if( toks.size() > 0 ) {
+
+        bool    b = toks.front().toInt();
+
+        QMetaObject::invokeMethod(
+            app->metrics(),
+            "instrSetEnabled",
+            Qt::QueuedConnection,
+            Q_ARG(bool, b) );
+    }
+    else
+        errMsg = "SETINSTRUMENTATION: Requires parameter {0 or 1}.";
+}
+
+
 // Expected tok parameter is run name.
 //
 void CmdWorker::setRunName( const QStringList &toks )
@@ -870,9 +1236,12 @@ void CmdWorker::setDigOut( const QStringList &toks )
 // 2) scan count
 // 3) <channel subset pattern "id1#id2#...">
 // 4) <integer downsample factor>
+// 5) <hipass neural 300 Hz {0,1}>
+// 6) <CAR {0=none,1=local 2,0,2=local 8,2,3=global,4=global demux}>
+// 7) <float32 volts {0,1}>
 //
 // Send( 'BINARY_DATA %d %d uint64(%ld)'\n", nChans, nScans, headCt ).
-// Write binary data stream.
+// Write binary data stream: int16, or float32 if (7) set.
 //
 void CmdWorker::fetch( const QStringList &toks )
 {
@@ -910,8 +1279,11 @@ void CmdWorker::fetch( const QStringList &toks )
                     p.ni.sns.saveBits);
 
             QBitArray   chanBits;
-            int         nChans  = aiQ->nChans();
+            int         nChans  = aiQ->nChans(),
+                        car     = 0;
             uint        dnsmp   = 1;
+            bool        hp      = false,
+                        f32     = false;
 
             // -----
             // Chans
@@ -939,77 +1311,70 @@ void CmdWorker::fetch( const QStringList &toks )
             if( toks.size() >= 5 )
                 dnsmp = toks.at( 4 ).toUInt();
 
-            // ---------------------------------
-            // Fetch whole timepoints from queue
-            // ---------------------------------
+            // ------------------
+            // Filter, CAR, volts
+            // ------------------
 
-            vec_i16 data;
-            quint64 fromCt  = toks.at( 1 ).toLongLong();
-            int     nMax    = toks.at( 2 ).toInt(),
-                    size,
-                    ret;
-
-            try {
-                data.reserve( nChans * nMax );
-            }
-            catch( const std::exception& ) {
-                Warning() << (errMsg = "FETCH: Low mem.");
-                return;
-            }
+            if( toks.size() >= 6 )
+                hp = toks.at( 5 ).toInt();
 
-            ret = aiQ->getNScansFromCt( data, fromCt, nMax );
+            if( toks.size() >= 7 ) {
 
-            if( ret < 0 ) {
-                Warning() << (errMsg = "FETCH: Too late.");
-                return;
-            }
+                car = toks.at( 6 ).toInt();
 
-            if( ret == 0 ) {
-                Warning() << (errMsg = "FETCH: Low mem.");
-                return;
+                if( car < 0 || car > 4 ) {
+                    Warning() <<
+                    (errMsg = "FETCH: CAR option must be in range [0..4].");
+                    return;
+                }
             }
 
-            size = data.size();
+            if( toks.size() >= 8 )
+                f32 = toks.at( 7 ).toInt();
 
-            if( size ) {
+            if( hp || car || f32 ) {
 
-                // ----------------
-                // Requested subset
-                // ----------------
+                if( !flt )
+                    flt = new FetchFlt;
 
-                if( chanBits.count( true ) < nChans ) {
+                flt->setup( p, ip, nChans, hp, car );
+            }
 
-                    QVector<uint>   iKeep;
+            // -----------------------------------------
+            // Gather, filter, subset, downsample, volts
+            // -----------------------------------------
 
-                    Subset::bits2Vec( iKeep, chanBits );
-                    Subset::subset( data, data, iKeep, nChans );
-                    nChans = iKeep.size();
-                }
+            FetchJob    job(
+                            aiQ, (hp || car || f32 ? flt : 0),
+                            chanBits,
+                            toks.at( 1 ).toLongLong(),
+                            toks.at( 2 ).toInt(),
+                            dnsmp, f32 );
 
-                // ----------
-                // Downsample
-                // ----------
+            job.exec();
 
-                if( dnsmp > 1 )
-                    Subset::downsample( data, data, nChans, dnsmp );
+            if( !job.errMsg.isEmpty() ) {
+                errMsg = job.errMsg;
+                return;
+            }
 
-                // ----
-                // Send
-                // ----
+            // ----
+            // Send
+            // ----
 
-                size = data.size();
+            int size = job.data.size();
 
-                SU.send(
-                    QString("BINARY_DATA %1 %2 uint64(%3)\n")
-                    .arg( nChans )
-                    .arg( size / nChans )
-                    .arg( fromCt ),
-                    true );
+            SU.send(
+                QString("BINARY_DATA %1 %2 uint64(%3)\n")
+                .arg( job.nChans )
+                .arg( size / job.nChans )
+                .arg( job.fromCt ),
+                true );
 
-                SU.sendBinary( &data[0], size*sizeof(qint16) );
-            }
+            if( f32 )
+                SU.sendBinary( &job.volts[0], size*sizeof(float) );
             else
-                Warning() << (errMsg = "FETCH: No data read from queue.");
+                SU.sendBinary( &job.data[0], size*sizeof(qint16) );
         }
     }
     else
@@ -1077,11 +1442,13 @@ void CmdWorker::verifySha1( QString file )
             }
 
             Sha1Worker  *v = new Sha1Worker( file, kvp );
+            Sha1Job     job( this, v );
+
+            job.exec();
 
-            Connect( v, SIGNAL(progress(int)), this, SLOT(sha1Progress(int)) );
-            Connect( v, SIGNAL(result(int)), this, SLOT(sha1Result(int)) );
+            if( Sha1Worker::Success != job.res )
+                errMsg = "SHA1: Sum does not match sum in meta file.";
 
-            v->run();
             delete v;
         }
     }
@@ -1162,6 +1529,39 @@ void CmdWorker::par2Start( QStringList toks )
 }
 
 
+// Cheap queries answered inline on the connection thread,
+// ahead of all other dispatch: no GUI thread, no job pool.
+//
+// Return true if cmd handled here.
+//
+bool CmdWorker::doFastQuery( const QString &cmd, const QStringList &toks )
+{
+    Run     *run = mainApp()->getRun();
+    QString resp;
+
+    if( cmd == "GETTIME" )
+        resp = QString("%1\n").arg( getTime(), 0, 'f', 3 );
+    else if( cmd == "GETVERSION" )
+        resp = QString("%1\n").arg( VERSION_STR );
+    else if( cmd == "GETSCANCOUNT" ) {
+
+        int ip = (toks.size() ? toks.front().toInt() : -1);
+
+        if( !okCfgStreamID( cmd, ip ) )
+            return true;
+
+        resp = QString("%1\n").arg( run->getScanCount( ip ) );
+    }
+    else if( cmd == "ISRUNNING" )
+        resp = QString("%1\n").arg( run->isRunning() );
+    else
+        return false;
+
+    SU.send( resp, true );
+    return true;
+}
+
+
 // Return true if cmd handled here.
 //
 bool CmdWorker::doQuery( const QString &cmd, const QStringList &toks )
@@ -1177,12 +1577,8 @@ bool CmdWorker::doQuery( const QString &cmd, const QStringList &toks )
     QString resp;
     bool    handled = true;
 
-    if( cmd == "GETVERSION" )
-        resp = QString("%1\n").arg( VERSION_STR );
-    else if( cmd == "ISINITIALIZED" )
+    if( cmd == "ISINITIALIZED" )
         resp = QString("%1\n").arg( mainApp()->isInitialized() );
-    else if( cmd == "GETTIME" )
-        resp = QString("%1\n").arg( getTime(), 0, 'f', 3 );
     else if( cmd == "GETDATADIR" )
         resp = QString("%1\n").arg( mainApp()->dataDir() );
     else if( cmd == "GETPARAMS" )
@@ -1199,8 +1595,6 @@ bool CmdWorker::doQuery( const QString &cmd, const QStringList &toks )
         getAcqChanCounts( resp, STREAMID );
     else if( cmd == "GETSAVECHANS" )
         getSaveChans( resp, STREAMID );
-    else if( cmd == "ISRUNNING" )
-        resp = QString("%1\n").arg( RUN->isRunning() );
     else if( cmd == "ISSAVING" )
         resp = QString("%1\n").arg( RUN->dfIsSaving() );
     else if( cmd == "ISUSRORDER" ) {
@@ -1219,17 +1613,14 @@ bool CmdWorker::doQuery( const QString &cmd, const QStringList &toks )
         if( okCfgStreamID( cmd, ip ) )
             resp = QString("%1\n").arg( RUN->dfGetFileStart( ip ) );
     }
-    else if( cmd == "GETSCANCOUNT" ) {
-
-        int ip = STREAMID;
-
-        if( okCfgStreamID( cmd, ip ) )
-            resp = QString("%1\n").arg( RUN->getScanCount( ip ) );
-    }
     else if( cmd == "ISCONSOLEHIDDEN" )
         isConsoleHidden( resp );
     else if( cmd == "MAPSAMPLE" )
         mapSample( resp, toks );
+    else if( cmd == "GETINSTRUMENTATION" )
+        getInstrumentation( resp );
+    else if( cmd == "GETSHMINFO" )
+        getShmInfo( resp, STREAMID );
     else
         handled = false;
 
@@ -1268,7 +1659,7 @@ bool CmdWorker::doCommand( const QString &cmd, const QStringList &toks )
     else if( cmd == "SETDATADIR" )
         setDataDir( toks.join( " " ).trimmed() );
     else if( cmd == "ENUMDATADIR" )
-        enumDir( mainApp()->dataDir() );
+        enumDir( mainApp()->dataDir(), toks );
     else if( cmd == "SETPARAMS" )
         setParams();
     else if( cmd == "SETAUDIOPARAMS" )
@@ -1277,6 +1668,8 @@ bool CmdWorker::doCommand( const QString &cmd, const QStringList &toks )
         setAudioEnable( toks );
     else if( cmd == "SETRECORDENAB" )
         setRecordingEnabled( toks );
+    else if( cmd == "SETINSTRUMENTATION" )
+        setInstrumentation( toks );
     else if( cmd == "SETRUNNAME" )
         setRunName( toks );
     else if( cmd == "SETNEXTFILENAME" )
@@ -1365,8 +1758,12 @@ bool CmdWorker::processLine( const QString &line )
 // Dispatch
 // --------
 
-    if( !doQuery( cmd, toks ) && !doCommand( cmd, toks ) )
+    if( !doFastQuery( cmd, toks )
+        && !doQuery( cmd, toks )
+        && !doCommand( cmd, toks ) ) {
+
         errMsg = QString("CmdWorker: Unknown command [%1].").arg( cmd );
+    }
 
     return errMsg.isEmpty();
 }
@@ -4,14 +4,21 @@
 #include "SockUtil.h"
 
 #include <QTcpServer>
+#include <QMutex>
+#include <QRunnable>
 #include <QStringList>
+#include <QVector>
+#include <QWaitCondition>
 
+class FetchFlt;
 class Par2Worker;
+class Sha1Worker;
 class MainApp;
 class ConfigCtl;
 class Run;
 
 class QTcpSocket;
+class QThreadPool;
 
 /* ---------------------------------------------------------------- */
 /* Types ---------------------------------------------------------- */
@@ -37,12 +44,79 @@ public:
         uint            timeout_ms = CMD_TOUT_MS );
 
     static void deleteAllActiveConnections();
+    static QThreadPool *jobPool();
 
 protected:
     virtual void incomingConnection( qintptr sockFd );  // from QTcpServer
 };
 
 
+// Heavy command work (FETCH gather/subset/downsample, SHA1,
+// directory scans) runs as a CmdJob on a pool shared by all
+// connections, bounded to half the cores, so several analysis
+// clients can't oversubscribe the machine or starve the
+// acquisition and writer threads.
+//
+// The connection's own thread stays the per-client queue: it
+// submits the job and blocks until the job completes, then
+// replies. It services no other events meanwhile; values the
+// job post()s (e.g. progress) are handed to relay() on the
+// connection thread, in order. Commands from one client thus
+// complete in order, while other clients' cheap queries proceed
+// on their own threads.
+//
+class CmdJob : public QRunnable
+{
+private:
+    QMutex          mtx;
+    QWaitCondition  cond;
+    QVector<int>    posted;
+    double          tSubmit;
+    bool            done;
+
+public:
+    CmdJob() : tSubmit(0), done(false)  {setAutoDelete( false );}
+    virtual ~CmdJob()                   {}
+
+    void exec();
+    virtual void run();
+
+protected:
+    virtual void work() = 0;
+    virtual void relay( int val )       {Q_UNUSED( val );}
+
+    void post( int val );
+};
+
+
+// SHA1 of a bin file on the job pool. The worker's signals are
+// taken directly on the pool thread; progress is post()ed and
+// relayed to the connection's sha1Progress().
+//
+class Sha1Job : public QObject, public CmdJob
+{
+    Q_OBJECT
+
+private:
+    QObject     *cmdWorker;
+    Sha1Worker  *v;
+
+public:
+    int         res;
+
+public:
+    Sha1Job( QObject *cmdWorker, Sha1Worker *v );
+
+public slots:
+    void progress( int pct )    {post( pct );}
+    void result( int res )      {this->res = res;}
+
+protected:
+    void work();
+    void relay( int pct );
+};
+
+
 // CmdServer creates a new CmdWorker instance
 // to handle each remote connection. If CmdWorker
 // remains innactive for timeout_ms (~10s) it
@@ -54,6 +128,7 @@ class CmdWorker : public QObject
 
 private:
     QString     errMsg;
+    FetchFlt    *flt;
     Par2Worker  *par2;
     QTcpSocket  *sock;
     SockUtil    SU;
@@ -62,7 +137,7 @@ private:
 
 public:
     CmdWorker( qintptr sockFd, int timeout )
-    :   QObject(0), par2(0),
+    :   QObject(0), flt(0), par2(0),
         sock(0), sockFd(sockFd),
         timeout(timeout)  {}
     virtual ~CmdWorker();
@@ -73,7 +148,6 @@ signals:
 public slots:
     void run();
     void sha1Progress( int pct );
-    void sha1Result( int res );
     void par2Report( const QString &s );
     void par2Error( const QString &s );
 
@@ -92,13 +166,16 @@ private:
     void getAcqChanCounts( QString &resp, int ip );
     void getSaveChans( QString &resp, int ip );
     void isConsoleHidden( QString &resp );
+    void getInstrumentation( QString &resp );
+    void getShmInfo( QString &resp, int ip );
     void mapSample( QString &resp, const QStringList &toks );
     void setDataDir( const QString &path );
-    bool enumDir( const QString &path );
+    void enumDir( const QString &path, const QStringList &toks );
     void setParams();
     void SetAudioParams( const QString &group );
     void setAudioEnable( const QStringList &toks );
     void setRecordingEnabled( const QStringList &toks );
+    void setInstrumentation( const QStringList &toks );
     void setRunName( const QStringList &toks );
     void setNextFileName( const QString &name );
     void setMetaData();
@@ -111,6 +188,7 @@ private:
     void consoleShow( bool show );
     void verifySha1( QString file );
     void par2Start( QStringList toks );
+    bool doFastQuery( const QString &cmd, const QStringList &toks );
     bool doQuery( const QString &cmd, const QStringList &toks );
     bool doCommand( const QString &cmd, const QStringList &toks );
     bool processLine( const QString &line );
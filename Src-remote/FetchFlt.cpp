@@ -0,0 +1,382 @@
+
+#include "FetchFlt.h"
+#include "Biquad.h"
+#include "DAQ.h"
+
+#include <QMap>
+
+#include <string.h>
+
+
+#define MAX10BIT    512
+#define MAX16BIT    32768
+
+
+/* ---------------------------------------------------------------- */
+/* FetchFlt ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+FetchFlt::FetchFlt()
+    :   hipass(0), nextCt(0), ip(-2), nC(0), nNu(0), nAna(0),
+        maxInt(MAX16BIT), stride(1), car(0), hp(false)
+{
+}
+
+
+FetchFlt::~FetchFlt()
+{
+    if( hipass )
+        delete hipass;
+}
+
+
+// Cheap when nothing changed: the usual case of one client
+// polling one stream with fixed options.
+//
+void FetchFlt::setup(
+    const DAQ::Params   &p,
+    int                 ip,
+    int                 nC,
+    bool                hp,
+    int                 car )
+{
+    const ShankMap  &M = (ip >= 0 ?
+                            p.im.each[ip].sns.shankMap :
+                            p.ni.sns.shankMap);
+
+    if( car < 0 || car > 4 )
+        car = 0;
+
+    if( ip == this->ip && nC == this->nC
+        && hp == this->hp && car == this->car
+        && (!car || M == SM) ) {
+
+        return;
+    }
+
+    this->ip    = ip;
+    this->nC    = nC;
+    this->hp    = hp;
+    this->car   = car;
+    nextCt      = 0;
+
+// ------
+// Counts
+// ------
+
+    double  span, srate;
+
+    if( ip >= 0 ) {
+
+        const CimCfg::AttrEach  &E = p.im.each[ip];
+
+        nNu     = E.imCumTypCnt[CimCfg::imSumAP];
+        nAna    = E.imCumTypCnt[CimCfg::imSumNeural];
+        maxInt  = MAX10BIT;
+        stride  = 24;
+        span    = p.im.all.range.span();
+        srate   = E.srate;
+    }
+    else {
+
+        nNu     = p.ni.niCumTypCnt[CniCfg::niSumNeural];
+        nAna    = p.ni.niCumTypCnt[CniCfg::niSumAnalog];
+        maxInt  = MAX16BIT;
+        stride  = p.ni.muxFactor;
+        span    = p.ni.range.span();
+        srate   = p.ni.srate;
+    }
+
+// ------
+// Hipass
+// ------
+
+    if( hipass ) {
+        delete hipass;
+        hipass = 0;
+    }
+
+    if( hp && nNu > 0 )
+        hipass = new Biquad( bq_type_highpass, 300/srate );
+
+// ---
+// CAR
+// ---
+
+    SM = M;
+    TSM.clear();
+
+    if( car == 1 )
+        carTable( 0, 2 );
+    else if( car == 2 )
+        carTable( 2, 8 );
+
+// -----
+// Volts
+// -----
+
+    // V = rmin + span * (i + maxInt) / (2*maxInt), over gain.
+
+    vA.assign( nC, 1.0F );
+    vB.assign( nC, 0.0F );
+
+    double  rmin = (ip >= 0 ? p.im.all.range.rmin : p.ni.range.rmin);
+
+    for( int ic = 0, n = qMin( nAna, nC ); ic < n; ++ic ) {
+
+        double  g = (ip >= 0 ?
+                        p.im.each[ip].chanGain( ic ) :
+                        p.ni.chanGain( ic ));
+
+        vA[ic] = span / (2 * maxInt) / g;
+        vB[ic] = (rmin + 0.5 * span) / g;
+    }
+}
+
+
+void FetchFlt::apply( qint16 *d, quint64 fromCt, int ntpts )
+{
+    if( ntpts <= 0 )
+        return;
+
+    if( hipass ) {
+
+        if( fromCt != nextCt )
+            hipass->clearMem();
+
+        hipass->applyBlockwiseMem( d, maxInt, ntpts, nC, 0, nNu );
+    }
+
+    nextCt = fromCt + ntpts;
+
+    switch( car ) {
+        case 1:
+        case 2:
+            carLocal( d, ntpts );
+            break;
+        case 3:
+            carGlobal( d, ntpts, 1 );
+            break;
+        case 4:
+            carGlobal( d, ntpts, stride );
+            break;
+        default:
+            ;
+    }
+}
+
+
+// d holds iKeep.size() channels per timepoint.
+//
+void FetchFlt::toVolts(
+    std::vector<float>  &V,
+    const vec_i16       &d,
+    const QVector<uint> &iKeep ) const
+{
+    int nk = iKeep.size(),
+        n  = d.size();
+
+    V.resize( n );
+
+    if( !nk || !n )
+        return;
+
+    std::vector<float>  A( nk ),
+                        B( nk );
+
+    for( int ik = 0; ik < nk; ++ik ) {
+
+        uint    ic = iKeep[ik];
+
+        A[ik] = (ic < vA.size() ? vA[ic] : 1.0F);
+        B[ik] = (ic < vB.size() ? vB[ic] : 0.0F);
+    }
+
+    const qint16    *S  = &d[0];
+    float           *D  = &V[0];
+    const float     *a  = &A[0],
+                    *b  = &B[0];
+
+    for( int it = 0, nt = n / nk; it < nt; ++it, S += nk, D += nk ) {
+
+        for( int ik = 0; ik < nk; ++ik )
+            D[ik] = a[ik] * S[ik] + b[ik];
+    }
+}
+
+
+// Same annuli as SVGrafsM::sAveTable.
+//
+void FetchFlt::carTable( int rIn, int rOut )
+{
+    int nS = qMin( nNu, int(SM.e.size()) );
+
+    if( nS <= 0 )
+        return;
+
+    TSM.resize( nS );
+
+    QMap<ShankMapDesc,uint> ISM;
+    SM.inverseMap( ISM );
+
+    for( int ic = 0; ic < nS; ++ic ) {
+
+        const ShankMapDesc  &E = SM.e[ic];
+
+        if( !E.u )
+            continue;
+
+        // ----------------------------------
+        // Form map of excluded inner indices
+        // ----------------------------------
+
+        QMap<int,int>   inner;  // keys sorted, value is arbitrary
+
+        int xL  = qMax( int(E.c)  - rIn, 0 ),
+            xH  = qMin( uint(E.c) + rIn + 1, SM.nc ),
+            yL  = qMax( int(E.r)  - rIn, 0 ),
+            yH  = qMin( uint(E.r) + rIn + 1, SM.nr );
+
+        for( int ix = xL; ix < xH; ++ix ) {
+
+            for( int iy = yL; iy < yH; ++iy ) {
+
+                QMap<ShankMapDesc,uint>::iterator   it;
+
+                it = ISM.find( ShankMapDesc( E.s, ix, iy, 1 ) );
+
+                if( it != ISM.end() )
+                    inner[it.value()] = 1;
+            }
+        }
+
+        // -------------------------
+        // Fill with annulus members
+        // -------------------------
+
+        std::vector<int>    &V = TSM[ic];
+
+        xL  = qMax( int(E.c)  - rOut, 0 );
+        xH  = qMin( uint(E.c) + rOut + 1, SM.nc );
+        yL  = qMax( int(E.r)  - rOut, 0 );
+        yH  = qMin( uint(E.r) + rOut + 1, SM.nr );
+
+        for( int ix = xL; ix < xH; ++ix ) {
+
+            for( int iy = yL; iy < yH; ++iy ) {
+
+                QMap<ShankMapDesc,uint>::iterator   it;
+
+                it = ISM.find( ShankMapDesc( E.s, ix, iy, 1 ) );
+
+                if( it != ISM.end() ) {
+
+                    int i = it.value();
+
+                    // Exclude inners
+
+                    if( i < nS && inner.find( i ) == inner.end() )
+                        V.push_back( i );
+                }
+            }
+        }
+
+        qSort( V );
+    }
+}
+
+
+// Annulus means are taken from the unreferenced row, as the
+// graphs do, so each timepoint is first copied aside.
+//
+void FetchFlt::carLocal( qint16 *d, int ntpts )
+{
+    int nS = TSM.size();
+
+    if( !nS )
+        return;
+
+    vec_i16 _R( nS );
+    qint16  *R = &_R[0];
+
+    for( int it = 0; it < ntpts; ++it, d += nC ) {
+
+        memcpy( R, d, nS * sizeof(qint16) );
+
+        for( int ic = 0; ic < nS; ++ic ) {
+
+            const std::vector<int>  &V = TSM[ic];
+
+            int nv = V.size();
+
+            if( nv ) {
+
+                const int   *v  = &V[0];
+                int         sum = 0;
+
+                for( int iv = 0; iv < nv; ++iv )
+                    sum += R[v[iv]];
+
+                d[ic] = R[ic] - sum/nv;
+            }
+        }
+    }
+}
+
+
+// Same per-shank means as SVGrafsM::sAveApplyGlobalStride;
+// stride 1 is SVGrafsM::sAveApplyGlobal.
+//
+void FetchFlt::carGlobal( qint16 *d, int ntpts, int stride )
+{
+    int nS = qMin( nNu, int(SM.e.size()) );
+
+    if( nS <= 0 )
+        return;
+
+    if( stride < 1 )
+        stride = 1;
+
+    const ShankMapDesc  *E = &SM.e[0];
+
+    int                 ns = SM.ns;
+    std::vector<int>    _A( ns ),
+                        _N( ns );
+    std::vector<float>  _S( ns );
+    int                 *A  = &_A[0],
+                        *N  = &_N[0];
+    float               *S  = &_S[0];
+
+    for( int it = 0; it < ntpts; ++it, d += nC ) {
+
+        for( int ic0 = 0; ic0 < stride; ++ic0 ) {
+
+            for( int is = 0; is < ns; ++is ) {
+                S[is] = 0;
+                N[is] = 0;
+                A[is] = 0;
+            }
+
+            for( int ic = ic0; ic < nS; ic += stride ) {
+
+                const ShankMapDesc  *e = &E[ic];
+
+                if( e->u ) {
+                    S[e->s] += d[ic];
+                    ++N[e->s];
+                }
+            }
+
+            for( int is = 0; is < ns; ++is ) {
+
+                if( N[is] )
+                    A[is] = S[is] / N[is];
+            }
+
+            for( int ic = ic0; ic < nS; ic += stride )
+                d[ic] -= A[E[ic].s];
+        }
+    }
+}
+
+
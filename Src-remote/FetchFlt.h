@@ -0,0 +1,84 @@
+#ifndef FETCHFLT_H
+#define FETCHFLT_H
+
+#include "SGLTypes.h"
+#include "ShankMap.h"
+
+#include <QVector>
+
+#include <vector>
+
+namespace DAQ {
+struct Params;
+}
+
+class Biquad;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Optional server-side processing for one client's FETCH calls,
+// applied to whole acquired timepoints before subset/downsample:
+//
+// - hipass: 300 Hz highpass on neural channels (imec AP, NI MN),
+//   same Biquad the graphs use. Filter state is kept between calls
+//   so consecutive fetches (fromCt == previous end) are seamless;
+//   any gap, or a change of stream/options, resets it, and the
+//   first BIQUAD_TRANS_WIDE samples then carry a transient.
+//
+// - car: common average reference, numbered like the graphs'
+//   -<S> selector, using the stream's ShankMap:
+//   {0=none, 1=local 2,0, 2=local 8,2, 3=global, 4=global demux}.
+//
+// toVolts() converts a subset/downsampled block to float volts.
+// Analog channels use stream range and per-channel gain; sync/
+// digital words are passed through as their integer values.
+//
+class FetchFlt
+{
+private:
+    Biquad                          *hipass;
+    ShankMap                        SM;
+    std::vector<std::vector<int> >  TSM;        // local CAR annuli
+    std::vector<float>              vA,         // volts = A*i + B
+                                    vB;
+    quint64                         nextCt;
+    int                             ip,
+                                    nC,
+                                    nNu,
+                                    nAna,
+                                    maxInt,
+                                    stride,
+                                    car;
+    bool                            hp;
+
+public:
+    FetchFlt();
+    virtual ~FetchFlt();
+
+    void setup(
+        const DAQ::Params   &p,
+        int                 ip,
+        int                 nC,
+        bool                hp,
+        int                 car );
+
+    bool isActive() const   {return hp || car;}
+
+    void apply( qint16 *d, quint64 fromCt, int ntpts );
+
+    void toVolts(
+        std::vector<float>  &V,
+        const vec_i16       &d,
+        const QVector<uint> &iKeep ) const;
+
+private:
+    void carTable( int rIn, int rOut );
+    void carLocal( qint16 *d, int ntpts );
+    void carGlobal( qint16 *d, int ntpts, int stride );
+};
+
+#endif  // FETCHFLT_H
+
+
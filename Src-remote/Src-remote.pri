@@ -2,6 +2,7 @@
 HEADERS += \
     $$PWD/CmdSrvDlg.h \
     $$PWD/CmdServer.h \
+    $$PWD/FetchFlt.h \
     $$PWD/RgtServer.h \
     $$PWD/RgtSrvDlg.h \
     $$PWD/SockUtil.h
@@ -9,6 +10,7 @@ HEADERS += \
 SOURCES += \
     $$PWD/CmdSrvDlg.cpp \
     $$PWD/CmdServer.cpp \
+    $$PWD/FetchFlt.cpp \
     $$PWD/RgtServer.cpp \
     $$PWD/RgtSrvDlg.cpp \
     $$PWD/SockUtil.cpp
@@ -1,11 +1,14 @@
 
 #include "AIQ.h"
 #include "Util.h"
+#include "ShmRing.h"
 
 
 #define SAMPS( arg )    (nchans * (arg))
 #define BYTES( arg )    (nchans * sizeof(qint16) * (arg))
 
+#define SHMSECS         8
+
 /* ---------------------------------------------------------------- */
 /* RingWalker ----------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -14,7 +17,7 @@
 
 class RingWalker {
 private:
-    const vec_i16   &buf;
+    const qint16    *buf;
     int             bufmax,
                     bufhead,
                     buflen,
@@ -28,7 +31,7 @@ public:
     const qint16    *cur;
 public:
     RingWalker(
-        const vec_i16   &buf,
+        const qint16    *buf,
         int             bufmax,
         int             bufhead,
         int             buflen,
@@ -88,7 +91,7 @@ bool RingWalker::next()
 
 class RingFltWalker {
 private:
-    const vec_i16       &buf;
+    const qint16        *buf;
     int                 bufmax,
                         bufhead,
                         buflen,
@@ -105,7 +108,7 @@ public:
     const qint16    *cur;
 public:
     RingFltWalker(
-        const vec_i16       &buf,
+        const qint16        *buf,
         int                 bufmax,
         int                 bufhead,
         int                 buflen,
@@ -189,11 +192,159 @@ void RingFltWalker::filter()
 /* AIQ ------------------------------------------------------------ */
 /* ---------------------------------------------------------------- */
 
-AIQ::AIQ( double srate, int nchans, int capacitySecs )
+// Storage is mapped but not touched; the thread that will fill
+// the queue calls prefault() at run setup, so first-touch places
+// pages on its NUMA node and no page faults hit acquisition.
+//
+// Windows large pages are committed at allocation, not at first
+// touch, so here we take normal pages and leave large pages to
+// prefault(), on the filling thread's node.
+//
+// Placement follows the filler only if it is pinned (imec workers
+// with a scheduled core); an unpinned thread may fault pages on
+// one node and later run on another. A warm (reused) queue keeps
+// its first placement.
+//
+AIQ::AIQ( double srate, int nchans, int capacitySecs, int hugePages )
     :   srate(srate), nchans(nchans), bufmax(capacitySecs * srate),
-        tzero(0), endCt(0), bufhead(0), buflen(0)
+        buf(0), mapBytes(BYTES(bufmax)), shm(0),
+        tzero(0), faultSecs(0), endCt(0),
+        bufhead(0), buflen(0), lateHuge(0),
+        huge(false), faulted(false)
+{
+#ifdef Q_OS_WIN
+    lateHuge    = hugePages;
+    hugePages   = 0;
+#endif
+
+    buf = (qint16*)allocBigBlock( mapBytes, hugePages, huge );
+
+    if( !buf )
+        throw std::bad_alloc();
+}
+
+
+AIQ::~AIQ()
+{
+    if( shm )
+        delete shm;
+
+    freeBigBlock( buf, mapBytes );
+}
+
+
+bool AIQ::sameShape( double srate, int nchans, int capacitySecs ) const
+{
+    return srate == this->srate
+            && nchans == this->nchans
+            && int(capacitySecs * srate) == bufmax;
+}
+
+
+// Empty the queue when parked after a run; buffer storage is kept.
+// Any shared-memory mirror is dropped (clients see live=0) and is
+// recreated on demand by the next run.
+//
+void AIQ::reset()
 {
-    buf.resize( SAMPS(bufmax) );
+    QMutexLocker    ml( &QMtx );
+
+    if( shm ) {
+        delete shm;
+        shm = 0;
+    }
+
+    tzero   = 0;
+    endCt   = 0;
+    bufhead = 0;
+    buflen  = 0;
+}
+
+
+// Touch every page from the calling thread; once only.
+// First swap in any deferred large pages, allocated on the
+// calling thread's NUMA node; keep normal pages if that fails.
+// hugePages() is true only once large pages are in place.
+//
+void AIQ::prefault()
+{
+    QMutexLocker    ml( &QMtx );
+
+    if( faulted )
+        return;
+
+    double  t0 = getTime();
+
+    if( lateHuge ) {
+
+        size_t  bytes   = BYTES(bufmax);
+        bool    h;
+        void    *lp     = allocBigBlock(
+                            bytes, lateHuge, h, getCurNumaNode() );
+
+        if( lp && h ) {
+            freeBigBlock( buf, mapBytes );
+            buf         = (qint16*)lp;
+            mapBytes    = bytes;
+            huge        = true;
+        }
+        else {
+
+            if( lp )
+                freeBigBlock( lp, bytes );
+
+            Log() <<
+                QString("Stream buffer: large pages unavailable;"
+                        " keeping %1 MB of normal pages.")
+                .arg( mapBytes / (1024*1024) );
+        }
+
+        lateHuge = 0;
+    }
+
+    volatile char   *p = (volatile char*)buf;
+
+    for( size_t i = 0; i < mapBytes; i += 4096 )
+        p[i] = 0;
+
+    faultSecs   = getTime() - t0;
+    faulted     = true;
+}
+
+
+// Create, on first call, a shared-memory mirror of scans
+// enqueued from now on (up to SHMSECS, at most the queue span).
+// Return its attach details.
+//
+bool AIQ::shmMirror(
+    QString         &err,
+    QString         &key,
+    int             &hdrBytes,
+    int             &capScans,
+    const QString   &stream ) const
+{
+    QMutexLocker    ml( &QMtx );
+
+    if( !shm ) {
+
+        ShmRing *S = new ShmRing;
+
+        if( !S->create(
+                err, stream, srate, tzero, nchans,
+                qMin( bufmax, int(SHMSECS * srate) ), endCt ) ) {
+
+            delete S;
+            return false;
+        }
+
+        shm = S;
+    }
+
+    key         = shm->key();
+    hdrBytes    = shm->hdrBytes();
+    capScans    = shm->capScans();
+
+    return true;
 }
 
 
@@ -207,6 +358,9 @@ void AIQ::enqueueZero( double t0, double tLim )
 
     endCt += nCts;
 
+    if( shm )
+        shm->writeZero( nCts );
+
     if( nCts >= bufmax ) {
         // Keep only newest bufmax-worth.
         bufhead = 0;
@@ -237,6 +391,9 @@ void AIQ::enqueue( const qint16 *src, int nCts )
 
     endCt += nCts;
 
+    if( shm )
+        shm->write( src, nCts );
+
     if( nCts >= bufmax ) {
         // Keep only newest bufmax-worth.
         bufhead = 0;
@@ -276,6 +433,9 @@ void AIQ::enqueueProfile(
 
     endCt += nCts;
 
+    if( shm )
+        shm->write( src, nCts );
+
     if( nCts >= bufmax ) {
         // Keep only newest bufmax-worth.
         bufhead = 0;
@@ -423,8 +583,8 @@ int AIQ::getNScansFromCtProfile(
     try {
         dest.insert(
             dest.end(),
-            buf.begin() + SAMPS(head),
-            buf.begin() + SAMPS(head + nrhs) );
+            buf + SAMPS(head),
+            buf + SAMPS(head + nrhs) );
     }
     catch( const std::exception& ) {
         Warning()
@@ -439,8 +599,8 @@ int AIQ::getNScansFromCtProfile(
         try {
             dest.insert(
                 dest.end(),
-                buf.begin(),
-                buf.begin() + SAMPS(nMax) );
+                buf,
+                buf + SAMPS(nMax) );
         }
         catch( const std::exception& ) {
             Warning()
@@ -487,8 +647,8 @@ int AIQ::getNScansFromCt(
     try {
         dest.insert(
             dest.end(),
-            buf.begin() + SAMPS(head),
-            buf.begin() + SAMPS(head + nrhs) );
+            buf + SAMPS(head),
+            buf + SAMPS(head + nrhs) );
     }
     catch( const std::exception& ) {
         Warning()
@@ -503,8 +663,8 @@ int AIQ::getNScansFromCt(
         try {
             dest.insert(
                 dest.end(),
-                buf.begin(),
-                buf.begin() + SAMPS(nMax) );
+                buf,
+                buf + SAMPS(nMax) );
         }
         catch( const std::exception& ) {
             Warning()
@@ -9,6 +9,8 @@
 
 #include <QMutex>
 
+class ShmRing;
+
 /* ---------------------------------------------------------------- */
 /* Types ---------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -41,27 +43,49 @@ private:
     const double    srate;
     const int       nchans,
                     bufmax;
-    vec_i16         buf;
+    qint16          *buf;
+    size_t          mapBytes;
     mutable QMutex  QMtx;
-    double          tzero;
+    mutable ShmRing *shm;
+    double          tzero,
+                    faultSecs;
     quint64         endCt;
     int             bufhead,
-                    buflen;
+                    buflen,
+                    lateHuge;
+    bool            huge,
+                    faulted;
 
 /* ------- */
 /* Methods */
 /* ------- */
 
 public:
-    AIQ( double srate, int nchans, int capacitySecs );
+    AIQ( double srate, int nchans, int capacitySecs, int hugePages = 0 );
+    virtual ~AIQ();
 
     double sRate() const        {return srate;}
     double chanRate() const     {return nchans * srate;}
     int nChans() const          {return nchans;}
+    qint64 bufBytes() const     {return mapBytes;}
+    bool hugePages() const      {return huge;}
+    bool hugePending() const    {return lateHuge != 0;}
+    double prefaultSecs() const {return faultSecs;}
+
+    bool sameShape( double srate, int nchans, int capacitySecs ) const;
+    void reset();
+    void prefault();
 
     void setTZero( double t0 )  {tzero = t0;}
     double tZero() const        {return tzero;}
 
+    bool shmMirror(
+        QString         &err,
+        QString         &key,
+        int             &hdrBytes,
+        int             &capScans,
+        const QString   &stream ) const;
+
     void enqueueZero( double t0, double tLim );
 
     void enqueue( const qint16 *src, int nCts );
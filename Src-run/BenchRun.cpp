@@ -0,0 +1,263 @@
+
+#include "BenchRun.h"
+#include "Util.h"
+#include "MainApp.h"
+#include "ConfigCtl.h"
+#include "MetricsWindow.h"
+#include "Instr.h"
+#include "DFZip.h"
+#include "ImUnpack.h"
+#include "NIDemux.h"
+#include "SubsetSIMD.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QMessageBox>
+#include <QTextStream>
+
+
+/* ---------------------------------------------------------------- */
+/* BenchRun ------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Assert run parameters for benchmark recording.
+//
+void BenchRun::initRun()
+{
+    MainApp     *app = mainApp();
+    ConfigCtl   *cfg = app->cfgCtl();
+    DAQ::Params p;
+    QDateTime   tCreate( QDateTime::currentDateTime() );
+
+// ---------------------
+// Set custom run params
+// ---------------------
+
+    p = oldParams = cfg->acceptedParams;
+
+    p.mode.mGate        = DAQ::eGateImmed;
+    p.mode.mTrig        = DAQ::eTrigImmed;
+    p.mode.manOvShowBut = false;
+    p.mode.manOvInitOff = false;
+
+    p.sns.notes     = "Throughput benchmark";
+    p.sns.runName   =
+        QString("Bench_%1")
+        .arg( dateTime2Str( tCreate, Qt::ISODate ).replace( ":", "." ) );
+    p.sns.fldPerPrb = false;
+
+    cfg->setParams( p, false );
+
+// ------------------------
+// Target dir, instrumented
+// ------------------------
+
+    oldDataDir = app->dataDir();
+    app->remoteSetsDataDir( dir );
+
+    oldInstr = Instr::isEnabled();
+    app->metrics()->instrSetEnabled( true );
+}
+
+
+void BenchRun::initTimer()
+{
+    runTZero = getTime();
+    cpuTZero = getProcessCPUSecs();
+}
+
+
+// First call wins: the timeout, else the run stopping.
+//
+void BenchRun::stopTimer()
+{
+    if( !runTStop && runTZero ) {
+        runTStop = getTime();
+        cpuSecs  = getProcessCPUSecs() - cpuTZero;
+    }
+}
+
+
+void BenchRun::restore()
+{
+    MainApp *app = mainApp();
+
+    app->cfgCtl()->setParams( oldParams, false );
+    app->remoteSetsDataDir( oldDataDir );
+    app->metrics()->instrSetEnabled( oldInstr );
+}
+
+
+// - Report.
+// - Restore user parameters.
+//
+void BenchRun::finish()
+{
+    stopTimer();
+
+    QStringList sl, csv;
+
+    report( sl, csv );
+
+    foreach( const QString &s, sl )
+        Log() << s;
+
+// -------------------
+// Append to bench.csv
+// -------------------
+
+    QFile   f( QString("%1/bench.csv").arg( dir ) );
+    bool    isNew = !f.exists();
+
+    if( f.open( QIODevice::Append | QIODevice::Text ) ) {
+
+        QTextStream ts( &f );
+
+        if( isNew )
+            ts << "run,secs,metric,name,value\n";
+
+        foreach( const QString &s, csv )
+            ts << s << "\n";
+    }
+    else
+        Warning() << "Benchmark: Can't write [" << f.fileName() << "].";
+
+    restore();
+
+    QMessageBox::information(
+        0,
+        "Throughput Benchmark",
+        sl.join( "\n" ) );
+
+    mainApp()->runBenchFinished();
+}
+
+/* ---------------------------------------------------------------- */
+/* Private -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void BenchRun::report( QStringList &sl, QStringList &csv )
+{
+    const DAQ::Params   &p      = mainApp()->cfgCtl()->acceptedParams;
+    double              wall    = qMax( 1e-3, runTStop - runTZero ),
+                        totB    = 0;
+    int                 np      = p.im.get_nProbes();
+    QString             run     = QString("%1,%2")
+                                    .arg( p.sns.runName )
+                                    .arg( wall, 0, 'f', 1 );
+
+    sl.append(
+        QString("Benchmark %1: %2 s, %3 imec%4%5")
+        .arg( p.sns.runName )
+        .arg( wall, 0, 'f', 1 )
+        .arg( np )
+        .arg( p.ni.enabled ? " + nidq" : "" )
+        .arg( mainApp()->isHeadless() ? ", headless" : "" ) );
+
+#ifdef HAVE_IMEC
+    imUnpackBench( sl );
+#endif
+
+    niDemuxBench( sl );
+    subsetBench( sl );
+    dfzBench( sl );
+
+// -----
+// Files
+// -----
+
+    QMap<QString,quint64>   bytes;
+    Instr::counterVals( bytes, ".wrBytes" );
+
+    QMap<QString,quint64>::const_iterator   it, end;
+
+    for( it = bytes.begin(), end = bytes.end(); it != end; ++it ) {
+
+        if( !it.value() )
+            continue;
+
+        double  MBps    = it.value() / wall / (1024*1024);
+        int     qHi     = Instr::gauge( it.key() + ".wrQueuePct" )->maxVal();
+        double  p99     = Instr::hist( it.key() + ".write" )->pctileUs( 99 );
+
+        totB += it.value();
+
+        sl.append(
+            QString("  %1  %2 MB/s  queue max %3%  write p99 %4 us")
+            .arg( it.key(), -10 )
+            .arg( MBps, 0, 'f', 2 )
+            .arg( qHi )
+            .arg( p99 ) );
+
+        csv.append( QString("%1,MBps,%2,%3")
+                    .arg( run ).arg( it.key() ).arg( MBps ) );
+        csv.append( QString("%1,queueMaxPct,%2,%3")
+                    .arg( run ).arg( it.key() ).arg( qHi ) );
+        csv.append( QString("%1,writeP99us,%2,%3")
+                    .arg( run ).arg( it.key() ).arg( p99 ) );
+    }
+
+    sl.append(
+        QString("  total  %1 MB/s  (%2 MB)")
+        .arg( totB / wall / (1024*1024), 0, 'f', 2 )
+        .arg( totB / (1024*1024), 0, 'f', 1 ) );
+
+    csv.append(
+        QString("%1,MBps,total,%2")
+        .arg( run ).arg( totB / wall / (1024*1024) ) );
+
+// -----------
+// Trigger lag
+// -----------
+
+    QStringList streams;
+
+    if( p.ni.enabled )
+        streams.append( "nidq" );
+
+    for( int ip = 0; ip < np; ++ip )
+        streams.append( QString("imec%1").arg( ip ) );
+
+    QString sLag;
+
+    foreach( const QString &s, streams ) {
+
+        int lag = Instr::gauge( s + ".trigLagPct" )->maxVal();
+
+        sLag += QString("  %1 %2%").arg( s ).arg( lag );
+        csv.append( QString("%1,lagMaxPct,%2,%3")
+                    .arg( run ).arg( s ).arg( lag ) );
+    }
+
+    sl.append( "  trigger lag max:" + sLag );
+
+// ---
+// CPU
+// ---
+
+    QMap<QString,quint64>   cpuUs;
+    Instr::counterVals( cpuUs, ".cpuUs" );
+
+    double  pct = 100.0 * cpuSecs / wall;
+
+    sl.append( QString("  CPU process %1%").arg( pct, 0, 'f', 1 ) );
+    csv.append( QString("%1,cpuPct,process,%2").arg( run ).arg( pct ) );
+
+    for( it = cpuUs.begin(), end = cpuUs.end(); it != end; ++it ) {
+
+        if( !it.value() )
+            continue;
+
+        pct = 1e-4 * it.value() / wall;
+
+        sl.append(
+            QString("  CPU %1  %2%")
+            .arg( it.key(), -18 )
+            .arg( pct, 0, 'f', 1 ) );
+
+        csv.append( QString("%1,cpuPct,%2,%3")
+                    .arg( run ).arg( it.key() ).arg( pct ) );
+    }
+}
+
+
@@ -0,0 +1,60 @@
+#ifndef BENCHRUN_H
+#define BENCHRUN_H
+
+#include "DAQ.h"
+
+#include <QObject>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Throughput benchmark.
+//
+// Records the current stream configuration (hardware, simulated
+// or replay) with immediate gate and trigger into a chosen folder
+// for a fixed time. Instrumentation is forced on for the run.
+//
+// Reported, per file: sustained MB/s, write queue high-water and
+// write-call p99; per stream: trigger lag high-water (percent of
+// AIQ not yet consumed); per thread: CPU percent.
+//
+// Results go to the log, a summary box, and are appended to
+// bench.csv in the target folder for comparison across builds.
+//
+class BenchRun : public QObject
+{
+    Q_OBJECT
+
+private:
+    DAQ::Params oldParams;
+    QString     oldDataDir,
+                dir;
+    double      runTZero,
+                runTStop,
+                cpuTZero,
+                cpuSecs;
+    int         secs;
+    bool        oldInstr;
+
+public:
+    BenchRun( const QString &dir, int secs )
+    :   dir(dir), runTZero(0), runTStop(0),
+        cpuTZero(0), cpuSecs(0), secs(secs), oldInstr(false)  {}
+
+    void initRun();
+    void initTimer();
+    void stopTimer();
+    int targetMS() const    {return 1000 * secs;}
+    void restore();
+
+public slots:
+    void finish();
+
+private:
+    void report( QStringList &sl, QStringList &csv );
+};
+
+#endif  // BENCHRUN_H
+
+
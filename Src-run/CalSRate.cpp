@@ -5,6 +5,7 @@
 #include "ConfigCtl.h"
 #include "DataFileIMAP.h"
 #include "DataFileNI.h"
+#include "DFEdges.h"
 
 #include <QMessageBox>
 #include <QProgressDialog>
@@ -233,103 +234,55 @@ QTextStream ts( &f );
     const int statN = 10;
 
     std::vector<Bin>    vB;
+    std::vector<qint64> vX;
     int                 nb = 0;
 
     double  srate   = df->samplingRateHz();
-    qint64  nRem    = df->scanCount(),
-            xpos    = 0,
-            lastX   = 0;
-    int     nC      = df->numChans(),
-            nthEdge = (quint64(nRem / (srate * syncPer)) - 1) / statN,
-            iEdge   = nthEdge - 1,
-            tenth   = 0;
-    bool    isHi    = false;
+    qint64  lastX   = 0;
+    int     nthEdge = (quint64(df->scanCount() / (srate * syncPer)) - 1) / statN,
+            iEdge   = nthEdge - 1;
 
-    int iword   = df->channelIDs().indexOf( dword ),
-        mask    = 1 << (syncChan % 16);
+// -----------------------------------------
+// Get rising edges from index, else by scan
+// -----------------------------------------
 
-    if( iword < 0 ) {
-        S.err =
-        QString("%1 sync word (chan %2) not included in saved channels")
-        .arg( df->streamFromObj() )
-        .arg( dword );
+    DFEdges edx;
+
+    if( edx.openForRead( df ) && edx.isIndexed( dword ) )
+        edx.bitEdges( vX, dword, syncChan % 16, true );
+    else if( !scanDigitalEdges( vX, S, df, syncChan, dword ) )
         return;
-    }
 
 // --------------------------
 // Collect and bin the counts
 // --------------------------
 
-    for(;;) {
-
-        if( isCanceled() ) {
-            S.err = "canceled";
-            return;
-        }
-
-        vec_i16 data;
-        qint64  ntpts,
-                chunk = srate,
-                nthis = qMin( chunk, nRem );
-
-        ntpts = df->readScans( data, xpos, nthis, QBitArray() );
-
-        if( ntpts <= 0 )
-            break;
-
-        // Init high/low flag
+    for( int ix = 0, nx = vX.size(); ix < nx; ++ix ) {
 
-        if( !xpos )
-            isHi = (data[iword] & mask) > 0;
+        if( ++iEdge >= nthEdge ) {
 
-        // Scan block for edges
+            if( lastX > 0 ) {
 
-        for( int i = 0; i < ntpts; ++i ) {
-
-            if( isHi ) {
-
-                if( (data[i*nC + iword] & mask) < 1 )
-                    isHi = false;
-            }
-            else {
-
-                if( (data[i*nC + iword] & mask) > 0 ) {
-
-                    if( ++iEdge >= nthEdge ) {
-
-                        if( lastX > 0 ) {
-
-                            qint64  c = xpos + i - lastX;
+                qint64  c = vX[ix] - lastX;
 
 #ifdef EDGEFILES
 ts << c << "\n";
 #endif
 
-                            for( int ib = 0; ib < nb; ++ib ) {
+                for( int ib = 0; ib < nb; ++ib ) {
 
-                                if( vB[ib].isIn( c ) )
-                                    goto binned;
-                            }
+                    if( vB[ib].isIn( c ) )
+                        goto binned;
+                }
 
-                            vB.push_back( Bin( c ) );
-                            ++nb;
-                        }
+                vB.push_back( Bin( c ) );
+                ++nb;
+            }
 
 binned:
-                        lastX = xpos + i;
-                        iEdge = 0;
-                        reportTenth( ++tenth );
-                    }
-
-                    isHi = true;
-                }
-            }
+            lastX = vX[ix];
+            iEdge = 0;
         }
-
-        // Advance for next block
-
-        xpos    += ntpts;
-        nRem    -= ntpts;
     }
 
 // ---------------
@@ -397,6 +350,83 @@ Log() << df->fileLblFromObj() << " win N " << nthEdge << " " << N;
 }
 
 
+// Scan whole file for rising edges of sync bit.
+// Return false if error or canceled.
+//
+bool CalSRWorker::scanDigitalEdges(
+    std::vector<qint64> &vX,
+    CalSRStream         &S,
+    DataFile            *df,
+    int                 syncChan,
+    int                 dword )
+{
+    qint64  nTot    = df->scanCount(),
+            nRem    = nTot,
+            xpos    = 0;
+    int     nC      = df->numChans();
+    bool    isHi    = false;
+
+    int iword   = df->channelIDs().indexOf( dword ),
+        mask    = 1 << (syncChan % 16);
+
+    if( iword < 0 ) {
+        S.err =
+        QString("%1 sync word (chan %2) not included in saved channels")
+        .arg( df->streamFromObj() )
+        .arg( dword );
+        return false;
+    }
+
+    for(;;) {
+
+        if( isCanceled() ) {
+            S.err = "canceled";
+            return false;
+        }
+
+        vec_i16 data;
+        qint64  ntpts,
+                chunk = df->samplingRateHz(),
+                nthis = qMin( chunk, nRem );
+
+        ntpts = df->readScans( data, xpos, nthis, QBitArray() );
+
+        if( ntpts <= 0 )
+            break;
+
+        // Init high/low flag
+
+        if( !xpos )
+            isHi = (data[iword] & mask) > 0;
+
+        // Scan block for edges
+
+        for( int i = 0; i < ntpts; ++i ) {
+
+            if( isHi ) {
+
+                if( (data[i*nC + iword] & mask) < 1 )
+                    isHi = false;
+            }
+            else if( (data[i*nC + iword] & mask) > 0 ) {
+
+                vX.push_back( xpos + i );
+                isHi = true;
+            }
+        }
+
+        // Advance for next block
+
+        xpos    += ntpts;
+        nRem    -= ntpts;
+
+        reportTenth( 10 * xpos / nTot );
+    }
+
+    return true;
+}
+
+
 void CalSRWorker::scanAnalog(
     CalSRStream     &S,
     DataFile        *df,
@@ -95,6 +95,13 @@ private:
         int             syncChan,
         int             dword );
 
+    bool scanDigitalEdges(
+        std::vector<qint64> &vX,
+        CalSRStream         &S,
+        DataFile            *df,
+        int                 syncChan,
+        int                 dword );
+
     void scanAnalog(
         CalSRStream     &S,
         DataFile        *df,
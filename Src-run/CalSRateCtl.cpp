@@ -5,6 +5,7 @@
 #include "Util.h"
 #include "MainApp.h"
 #include "ConfigCtl.h"
+#include "DFCatalog.h"
 #include "DFName.h"
 #include "KVParams.h"
 #include "HelpButDialog.h"
@@ -341,17 +342,27 @@ void CalSRateCtl::setJobsOne( QString &f )
 
 void CalSRateCtl::setJobsAll( QString &f )
 {
-    KVParams    kvp;
-    int         np;
+    DFCatRec    R;
+    int         np,
+                nn;
 
-    kvp.fromMetaFile( DFName::forceMetaSuffix( f ) );
+    if( DFCatalog::find( R, mainApp()->dataDir(), f ) ) {
+        np = R.nIm;
+        nn = R.nNi;
+    }
+    else {
+        KVParams    kvp;
+
+        kvp.fromMetaFile( DFName::forceMetaSuffix( f ) );
 
-    np = kvp["typeImEnabled"].toInt();
+        np = kvp["typeImEnabled"].toInt();
+        nn = kvp["typeNiEnabled"].toInt();
+    }
 
     for( int ip = 0; ip < np; ++ip )
         vIM.push_back( CalSRStream( ip ) );
 
-    if( kvp["typeNiEnabled"].toInt() > 0 )
+    if( nn > 0 )
         vNI.push_back( CalSRStream( -1 ) );
 }
 
@@ -0,0 +1,257 @@
+
+#include "CimAcqFile.h"
+#include "Util.h"
+#include "Instr.h"
+#include "DataFileIMAP.h"
+#include "DataFileIMLF.h"
+#include "DFName.h"
+
+#include <QFileInfo>
+#include <QThread>
+
+
+#define LOOPSECS    0.005
+
+
+/* ---------------------------------------------------------------- */
+/* CimAcqFile ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+CimAcqFile::CimAcqFile(
+    IMReaderWorker      *owner,
+    const DAQ::Params   &p,
+    const ReplayParams  &R )
+    :   CimAcq( owner, p ), R(R)
+{
+}
+
+
+CimAcqFile::~CimAcqFile()
+{
+    for( int ip = 0, np = vP.size(); ip < np; ++ip )
+        delete vP[ip];
+}
+
+/* ---------------------------------------------------------------- */
+/* CimAcqFile::run ------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+// Alternately:
+// (1) Enqueue pts at speed * sample rate.
+// (2) Sleep balance of time, up to LOOPSECS.
+//
+// File reading is done by each feed's prefetch thread,
+// so one thread here serves all probes.
+//
+// Looping: once every probe's AP feed is at EOF, all feeds
+// rewind together, when ReplayLoop says all streams are done.
+//
+void CimAcqFile::run()
+{
+// ---------
+// Configure
+// ---------
+
+    QString err;
+
+    if( !openFeeds( err ) ) {
+        runError( err );
+        return;
+    }
+
+    int     np      = vP.size(),
+            loopId  = (R.loop ? ReplayLoop::join() : -1),
+            iLoop   = 0;
+    vec_i16 buf;
+
+    for( int ip = 0; ip < np; ++ip )
+        owner->imQ[ip]->prefault();
+
+// -----
+// Start
+// -----
+
+    atomicSleepWhenReady();
+
+    if( isStopped() )
+        return;
+
+// ---
+// Run
+// ---
+
+    InstrThreadCPU  cpu( "imAcq" );
+    double          t0          = getTime();
+    bool            eofReported = false;
+
+    for( int ip = 0; ip < np; ++ip )
+        owner->imQ[ip]->setTZero( t0 );
+
+    while( !isStopped() ) {
+
+        double  t       = getTime();
+        bool    allEOF  = true;
+
+        cpu.sample();
+
+        for( int ip = 0; ip < np; ++ip ) {
+
+            FilePrb &P          = *vP[ip];
+            quint64 targetCt    = (t + LOOPSECS - t0) * R.speed * P.srate;
+
+            if( targetCt > P.totPts ) {
+
+                int nMax = qMin(
+                            targetCt - P.totPts,
+                            quint64(10 * LOOPSECS * R.speed * P.srate) );
+
+                buf.resize( nMax * P.nCH );
+
+                int n = fetch( &buf[0], P, nMax );
+
+                if( n ) {
+                    owner->imQ[ip]->enqueue( &buf[0], n );
+                    P.totPts += n;
+                }
+            }
+
+            if( !P.ap.atEOF() )
+                allEOF = false;
+        }
+
+        if( allEOF && !eofReported ) {
+            Log() << "Replay: end of imec files.";
+            eofReported = true;
+        }
+
+        if( allEOF
+            && loopId >= 0
+            && ReplayLoop::arrive( loopId, iLoop ) ) {
+
+            for( int ip = 0; ip < np; ++ip ) {
+
+                FilePrb &P = *vP[ip];
+
+                P.ap.rewind();
+
+                if( P.hasLF )
+                    P.lf.rewind();
+
+                P.lfPhase = 0;
+            }
+
+            ++iLoop;
+        }
+
+        double  dt = getTime() - t;
+
+        if( dt < LOOPSECS )
+            QThread::usleep( 1e6 * (LOOPSECS - dt) );
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* Private -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+bool CimAcqFile::openFeeds( QString &err )
+{
+    DFRunTag    tag( R.binFile );
+
+    for( int ip = 0, np = p.im.get_nProbes(); ip < np; ++ip ) {
+
+        const CimCfg::AttrEach  &E = p.im.each[ip];
+
+        FilePrb *P = new FilePrb;
+        vP.push_back( P );
+
+        P->srate    = E.srate;
+        P->nCH      = E.imCumTypCnt[CimCfg::imSumAll];
+        P->tpl.assign( P->nCH, 0 );
+
+        QString ap = tag.filename( ip, "ap.bin" ),
+                lf = tag.filename( ip, "lf.bin" );
+
+        if( !P->ap.open(
+                err, new DataFileIMAP( ip ),
+                ap, P->nCH, R.speed ) ) {
+
+            return false;
+        }
+
+        if( qAbs( P->ap.srate() - P->srate ) > 0.01 * P->srate ) {
+            Warning() <<
+                QString("Replay imec%1: file rate %2 Hz, configured %3 Hz.")
+                .arg( ip ).arg( P->ap.srate() ).arg( P->srate );
+        }
+
+        if( QFileInfo( lf ).exists() ) {
+
+            if( !P->lf.open(
+                    err, new DataFileIMLF( ip ),
+                    lf, P->nCH, R.speed ) ) {
+
+                return false;
+            }
+
+            P->hasLF    = true;
+            P->lfRatio  = qMax( 1, qRound( P->ap.srate() / P->lf.srate() ) );
+        }
+    }
+
+    return true;
+}
+
+
+// Build up to nMax scans in acq layout.
+// LF values are held across lfRatio AP scans.
+// Return count made; fewer if prefetch ran dry.
+//
+// AP waits for its LF scan so the two never drift apart. If
+// LF ends first, its last values are held. Feeds don't loop
+// on their own; run() rewinds them all together.
+//
+int CimAcqFile::fetch( qint16 *dst, FilePrb &P, int nMax )
+{
+    int n = 0;
+
+    for( ; n < nMax; ++n ) {
+
+        const qint16    *src = P.ap.curScan();
+
+        if( !src )
+            break;
+
+        if( P.hasLF && !P.lfPhase ) {
+
+            const qint16    *lf = P.lf.curScan();
+
+            if( lf ) {
+                P.lf.scatter( &P.tpl[0], lf );
+                P.lf.advance();
+            }
+            else if( !P.lf.atEOF() )
+                break;
+        }
+
+        if( ++P.lfPhase >= P.lfRatio )
+            P.lfPhase = 0;
+
+        P.ap.scatter( &P.tpl[0], src );
+        P.ap.advance();
+
+        memcpy( dst, &P.tpl[0], P.nCH * sizeof(qint16) );
+        dst += P.nCH;
+    }
+
+    return n;
+}
+
+
+void CimAcqFile::runError( QString err )
+{
+    Error() << err;
+    emit owner->daqError( err );
+}
+
+
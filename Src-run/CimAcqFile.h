@@ -0,0 +1,54 @@
+#ifndef CIMACQFILE_H
+#define CIMACQFILE_H
+
+#include "CimAcq.h"
+#include "Replay.h"
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// IMEC input replayed from recorded files
+//
+class CimAcqFile : public CimAcq
+{
+private:
+    struct FilePrb {
+        ReplayFeed      ap,
+                        lf;
+        vec_i16         tpl;        // last values, acq layout
+        quint64         totPts;
+        double          srate;
+        int             nCH,
+                        lfRatio,
+                        lfPhase;
+        bool            hasLF;
+
+        FilePrb()
+        :   totPts(0), srate(0), nCH(0),
+            lfRatio(1), lfPhase(0), hasLF(false)    {}
+    };
+
+private:
+    ReplayParams            R;
+    std::vector<FilePrb*>   vP;
+
+public:
+    CimAcqFile(
+        IMReaderWorker      *owner,
+        const DAQ::Params   &p,
+        const ReplayParams  &R );
+    virtual ~CimAcqFile();
+
+    virtual void run();
+    virtual void update( int )  {}
+
+private:
+    bool openFeeds( QString &err );
+    int fetch( qint16 *dst, FilePrb &P, int nMax );
+    void runError( QString err );
+};
+
+#endif  // CIMACQFILE_H
+
+
@@ -7,8 +7,13 @@
 #include "ConfigCtl.h"
 #include "Run.h"
 #include "MetricsWindow.h"
+#include "Instr.h"
+#include "ImUnpack.h"
+#include "ImAPI.h"
+#include "ImProbeCfg.h"
 
 #include <QDir>
+#include <QSettings>
 #include <QThread>
 
 
@@ -18,103 +23,11 @@
 #define TPNTPERFETCH    12
 #define AVEE            5
 #define MAXE            24
+#define PLANSECS        20.0
 //#define PROFILE
 //#define TUNE            0
 
 
-/* ---------------------------------------------------------------- */
-/* ImAcqShared ---------------------------------------------------- */
-/* ---------------------------------------------------------------- */
-
-ImAcqShared::ImAcqShared()
-    :   awake(0), asleep(0), stop(false)
-{
-// Experiment to histogram successive timestamp differences.
-    tStampBins.assign( 34, 0 );
-    tStampEvtByPrb.assign( 32, 0 );
-}
-
-
-// Experiment to histogram successive timestamp differences.
-//
-ImAcqShared::~ImAcqShared()
-{
-#if 0
-    Log()<<"------ Intrafetch timestamp diffs ------";
-    for( int i = 0; i < 34; ++i )
-        Log()<<QString("bin %1  N %2").arg( i ).arg( tStampBins[i] );
-    Log()<<"---- Timestamp incidents each probe ----";
-    for( int i = 0; i < 32; ++i )
-        Log()<<QString("probe %1  N %2").arg( i ).arg( tStampEvtByPrb[i] );
-    Log()<<"----------------------------------------";
-#endif
-}
-
-
-// Experiment to histogram successive timestamp differences.
-// One can collect just difs within packets, or just between
-// packets, or both.
-//
-void ImAcqShared::tStampHist(
-    const electrodePacket*  E,
-    int                     ip,
-    int                     ie,
-    int                     it )
-{
-#if 0
-    qint64  dif = -999999;
-    if( it > 0 )        // intra-packet
-        dif = E[ie].timestamp[it] - E[ie].timestamp[it-1];
-    else if( ie > 0 )   // inter-packet
-        dif = E[ie].timestamp[0] - E[ie-1].timestamp[11];
-
-// @@@ Fix Experiment to report the zero delta value.
-#if 0
-    if( dif == 0 ) {
-        if( !tStampEvtByPrb[ip] ) {
-            Warning()<<
-            QString("ZERO TS probe %1, value %2")
-            .arg( ip ).arg( E[0].timestamp[0] );
-        }
-    }
-#endif
-
-// @@@ FIX Report disabled: too many instances.
-#if 0
-    if( dif == 0 ) {
-        Log()<<QString("ZERO TSTAMP DIF: stamp %1")
-        .arg( E[ie].timestamp[it] );
-    }
-#endif
-
-// @@@ FIX Report disabled: too many instances.
-#if 0
-    if( dif > 31 ) {
-        Log()<<QString("BIGDIF: ip %1 dif %2 stamp %3")
-        .arg( ip ).arg( dif ).arg( E[ie].timestamp[it] );
-    }
-#endif
-
-    if( dif != -999999 ) {
-
-        if( dif < 0 )
-            ++tStampBins[32];
-        else if( dif > 31 )
-            ++tStampBins[33];
-        else
-            ++tStampBins[dif];
-
-        if( dif < 3 || dif > 4 )
-            ++tStampEvtByPrb[ip];
-    }
-#else
-    Q_UNUSED( E )
-    Q_UNUSED( ip )
-    Q_UNUSED( ie )
-    Q_UNUSED( it )
-#endif
-}
-
 /* ---------------------------------------------------------------- */
 /* ImAcqProbe ----------------------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -124,17 +37,15 @@ ImAcqProbe::ImAcqProbe(
     const DAQ::Params           &p,
     int                         ip )
     :   tLastErrReport(0), tLastFifoReport(0),
-        peakDT(0), sumTot(0), totPts(0ULL),
+        peakDT(0), sumTot(0), tLastGapReport(0), totPts(0ULL),
         errCOUNT(0), errSERDES(0), errLOCK(0), errPOP(0), errSYNC(0),
-        fifoAve(0), fifoN(0), sumN(0), ip(ip),
+        tStampLastFetch(0), fifoAve(0), fifoN(0), fifoLast(0), sumN(0),
+        gapsSince(0), dropSince(0), ip(ip),
         fetchType(0), zeroFill(false)
 {
 // @@@ FIX Experiment to report large fetch cycle times.
     tLastFetch      = 0;
 
-// Experiment to detect gaps in timestamps across fetches.
-    tStampLastFetch = 0;
-
 #ifdef PROFILE
     sumLag  = 0;
     sumGet  = 0;
@@ -148,9 +59,25 @@ ImAcqProbe::ImAcqProbe(
     nSY = cum[CimCfg::imTypeSY] - cum[CimCfg::imTypeLF];
     nCH = nAP + nLF + nSY;
 
+    lfLast.assign( nLF, 0.0F );
+
     const CimCfg::ImProbeDat    &P = T.get_iProbe( ip );
     slot = P.slot;
     port = P.port;
+
+    QString pfx = QString("imec%1.").arg( ip );
+    hFetch  = Instr::hist( pfx + "fetch" );
+    hScale  = Instr::hist( pfx + "scale" );
+    hEnq    = Instr::hist( pfx + "enqueue" );
+    gFifo   = Instr::gauge( pfx + "fifoPct" );
+    cPts    = Instr::counter( pfx + "samples" );
+
+    bTsDelta    = Instr::bins( pfx + "tsDelta", 0, 1, 32 );
+    bFetchNE    = Instr::bins( pfx + "fetchNE", 0, 1, MAXE + 1 );
+    bFifo       = Instr::bins( pfx + "fifoPctBins", 0, 5, 20 );
+    cTsGap      = Instr::counter( pfx + "tsGaps" );
+    cTsDrop     = Instr::counter( pfx + "tsDropEst" );
+    cTsBack     = Instr::counter( pfx + "tsBackSteps" );
 }
 
 
@@ -208,18 +135,108 @@ void ImAcqProbe::checkErrFlags( qint8 *E, int nE ) const
 }
 
 
+// Timestamp analytics; called only if instrumentation enabled.
+//
+// Successive samples normally differ by 3 or 4 timestamp ticks.
+// All deltas, within and across fetches, go to tsDelta bins.
+// A delta > 4 is a gap; we estimate dropped samples at 0.3 per
+// tick. A delta <= 0 is a back-step. Gaps are also logged, at
+// most once per 5 seconds per probe.
+//
+void ImAcqProbe::tStampStats( const qint8 *E, int nE ) const
+{
+    const electrodePacket   *pE = (const electrodePacket*)E;
+
+    quint64 loc[34];    // [-1 (under), 0..31, 32 (over)]
+    quint32 prev    = tStampLastFetch;
+    int     nGap    = 0,
+            nDrop   = 0,
+            nBack   = 0;
+
+    memset( loc, 0, 34 * sizeof(quint64) );
+
+    for( int ie = 0; ie < nE; ++ie ) {
+
+        for( int it = 0; it < TPNTPERFETCH; ++it ) {
+
+            quint32 ts = pE[ie].timestamp[it];
+
+            if( prev ) {
+
+                qint32  dif = qint32(ts - prev);
+
+                ++loc[1 + qBound( -1, dif, 32 )];
+
+                if( dif > 4 ) {
+                    ++nGap;
+                    nDrop += qMax( 0, qRound( 0.3 * dif ) - 1 );
+                }
+                else if( dif <= 0 )
+                    ++nBack;
+            }
+
+            prev = ts;
+        }
+    }
+
+    tStampLastFetch = prev;
+
+    for( int i = 0; i < 34; ++i ) {
+
+        if( loc[i] )
+            bTsDelta->add( i - 1, loc[i] );
+    }
+
+    if( nBack )
+        cTsBack->add( nBack );
+
+    if( nGap ) {
+        cTsGap->add( nGap );
+        cTsDrop->add( nDrop );
+        gapsSince += nGap;
+        dropSince += nDrop;
+    }
+
+    if( gapsSince ) {
+
+        double  tGap = getTime();
+
+        if( tGap - tLastGapReport >= 5.0 ) {
+
+            Warning() <<
+                QString("IMEC probe %1: %2 timestamp gaps"
+                " (~%3 samples dropped).")
+                .arg( ip ).arg( gapsSince ).arg( dropSince );
+
+            gapsSince       = 0;
+            dropSince       = 0;
+            tLastGapReport  = tGap;
+        }
+    }
+}
+
+
 bool ImAcqProbe::checkFifo( size_t *packets, CimAcqImec *acq ) const
 {
     double  tFifo = getTime();
 
-    fifoAve += acq->fifoPct( packets, *this );
+    int pct = acq->fifoPct( packets, *this );
+
+    fifoAve += pct;
     ++fifoN;
 
+    if( Instr::isEnabled() ) {
+        gFifo->set( pct );
+        bFifo->add( pct );
+    }
+
     if( tFifo - tLastFifoReport >= 5.0 ) {
 
         if( fifoN > 0 )
             fifoAve /= fifoN;
 
+        fifoLast = fifoAve;
+
         QMetaObject::invokeMethod(
             mainApp()->metrics(),
             "prfUpdateFifo",
@@ -250,17 +267,234 @@ bool ImAcqProbe::checkFifo( size_t *packets, CimAcqImec *acq ) const
     return true;
 }
 
+/* ---------------------------------------------------------------- */
+/* ImAcqSched ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Initial layout: contiguous blocks of prbPerThd.
+//
+void ImAcqSched::init( int np )
+{
+    loadSettings();
+
+    int nThd = (np + prbPerThd - 1) / prbPerThd;
+
+    layout.assign( nThd, std::vector<int>() );
+
+    for( int ip = 0; ip < np; ++ip )
+        layout[ip / prbPerThd].push_back( ip );
+
+    load.assign( np, 0.0 );
+    fifo.assign( np, 0 );
+
+    nCores      = qMin( getNProcessors(), 64 );
+    nAck        = nThd;
+    tLastPlan   = getTime();
+    gen.store( 1 );
+}
+
+
+// Worker k to core 1 + k % (nCores-1), leaving core 0
+// to the GUI and other streams; -1 if not pinning.
+// nCores is capped at the 64-bit affinity mask width.
+//
+int ImAcqSched::core( int iThd ) const
+{
+    if( !pinCores || nCores < 2 )
+        return -1;
+
+    return 1 + iThd % (nCores - 1);
+}
+
+
+void ImAcqSched::report( int ip, double busy, int fifoPct )
+{
+    QMutexLocker    ml( &mtx );
+
+    load[ip] = busy;
+    fifo[ip] = fifoPct;
+}
+
+
+// Longest-first greedy: next heaviest probe goes to least
+// loaded thread, preferring its current thread on ties.
+// Cost is busy fraction, inflated by FIFO fill.
+//
+// Return true if new layout published.
+//
+bool ImAcqSched::plan()
+{
+    QMutexLocker    ml( &mtx );
+
+    int     nThd    = layout.size(),
+            np      = load.size(),
+            fifoMax = 0;
+    double  t       = getTime(),
+            curMax  = 0,
+            newMax  = 0;
+
+    if( !rebalance || nThd < 2 || nAck < nThd || t - tLastPlan < PLANSECS )
+        return false;
+
+// Current loads
+
+    std::vector<double> cost( np, 0.0 );
+    std::vector<int>    owner( np, 0 );
+
+    for( int iThd = 0; iThd < nThd; ++iThd ) {
+
+        const std::vector<int>  &L      = layout[iThd];
+        double                  sum     = 0;
+
+        for( int k = 0, n = L.size(); k < n; ++k ) {
+
+            int ip = L[k];
+
+            cost[ip]    = load[ip] * (1.0 + fifo[ip] / 20.0);
+            owner[ip]   = iThd;
+            sum        += cost[ip];
+            fifoMax     = qMax( fifoMax, fifo[ip] );
+        }
+
+        curMax = qMax( curMax, sum );
+    }
+
+    if( curMax < 0.5 && fifoMax < 5 )
+        return false;
+
+// Greedy pack
+
+    std::vector<std::vector<int> >  newL( nThd );
+    std::vector<double>             sum( nThd, 0.0 );
+    std::vector<bool>               done( np, false );
+
+    for( int k = 0; k < np; ++k ) {
+
+        int ip = -1;
+
+        for( int i = 0; i < np; ++i ) {
+
+            if( !done[i] && (ip < 0 || cost[i] > cost[ip]) )
+                ip = i;
+        }
+
+        int best = owner[ip];
+
+        for( int iThd = 0; iThd < nThd; ++iThd ) {
+
+            if( sum[iThd] < sum[best] - 1e-6 )
+                best = iThd;
+        }
+
+        newL[best].push_back( ip );
+        sum[best]  += cost[ip];
+        done[ip]    = true;
+    }
+
+    for( int iThd = 0; iThd < nThd; ++iThd ) {
+        newMax = qMax( newMax, sum[iThd] );
+        qSort( newL[iThd] );
+    }
+
+    tLastPlan = t;
+
+    if( newMax > 0.9 * curMax || newL == layout )
+        return false;
+
+// Publish
+
+    layout.swap( newL );
+    nAck = 0;
+    gen.ref();
+
+    return true;
+}
+
+
+// "T0[0 1 2]@cpu1 T1[3 4]@cpu2"
+//
+QString ImAcqSched::toString() const
+{
+    QMutexLocker    ml( &mtx );
+
+    QString s;
+
+    for( int iThd = 0, nThd = layout.size(); iThd < nThd; ++iThd ) {
+
+        const std::vector<int>  &L = layout[iThd];
+
+        if( iThd )
+            s += " ";
+
+        s += QString("T%1[").arg( iThd );
+
+        for( int k = 0, n = L.size(); k < n; ++k )
+            s += QString(k ? " %1" : "%1").arg( L[k] );
+
+        s += "]";
+
+        if( core( iThd ) >= 0 )
+            s += QString("@cpu%1").arg( core( iThd ) );
+    }
+
+    return s;
+}
+
+
+// Worker acks current generation; returns it.
+//
+int ImAcqSched::ack()
+{
+    QMutexLocker    ml( &mtx );
+
+    ++nAck;
+    return gen.load();
+}
+
+
+// True if all acked generation g, or g already superseded.
+//
+bool ImAcqSched::allAcked( int g ) const
+{
+    QMutexLocker    ml( &mtx );
+
+    return gen.load() != g || nAck >= (int)layout.size();
+}
+
+
+// Return list and generation it belongs to, read together.
+//
+int ImAcqSched::mine( std::vector<int> &v, int iThd ) const
+{
+    QMutexLocker    ml( &mtx );
+
+    v = layout[iThd];
+    return gen.load();
+}
+
+
+void ImAcqSched::loadSettings()
+{
+    STDSETTINGS( settings, "imacqsched" );
+    settings.beginGroup( "ImAcqSched" );
+
+    prbPerThd   = qBound( 1, settings.value( "prbPerThd", 3 ).toInt(), 32 );
+    rebalance   = settings.value( "rebalance", true ).toBool();
+    pinCores    = settings.value( "pinCores", false ).toBool();
+}
+
 /* ---------------------------------------------------------------- */
 /* ImAcqWorker ---------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
 ImAcqWorker::ImAcqWorker(
-    CimAcqImec              *acq,
-    QVector<AIQ*>           &imQ,
-    ImAcqShared             &shr,
-    std::vector<ImAcqProbe> &probes )
-    :   acq(acq), imQ(imQ), shr(shr), probes(probes),
-        tLastYieldReport(getTime()), yieldSum(0)
+    CimAcqImec      *acq,
+    QVector<AIQ*>   &imQ,
+    ImAcqShared     &shr,
+    int             iThd )
+    :   acq(acq), imQ(imQ), shr(shr),
+        tLastYieldReport(getTime()), yieldSum(0),
+        iThd(iThd), gen(0)
 {
 }
 
@@ -269,26 +503,23 @@ void ImAcqWorker::run()
 {
 // Size buffers
 // ------------
-// - lfLast[][]: each probe must retain the prev LF for all channels.
-// - i16Buf[][]: sized for each probe.
+// Probes can migrate between workers, so buffers are sized
+// over all probes, and each probe carries its own LF history.
+// - i16Buf[]: max sized over nCH; reused each iID.
 // - E[]: max sized over {fetchType, MAXE}; reused each iID.
 //
 
-    std::vector<std::vector<float> >    lfLast;
-    std::vector<std::vector<qint16> >   i16Buf;
+    std::vector<qint16> i16Buf;
 
-    const int   nID     = probes.size();
-    uint        EbytMax = 0;
+    uint            EbytMax = 0;
+    int             nCHMax  = 0;
+    InstrThreadCPU  cpu( QString("imAcq%1").arg( iThd ) );
 
-    lfLast.resize( nID );
-    i16Buf.resize( nID );
+    for( int ip = 0, np = acq->vP.size(); ip < np; ++ip ) {
 
-    for( int iID = 0; iID < nID; ++iID ) {
-
-        const ImAcqProbe    &P = probes[iID];
+        const ImAcqProbe    &P = acq->vP[ip];
 
-        lfLast[iID].assign( P.nLF, 0.0F );
-        i16Buf[iID].resize( MAXE * TPNTPERFETCH * P.nCH );
+        nCHMax = qMax( nCHMax, P.nCH );
 
         if( P.fetchType == 0 ) {
             if( sizeof(electrodePacket) > EbytMax )
@@ -296,8 +527,27 @@ void ImAcqWorker::run()
         }
     }
 
+    i16Buf.resize( MAXE * TPNTPERFETCH * nCHMax );
     E.resize( MAXE * EbytMax );
 
+    {
+        std::vector<int>    v;
+
+        gen = acq->sched.mine( v, iThd );
+
+        for( int k = 0, n = v.size(); k < n; ++k )
+            probes.push_back( &acq->vP[v[k]] );
+    }
+
+    if( acq->sched.core( iThd ) >= 0 )
+        setCurrentThreadAffinityMask( quint64(1) << acq->sched.core( iThd ) );
+
+// Fault in my probes' queues now, after pinning, so their
+// pages are local to this thread (first-touch NUMA policy).
+
+    for( int iID = 0, nID = probes.size(); iID < nID; ++iID )
+        imQ[probes[iID]->ip]->prefault();
+
 // -------------
 // @@@ FIX Mod for no packets
 //_rawAP.resize( MAXE * TPNTPERFETCH * 384 );
@@ -317,20 +567,29 @@ void ImAcqWorker::run()
 
         loopT = getTime();
 
+        cpu.sample();
+
+        // -------------
+        // Layout change
+        // -------------
+
+        if( acq->sched.curGen() != gen && !adoptLayout() )
+            goto exit;
+
         // ------------
         // Do my probes
         // ------------
 
-        for( int iID = 0; iID < nID; ++iID ) {
+        for( int iID = 0, nID = probes.size(); iID < nID; ++iID ) {
 
-            const ImAcqProbe    &P = probes[iID];
+            const ImAcqProbe    &P = *probes[iID];
 
             if( !P.totPts )
                 imQ[P.ip]->setTZero( loopT + T0FUDGE );
 
             double  dtTot = getTime();
 
-            if( !doProbe( &lfLast[iID][0], i16Buf[iID], P ) )
+            if( !doProbe( &P.lfLast[0], i16Buf, P ) )
                 goto exit;
 
             dtTot = getTime() - dtTot;
@@ -355,9 +614,13 @@ void ImAcqWorker::run()
 
         if( loopT - lastCheckT >= 5.0 ) {
 
-            for( int iID = 0; iID < nID; ++iID ) {
+            double  span = loopT - lastCheckT;
+
+            for( int iID = 0, nID = probes.size(); iID < nID; ++iID ) {
+
+                const ImAcqProbe    &P = *probes[iID];
 
-                const ImAcqProbe    &P = probes[iID];
+                acq->sched.report( P.ip, P.sumTot / span, P.fifoLast );
 
 #ifdef PROFILE
                 profile( P );
@@ -385,6 +648,8 @@ bool ImAcqWorker::doProbe(
     double  prbT0 = getTime();
 #endif
 
+    double  tInstr = Instr::startT();
+
     qint16* dst = &dst1D[0];
     int     nE;
 
@@ -397,6 +662,9 @@ bool ImAcqWorker::doProbe(
     if( !acq->fetchE( nE, &E[0], P ) )
         return false;
 
+    if( tInstr )
+        P.bFetchNE->add( nE );
+
     if( !nE ) {
 
 // @@@ FIX Adjust sample waiting for trigger type
@@ -417,114 +685,35 @@ bool ImAcqWorker::doProbe(
     P.sumGet += getTime() - prbT0;
 #endif
 
+    if( tInstr ) {
+
+        P.hFetch->addSince( tInstr );
+
+        if( P.fetchType == 0 )
+            P.tStampStats( &E[0], nE );
+    }
+
 // -----
 // Scale
 // -----
 
-//------------------------------------------------------------------
-// Experiment to detect gaps in timestamps across fetches.
-#if 0
-{
-quint32 firstVal = ((electrodePacket*)&E[0])[0].timestamp[0];
-if( P.tStampLastFetch
-    && (firstVal < P.tStampLastFetch
-    ||  firstVal > P.tStampLastFetch + 4) ) {
-
-    Log() <<
-        QString("~~ TSTAMP GAP IM %1  val %2")
-        .arg( P.ip )
-        .arg( qint32(firstVal - P.tStampLastFetch) );
-}
-P.tStampLastFetch = ((electrodePacket*)&E[0])[nE-1].timestamp[11];
-}
-#endif
-//------------------------------------------------------------------
-
 #ifdef PROFILE
     double  dtScl = getTime();
 #endif
 
-    for( int ie = 0; ie < nE; ++ie ) {
-
-        const qint16    *srcLF = 0;
-        const quint16   *srcSY = 0;
-
-        if( P.fetchType == 0 ) {
-
-            electrodePacket *pE = &((electrodePacket*)&E[0])[ie];
-
-            srcLF = pE->lfpData;
-            srcSY = pE->Status;
-        }
-
-        for( int it = 0; it < TPNTPERFETCH; ++it ) {
-
-            // ----------
-            // ap - as is
-            // ----------
-
-            if( P.fetchType == 0 ) {
-                memcpy( dst,
-                    ((electrodePacket*)&E[0])[ie].apData[it],
-                    P.nAP * sizeof(qint16) );
-            }
-
-            shr.tStampHist( (electrodePacket*)&E[0], P.ip, ie, it );
-
-//------------------------------------------------------------------
-// Experiment to visualize timestamps as sawtooth in channel 16.
-#if 0
-dst[16] = ((electrodePacket*)&E[0])[ie].timestamp[it] % 8000 - 4000;
-#endif
-//------------------------------------------------------------------
-
-//------------------------------------------------------------------
-// Experiment to visualize counter as sawtooth in channel 16.
-#if 0
-static uint count[16] = {0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0};
-count[P.ip] += 3;
-dst[16] = count[P.ip] % 8000 - 4000;
-#endif
-//------------------------------------------------------------------
-
-            dst += P.nAP;
-
-            // -----------------
-            // lf - interpolated
-            // -----------------
-
-#if 1
-// Standard linear interpolation
-            float slope = float(it)/TPNTPERFETCH;
-
-            for( int lf = 0, nlf = P.nLF; lf < nlf; ++lf )
-                *dst++ = lfLast[lf] + slope*(srcLF[lf]-lfLast[lf]);
-#else
-// Raw data for diagnostics
-            for( int lf = 0, nlf = P.nLF; lf < nlf; ++lf )
-                *dst++ = srcLF[lf];
-#endif
-
-            // ----
-            // sync
-            // ----
+// Kernel chosen by CPU features (see ImUnpack).
 
-            *dst++ = srcSY[it];
-
-        }   // it
-
-        // ---------------
-        // update saved lf
-        // ---------------
+    tInstr = Instr::startT();
 
-        for( int lf = 0, nlf = P.nLF; lf < nlf; ++lf )
-            lfLast[lf] = srcLF[lf];
-    }   // ie
+    if( P.fetchType == 0 )
+        acq->unpack( dst, lfLast, &E[0], nE, P.nAP, P.nLF );
 
 #ifdef PROFILE
     P.sumScl += getTime() - dtScl;
 #endif
 
+    P.hScale->addSince( tInstr );
+
 // -------
 // Enqueue
 // -------
@@ -540,6 +729,11 @@ dst[16] = count[P.ip] % 8000 - 4000;
     P.tPostEnq = getTime();
     P.totPts  += TPNTPERFETCH * nE;
 
+    if( Instr::isEnabled() ) {
+        P.hEnq->add( P.tPostEnq - P.tPreEnq );
+        P.cPts->add( TPNTPERFETCH * nE );
+    }
+
 #ifdef PROFILE
     P.sumLag += mainApp()->getRun()->getStreamTime() -
                 (imQ[P.ip]->tZero() + P.totPts / imQ[P.ip]->sRate());
@@ -550,16 +744,53 @@ dst[16] = count[P.ip] % 8000 - 4000;
 }
 
 
-bool ImAcqWorker::workerYield()
+// Ack new layout, then wait until all workers have acked,
+// so no probe is still held by its old owner. Probe state
+// (LF history, counters) travels with the ImAcqProbe.
+// If another plan was published meanwhile, ack that one.
+//
+bool ImAcqWorker::adoptLayout()
 {
-// Get maximum outstanding packets for this worker thread
+    std::vector<int>    v;
+    int                 g;
 
-    size_t  maxQPkts    = 0;
-    int     nID         = probes.size();
+    for(;;) {
+
+        g = acq->sched.ack();
+
+        while( !acq->sched.allAcked( g ) ) {
+
+            if( acq->isStopped() || shr.stopping() )
+                return false;
+
+            QThread::usleep( 100 );
+        }
+
+        if( acq->sched.mine( v, iThd ) == g )
+            break;
+    }
+
+    probes.clear();
+
+    for( int k = 0, n = v.size(); k < n; ++k )
+        probes.push_back( &acq->vP[v[k]] );
+
+    gen = g;
+
+    return true;
+}
+
+
+bool ImAcqWorker::workerYield()
+{
+// Get maximum outstanding packets for this worker thread
+
+    size_t  maxQPkts    = 0;
+    int     nID         = probes.size();
 
     for( int iID = 0; iID < nID; ++iID ) {
 
-        const ImAcqProbe    &P = probes[iID];
+        const ImAcqProbe    &P = *probes[iID];
         size_t              packets;
 
         if( !P.checkFifo( &packets, acq ) )
@@ -580,13 +811,18 @@ bool ImAcqWorker::workerYield()
 
     if( t - tLastYieldReport >= 5.0 ) {
 
-        QMetaObject::invokeMethod(
-            mainApp()->metrics(),
-            "prfUpdateAwake",
-            Qt::QueuedConnection,
-            Q_ARG(int, probes[0].ip),
-            Q_ARG(int, probes[nID-1].ip),
-            Q_ARG(int, qMax( 0, int(100.0*(1.0 - yieldSum/5.0))) ) );
+        // Probes needn't be contiguous; report each
+
+        for( int iID = 0; iID < nID; ++iID ) {
+
+            QMetaObject::invokeMethod(
+                mainApp()->metrics(),
+                "prfUpdateAwake",
+                Qt::QueuedConnection,
+                Q_ARG(int, probes[iID]->ip),
+                Q_ARG(int, probes[iID]->ip),
+                Q_ARG(int, qMax( 0, int(100.0*(1.0 - yieldSum/5.0))) ) );
+        }
 
         yieldSum            = 0;
         tLastYieldReport    = t;
@@ -637,13 +873,13 @@ void ImAcqWorker::profile( const ImAcqProbe &P )
 /* ---------------------------------------------------------------- */
 
 ImAcqThread::ImAcqThread(
-    CimAcqImec              *acq,
-    QVector<AIQ*>           &imQ,
-    ImAcqShared             &shr,
-    std::vector<ImAcqProbe> &probes )
+    CimAcqImec      *acq,
+    QVector<AIQ*>   &imQ,
+    ImAcqShared     &shr,
+    int             iThd )
 {
     thread  = new QThread;
-    worker  = new ImAcqWorker( acq, imQ, shr, probes );
+    worker  = new ImAcqWorker( acq, imQ, shr, iThd );
 
     worker->moveToThread( thread );
 
@@ -673,8 +909,13 @@ ImAcqThread::~ImAcqThread()
 CimAcqImec::CimAcqImec( IMReaderWorker *owner, const DAQ::Params &p )
     :   CimAcq( owner, p ),
         T(mainApp()->cfgCtl()->prbTab),
-        pausPortsRequired(0), pausSlot(-1), nThd(0)
+        unpack(imUnpackSelect()),
+        cfgSecs(0), pausPortsRequired(0), pausSlot(-1), nThd(0),
+        keepHW(false), hwOK(false)
 {
+    STDSETTINGS( settings, "runwarm" );
+    settings.beginGroup( "RunWarm" );
+    keepHW = settings.value( "keepHardware", false ).toBool();
 }
 
 /* ---------------------------------------------------------------- */
@@ -686,10 +927,40 @@ CimAcqImec::~CimAcqImec()
     shr.kill();
 
     for( int iThd = 0; iThd < nThd; ++iThd ) {
-        imT[iThd]->thread->wait( 10000/nThd );
+
+        if( !imT[iThd]->thread->wait( 10000/nThd ) )
+            hwOK = false;
+
         delete imT[iThd];
     }
 
+// Keep configured hardware for next identical run,
+// only if the run ended cleanly and streaming stops.
+
+    if( keepHW && hwOK ) {
+
+        QVector<int>    slots;
+
+        for( int is = 0, ns = T.nLogSlots(); is < ns; ++is ) {
+
+            int slot = T.getEnumSlot( is );
+
+            if( arm( slot ) != SUCCESS ) {
+                hwOK = false;
+                break;
+            }
+
+            slots.push_back( slot );
+        }
+
+        if( hwOK ) {
+            CimCfg::warmSet( warmKey, slots, cfgSecs );
+            return;
+        }
+
+        Warning() << "IMEC warm restart: arm failed; closing hardware.";
+    }
+
     QThread::msleep( 2000 );
 
 // Close hardware
@@ -713,27 +984,27 @@ void CimAcqImec::run()
     if( !configure() )
         return;
 
-// Create worker threads
+// Create probes and worker threads
+// Probe storage is fixed before workers take pointers.
 
-// @@@ FIX Tune probes per thread here and in triggers
-    const int   nPrbPerThd = 3;
+    int np = p.im.get_nProbes();
 
-    for( int ip0 = 0, np = p.im.get_nProbes(); ip0 < np; ip0 += nPrbPerThd ) {
+    vP.reserve( np );
 
-        std::vector<ImAcqProbe> probes;
+    for( int ip = 0; ip < np; ++ip )
+        vP.push_back( ImAcqProbe( T, p, ip ) );
 
-        for( int id = 0; id < nPrbPerThd; ++id ) {
+    sched.init( np );
 
-            if( ip0 + id < np )
-                probes.push_back( ImAcqProbe( T, p, ip0 + id ) );
-            else
-                break;
-        }
+    Log() << "IMEC unpack kernel: " << imUnpackName( unpack );
 
-        imT.push_back( new ImAcqThread( this, owner->imQ, shr, probes ) );
+    for( int iThd = 0, n = sched.nThreads(); iThd < n; ++iThd ) {
+        imT.push_back( new ImAcqThread( this, owner->imQ, shr, iThd ) );
         ++nThd;
     }
 
+    postLayout();
+
 // Wait for threads to reach ready (sleep) state
 
     shr.runMtx.lock();
@@ -772,9 +1043,25 @@ void CimAcqImec::run()
 
     shr.condWake.wakeAll();
 
-// Sleep main thread until external stop command
+// Sleep main thread until external stop command,
+// waking periodically to rebalance workers.
 
-    atomicSleepWhenReady();
+    for(;;) {
+
+        bool    sleep;
+
+        runMtx.lock();
+            sleep = _canSleep && !pleaseStop;
+            if( sleep )
+                condRun.wait( &runMtx, 5000 );
+        runMtx.unlock();
+
+        if( !sleep || isStopped() )
+            break;
+
+        if( sched.plan() )
+            postLayout();
+    }
 
 // --------
 // Clean up
@@ -792,6 +1079,10 @@ void CimAcqImec::update( int ip )
     const CimCfg::ImProbeDat    &P = T.get_iProbe( ip );
     NP_ErrorCode                err;
 
+// Hardware no longer matches warmKey; don't keep it
+
+    hwOK = false;
+
     pauseSlot( P.slot );
 
     while( !pauseAllAck() )
@@ -1128,6 +1419,35 @@ int CimAcqImec::fifoPct( size_t *packets, const ImAcqProbe &P ) const
     return pct;
 }
 
+/* ---------------------------------------------------------------- */
+/* hwKey ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Everything _open, _setSync and _configProbes depend upon.
+// Triggering and arming are redone every run.
+//
+QString CimAcqImec::hwKey() const
+{
+    QString s = QString("sync %1 %2 %3 cal %4;")
+                .arg( p.sync.sourceIdx )
+                .arg( p.sync.imInputSlot )
+                .arg( p.sync.sourcePeriod )
+                .arg( p.im.all.calPolicy );
+
+    for( int ip = 0, np = T.nLogProbes(); ip < np; ++ip ) {
+
+        const CimCfg::ImProbeDat    &P = T.get_iProbe( ip );
+        const CimCfg::AttrEach      &E = p.im.each[ip];
+
+        s += QString(" %1 %2 %3 %4 %5 %6;")
+                .arg( P.slot ).arg( P.port ).arg( P.sn )
+                .arg( E.LEDEnable ).arg( E.stdbyStr )
+                .arg( E.roTbl.toString() );
+    }
+
+    return s;
+}
+
 /* ---------------------------------------------------------------- */
 /* configure ------------------------------------------------------ */
 /* ---------------------------------------------------------------- */
@@ -1329,417 +1649,22 @@ bool CimAcqImec::_setSync( const CimCfg::ImProbeTable &T )
 }
 
 
-bool CimAcqImec::_openProbe( const CimCfg::ImProbeDat &P )
-{
-    SETLBL( QString("open probe %1").arg( P.ip ), true );
-
-    NP_ErrorCode    err = openProbe( P.slot, P.port );
-
-    if( err != SUCCESS ) {
-        runError(
-            QString("IMEC openProbe(slot %1, port %2) error %3 '%4'.")
-            .arg( P.slot ).arg( P.port )
-            .arg( err ).arg( np_GetErrorMessage( err ) ) );
-        return false;
-    }
-
-    err = init( P.slot, P.port );
-
-    if( err != SUCCESS ) {
-        runError(
-            QString("IMEC init(slot %1, port %2) error %3 '%4'.")
-            .arg( P.slot ).arg( P.port )
-            .arg( err ).arg( np_GetErrorMessage( err ) ) );
-        return false;
-    }
-
-    SETVAL( 50 );
-    return true;
-}
-
-
-bool CimAcqImec::_calibrateADC( const CimCfg::ImProbeDat &P )
-{
-    if( p.im.all.calPolicy == 2 ) {
-
-warn:
-        Warning() <<
-            QString("IMEC Skipping probe %1 ADC calibration").arg( P.ip );
-        return true;
-    }
-
-    if( P.cal < 1 ) {
-
-        if( p.im.all.calPolicy == 1 )
-            goto warn;
-        else {
-            runError(
-                QString("Can't find calibration folder '%1' for probe %2.")
-                .arg( P.sn ).arg( P.ip ) );
-            return false;
-        }
-    }
-
-    SETLBL( QString("calibrate probe %1 ADC").arg( P.ip )  );
-
-    QString path = calibPath();
-
-    if( !QDir().mkpath( path ) ) {
-        runError( QString("Failed to create folder '%1'.").arg( path ) );
-        return false;
-    }
-
-    path = QString("%1/%2/%2_ADCCalibration.csv").arg( path ).arg( P.sn ) ;
-
-    if( !QFile( path ).exists() ) {
-        runError( QString("Can't find file '%1'.").arg( path ) );
-        return false;
-    }
-
-    path.replace( "/", "\\" );
-
-    NP_ErrorCode    err;
-
-    err = setADCCalibration( P.slot, P.port, STR2CHR( path ) );
-
-    if( err != SUCCESS ) {
-        runError(
-            QString(
-            "IMEC setADCCalibration(slot %1, port %2) error %3 '%4'.")
-            .arg( P.slot ).arg( P.port )
-            .arg( err ).arg( np_GetErrorMessage( err ) ) );
-        return false;
-    }
-
-    SETVAL( 53 );
-    Log() << QString("IMEC probe %1 ADC calibrated").arg( P.ip );
-    return true;
-}
-
-
-bool CimAcqImec::_calibrateGain( const CimCfg::ImProbeDat &P )
-{
-    if( p.im.all.calPolicy == 2 ) {
-
-warn:
-        Warning() <<
-            QString("IMEC Skipping probe %1 gain calibration").arg( P.ip );
-        return true;
-    }
-
-    if( P.cal < 1 ) {
-
-        if( p.im.all.calPolicy == 1 )
-            goto warn;
-        else {
-            runError(
-                QString("Can't find calibration folder '%1' for probe %2.")
-                .arg( P.sn ).arg( P.ip ) );
-            return false;
-        }
-    }
-
-    SETLBL( QString("calibrate probe %1 gains").arg( P.ip ) );
-
-    QString path = calibPath();
-
-    if( !QDir().mkpath( path ) ) {
-        runError( QString("Failed to create folder '%1'.").arg( path ) );
-        return false;
-    }
-
-    path = QString("%1/%2/%2_gainCalValues.csv").arg( path ).arg( P.sn ) ;
-
-    if( !QFile( path ).exists() ) {
-        runError( QString("Can't find file '%1'.").arg( path ) );
-        return false;
-    }
-
-    path.replace( "/", "\\" );
-
-    NP_ErrorCode    err;
-
-    err = setGainCalibration( P.slot, P.port, STR2CHR( path ) );
-
-    if( err != SUCCESS ) {
-        runError(
-            QString(
-            "IMEC setGainCalibration(slot %1, port %2) error %3 '%4'.")
-            .arg( P.slot ).arg( P.port )
-            .arg( err ).arg( np_GetErrorMessage( err ) ) );
-        return false;
-    }
-
-    SETVAL( 57 );
-    Log() << QString("IMEC probe %1 gains calibrated").arg( P.ip );
-    return true;
-}
-
-
-#if 0   // selectDataSource now private in NeuropixAPI.h
-// Synthetic data generation for testing:
-// 0 = normal
-// 1 = each chan is ADC id num
-// 2 = each chan is chan id num
-// 3 = each chan linear ramping
+// Probes are configured concurrently, see ImProbeCfg.
 //
-bool CimAcqImec::_dataGenerator( const CimCfg::ImProbeDat &P )
+bool CimAcqImec::_configProbes()
 {
-    NP_ErrorCode    err = IM.selectDataSource( P.slot, P.port, 3 );
+    ImAPIHW     api;
+    ImProbeCfg  cfg( api, this, p, T );
+    QString     err;
 
-    if( err != SUCCESS ) {
-        runError(
-            QString(
-            "IMEC selectDataSource(slot %1, port %2) error %3 '%4'.")
-            .arg( P.slot ).arg( P.port )
-            .arg( err ).arg( np_GetErrorMessage( err ) ) );
-        return false;
-    }
-
-    Log() << QString("IMEC probe %1 generating synthetic data").arg( P.ip );
-    return true;
-}
-#endif
+    if( !cfg.configure( err ) ) {
 
+        if( !err.isEmpty() )
+            runError( err );
 
-bool CimAcqImec::_setLEDs( const CimCfg::ImProbeDat &P )
-{
-    SETLBL( QString("set probe %1 LED").arg( P.ip ) );
-
-    NP_ErrorCode    err;
-
-    err = setHSLed( P.slot, P.port, p.im.each[P.ip].LEDEnable );
-
-    if( err != SUCCESS ) {
-        runError(
-            QString("IMEC setHSLed(slot %1, port %2) error %3 '%4'.")
-            .arg( P.slot ).arg( P.port )
-            .arg( err ).arg( np_GetErrorMessage( err ) ) );
         return false;
     }
 
-    SETVAL( 58 );
-    Log() << QString("IMEC probe %1 LED set").arg( P.ip );
-    return true;
-}
-
-
-bool CimAcqImec::_selectElectrodes( const CimCfg::ImProbeDat &P )
-{
-    SETLBL( QString("select probe %1 electrodes").arg( P.ip ) );
-
-    const IMROTbl   &T = p.im.each[P.ip].roTbl;
-    int             nC = T.nChan();
-    NP_ErrorCode    err;
-
-// ------------------------------------
-// Connect all according to table banks
-// ------------------------------------
-
-    for( int ic = 0; ic < nC; ++ic ) {
-
-        if( T.chIsRef( ic ) )
-            continue;
-
-        err = selectElectrode( P.slot, P.port, ic, T.e[ic].bank );
-
-        if( err != SUCCESS ) {
-            runError(
-                QString(
-                "IMEC selectElectrode(slot %1, port %2) error %3 '%4'.")
-                .arg( P.slot ).arg( P.port )
-                .arg( err ).arg( np_GetErrorMessage( err ) ) );
-            return false;
-        }
-    }
-
-    SETVAL( 59 );
-    Log() << QString("IMEC probe %1 electrodes selected").arg( P.ip );
-    return true;
-}
-
-
-bool CimAcqImec::_setReferences( const CimCfg::ImProbeDat &P )
-{
-    SETLBL( QString("set probe %1 references").arg( P.ip ) );
-
-    const IMROTbl   &R = p.im.each[P.ip].roTbl;
-    int             nC = R.nChan();
-    NP_ErrorCode    err;
-
-// ------------------------------------
-// Connect all according to table refid
-// ------------------------------------
-
-// refid    (ref,bnk)   who
-// -----    ---------   ---
-//   0        (0,0)     ext
-//   1        (1,0)     tip
-//   2        (2,0)     192
-//   3        (2,1)     576
-//   4        (2,2)     960
-//
-    for( int ic = 0; ic < nC; ++ic ) {
-
-        int rid = R.e[ic].refid,
-            ref = (rid < 2 ? rid : 2),
-            bnk = (rid > 1 ? rid - 2 : 0);
-
-        err = setReference( P.slot, P.port, ic,
-                channelreference_t(ref), bnk );
-
-        if( err != SUCCESS ) {
-            runError(
-                QString(
-                "IMEC setReference(slot %1, port %2) error %3 '%4'.")
-                .arg( P.slot ).arg( P.port )
-                .arg( err ).arg( np_GetErrorMessage( err ) ) );
-            return false;
-        }
-    }
-
-    SETVAL( 60 );
-    Log() << QString("IMEC probe %1 references set").arg( P.ip );
-    return true;
-}
-
-
-bool CimAcqImec::_setGains( const CimCfg::ImProbeDat &P )
-{
-    SETLBL( QString("set probe %1 gains").arg( P.ip ) );
-
-    const IMROTbl   &R = p.im.each[P.ip].roTbl;
-    int             nC = R.nChan();
-    NP_ErrorCode    err;
-
-// --------------------------------
-// Set all according to table gains
-// --------------------------------
-
-    for( int ic = 0; ic < nC; ++ic ) {
-
-        const IMRODesc  &E = R.e[ic];
-
-        err = setGain( P.slot, P.port, ic,
-                    IMROTbl::gainToIdx( E.apgn ),
-                    IMROTbl::gainToIdx( E.lfgn ) );
-
-//---------------------------------------------------------
-// Experiment to visualize LF scambling on shankviewer by
-// setting every nth gain high and others low.
-#if 0
-        int apidx, lfidx;
-
-        if( !(ic % 10) ) {
-            apidx = IMROTbl::gainToIdx( 3000 );
-            lfidx = IMROTbl::gainToIdx( 3000 );
-        }
-        else {
-            apidx = IMROTbl::gainToIdx( 50 );
-            lfidx = IMROTbl::gainToIdx( 50 );
-        }
-
-        err = setGain( P.slot, P.port, ic,
-                    apidx,
-                    lfidx );
-#endif
-//---------------------------------------------------------
-
-        if( err != SUCCESS ) {
-            runError(
-                QString("IMEC setGain(slot %1, port %2) error %3 '%4'.")
-                .arg( P.slot ).arg( P.port )
-                .arg( err ).arg( np_GetErrorMessage( err ) ) );
-            return false;
-        }
-    }
-
-    SETVAL( 61 );
-    Log() << QString("IMEC probe %1 gains set").arg( P.ip );
-    return true;
-}
-
-
-bool CimAcqImec::_setHighPassFilter( const CimCfg::ImProbeDat &P )
-{
-    SETLBL( QString("set probe %1 filters").arg( P.ip ) );
-
-    const IMROTbl   &R = p.im.each[P.ip].roTbl;
-    int             nC = R.nChan();
-
-    for( int ic = 0; ic < nC; ++ic ) {
-
-        NP_ErrorCode    err;
-
-        err = setAPCornerFrequency( P.slot, P.port, ic, !R.e[ic].apflt );
-
-        if( err != SUCCESS ) {
-            runError(
-                QString(
-                "IMEC setAPCornerFrequency(slot %1, port %2)"
-                " error %3 '%4'.")
-                .arg( P.slot ).arg( P.port )
-                .arg( err ).arg( np_GetErrorMessage( err ) ) );
-            return false;
-        }
-    }
-
-    SETVAL( 62 );
-    Log() << QString("IMEC probe %1 filters set").arg( P.ip );
-    return true;
-}
-
-
-bool CimAcqImec::_setStandby( const CimCfg::ImProbeDat &P )
-{
-    SETLBL( QString("set probe %1 standby").arg( P.ip ) );
-
-// --------------------------------------------------
-// Turn ALL channels on or off according to stdbyBits
-// --------------------------------------------------
-
-    int nC = p.im.each[P.ip].roTbl.nChan();
-
-    for( int ic = 0; ic < nC; ++ic ) {
-
-        NP_ErrorCode    err;
-
-        err = setStdb( P.slot, P.port, ic,
-                p.im.each[P.ip].stdbyBits.testBit( ic ) );
-
-        if( err != SUCCESS ) {
-            runError(
-                QString("IMEC setStandby(slot %1, port %2) error %3 '%4'.")
-                .arg( P.slot ).arg( P.port )
-                .arg( err ).arg( np_GetErrorMessage( err ) ) );
-            return false;
-        }
-    }
-
-    SETVAL( 63 );
-    Log() << QString("IMEC probe %1 standby chans set").arg( P.ip );
-    return true;
-}
-
-
-bool CimAcqImec::_writeProbe( const CimCfg::ImProbeDat &P )
-{
-    SETLBL( QString("writing probe %1...").arg( P.ip ) );
-
-    NP_ErrorCode    err;
-
-    err = writeProbeConfiguration( P.slot, P.port, true );
-
-    if( err != SUCCESS ) {
-        runError(
-            QString(
-            "IMEC writeProbeConfig(slot %1, port %2) error %3 '%4'.")
-            .arg( P.slot ).arg( P.port )
-            .arg( err ).arg( np_GetErrorMessage( err ) ) );
-        return false;
-    }
-
-    SETVAL( 100 );
     return true;
 }
 
@@ -1868,10 +1793,30 @@ bool CimAcqImec::_softStart()
 }
 
 
+// With runwarm.ini keepHardware=true, hardware left configured
+// by an identical previous run is reused as is; else any kept
+// hardware is closed and we configure from scratch.
+//
 bool CimAcqImec::configure()
 {
     STOPCHECK;
 
+    double  t0 = getTime();
+
+    warmKey = hwKey();
+
+    if( keepHW && CimCfg::warmTake( warmKey, cfgSecs ) ) {
+
+        hwOK = true;
+        Log() <<
+            QString("IMEC warm restart: hardware kept configured,"
+            " ~%1 s configuration saved.")
+            .arg( cfgSecs, 0, 'f', 1 );
+        goto trigger;
+    }
+
+    CimCfg::warmRelease();
+
     if( !_allProbesSizeStreamBufs() )
         return false;
 
@@ -1887,65 +1832,14 @@ bool CimAcqImec::configure()
 
     STOPCHECK;
 
-    for( int ip = 0, np = p.im.get_nProbes(); ip < np; ++ip ) {
-
-        const CimCfg::ImProbeDat    &P = T.get_iProbe( ip );
-
-        if( !_openProbe( P ) )
-            return false;
-
-        STOPCHECK;
-
-        if( !_calibrateADC( P ) )
-            return false;
-
-        STOPCHECK;
-
-        if( !_calibrateGain( P ) )
-            return false;
-
-//        STOPCHECK;
-
-//        if( !_dataGenerator( P ) )
-//            return false;
-
-        STOPCHECK;
-
-        if( !_setLEDs( P ) )
-            return false;
-
-        STOPCHECK;
-
-        if( !_selectElectrodes( P ) )
-            return false;
-
-        STOPCHECK;
-
-        if( !_setReferences( P ) )
-            return false;
-
-        STOPCHECK;
-
-        if( !_setGains( P ) )
-            return false;
-
-        STOPCHECK;
-
-        if( !_setHighPassFilter( P ) )
-            return false;
-
-        STOPCHECK;
-
-        if( !_setStandby( P ) )
-            return false;
-
-        STOPCHECK;
+    if( !_configProbes() )
+        return false;
 
-        if( !_writeProbe( P ) )
-            return false;
+    hwOK    = true;
+    cfgSecs = getTime() - t0;
 
-        STOPCHECK;
-    }
+trigger:
+    STOPCHECK;
 
     if( !_setTrigger() )
         return false;
@@ -1980,12 +1874,33 @@ bool CimAcqImec::startAcq()
     return true;
 }
 
+/* ---------------------------------------------------------------- */
+/* postLayout ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void CimAcqImec::postLayout()
+{
+    QString s = sched.toString();
+
+    Log() << "IMEC worker layout: " << s;
+
+    QMetaObject::invokeMethod(
+        mainApp()->metrics(),
+        "prfUpdateLayout",
+        Qt::QueuedConnection,
+        Q_ARG(QString, s) );
+}
+
 /* ---------------------------------------------------------------- */
 /* runError ------------------------------------------------------- */
 /* ---------------------------------------------------------------- */
 
+// Hardware that faulted is never kept for the next run.
+//
 void CimAcqImec::runError( QString err )
 {
+    hwOK = false;
+
     Error() << err;
     emit owner->daqError( err );
 }
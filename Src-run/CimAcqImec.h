@@ -4,10 +4,17 @@
 #ifdef HAVE_IMEC
 
 #include "CimAcq.h"
+#include "ImUnpack.h"
 #include "IMEC/NeuropixAPI.h"
 
+#include <QAtomicInt>
 #include <QSet>
 
+class InstrCounter;
+class InstrGauge;
+class InstrHist;
+class InstrBins;
+
 class CimAcqImec;
 
 
@@ -17,24 +24,13 @@ class CimAcqImec;
 
 struct ImAcqShared {
     double                  startT;
-// Experiment to histogram successive timestamp differences.
-    std::vector<quint64>    tStampBins,
-                            tStampEvtByPrb;
     QMutex                  runMtx;
     QWaitCondition          condWake;
     int                     awake,
                             asleep;
     bool                    stop;
 
-    ImAcqShared();
-
-// Experiment to histogram successive timestamp differences.
-    virtual ~ImAcqShared();
-    void tStampHist(
-        const electrodePacket*  E,
-        int                     ip,
-        int                     ie,
-        int                     it );
+    ImAcqShared() : awake(0), asleep(0), stop(false)   {}
 
     bool wait()
     {
@@ -80,8 +76,8 @@ struct ImAcqProbe {
                     sumGet,
                     sumScl,
                     sumEnq;
+    mutable double  tLastGapReport;
     mutable quint64 totPts;
-// Experiment to detect gaps in timestamps across fetches.
     mutable quint32 errCOUNT,
                     errSERDES,
                     errLOCK,
@@ -90,7 +86,10 @@ struct ImAcqProbe {
                     tStampLastFetch;
     mutable int     fifoAve,
                     fifoN,
-                    sumN;
+                    fifoLast,
+                    sumN,
+                    gapsSince,
+                    dropSince;
     int             ip,
                     nAP,
                     nLF,
@@ -100,6 +99,18 @@ struct ImAcqProbe {
                     port,
                     fetchType;  // accommodate custom probe architectures
     mutable bool    zeroFill;
+    mutable std::vector<float>  lfLast; // prev LF for interpolation
+    InstrHist       *hFetch,
+                    *hScale,
+                    *hEnq;
+    InstrBins       *bTsDelta,
+                    *bFetchNE,
+                    *bFifo;
+    InstrGauge      *gFifo;
+    InstrCounter    *cPts,
+                    *cTsGap,
+                    *cTsDrop,
+                    *cTsBack;
 
     ImAcqProbe()    {}
     ImAcqProbe(
@@ -110,20 +121,79 @@ struct ImAcqProbe {
 
     void sendErrMetrics() const;
     void checkErrFlags( qint8 *E, int nE ) const;
+    void tStampStats( const qint8 *E, int nE ) const;
     bool checkFifo( size_t *packets, CimAcqImec *acq ) const;
 };
 
 
+// Probe-to-thread assignment.
+//
+// Probes start in contiguous blocks of prbPerThd per worker.
+// Workers report each probe's busy fraction (processing time /
+// wall time) and FIFO fill every 5 seconds. Periodically the
+// acquisition main thread re-plans with longest-first greedy
+// packing; a new layout is published only if some thread is
+// loaded or a FIFO is filling, and the busiest thread improves
+// by at least 10%.
+//
+// Handoff: between passes (holding no probe) each worker acks
+// the new generation, then waits for all to ack before taking
+// its new list, so a probe is never serviced by two threads.
+//
+// Settings (imacqsched.ini, group ImAcqSched):
+// - prbPerThd: initial probes per thread (default 3).
+// - rebalance: allow run-time moves (default true).
+// - pinCores:  pin worker k to core 1 + k % (nCores-1),
+//              using cores 0..63 at most (affinity mask width).
+//
+class ImAcqSched
+{
+private:
+    mutable QMutex                  mtx;
+    std::vector<std::vector<int> >  layout;     // [thd] -> probe ips
+    std::vector<double>             load;       // [ip] busy fraction
+    std::vector<int>                fifo;       // [ip] fill %
+    QAtomicInt                      gen;
+    double                          tLastPlan;
+    int                             nAck,
+                                    prbPerThd,
+                                    nCores;
+    bool                            rebalance,
+                                    pinCores;
+
+public:
+    ImAcqSched()
+    :   tLastPlan(0), nAck(0), prbPerThd(3), nCores(1),
+        rebalance(true), pinCores(false)    {}
+
+    void init( int np );
+    int nThreads() const    {return layout.size();}
+    int curGen() const      {return gen.load();}
+    int core( int iThd ) const;
+
+    void report( int ip, double busy, int fifoPct );
+    bool plan();
+    QString toString() const;
+
+    int ack();
+    bool allAcked( int g ) const;
+    int mine( std::vector<int> &v, int iThd ) const;
+
+private:
+    void loadSettings();
+};
+
+
 class ImAcqWorker : public QObject
 {
     Q_OBJECT
 
 private:
-    CimAcqImec              *acq;
-    QVector<AIQ*>           &imQ;
-    ImAcqShared             &shr;
-    std::vector<ImAcqProbe> probes;
-    std::vector<qint8>      E;
+    CimAcqImec                  *acq;
+    QVector<AIQ*>               &imQ;
+    ImAcqShared                 &shr;
+    std::vector<ImAcqProbe*>    probes;
+    std::vector<qint8>          E;
 // ---------
 // @@@ FIX Mod for no packets
 std::vector<qint16> _rawAP, _rawLF;
@@ -132,13 +202,15 @@ std::vector<qint16> _rawAP, _rawLF;
                         yieldSum,
                         loopT,
                         lastCheckT;
+    int                 iThd,
+                        gen;
 
 public:
     ImAcqWorker(
-        CimAcqImec              *acq,
-        QVector<AIQ*>           &imQ,
-        ImAcqShared             &shr,
-        std::vector<ImAcqProbe> &probes );
+        CimAcqImec      *acq,
+        QVector<AIQ*>   &imQ,
+        ImAcqShared     &shr,
+        int             iThd );
     virtual ~ImAcqWorker()  {}
 
 signals:
@@ -152,6 +224,7 @@ private:
         float               *lfLast,
         vec_i16             &dst1D,
         const ImAcqProbe    &P );
+    bool adoptLayout();
     bool workerYield();
     void profile( const ImAcqProbe &P );
 };
@@ -165,10 +238,10 @@ public:
 
 public:
     ImAcqThread(
-        CimAcqImec              *acq,
-        QVector<AIQ*>           &imQ,
-        ImAcqShared             &shr,
-        std::vector<ImAcqProbe> &probes );
+        CimAcqImec      *acq,
+        QVector<AIQ*>   &imQ,
+        ImAcqShared     &shr,
+        int             iThd );
     virtual ~ImAcqThread();
 };
 
@@ -183,11 +256,18 @@ class CimAcqImec : public CimAcq
 private:
     const CimCfg::ImProbeTable  &T;
     ImAcqShared                 shr;
+    ImAcqSched                  sched;
+    std::vector<ImAcqProbe>     vP;         // all probes, by ip
     std::vector<ImAcqThread*>   imT;
+    ImUnpackFn                  unpack;
     QSet<int>                   pausPortsReported;
+    QString                     warmKey;
+    double                      cfgSecs;
     int                         pausPortsRequired,
                                 pausSlot,
                                 nThd;
+    bool                        keepHW;     // runwarm.ini
+    volatile bool               hwOK;       // clean; may be kept
 
 public:
     CimAcqImec( IMReaderWorker *owner, const DAQ::Params &p );
@@ -215,22 +295,13 @@ private:
     void SETVAL( int val );
     void SETVALBLOCKING( int val );
 
+    QString hwKey() const;
     bool _allProbesSizeStreamBufs();
     bool _open( const CimCfg::ImProbeTable &T );
     bool _setSyncAsOutput( int slot );
     bool _setSyncAsInput( int slot );
     bool _setSync( const CimCfg::ImProbeTable &T );
-    bool _openProbe( const CimCfg::ImProbeDat &P );
-    bool _calibrateADC( const CimCfg::ImProbeDat &P );
-    bool _calibrateGain( const CimCfg::ImProbeDat &P );
-    bool _dataGenerator( const CimCfg::ImProbeDat &P );
-    bool _setLEDs( const CimCfg::ImProbeDat &P );
-    bool _selectElectrodes( const CimCfg::ImProbeDat &P );
-    bool _setReferences( const CimCfg::ImProbeDat &P );
-    bool _setGains( const CimCfg::ImProbeDat &P );
-    bool _setHighPassFilter( const CimCfg::ImProbeDat &P );
-    bool _setStandby( const CimCfg::ImProbeDat &P );
-    bool _writeProbe( const CimCfg::ImProbeDat &P );
+    bool _configProbes();
 
     bool _setTrigger();
     bool _setArm();
@@ -239,6 +310,7 @@ private:
 
     bool configure();
     bool startAcq();
+    void postLayout();
     void runError( QString err );
 };
 
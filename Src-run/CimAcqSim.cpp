@@ -3,6 +3,9 @@
 #include "Util.h"
 #include "MainApp.h"
 #include "ConfigCtl.h"
+#include "Instr.h"
+#include "ImAPI.h"
+#include "ImProbeCfg.h"
 
 #include <QThread>
 
@@ -72,6 +75,13 @@ ImSimProbe::ImSimProbe(
 
     for( int c = 0; c < nNeu; ++c )
         gain[c] = E.chanGain( c );
+
+// Instrumentation
+
+    QString pfx = QString("imec%1.").arg( ip );
+    hFetch  = Instr::hist( pfx + "fetch" );
+    hEnq    = Instr::hist( pfx + "enqueue" );
+    cPts    = Instr::counter( pfx + "samples" );
 }
 
 /* ---------------------------------------------------------------- */
@@ -87,12 +97,15 @@ void ImSimWorker::run()
 
     std::vector<std::vector<qint16> >   i16Buf;
 
-    const int   nID = probes.size();
+    const int       nID = probes.size();
+    InstrThreadCPU  cpu( QString("imAcq%1").arg( probes[0].ip ) );
 
     i16Buf.resize( nID );
 
-    for( int iID = 0; iID < nID; ++iID )
+    for( int iID = 0; iID < nID; ++iID ) {
         i16Buf[iID].resize( MAXS * probes[iID].nCH );
+        imQ[probes[iID].ip]->prefault();
+    }
 
     if( !shr.wait() )
         goto exit;
@@ -107,6 +120,8 @@ void ImSimWorker::run()
 
         loopT = getTime();
 
+        cpu.sample();
+
         // ------------
         // Do my probes
         // ------------
@@ -174,6 +189,8 @@ bool ImSimWorker::doProbe( vec_i16 &dst1D, ImSimProbe &P )
     double  prbT0 = getTime();
 #endif
 
+    double  tInstr = Instr::startT();
+
     qint16* dst = &dst1D[0];
     int     nS;
 
@@ -194,6 +211,8 @@ bool ImSimWorker::doProbe( vec_i16 &dst1D, ImSimProbe &P )
     P.sumGet += getTime() - prbT0;
 #endif
 
+    P.hFetch->addSince( tInstr );
+
 // -------
 // Enqueue
 // -------
@@ -204,9 +223,16 @@ bool ImSimWorker::doProbe( vec_i16 &dst1D, ImSimProbe &P )
 
     double  tLock, tWork;
 
+    tInstr = Instr::startT();
+
     imQ[P.ip]->enqueueProfile( tLock, tWork, dst, nS );
     P.totPts += nS;
 
+    if( tInstr ) {
+        P.hEnq->addSince( tInstr );
+        P.cPts->add( nS );
+    }
+
 #ifdef PROFILE
     P.sumEnq += getTime() - dtEnq;
     P.sumLok += tLock;
@@ -330,6 +356,23 @@ void CimAcqSim::run()
 // Configure
 // ---------
 
+// Optionally time probe configuration against mock API
+
+    if( ImProbeCfg::mockSim() ) {
+
+        ImAPIMock   api;
+        ImProbeCfg  cfg( api, this, p, T );
+        QString     err;
+
+        if( !cfg.configure( err ) ) {
+
+            if( !err.isEmpty() )
+                runError( err );
+
+            return;
+        }
+    }
+
 // Create worker threads
 
 // MS: With a variable number of probes handled per thread here,
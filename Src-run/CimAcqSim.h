@@ -3,6 +3,9 @@
 
 #include "CimAcq.h"
 
+class InstrCounter;
+class InstrHist;
+
 class CimAcqSim;
 
 /* ---------------------------------------------------------------- */
@@ -69,6 +72,9 @@ struct ImSimProbe {
                         slot,
                         port,
                         sumN;
+    InstrHist           *hFetch,
+                        *hEnq;
+    InstrCounter        *cPts;
 
     ImSimProbe()        {}
     ImSimProbe(
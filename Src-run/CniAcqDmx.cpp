@@ -4,6 +4,7 @@
 #include "CniAcqDmx.h"
 #include "Util.h"
 #include "Subset.h"
+#include "Instr.h"
 
 #include <QThread>
 
@@ -245,6 +246,12 @@ void CniAcqDmx::run()
         * daqAIFetchPeriodMillis()
         * (kxd1+kxd2 ? 2 : 0.1);
 
+    InstrHist       *hFetch = Instr::hist( "nidq.fetch" ),
+                    *hDmx   = Instr::hist( "nidq.demux" ),
+                    *hEnq   = Instr::hist( "nidq.enqueue" );
+    InstrCounter    *cPts   = Instr::counter( "nidq.samples" );
+    InstrThreadCPU  cpu( "niAcq" );
+
     double  peak_loopT  = 0;
     int32   nFetched;
     int     peak_nWhole = 0,
@@ -257,6 +264,8 @@ void CniAcqDmx::run()
 
         double  loopT = getTime();
 
+        cpu.sample();
+
         nWhole = 0;
 
         // Slide partial timepoint forward.
@@ -277,9 +286,13 @@ void CniAcqDmx::run()
         // Fetch
         // -----
 
+        double  tInstr = Instr::startT();
+
         if( !fetch( nFetched, rem ) )
             goto Error_Out;
 
+        hFetch->addSince( tInstr );
+
 // Experiment to report fetched sample count vs time.
 #if 0
 {
@@ -350,8 +363,12 @@ void CniAcqDmx::run()
             // Demux and merge
             // ---------------
 
+            tInstr = Instr::startT();
+
             demuxMerge( nWhole );
 
+            hDmx->addSince( tInstr );
+
             // -------
             // Publish
             // -------
@@ -359,8 +376,15 @@ void CniAcqDmx::run()
             if( !totPts )
                 owner->niQ->setTZero( loopT );
 
+            tInstr = Instr::startT();
+
             owner->niQ->enqueue( &merged[0], nWhole );
             totPts += nWhole;
+
+            if( tInstr ) {
+                hEnq->addSince( tInstr );
+                cPts->add( nWhole );
+            }
         }
 
         // ------------------
@@ -852,6 +876,26 @@ bool CniAcqDmx::configure()
         kxd2 = p.ni.xdBytes2;
     }
 
+// ----------
+// Demux plan
+// ----------
+
+    {
+        NIDemuxLayout   L;
+
+        L.kmux = kmux;
+        L.kmn1 = kmn1;
+        L.kma1 = kma1;
+        L.kxa1 = kxa1;
+        L.kxd1 = kxd1;
+        L.kmn2 = kmn2;
+        L.kma2 = kma2;
+        L.kxa2 = kxa2;
+        L.kxd2 = kxd2;
+
+        dmx.init( L );
+    }
+
 // In the case of multifunction IO devices, to route a clock source
 // to di/SampleClock without involving a trigger line on a chassis
 // backplane, we use ai/SampleClock. That means that to do digital
@@ -1137,280 +1181,17 @@ Error_Out:
 // - Average oversampled xa chans.
 // - Downsample oversampled xd and pack bytes into low-order bits.
 //
+// The plan (dmx) is built once in configure().
+//
 void CniAcqDmx::demuxMerge( int nwhole )
 {
-    qint16          *dst    = &merged[0];
-    const qint16    *sA1    = (rawAI1.size() ? &rawAI1[0] : 0),
-                    *sA2    = (rawAI2.size() ? &rawAI2[0] : 0);
-    const uInt32    *sD1    = (kxd1 ? &rawDI1[0] : 0),
-                    *sD2    = (kxd2 ? &rawDI2[0] : 0);
-
-// ----------
-// Not muxing
-// ----------
-
-    if( kmux == 1 ) {
-
-        for( int w = 0; w < nwhole; ++w ) {
-
-            // Copy XA
-
-            if( kxa1 ) {
-                memcpy( dst, sA1, kxa1*sizeof(qint16) );
-                dst += kxa1;
-                sA1 += kxa1;
-            }
-
-            if( kxa2 ) {
-                memcpy( dst, sA2, kxa2*sizeof(qint16) );
-                dst += kxa2;
-                sA2 += kxa2;
-            }
-
-            // Copy XD
-
-            if( kxd1 + kxd2 == 0 )
-                continue;
-
-            quint16 W = 0;
-            bool    F = 0;   // filling F: {0=empty,1=lsb,2=full}
-
-            if( kxd1 == 4 ) {
-                *dst++ = *sD1;
-                *dst++ = *sD1 >> 16;
-                ++sD1;
-            }
-            if( kxd1 == 3 ) {
-                *dst++ = *sD1;
-                W = (*sD1 >> 16) & 0xFF;
-                F = 1;
-                ++sD1;
-            }
-            else if( kxd1 == 2 ) {
-                *dst++ = *sD1++;
-            }
-            else if( kxd1 == 1 ) {
-                W = *sD1++ & 0xFF;
-                F = 1;
-            }
-
-            if( kxd2 == 0 ) {
-
-                if( F > 0 )
-                    *dst++ = W;
-            }
-            else if( kxd2 == 1 ) {
-
-                if( F == 0 )
-                    *dst++ = *sD2++ & 0xFF;
-                else
-                    *dst++ = W + (*sD2++ << 8);
-            }
-            else if( kxd2 == 2 ) {
-
-                if( F == 0 )
-                    *dst++ = *sD2++;
-                else {
-                    *dst++ = W + (*sD2 << 8);
-                    *dst++ = (*sD2 >> 8) & 0xFF;
-                    ++sD2;
-                }
-            }
-            else if( kxd2 == 3 ) {
-
-                if( F == 0 ) {
-                    *dst++ = *sD2;
-                    *dst++ = (*sD2 >> 16) & 0xFF;
-                    ++sD2;
-                }
-                else {
-                    *dst++ = W + (*sD2 << 8);
-                    *dst++ = *sD2 >> 8;
-                    ++sD2;
-                }
-            }
-            else if( kxd2 == 4 ) {
-
-                if( F == 0 ) {
-                    *dst++ = *sD2;
-                    *dst++ = *sD2 >> 16;
-                    ++sD2;
-                }
-                else {
-                    *dst++ = W + (*sD2 << 8);
-                    *dst++ = *sD2 >> 8;
-                    *dst++ = *sD2 >> 24;
-                    ++sD2;
-                }
-            }
-        }
-
-        return;
-    }
-
-// ------
-// Muxing
-// ------
-
-// In each timepoint the muxed channels form a matrix. As acquired,
-// each column is a muxer (so, ncol = kmn1 + kmn2 + kma1 + kma2).
-// There are kmux rows. We will transpose this matrix so that all
-// the samples from a given muxer are together. In each timepoint
-// the xa values are oversampled by kmux, so we will average them.
-
-    int     ncol    = kmn1 + kmn2 + kma1 + kma2,
-            nrow    = kmux,
-            ntmp    = nrow * ncol;
-    vec_i16 vtmp( ntmp );
-
-    for( int w = 0; w < nwhole; ++w ) {
-
-        std::vector<long>   sumxa1( kxa1, 0 ),
-                            sumxa2( kxa2, 0 );
-        qint16              *tmp = &vtmp[0];
-
-        for( int s = 0; s < kmux; ++s ) {
-
-            // Fill MN, MA matrix
-
-            if( kmn1 ) {
-                memcpy( tmp, sA1, kmn1*sizeof(qint16) );
-                tmp += kmn1;
-                sA1 += kmn1;
-            }
-
-            if( kmn2 ) {
-                memcpy( tmp, sA2, kmn2*sizeof(qint16) );
-                tmp += kmn2;
-                sA2 += kmn2;
-            }
-
-            if( kma1 ) {
-                memcpy( tmp, sA1, kma1*sizeof(qint16) );
-                tmp += kma1;
-                sA1 += kma1;
-            }
-
-            if( kma2 ) {
-                memcpy( tmp, sA2, kma2*sizeof(qint16) );
-                tmp += kma2;
-                sA2 += kma2;
-            }
-
-            // Sum XA
-
-            for( int x = 0; x < kxa1; ++x )
-                sumxa1[x] += *sA1++;
-
-            for( int x = 0; x < kxa2; ++x )
-                sumxa2[x] += *sA2++;
-        }
-
-        // Transpose and store MN, MA:
-        // Original element address is [ncol*Y + X].
-        // Swap roles X <-> Y and row <-> col.
-
-        for( int iacq = 0; iacq < ntmp; ++iacq ) {
-
-            int Y = iacq / ncol,
-                X = iacq - ncol * Y;
-
-            dst[nrow*X + Y] = vtmp[iacq];
-        }
-
-        dst += ntmp;
-
-        // Copy XA averages
-
-        for( int x = 0; x < kxa1; ++x )
-            *dst++ = sumxa1[x] / kmux;
-
-        for( int x = 0; x < kxa2; ++x )
-            *dst++ = sumxa2[x] / kmux;
-
-        // Copy XD
-
-        if( kxd1 + kxd2 == 0 )
-            continue;
-
-        quint16 W = 0;
-        bool    F = 0;   // filling F: {0=empty,1=lsb,2=full}
-
-        if( kxd1 == 4 ) {
-            *dst++ = *sD1;
-            *dst++ = *sD1 >> 16;
-            ++sD1;
-        }
-        if( kxd1 == 3 ) {
-            *dst++ = *sD1;
-            W = (*sD1 >> 16) & 0xFF;
-            F = 1;
-            ++sD1;
-        }
-        else if( kxd1 == 2 ) {
-            *dst++ = *sD1++;
-        }
-        else if( kxd1 == 1 ) {
-            W = *sD1++ & 0xFF;
-            F = 1;
-        }
-
-        if( kxd2 == 0 ) {
-
-            if( F > 0 )
-                *dst++ = W;
-        }
-        else if( kxd2 == 1 ) {
-
-            if( F == 0 )
-                *dst++ = *sD2++ & 0xFF;
-            else
-                *dst++ = W + (*sD2++ << 8);
-        }
-        else if( kxd2 == 2 ) {
-
-            if( F == 0 )
-                *dst++ = *sD2++;
-            else {
-                *dst++ = W + (*sD2 << 8);
-                *dst++ = (*sD2 >> 8) & 0xFF;
-                ++sD2;
-            }
-        }
-        else if( kxd2 == 3 ) {
-
-            if( F == 0 ) {
-                *dst++ = *sD2;
-                *dst++ = (*sD2 >> 16) & 0xFF;
-                ++sD2;
-            }
-            else {
-                *dst++ = W + (*sD2 << 8);
-                *dst++ = *sD2 >> 8;
-                ++sD2;
-            }
-        }
-        else if( kxd2 == 4 ) {
-
-            if( F == 0 ) {
-                *dst++ = *sD2;
-                *dst++ = *sD2 >> 16;
-                ++sD2;
-            }
-            else {
-                *dst++ = W + (*sD2 << 8);
-                *dst++ = *sD2 >> 8;
-                *dst++ = *sD2 >> 24;
-                ++sD2;
-            }
-        }
-
-        if( kxd1 )
-            sD1 += (kmux - 1);
-
-        if( kxd2 )
-            sD2 += (kmux - 1);
-    }
+    dmx.apply(
+        &merged[0],
+        (rawAI1.size() ? &rawAI1[0] : 0),
+        (rawAI2.size() ? &rawAI2[0] : 0),
+        (kxd1 ? (const quint32*)&rawDI1[0] : 0),
+        (kxd2 ? (const quint32*)&rawDI2[0] : 0),
+        nwhole );
 }
 
 /* ---------------------------------------------------------------- */
@@ -4,6 +4,7 @@
 #ifdef HAVE_NIDAQmx
 
 #include "CniAcq.h"
+#include "NIDemux.h"
 #include "NI/NIDAQmx.h"
 
 /* ---------------------------------------------------------------- */
@@ -15,6 +16,7 @@
 class CniAcqDmx : public CniAcq
 {
 private:
+    NIDemux             dmx;
     vec_i16             merged,
                         rawAI1,     rawAI2;
     std::vector<uInt32> rawDI1,     rawDI2;
@@ -0,0 +1,130 @@
+
+#include "CniAcqFile.h"
+#include "Util.h"
+#include "Instr.h"
+#include "DataFileNI.h"
+#include "DFName.h"
+
+#include <QThread>
+
+
+#define LOOPSECS    0.01
+
+
+/* ---------------------------------------------------------------- */
+/* CniAcqFile::run() ---------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Alternately:
+// (1) Enqueue pts at speed * sample rate.
+// (2) Sleep balance of time, up to LOOPSECS.
+//
+// Looping: at EOF the feed rewinds when ReplayLoop says all
+// streams are done, so nidq stays aligned with imec.
+//
+void CniAcqFile::run()
+{
+// ---------
+// Configure
+// ---------
+
+    QString bin = DFRunTag( R.binFile ).filename( -1, "bin" ),
+            err;
+    int     nCH = p.ni.niCumTypCnt[CniCfg::niSumAll];
+
+    if( !feed.open( err, new DataFileNI, bin, nCH, R.speed ) ) {
+        runError( err );
+        return;
+    }
+
+    int loopId  = (R.loop ? ReplayLoop::join() : -1),
+        iLoop   = 0;
+
+    if( qAbs( feed.srate() - p.ni.srate ) > 0.01 * p.ni.srate ) {
+        Warning() <<
+            QString("Replay nidq: file rate %1 Hz, configured %2 Hz.")
+            .arg( feed.srate() ).arg( p.ni.srate );
+    }
+
+    vec_i16 tpl( nCH, 0 ),
+            buf;
+
+// -----
+// Start
+// -----
+
+    atomicSleepWhenReady();
+
+// -----
+// Fetch
+// -----
+
+    const quint64   maxPts = 10 * LOOPSECS * R.speed * p.ni.srate;
+
+    InstrThreadCPU  cpu( "niAcq" );
+    double          t0          = getTime();
+    bool            eofReported = false;
+
+    owner->niQ->setTZero( t0 );
+
+    while( !isStopped() ) {
+
+        double  t           = getTime();
+        quint64 targetCt    = (t + LOOPSECS - t0) * R.speed * p.ni.srate;
+
+        cpu.sample();
+
+        if( targetCt > totPts ) {
+
+            int nMax    = qMin( targetCt - totPts, maxPts ),
+                n       = 0;
+
+            buf.resize( nMax * nCH );
+
+            for( ; n < nMax; ++n ) {
+
+                const qint16    *src = feed.curScan();
+
+                if( !src )
+                    break;
+
+                feed.scatter( &tpl[0], src );
+                feed.advance();
+
+                memcpy( &buf[n * nCH], &tpl[0], nCH * sizeof(qint16) );
+            }
+
+            if( n ) {
+                owner->niQ->enqueue( &buf[0], n );
+                totPts += n;
+            }
+        }
+
+        if( feed.atEOF() ) {
+
+            if( !eofReported ) {
+                Log() << "Replay: end of nidq file.";
+                eofReported = true;
+            }
+
+            if( loopId >= 0 && ReplayLoop::arrive( loopId, iLoop ) ) {
+                feed.rewind();
+                ++iLoop;
+            }
+        }
+
+        double  dt = getTime() - t;
+
+        if( dt < LOOPSECS )
+            QThread::usleep( 1e6 * (LOOPSECS - dt) );
+    }
+}
+
+
+void CniAcqFile::runError( QString err )
+{
+    Error() << err;
+    emit owner->daqError( err );
+}
+
+
@@ -0,0 +1,34 @@
+#ifndef CNIACQFILE_H
+#define CNIACQFILE_H
+
+#include "CniAcq.h"
+#include "Replay.h"
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// NI-DAQ input replayed from recorded file
+//
+class CniAcqFile : public CniAcq
+{
+private:
+    ReplayParams    R;
+    ReplayFeed      feed;
+
+public:
+    CniAcqFile(
+        NIReaderWorker      *owner,
+        const DAQ::Params   &p,
+        const ReplayParams  &R )
+    :   CniAcq( owner, p ), R(R)    {}
+
+    virtual void run();
+
+private:
+    void runError( QString err );
+};
+
+#endif  // CNIACQFILE_H
+
+
@@ -1,6 +1,7 @@
 
 #include "CniAcqSim.h"
 #include "Util.h"
+#include "Instr.h"
 
 #include <QThread>
 
@@ -119,7 +120,8 @@ void CniAcqSim::run()
     const double    loopSecs    = 0.02;
     const quint64   maxPts      = 10 * loopSecs * p.ni.srate;
 
-    double  t0 = getTime();
+    InstrThreadCPU  cpu( "niAcq" );
+    double          t0 = getTime();
 
     owner->niQ->setTZero( t0 );
 
@@ -130,6 +132,8 @@ void CniAcqSim::run()
                 tElapse     = t + loopSecs - t0;
         quint64 targetCt    = tElapse * p.ni.srate;
 
+        cpu.sample();
+
         // Make some more pts?
 
         if( targetCt > totPts ) {
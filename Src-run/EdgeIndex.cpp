@@ -0,0 +1,423 @@
+
+#include "EdgeIndex.h"
+#include "Util.h"
+#include "AIQ.h"
+
+#include <QThread>
+
+#include <algorithm>
+
+
+#define PERIOD_SECS 0.02
+#define MAXSCANS    32768
+
+
+static bool riseLT( const EdgeRec &E, quint64 ct )
+{
+    return E.riseCt < ct;
+}
+
+
+/* ---------------------------------------------------------------- */
+/* Watch ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+bool EdgeIdxWorker::Watch::isSame(
+    const AIQ   *Q,
+    int         chan,
+    int         bit,
+    int         thresh,
+    int         inarow ) const
+{
+    return  this->Q == Q
+            && this->chan == chan
+            && this->bit == bit
+            && (bit >= 0 || this->thresh == thresh)
+            && this->inarow == qMax( 1, inarow );
+}
+
+
+// Forget level history; next sample establishes state.
+//
+void EdgeIdxWorker::Watch::restart( quint64 fromCt )
+{
+    nextCt  = fromCt;
+    nok     = 0;
+    primed  = false;
+}
+
+
+// Drop edges that have fallen off the left end of the stream.
+//
+void EdgeIdxWorker::Watch::trim( quint64 headCt )
+{
+    while( !edges.empty() ) {
+
+        const EdgeRec   &E = edges.front();
+
+        if( E.fallCt && E.fallCt < headCt )
+            edges.pop_front();
+        else
+            break;
+    }
+}
+
+
+// Advance level state machine over n samples starting at nextCt.
+// New edges collect in newE; a fall that ends the last published
+// edge is held in newFall. Both await publish().
+//
+void EdgeIdxWorker::Watch::scan( const qint16 *src, int n )
+{
+    for( int i = 0; i < n; ++i ) {
+
+        bool    hi = isHigh( src[i] );
+
+        if( !primed ) {
+            isHi    = hi;
+            primed  = true;
+        }
+        else if( hi == isHi )
+            nok = 0;
+        else {
+
+            if( !nok++ )
+                candCt = nextCt + i;
+
+            if( nok >= inarow ) {
+
+                if( hi )
+                    newE.push_back( EdgeRec( candCt ) );
+                else if( !newE.empty() ) {
+                    if( !newE.back().fallCt )
+                        newE.back().fallCt = candCt;
+                }
+                else if( !newFall )
+                    newFall = candCt;
+
+                isHi    = hi;
+                nok     = 0;
+            }
+        }
+    }
+
+    nextCt += n;
+}
+
+
+// Move scan results into edges; caller holds wMtx.
+//
+void EdgeIdxWorker::Watch::publish( quint64 headCt )
+{
+    if( newFall && !edges.empty() && !edges.back().fallCt )
+        edges.back().fallCt = newFall;
+
+    edges.insert( edges.end(), newE.begin(), newE.end() );
+
+    newE.clear();
+    newFall = 0;
+    pubCt   = (nok ? candCt : nextCt);
+
+    trim( headCt );
+}
+
+
+// Index of first edge rising at or after ct.
+//
+int EdgeIdxWorker::Watch::iRise( quint64 ct ) const
+{
+    return std::lower_bound(
+            edges.begin(), edges.end(), ct, riseLT ) - edges.begin();
+}
+
+
+// Count from which a subsequent search would resume,
+// reported to caller as last count examined (like AIQ).
+//
+quint64 EdgeIdxWorker::Watch::resumeCt( quint64 fromCt ) const
+{
+    return qMax( fromCt, (pubCt ? pubCt - 1 : 0) );
+}
+
+/* ---------------------------------------------------------------- */
+/* EdgeIdxWorker -------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+EdgeIdxWorker::~EdgeIdxWorker()
+{
+    for( int iw = 0, nw = vW.size(); iw < nw; ++iw ) {
+
+        if( vW[iw] )
+            delete vW[iw];
+    }
+}
+
+
+void EdgeIdxWorker::run()
+{
+    Debug() << "Edge indexing started.";
+
+    const int   loopPeriod_us = 1e6 * PERIOD_SECS;
+
+    while( !isStopped() ) {
+
+        double  loopT = getTime();
+
+        scanAll();
+
+        loopT = 1e6*(getTime() - loopT);    // microsec
+
+        if( loopT < loopPeriod_us )
+            QThread::usleep( loopPeriod_us - loopT );
+        else
+            QThread::usleep( 1000 * 2 );
+    }
+
+    Debug() << "Edge indexing stopped.";
+
+    emit finished();
+}
+
+
+// Each watch advances from its nextCt to the stream's endCt.
+// If a watch lags off the left end of the ring, it restarts
+// at the head; edges before the head are forgotten.
+//
+// Watches added meanwhile join the next pass; unwatch() waits
+// on scanMtx, so none is deleted under us.
+//
+void EdgeIdxWorker::scanAll()
+{
+    QMutexLocker        ms( &scanMtx );
+    std::vector<Watch*> vS;
+
+    wMtx.lock();
+    vS = vW;
+    wMtx.unlock();
+
+    for( int iw = 0, nw = vS.size(); iw < nw; ++iw ) {
+
+        Watch   *W = vS[iw];
+
+        if( !W )
+            continue;
+
+        quint64 headCt = W->Q->qHeadCt();
+
+        if( W->nextCt < headCt )
+            W->restart( headCt );
+
+        for(;;) {
+
+            quint64 endCt = W->Q->endCount();
+
+            if( W->nextCt >= endCt )
+                break;
+
+            int nScans = qMin( endCt - W->nextCt, quint64(MAXSCANS) );
+
+            if( int(buf.size()) < nScans )
+                buf.resize( nScans );
+
+            if( W->Q->getNScansFromCtMono(
+                    &buf[0], W->nextCt, nScans, W->chan ) < 0 ) {
+
+                W->restart( W->Q->qHeadCt() );
+                break;
+            }
+
+            W->scan( &buf[0], nScans );
+
+            QMutexLocker    ml( &wMtx );
+            W->publish( headCt );
+        }
+
+        QMutexLocker    ml( &wMtx );
+        W->publish( headCt );
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* EdgeIndex ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+EdgeIndex::EdgeIndex()
+{
+    thread  = new QThread;
+    worker  = new EdgeIdxWorker;
+
+    worker->moveToThread( thread );
+
+    Connect( thread, SIGNAL(started()), worker, SLOT(run()) );
+    Connect( worker, SIGNAL(finished()), worker, SLOT(deleteLater()) );
+    Connect( worker, SIGNAL(destroyed()), thread, SLOT(quit()), Qt::DirectConnection );
+
+    thread->start();
+}
+
+
+EdgeIndex::~EdgeIndex()
+{
+// worker object auto-deleted asynchronously
+// thread object manually deleted synchronously (so we can call wait())
+
+    if( thread->isRunning() ) {
+
+        worker->stop();
+        thread->wait();
+    }
+
+    delete thread;
+}
+
+
+// Register interest in edges of (Q, chan) where:
+// - bit = -1: analog channel, level high if value >= thresh,
+// - bit >= 0: digital word, level given by that bit.
+//
+// Identical requests share one watch.
+// Indexing begins at the current ring head.
+//
+// Return watch id for queries and unwatch().
+//
+int EdgeIndex::watch(
+    const AIQ   *Q,
+    int         chan,
+    int         bit,
+    int         thresh,
+    int         inarow )
+{
+    QMutexLocker    ml( &worker->wMtx );
+
+    std::vector<EdgeIdxWorker::Watch*>  &vW = worker->vW;
+
+    int nw = vW.size(), iFree = -1;
+
+    for( int iw = 0; iw < nw; ++iw ) {
+
+        EdgeIdxWorker::Watch    *W = vW[iw];
+
+        if( !W ) {
+            if( iFree < 0 )
+                iFree = iw;
+        }
+        else if( W->isSame( Q, chan, bit, thresh, inarow ) ) {
+            ++W->nUsers;
+            return iw;
+        }
+    }
+
+    EdgeIdxWorker::Watch    *W =
+        new EdgeIdxWorker::Watch( Q, chan, bit, thresh, inarow );
+
+    W->restart( Q->qHeadCt() );
+    W->pubCt = W->nextCt;
+
+    if( iFree >= 0 ) {
+        vW[iFree] = W;
+        return iFree;
+    }
+
+    vW.push_back( W );
+    return nw;
+}
+
+
+void EdgeIndex::unwatch( int iw )
+{
+    QMutexLocker    ms( &worker->scanMtx );
+    QMutexLocker    ml( &worker->wMtx );
+
+    std::vector<EdgeIdxWorker::Watch*>  &vW = worker->vW;
+
+    if( iw < 0 || iw >= int(vW.size()) || !vW[iw] )
+        return;
+
+    if( !--vW[iw]->nUsers ) {
+        delete vW[iw];
+        vW[iw] = 0;
+    }
+}
+
+
+// Find first rising edge at or after fromCt.
+//
+// If found, outCt = edge count; return true.
+// Else outCt = last count known not to begin an edge
+// (resume searching from there); return false.
+//
+bool EdgeIndex::nextRise( quint64 &outCt, int iw, quint64 fromCt ) const
+{
+    QMutexLocker    ml( &worker->wMtx );
+
+    const EdgeIdxWorker::Watch  *W = worker->vW[iw];
+
+    int ie = W->iRise( fromCt );
+
+    if( ie < int(W->edges.size()) ) {
+        outCt = W->edges[ie].riseCt;
+        return true;
+    }
+
+    outCt = W->resumeCt( fromCt );
+    return false;
+}
+
+
+// Find first falling edge at or after fromCt.
+//
+// Semantics as for nextRise().
+//
+// Spans do not overlap, so only the span rising just before
+// fromCt, or a later one, can fall at or after fromCt.
+//
+bool EdgeIndex::nextFall( quint64 &outCt, int iw, quint64 fromCt ) const
+{
+    QMutexLocker    ml( &worker->wMtx );
+
+    const EdgeIdxWorker::Watch  *W = worker->vW[iw];
+
+    for( int ie = qMax( 0, W->iRise( fromCt ) - 1 ),
+            ne = W->edges.size(); ie < ne; ++ie ) {
+
+        const EdgeRec   &E = W->edges[ie];
+
+        if( E.fallCt && E.fallCt >= fromCt ) {
+            outCt = E.fallCt;
+            return true;
+        }
+    }
+
+    outCt = W->resumeCt( fromCt );
+    return false;
+}
+
+
+// Return all high spans that overlap [fromCt, toCt).
+//
+void EdgeIndex::getEdges(
+    std::vector<EdgeRec>    &vE,
+    int                     iw,
+    quint64                 fromCt,
+    quint64                 toCt ) const
+{
+    vE.clear();
+
+    QMutexLocker    ml( &worker->wMtx );
+
+    const EdgeIdxWorker::Watch  *W = worker->vW[iw];
+
+    for( int ie = qMax( 0, W->iRise( fromCt ) - 1 ),
+            ne = W->edges.size(); ie < ne; ++ie ) {
+
+        const EdgeRec   &E = W->edges[ie];
+
+        if( E.riseCt >= toCt )
+            break;
+
+        if( !E.fallCt || E.fallCt >= fromCt )
+            vE.push_back( E );
+    }
+}
+
+
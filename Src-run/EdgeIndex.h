@@ -0,0 +1,159 @@
+#ifndef EDGEINDEX_H
+#define EDGEINDEX_H
+
+#include "SGLTypes.h"
+
+#include <QObject>
+#include <QMutex>
+
+#include <deque>
+
+class AIQ;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// One rising edge and the falling edge that ends it.
+// fallCt is zero while the signal is still high.
+//
+struct EdgeRec {
+    quint64 riseCt,
+            fallCt;
+
+    EdgeRec() : riseCt(0), fallCt(0)                {}
+    EdgeRec( quint64 riseCt ) : riseCt(riseCt), fallCt(0)  {}
+};
+
+
+// Background edge detection for AIQ streams.
+//
+// A client registers a watch: {stream, chan, bit or threshold, inarow}.
+// Identical watches are shared. The worker scans each (stream, chan)
+// once as data arrive, so that triggers and ColorTTL events can query
+// edges by count range instead of rescanning the rings themselves.
+//
+// Edge definition matches AIQ::findRisingEdge et al:
+// - rising:  from below to >= T (or bit 0 -> 1),
+// - falling: from above to <  T (or bit 1 -> 0),
+// and including first crossing, the new level must persist
+// for at least inarow counts.
+//
+// The worker reads and scans stream data holding only scanMtx;
+// wMtx is taken just to publish new edges, so queries are not
+// held up by ring copies. Edges are ordered by count, so queries
+// binary search them.
+//
+class EdgeIdxWorker : public QObject
+{
+    Q_OBJECT
+
+    friend class EdgeIndex;
+
+private:
+    struct Watch {
+        // const ----------------------
+        const AIQ           *Q;
+        int                 chan,
+                            bit,    // -1=analog
+                            thresh,
+                            inarow;
+        // published (wMtx) -----------
+        std::deque<EdgeRec> edges;
+        quint64             pubCt;
+        int                 nUsers;
+        // scanner (scanMtx) ----------
+        std::vector<EdgeRec>    newE;
+        quint64                 newFall,
+                                nextCt,
+                                candCt;
+        int                     nok;
+        bool                    primed,
+                                isHi;
+
+        Watch(
+            const AIQ   *Q,
+            int         chan,
+            int         bit,
+            int         thresh,
+            int         inarow )
+        :   Q(Q), chan(chan), bit(bit), thresh(thresh),
+            inarow(qMax( 1, inarow )), pubCt(0), nUsers(1),
+            newFall(0), nextCt(0), candCt(0), nok(0),
+            primed(false), isHi(false)  {}
+
+        bool isSame(
+            const AIQ   *Q,
+            int         chan,
+            int         bit,
+            int         thresh,
+            int         inarow ) const;
+
+        bool isHigh( qint16 v ) const
+            {return (bit < 0 ? v >= thresh : (v >> bit) & 1);}
+
+        void restart( quint64 fromCt );
+        void trim( quint64 headCt );
+        void scan( const qint16 *src, int n );
+        void publish( quint64 headCt );
+        int iRise( quint64 ct ) const;
+        quint64 resumeCt( quint64 fromCt ) const;
+    };
+
+private:
+    std::vector<Watch*> vW;
+    vec_i16             buf;
+    mutable QMutex      wMtx,
+                        scanMtx,
+                        runMtx;
+    volatile bool       pleaseStop;
+
+public:
+    EdgeIdxWorker() : QObject(0), pleaseStop(false)    {}
+    virtual ~EdgeIdxWorker();
+
+    void stop()             {QMutexLocker ml( &runMtx ); pleaseStop = true;}
+    bool isStopped() const  {QMutexLocker ml( &runMtx ); return pleaseStop;}
+
+signals:
+    void finished();
+
+public slots:
+    void run();
+
+private:
+    void scanAll();
+};
+
+
+class EdgeIndex
+{
+private:
+    QThread         *thread;
+    EdgeIdxWorker   *worker;
+
+public:
+    EdgeIndex();
+    virtual ~EdgeIndex();
+
+    int watch(
+        const AIQ   *Q,
+        int         chan,
+        int         bit,
+        int         thresh,
+        int         inarow );
+    void unwatch( int iw );
+
+    bool nextRise( quint64 &outCt, int iw, quint64 fromCt ) const;
+    bool nextFall( quint64 &outCt, int iw, quint64 fromCt ) const;
+
+    void getEdges(
+        std::vector<EdgeRec>    &vE,
+        int                     iw,
+        quint64                 fromCt,
+        quint64                 toCt ) const;
+};
+
+#endif  // EDGEINDEX_H
+
+
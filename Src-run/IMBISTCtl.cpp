@@ -4,6 +4,7 @@
 #include "ui_IMBISTDlg.h"
 
 #include "IMBISTCtl.h"
+#include "CimCfg.h"
 #include "HelpButDialog.h"
 #include "Util.h"
 #include "MainApp.h"
@@ -143,6 +144,8 @@ bool IMBISTCtl::_openSlot()
 {
     int slot = bistUI->slotSB->value();
 
+    CimCfg::warmRelease();
+
     if( openSlots.end() == find( openSlots.begin(), openSlots.end(), slot ) )
         openSlots.push_back( slot );
 
@@ -6,6 +6,7 @@
 #include "IMEC/NeuropixAPI.h"
 
 #include "IMFirmCtl.h"
+#include "CimCfg.h"
 #include "HelpButDialog.h"
 #include "Util.h"
 
@@ -83,6 +84,8 @@ void IMFirmCtl::detect()
 // Connect
 // -------
 
+    CimCfg::warmRelease();
+
     NP_ErrorCode    err = openBS( slot );
 
     if( err != SUCCESS ) {
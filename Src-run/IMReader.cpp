@@ -3,6 +3,7 @@
 #include "Util.h"
 #include "CimAcqImec.h"
 #include "CimAcqSim.h"
+#include "CimAcqFile.h"
 
 #include <QThread>
 
@@ -14,6 +15,14 @@
 IMReaderWorker::IMReaderWorker( const DAQ::Params &p, QVector<AIQ*> &imQ )
     :   QObject(0), imQ(imQ)
 {
+    ReplayParams    R;
+    R.loadSettings();
+
+    if( R.isEnabled() ) {
+        imAcq = new CimAcqFile( this, p, R );
+        return;
+    }
+
 #ifdef HAVE_IMEC
     imAcq = new CimAcqImec( this, p );
 #else
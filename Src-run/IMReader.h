@@ -18,6 +18,7 @@ class IMReaderWorker : public QObject
 
     friend class CimAcqImec;
     friend class CimAcqSim;
+    friend class CimAcqFile;
 
 private:
     CimAcq          *imAcq;
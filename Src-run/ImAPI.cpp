@@ -0,0 +1,159 @@
+
+#include "ImAPI.h"
+#include "Util.h"
+
+#ifdef HAVE_IMEC
+#include "IMEC/NeuropixAPI.h"
+#endif
+
+#include <QSettings>
+#include <QThread>
+
+
+/* ---------------------------------------------------------------- */
+/* ImAPIHW -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef HAVE_IMEC
+
+QString ImAPIHW::errMsg( int err ) const
+{
+    return np_GetErrorMessage( NP_ErrorCode(err) );
+}
+
+
+int ImAPIHW::openProbe( int slot, int port )
+{
+    return ::openProbe( slot, port );
+}
+
+
+int ImAPIHW::init( int slot, int port )
+{
+    return ::init( slot, port );
+}
+
+
+int ImAPIHW::setADCCalibration(
+    int             slot,
+    int             port,
+    const QString   &path )
+{
+    return ::setADCCalibration( slot, port, STR2CHR( path ) );
+}
+
+
+int ImAPIHW::setGainCalibration(
+    int             slot,
+    int             port,
+    const QString   &path )
+{
+    return ::setGainCalibration( slot, port, STR2CHR( path ) );
+}
+
+
+int ImAPIHW::setHSLed( int slot, int port, bool enable )
+{
+    return ::setHSLed( slot, port, enable );
+}
+
+
+int ImAPIHW::selectElectrode( int slot, int port, int ic, int bank )
+{
+    return ::selectElectrode( slot, port, ic, bank );
+}
+
+
+int ImAPIHW::setReference( int slot, int port, int ic, int ref, int bank )
+{
+    return ::setReference( slot, port, ic, channelreference_t(ref), bank );
+}
+
+
+int ImAPIHW::setGain( int slot, int port, int ic, int apIdx, int lfIdx )
+{
+    return ::setGain( slot, port, ic, apIdx, lfIdx );
+}
+
+
+int ImAPIHW::setAPCornerFrequency(
+    int     slot,
+    int     port,
+    int     ic,
+    bool    disableHP )
+{
+    return ::setAPCornerFrequency( slot, port, ic, disableHP );
+}
+
+
+int ImAPIHW::setStdb( int slot, int port, int ic, bool standby )
+{
+    return ::setStdb( slot, port, ic, standby );
+}
+
+
+int ImAPIHW::writeProbeConfiguration( int slot, int port, bool readCheck )
+{
+    return ::writeProbeConfiguration( slot, port, readCheck );
+}
+
+#endif  // HAVE_IMEC
+
+/* ---------------------------------------------------------------- */
+/* ImAPIMock ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+ImAPIMock::ImAPIMock()
+{
+    STDSETTINGS( settings, "improbecfg" );
+    settings.beginGroup( "ImAPIMock" );
+
+    msOpen      = settings.value( "open", 500.0 ).toDouble();
+    msInit      = settings.value( "init", 200.0 ).toDouble();
+    msCal       = settings.value( "cal", 1500.0 ).toDouble();
+    msLED       = settings.value( "led", 5.0 ).toDouble();
+    msChan      = settings.value( "chan", 0.05 ).toDouble();
+    msWrite     = settings.value( "write", 300.0 ).toDouble();
+    slotLock    = settings.value( "slotLock", false ).toBool();
+}
+
+
+ImAPIMock::~ImAPIMock()
+{
+    qDeleteAll( slotMtx );
+}
+
+
+QString ImAPIMock::errMsg( int err ) const
+{
+    return QString("mock error %1").arg( err );
+}
+
+
+int ImAPIMock::call( int slot, double ms )
+{
+    QMutex  *m = 0;
+
+    if( slotLock ) {
+
+        QMutexLocker    ml( &mapMtx );
+
+        QMutex* &M = slotMtx[slot];
+
+        if( !M )
+            M = new QMutex;
+
+        m = M;
+        m->lock();
+    }
+
+    if( ms > 0 )
+        QThread::usleep( qRound( 1000 * ms ) );
+
+    if( m )
+        m->unlock();
+
+    return 0;
+}
+
+
@@ -0,0 +1,173 @@
+#ifndef IMAPI_H
+#define IMAPI_H
+
+#include <QMap>
+#include <QMutex>
+#include <QString>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Per-probe NeuropixAPI calls used by ImProbeCfg.
+//
+// Error codes follow NP_ErrorCode: 0 = SUCCESS. Parameters are
+// plain ints so this header, and the mock, build without the
+// vendor headers.
+//
+class ImAPI
+{
+public:
+    virtual ~ImAPI()    {}
+
+    virtual bool isMock() const = 0;
+    virtual QString errMsg( int err ) const = 0;
+
+    virtual int openProbe( int slot, int port ) = 0;
+    virtual int init( int slot, int port ) = 0;
+    virtual int setADCCalibration(
+        int             slot,
+        int             port,
+        const QString   &path ) = 0;
+    virtual int setGainCalibration(
+        int             slot,
+        int             port,
+        const QString   &path ) = 0;
+    virtual int setHSLed( int slot, int port, bool enable ) = 0;
+    virtual int selectElectrode( int slot, int port, int ic, int bank ) = 0;
+    virtual int setReference(
+        int slot,
+        int port,
+        int ic,
+        int ref,
+        int bank ) = 0;
+    virtual int setGain(
+        int slot,
+        int port,
+        int ic,
+        int apIdx,
+        int lfIdx ) = 0;
+    virtual int setAPCornerFrequency(
+        int     slot,
+        int     port,
+        int     ic,
+        bool    disableHP ) = 0;
+    virtual int setStdb( int slot, int port, int ic, bool standby ) = 0;
+    virtual int writeProbeConfiguration(
+        int     slot,
+        int     port,
+        bool    readCheck ) = 0;
+};
+
+
+#ifdef HAVE_IMEC
+// Forwards to NeuropixAPI.
+//
+class ImAPIHW : public ImAPI
+{
+public:
+    virtual bool isMock() const {return false;}
+    virtual QString errMsg( int err ) const;
+
+    virtual int openProbe( int slot, int port );
+    virtual int init( int slot, int port );
+    virtual int setADCCalibration(
+        int             slot,
+        int             port,
+        const QString   &path );
+    virtual int setGainCalibration(
+        int             slot,
+        int             port,
+        const QString   &path );
+    virtual int setHSLed( int slot, int port, bool enable );
+    virtual int selectElectrode( int slot, int port, int ic, int bank );
+    virtual int setReference(
+        int slot,
+        int port,
+        int ic,
+        int ref,
+        int bank );
+    virtual int setGain(
+        int slot,
+        int port,
+        int ic,
+        int apIdx,
+        int lfIdx );
+    virtual int setAPCornerFrequency(
+        int     slot,
+        int     port,
+        int     ic,
+        bool    disableHP );
+    virtual int setStdb( int slot, int port, int ic, bool standby );
+    virtual int writeProbeConfiguration(
+        int     slot,
+        int     port,
+        bool    readCheck );
+};
+#endif
+
+
+// Stand-in for NeuropixAPI: every call succeeds after sleeping
+// a configurable latency, so configuration scheduling can be
+// timed on any machine.
+//
+// Settings (improbecfg.ini, group ImAPIMock), in milliseconds:
+// - open:      openProbe (default 500).
+// - init:      init (default 200).
+// - cal:       each calibration file load (default 1500).
+// - led:       setHSLed (default 5).
+// - chan:      each per-channel call (default 0.05).
+// - write:     writeProbeConfiguration (default 300).
+// - slotLock:  serialize calls on a slot, modeling one
+//              basestation bus (default false).
+//
+class ImAPIMock : public ImAPI
+{
+private:
+    QMutex              mapMtx;
+    QMap<int,QMutex*>   slotMtx;
+    double              msOpen,
+                        msInit,
+                        msCal,
+                        msLED,
+                        msChan,
+                        msWrite;
+    bool                slotLock;
+
+public:
+    ImAPIMock();
+    virtual ~ImAPIMock();
+
+    virtual bool isMock() const {return true;}
+    virtual QString errMsg( int err ) const;
+
+    virtual int openProbe( int slot, int )
+        {return call( slot, msOpen );}
+    virtual int init( int slot, int )
+        {return call( slot, msInit );}
+    virtual int setADCCalibration( int slot, int, const QString& )
+        {return call( slot, msCal );}
+    virtual int setGainCalibration( int slot, int, const QString& )
+        {return call( slot, msCal );}
+    virtual int setHSLed( int slot, int, bool )
+        {return call( slot, msLED );}
+    virtual int selectElectrode( int slot, int, int, int )
+        {return call( slot, msChan );}
+    virtual int setReference( int slot, int, int, int, int )
+        {return call( slot, msChan );}
+    virtual int setGain( int slot, int, int, int, int )
+        {return call( slot, msChan );}
+    virtual int setAPCornerFrequency( int slot, int, int, bool )
+        {return call( slot, msChan );}
+    virtual int setStdb( int slot, int, int, bool )
+        {return call( slot, msChan );}
+    virtual int writeProbeConfiguration( int slot, int, bool )
+        {return call( slot, msWrite );}
+
+private:
+    int call( int slot, double ms );
+};
+
+#endif  // IMAPI_H
+
+
@@ -0,0 +1,506 @@
+
+#include "ImProbeCfg.h"
+#include "ImAPI.h"
+#include "ImCalCache.h"
+#include "CimAcq.h"
+#include "Util.h"
+#include "MainApp.h"
+
+#include <QMap>
+#include <QSettings>
+#include <QThreadPool>
+
+
+/* ---------------------------------------------------------------- */
+/* ImProbeCfg ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+ImProbeCfg::ImProbeCfg(
+    ImAPI                       &api,
+    CimAcq                      *acq,
+    const DAQ::Params           &p,
+    const CimCfg::ImProbeTable  &T )
+    :   api(api), acq(acq), p(p), T(T),
+        failed(0), np(p.im.get_nProbes()), parallel(0)
+{
+    loadSettings();
+}
+
+
+// Return true if all probes configured.
+// Else error describes the first failure.
+//
+bool ImProbeCfg::configure( QString &error )
+{
+    double  t0 = getTime();
+
+    firstErr.clear();
+    failed.store( 0 );
+
+    QMetaObject::invokeMethod(
+        mainApp(), "runInitSetLabel",
+        Qt::QueuedConnection,
+        Q_ARG(QString, QString("configure %1 probes").arg( np )),
+        Q_ARG(bool, true) );
+
+// -----------
+// Build tasks
+// -----------
+
+    QVector<QVector<int> >  vT;
+
+    if( parallel == 0 ) {
+
+        vT.resize( 1 );
+
+        for( int ip = 0; ip < np; ++ip )
+            vT[0].push_back( ip );
+    }
+    else if( parallel == 1 ) {
+
+        QMap<int,int>   slot2task;
+
+        for( int ip = 0; ip < np; ++ip ) {
+
+            int slot = T.get_iProbe( ip ).slot;
+
+            if( !slot2task.contains( slot ) ) {
+                slot2task[slot] = vT.size();
+                vT.resize( vT.size() + 1 );
+            }
+
+            vT[slot2task[slot]].push_back( ip );
+        }
+    }
+    else {
+
+        vT.resize( np );
+
+        for( int ip = 0; ip < np; ++ip )
+            vT[ip].push_back( ip );
+    }
+
+// ---
+// Run
+// ---
+
+    int nT = vT.size();
+
+    if( nT <= 1 ) {
+
+        if( nT )
+            runProbes( vT[0] );
+    }
+    else {
+
+        // Tasks mostly wait on hardware, so one thread each.
+
+        QThreadPool pool;
+
+        pool.setMaxThreadCount( nT );
+
+        for( int it = 0; it < nT; ++it )
+            pool.start( new ImProbeCfgTask( this, vT[it] ) );
+
+        pool.waitForDone();
+    }
+
+    if( failed.load() ) {
+        error = firstErr;
+        return false;
+    }
+
+    if( acq->isStopped() )
+        return false;
+
+    Log() <<
+        QString("IMEC %1 probes configured in %2 s (%3 tasks%4)")
+        .arg( np )
+        .arg( getTime() - t0, 0, 'f', 2 )
+        .arg( nT )
+        .arg( api.isMock() ? ", mock API" : "" );
+
+    return true;
+}
+
+
+bool ImProbeCfg::mockSim()
+{
+    STDSETTINGS( settings, "improbecfg" );
+    settings.beginGroup( "ImProbeCfg" );
+
+    return settings.value( "mockSim", false ).toBool();
+}
+
+
+void ImProbeCfg::loadSettings()
+{
+    STDSETTINGS( settings, "improbecfg" );
+    settings.beginGroup( "ImProbeCfg" );
+
+    parallel = qBound( 0, settings.value( "parallel", 0 ).toInt(), 2 );
+}
+
+
+bool ImProbeCfg::stopped() const
+{
+    return failed.load() || acq->isStopped();
+}
+
+
+// Keep first error; stop other tasks.
+//
+void ImProbeCfg::cfgError( const QString &e )
+{
+    Error() << e;
+
+    QMutexLocker    ml( &errMtx );
+
+    if( !failed.load() ) {
+        firstErr = e;
+        failed.store( 1 );
+    }
+}
+
+
+QString ImProbeCfg::apiErr(
+    const QString               &fn,
+    const CimCfg::ImProbeDat    &P,
+    int                         e )
+{
+    return
+        QString("IMEC %1(slot %2, port %3) error %4 '%5'.")
+        .arg( fn ).arg( P.slot ).arg( P.port )
+        .arg( e ).arg( api.errMsg( e ) );
+}
+
+
+void ImProbeCfg::SETLBL( const QString &s, bool zero )
+{
+    QMetaObject::invokeMethod(
+        mainApp(), "runInitSetLabel",
+        Qt::QueuedConnection,
+        Q_ARG(QString, s),
+        Q_ARG(bool, zero) );
+}
+
+
+void ImProbeCfg::SETVAL( int val )
+{
+    QMetaObject::invokeMethod(
+        mainApp(), "runInitSetValue",
+        Qt::QueuedConnection,
+        Q_ARG(int, val) );
+}
+
+
+void ImProbeCfg::runProbes( const QVector<int> &vip )
+{
+    for( int i = 0, n = vip.size(); i < n; ++i ) {
+
+        if( stopped() || !probe( T.get_iProbe( vip[i] ) ) )
+            return;
+    }
+}
+
+
+// Progress text and values as for serial configuration;
+// concurrent tasks interleave their steps.
+//
+#define STEP( fn, lbl, zero, val )                                  \
+    SETLBL( QString(lbl).arg( P.ip ), zero );                       \
+    if( stopped() || !fn( P ) ) return false;                       \
+    SETVAL( val );
+
+bool ImProbeCfg::probe( const CimCfg::ImProbeDat &P )
+{
+    STEP( _openProbe,           "open probe %1",                true,  50 );
+    STEP( _calibrateADC,        "calibrate probe %1 ADC",       false, 53 );
+    STEP( _calibrateGain,       "calibrate probe %1 gains",     false, 57 );
+    STEP( _setLEDs,             "set probe %1 LED",             false, 58 );
+    STEP( _selectElectrodes,    "select probe %1 electrodes",   false, 59 );
+    STEP( _setReferences,       "set probe %1 references",      false, 60 );
+    STEP( _setGains,            "set probe %1 gains",           false, 61 );
+    STEP( _setHighPassFilter,   "set probe %1 filters",         false, 62 );
+    STEP( _setStandby,          "set probe %1 standby",         false, 63 );
+    STEP( _writeProbe,          "writing probe %1...",          false, 100 );
+
+    return true;
+}
+
+
+bool ImProbeCfg::_openProbe( const CimCfg::ImProbeDat &P )
+{
+    int err = api.openProbe( P.slot, P.port );
+
+    if( err ) {
+        cfgError( apiErr( "openProbe", P, err ) );
+        return false;
+    }
+
+    err = api.init( P.slot, P.port );
+
+    if( err ) {
+        cfgError( apiErr( "init", P, err ) );
+        return false;
+    }
+
+    return true;
+}
+
+
+bool ImProbeCfg::_calibrateADC( const CimCfg::ImProbeDat &P )
+{
+    if( p.im.all.calPolicy == 2 ) {
+
+warn:
+        Warning() <<
+            QString("IMEC Skipping probe %1 ADC calibration").arg( P.ip );
+        return true;
+    }
+
+    QString path,
+            msg;
+
+    if( api.isMock() )
+        goto call;
+
+    if( P.cal < 1 ) {
+
+        if( p.im.all.calPolicy == 1 )
+            goto warn;
+        else {
+            cfgError(
+                QString("Can't find calibration folder '%1' for probe %2.")
+                .arg( P.sn ).arg( P.ip ) );
+            return false;
+        }
+    }
+
+    if( !ImCalCache::path( path, msg, P.sn, ImCalCache::calADC ) ) {
+        cfgError( msg );
+        return false;
+    }
+
+call:
+    int ret = api.setADCCalibration( P.slot, P.port, path );
+
+    if( ret ) {
+        cfgError( apiErr( "setADCCalibration", P, ret ) );
+        return false;
+    }
+
+    Log() << QString("IMEC probe %1 ADC calibrated").arg( P.ip );
+    return true;
+}
+
+
+bool ImProbeCfg::_calibrateGain( const CimCfg::ImProbeDat &P )
+{
+    if( p.im.all.calPolicy == 2 ) {
+
+warn:
+        Warning() <<
+            QString("IMEC Skipping probe %1 gain calibration").arg( P.ip );
+        return true;
+    }
+
+    QString path,
+            msg;
+
+    if( api.isMock() )
+        goto call;
+
+    if( P.cal < 1 ) {
+
+        if( p.im.all.calPolicy == 1 )
+            goto warn;
+        else {
+            cfgError(
+                QString("Can't find calibration folder '%1' for probe %2.")
+                .arg( P.sn ).arg( P.ip ) );
+            return false;
+        }
+    }
+
+    if( !ImCalCache::path( path, msg, P.sn, ImCalCache::calGain ) ) {
+        cfgError( msg );
+        return false;
+    }
+
+call:
+    int ret = api.setGainCalibration( P.slot, P.port, path );
+
+    if( ret ) {
+        cfgError( apiErr( "setGainCalibration", P, ret ) );
+        return false;
+    }
+
+    Log() << QString("IMEC probe %1 gains calibrated").arg( P.ip );
+    return true;
+}
+
+
+bool ImProbeCfg::_setLEDs( const CimCfg::ImProbeDat &P )
+{
+    int err = api.setHSLed( P.slot, P.port, p.im.each[P.ip].LEDEnable );
+
+    if( err ) {
+        cfgError( apiErr( "setHSLed", P, err ) );
+        return false;
+    }
+
+    Log() << QString("IMEC probe %1 LED set").arg( P.ip );
+    return true;
+}
+
+
+bool ImProbeCfg::_selectElectrodes( const CimCfg::ImProbeDat &P )
+{
+    const IMROTbl   &R = p.im.each[P.ip].roTbl;
+    int             nC = R.nChan();
+
+// ------------------------------------
+// Connect all according to table banks
+// ------------------------------------
+
+    for( int ic = 0; ic < nC; ++ic ) {
+
+        if( R.chIsRef( ic ) )
+            continue;
+
+        int err = api.selectElectrode( P.slot, P.port, ic, R.e[ic].bank );
+
+        if( err ) {
+            cfgError( apiErr( "selectElectrode", P, err ) );
+            return false;
+        }
+    }
+
+    Log() << QString("IMEC probe %1 electrodes selected").arg( P.ip );
+    return true;
+}
+
+
+bool ImProbeCfg::_setReferences( const CimCfg::ImProbeDat &P )
+{
+    const IMROTbl   &R = p.im.each[P.ip].roTbl;
+    int             nC = R.nChan();
+
+// ------------------------------------
+// Connect all according to table refid
+// ------------------------------------
+
+// refid    (ref,bnk)   who
+// -----    ---------   ---
+//   0        (0,0)     ext
+//   1        (1,0)     tip
+//   2        (2,0)     192
+//   3        (2,1)     576
+//   4        (2,2)     960
+//
+    for( int ic = 0; ic < nC; ++ic ) {
+
+        int rid = R.e[ic].refid,
+            ref = (rid < 2 ? rid : 2),
+            bnk = (rid > 1 ? rid - 2 : 0),
+            err = api.setReference( P.slot, P.port, ic, ref, bnk );
+
+        if( err ) {
+            cfgError( apiErr( "setReference", P, err ) );
+            return false;
+        }
+    }
+
+    Log() << QString("IMEC probe %1 references set").arg( P.ip );
+    return true;
+}
+
+
+bool ImProbeCfg::_setGains( const CimCfg::ImProbeDat &P )
+{
+    const IMROTbl   &R = p.im.each[P.ip].roTbl;
+    int             nC = R.nChan();
+
+// --------------------------------
+// Set all according to table gains
+// --------------------------------
+
+    for( int ic = 0; ic < nC; ++ic ) {
+
+        const IMRODesc  &E = R.e[ic];
+
+        int err = api.setGain( P.slot, P.port, ic,
+                    IMROTbl::gainToIdx( E.apgn ),
+                    IMROTbl::gainToIdx( E.lfgn ) );
+
+        if( err ) {
+            cfgError( apiErr( "setGain", P, err ) );
+            return false;
+        }
+    }
+
+    Log() << QString("IMEC probe %1 gains set").arg( P.ip );
+    return true;
+}
+
+
+bool ImProbeCfg::_setHighPassFilter( const CimCfg::ImProbeDat &P )
+{
+    const IMROTbl   &R = p.im.each[P.ip].roTbl;
+    int             nC = R.nChan();
+
+    for( int ic = 0; ic < nC; ++ic ) {
+
+        int err = api.setAPCornerFrequency(
+                    P.slot, P.port, ic, !R.e[ic].apflt );
+
+        if( err ) {
+            cfgError( apiErr( "setAPCornerFrequency", P, err ) );
+            return false;
+        }
+    }
+
+    Log() << QString("IMEC probe %1 filters set").arg( P.ip );
+    return true;
+}
+
+
+bool ImProbeCfg::_setStandby( const CimCfg::ImProbeDat &P )
+{
+// --------------------------------------------------
+// Turn ALL channels on or off according to stdbyBits
+// --------------------------------------------------
+
+    const CimCfg::AttrEach  &E  = p.im.each[P.ip];
+    int                     nC  = E.roTbl.nChan();
+
+    for( int ic = 0; ic < nC; ++ic ) {
+
+        int err = api.setStdb( P.slot, P.port, ic,
+                    E.stdbyBits.testBit( ic ) );
+
+        if( err ) {
+            cfgError( apiErr( "setStandby", P, err ) );
+            return false;
+        }
+    }
+
+    Log() << QString("IMEC probe %1 standby chans set").arg( P.ip );
+    return true;
+}
+
+
+bool ImProbeCfg::_writeProbe( const CimCfg::ImProbeDat &P )
+{
+    int err = api.writeProbeConfiguration( P.slot, P.port, true );
+
+    if( err ) {
+        cfgError( apiErr( "writeProbeConfig", P, err ) );
+        return false;
+    }
+
+    return true;
+}
+
+
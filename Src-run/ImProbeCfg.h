@@ -0,0 +1,100 @@
+#ifndef IMPROBECFG_H
+#define IMPROBECFG_H
+
+#include "DAQ.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QRunnable>
+
+class CimAcq;
+class ImAPI;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Per-probe configuration: open, calibrate, LED, electrodes,
+// references, gains, filters, standby, write; run as concurrent
+// tasks through an ImAPI.
+//
+// Each task configures its probes in ip order. The first error
+// stops all tasks at their next step and is the one reported.
+//
+// Settings (improbecfg.ini, group ImProbeCfg):
+// - parallel: 0 = one probe at a time (default),
+//             1 = one task per slot,
+//             2 = one task per probe.
+//             Nonzero issues concurrent NeuropixAPI calls; use only
+//             once validated on the hardware at hand.
+// - mockSim:  simulated probes run this configuration against
+//             ImAPIMock first, to time startup (default false).
+//
+class ImProbeCfg
+{
+    friend class ImProbeCfgTask;
+
+private:
+    ImAPI                       &api;
+    CimAcq                      *acq;
+    const DAQ::Params           &p;
+    const CimCfg::ImProbeTable  &T;
+    QMutex                      errMtx;
+    QString                     firstErr;
+    QAtomicInt                  failed;
+    int                         np,
+                                parallel;
+
+public:
+    ImProbeCfg(
+        ImAPI                       &api,
+        CimAcq                      *acq,
+        const DAQ::Params           &p,
+        const CimCfg::ImProbeTable  &T );
+
+    bool configure( QString &error );
+
+    static bool mockSim();
+
+private:
+    void loadSettings();
+
+    void SETLBL( const QString &s, bool zero = false );
+    void SETVAL( int val );
+
+    bool stopped() const;
+    void cfgError( const QString &e );
+    QString apiErr( const QString &fn, const CimCfg::ImProbeDat &P, int e );
+
+    void runProbes( const QVector<int> &vip );
+    bool probe( const CimCfg::ImProbeDat &P );
+
+    bool _openProbe( const CimCfg::ImProbeDat &P );
+    bool _calibrateADC( const CimCfg::ImProbeDat &P );
+    bool _calibrateGain( const CimCfg::ImProbeDat &P );
+    bool _setLEDs( const CimCfg::ImProbeDat &P );
+    bool _selectElectrodes( const CimCfg::ImProbeDat &P );
+    bool _setReferences( const CimCfg::ImProbeDat &P );
+    bool _setGains( const CimCfg::ImProbeDat &P );
+    bool _setHighPassFilter( const CimCfg::ImProbeDat &P );
+    bool _setStandby( const CimCfg::ImProbeDat &P );
+    bool _writeProbe( const CimCfg::ImProbeDat &P );
+};
+
+
+class ImProbeCfgTask : public QRunnable
+{
+private:
+    ImProbeCfg      *cfg;
+    QVector<int>    vip;
+
+public:
+    ImProbeCfgTask( ImProbeCfg *cfg, const QVector<int> &vip )
+    :   QRunnable(), cfg(cfg), vip(vip) {}
+
+    virtual void run()  {cfg->runProbes( vip );}
+};
+
+#endif  // IMPROBECFG_H
+
+
@@ -0,0 +1,311 @@
+#ifdef HAVE_IMEC
+
+#include "ImUnpack.h"
+#include "KernelTest.h"
+#include "Util.h"
+#include "SGLTypes.h"
+#include "IMEC/NeuropixAPI.h"
+
+#include <string.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define IMUNPACK_X86
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #define TARGET_AVX2
+    #else
+        #define TARGET_AVX2 __attribute__((target("avx2")))
+    #endif
+#endif
+
+
+/* ---------------------------------------------------------------- */
+/* imUnpackScalar ------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Reference kernel; this is the original doProbe loop.
+//
+void imUnpackScalar(
+    qint16      *dst,
+    float       *lfLast,
+    const qint8 *E,
+    int         nE,
+    int         nAP,
+    int         nLF )
+{
+    for( int ie = 0; ie < nE; ++ie ) {
+
+        const electrodePacket   *pE     = &((const electrodePacket*)E)[ie];
+        const qint16            *srcLF  = pE->lfpData;
+
+        for( int it = 0; it < PROBE_SUPERFRAMESIZE; ++it ) {
+
+            // ----------
+            // ap - as is
+            // ----------
+
+            memcpy( dst, pE->apData[it], nAP * sizeof(qint16) );
+            dst += nAP;
+
+            // -----------------
+            // lf - interpolated
+            // -----------------
+
+            float slope = float(it)/PROBE_SUPERFRAMESIZE;
+
+            for( int lf = 0; lf < nLF; ++lf )
+                *dst++ = lfLast[lf] + slope*(srcLF[lf]-lfLast[lf]);
+
+            // ----
+            // sync
+            // ----
+
+            *dst++ = pE->Status[it];
+        }
+
+        // ---------------
+        // update saved lf
+        // ---------------
+
+        for( int lf = 0; lf < nLF; ++lf )
+            lfLast[lf] = srcLF[lf];
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* imUnpackAVX2 --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#ifdef IMUNPACK_X86
+
+// Per packet, (LF - lfLast) is formed once; each timepoint is
+// then one multiply-add per 8 channels, truncated to int32
+// and saturate-packed to int16, exactly as the scalar float
+// to qint16 conversion (values are always in range).
+//
+// No FMA: scalar code rounds the product before the add.
+//
+TARGET_AVX2 void imUnpackAVX2(
+    qint16      *dst,
+    float       *lfLast,
+    const qint8 *E,
+    int         nE,
+    int         nAP,
+    int         nLF )
+{
+    float   diff[PROBE_CHANNEL_COUNT];
+    int     nLF8 = qMin( nLF, PROBE_CHANNEL_COUNT ) & ~7;
+
+    for( int ie = 0; ie < nE; ++ie ) {
+
+        const electrodePacket   *pE     = &((const electrodePacket*)E)[ie];
+        const qint16            *srcLF  = pE->lfpData;
+
+        for( int lf = 0; lf < nLF8; lf += 8 ) {
+
+            __m256  cur = _mm256_cvtepi32_ps(
+                            _mm256_cvtepi16_epi32(
+                                _mm_loadu_si128(
+                                    (const __m128i*)(srcLF + lf) ) ) );
+
+            _mm256_storeu_ps(
+                diff + lf,
+                _mm256_sub_ps( cur, _mm256_loadu_ps( lfLast + lf ) ) );
+        }
+
+        for( int it = 0; it < PROBE_SUPERFRAMESIZE; ++it ) {
+
+            memcpy( dst, pE->apData[it], nAP * sizeof(qint16) );
+            dst += nAP;
+
+            float   slope   = float(it)/PROBE_SUPERFRAMESIZE;
+            __m256  vSlope  = _mm256_set1_ps( slope );
+            int     lf      = 0;
+
+            for( ; lf < nLF8; lf += 8 ) {
+
+                __m256  v = _mm256_add_ps(
+                                _mm256_loadu_ps( lfLast + lf ),
+                                _mm256_mul_ps(
+                                    vSlope,
+                                    _mm256_loadu_ps( diff + lf ) ) );
+
+                __m256i i32 = _mm256_cvttps_epi32( v );
+
+                _mm_storeu_si128(
+                    (__m128i*)(dst + lf),
+                    _mm_packs_epi32(
+                        _mm256_castsi256_si128( i32 ),
+                        _mm256_extracti128_si256( i32, 1 ) ) );
+            }
+
+            for( ; lf < nLF; ++lf )
+                dst[lf] = lfLast[lf] + slope*(srcLF[lf]-lfLast[lf]);
+
+            dst   += nLF;
+            *dst++ = pE->Status[it];
+        }
+
+        for( int lf = 0; lf < nLF; ++lf )
+            lfLast[lf] = srcLF[lf];
+    }
+}
+
+#else
+
+void imUnpackAVX2(
+    qint16      *dst,
+    float       *lfLast,
+    const qint8 *E,
+    int         nE,
+    int         nAP,
+    int         nLF )
+{
+    imUnpackScalar( dst, lfLast, E, nE, nAP, nLF );
+}
+
+#endif
+
+/* ---------------------------------------------------------------- */
+/* Selection ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+bool imUnpackHaveAVX2()
+{
+    return cpuHasAVX2();
+}
+
+
+ImUnpackFn imUnpackSelect()
+{
+    return (imUnpackHaveAVX2() ? imUnpackAVX2 : imUnpackScalar);
+}
+
+
+const char *imUnpackName( ImUnpackFn fn )
+{
+    return (fn == imUnpackAVX2 ? "AVX2" : "scalar");
+}
+
+/* ---------------------------------------------------------------- */
+/* Self-check and bench ------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+#define TSTNE   24      // one full MAXE-size fetch
+
+
+// Random AP and LF, incrementing status.
+//
+static void imUnpackTestData( std::vector<electrodePacket> &E )
+{
+    KTRand  R;
+
+    E.resize( TSTNE );
+
+    for( int ie = 0; ie < TSTNE; ++ie ) {
+
+        electrodePacket &P = E[ie];
+
+        for( int it = 0; it < PROBE_SUPERFRAMESIZE; ++it ) {
+
+            for( int c = 0; c < PROBE_CHANNEL_COUNT; ++c )
+                P.apData[it][c] = R.i16();
+
+            P.Status[it] = it;
+        }
+
+        for( int c = 0; c < PROBE_CHANNEL_COUNT; ++c )
+            P.lfpData[c] = R.i16() / 4;
+    }
+}
+
+
+// Two fetches, so LF interpolation carries lfLast across calls.
+//
+bool imUnpackSelfCheck( QString &err )
+{
+    if( !imUnpackHaveAVX2() )
+        return true;
+
+    const int   nAP = PROBE_CHANNEL_COUNT,
+                nLF = PROBE_CHANNEL_COUNT,
+                nCH = nAP + nLF + 1;
+
+    std::vector<electrodePacket>    E;
+    std::vector<float>              lf1( nLF, 0.0F ),
+                                    lf2( nLF, 0.0F );
+    vec_i16                         out1( TSTNE * PROBE_SUPERFRAMESIZE * nCH ),
+                                    out2( out1.size() );
+
+    imUnpackTestData( E );
+
+    for( int pass = 0; pass < 2; ++pass ) {
+
+        imUnpackScalar(
+            &out1[0], &lf1[0], (const qint8*)&E[0], TSTNE, nAP, nLF );
+        imUnpackAVX2(
+            &out2[0], &lf2[0], (const qint8*)&E[0], TSTNE, nAP, nLF );
+
+        if( !ktCompare(
+                err, QString("imec unpack AVX2 pass %1").arg( pass ),
+                out1, out2, nCH ) ) {
+
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+void imUnpackBench( QStringList &sl )
+{
+    const int   nAP     = PROBE_CHANNEL_COUNT,
+                nLF     = PROBE_CHANNEL_COUNT,
+                nCH     = nAP + nLF + 1,
+                nReps   = 500;
+
+    std::vector<electrodePacket>    E;
+    std::vector<ImUnpackFn>         vFn;
+    std::vector<double>             vUs;
+
+    imUnpackTestData( E );
+
+    vFn.push_back( imUnpackScalar );
+
+    if( imUnpackHaveAVX2() )
+        vFn.push_back( imUnpackAVX2 );
+
+    for( int k = 0, nk = vFn.size(); k < nk; ++k ) {
+
+        std::vector<float>  lfLast( nLF, 0.0F );
+        vec_i16             out( TSTNE * PROBE_SUPERFRAMESIZE * nCH );
+        KTTimer             T;
+
+        for( int r = 0; r < nReps; ++r ) {
+            vFn[k](
+                &out[0], &lfLast[0], (const qint8*)&E[0], TSTNE, nAP, nLF );
+        }
+
+        vUs.push_back( T.usPer( nReps ) );
+    }
+
+    for( int k = 0, nk = vFn.size(); k < nk; ++k ) {
+
+        sl.append(
+            QString("  imec unpack %1: %2 us per %3-packet fetch")
+            .arg( imUnpackName( vFn[k] ), -6 )
+            .arg( vUs[k], 0, 'f', 1 )
+            .arg( TSTNE ) );
+    }
+
+    if( vUs.size() > 1 && vUs.back() > 0 ) {
+        sl.append(
+            QString("  imec unpack speedup: %1x")
+            .arg( vUs[0] / vUs.back(), 0, 'f', 2 ) );
+    }
+}
+
+#endif  // HAVE_IMEC
+
+
@@ -0,0 +1,66 @@
+#ifndef IMUNPACK_H
+#define IMUNPACK_H
+
+#ifdef HAVE_IMEC
+
+#include <QStringList>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Convert a batch of nE electrodePackets (E) to interleaved
+// AIQ scans at dst. Each packet yields PROBE_SUPERFRAMESIZE
+// scans of:
+// - nAP AP values, as is,
+// - nLF LF values, linearly interpolated from lfLast to this
+//   packet's LF (slope it/PROBE_SUPERFRAMESIZE),
+// - one SY status word.
+//
+// lfLast[nLF] carries the previous packet's LF across calls.
+//
+// All kernels produce bit-identical output.
+//
+typedef void (*ImUnpackFn)(
+    qint16      *dst,
+    float       *lfLast,
+    const qint8 *E,
+    int         nE,
+    int         nAP,
+    int         nLF );
+
+void imUnpackScalar(
+    qint16      *dst,
+    float       *lfLast,
+    const qint8 *E,
+    int         nE,
+    int         nAP,
+    int         nLF );
+
+void imUnpackAVX2(
+    qint16      *dst,
+    float       *lfLast,
+    const qint8 *E,
+    int         nE,
+    int         nAP,
+    int         nLF );
+
+bool imUnpackHaveAVX2();
+
+// Fastest kernel this CPU supports
+ImUnpackFn imUnpackSelect();
+const char *imUnpackName( ImUnpackFn fn );
+
+// Compare AVX2 to scalar on synthetic packets. Return false
+// and describe first mismatch. Run by the KernelChecks test app.
+bool imUnpackSelfCheck( QString &err );
+
+// Time each available kernel on synthetic packets;
+// append report lines to sl.
+void imUnpackBench( QStringList &sl );
+
+#endif  // HAVE_IMEC
+
+#endif  // IMUNPACK_H
+
+
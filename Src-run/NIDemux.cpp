@@ -0,0 +1,684 @@
+
+#include "NIDemux.h"
+#include "KernelTest.h"
+#include "Util.h"
+
+#include <string.h>
+
+#if defined(_M_X64) || defined(__SSE2__)
+    #define DEMUX_SSE2
+    #include <emmintrin.h>
+#endif
+
+
+/* ---------------------------------------------------------------- */
+/* NIDemux -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// In each timepoint the muxed channels form a matrix. As acquired,
+// each column is a muxer (ncol = kmn1 + kmn2 + kma1 + kma2), and
+// there are kmux rows. Output is the transpose, so all samples
+// from a given muxer are together; col[] holds each column's row-0
+// source in output order. XA values are oversampled by kmux and
+// averaged; xa[] holds each one's row-0 source.
+//
+// XD: the low kxd1 bytes of the dev1 word, then the low kxd2 bytes
+// of the dev2 word, are packed little-endian into nXD 16-bit words.
+//
+void NIDemux::init( const NIDemuxLayout &L, bool simd )
+{
+    this->L = L;
+
+    col.clear();
+    xa.clear();
+    blk.clear();
+
+// -----------
+// Analog plan
+// -----------
+
+    if( L.kmux == 1 ) {
+
+        // Not muxing: XA copied as is
+
+        row[0] = L.kxa1;
+        row[1] = L.kxa2;
+    }
+    else {
+
+        row[0] = L.kmn1 + L.kma1 + L.kxa1;
+        row[1] = L.kmn2 + L.kma2 + L.kxa2;
+
+        // Columns in acquired order: (mn1 | mn2 | ma1 | ma2).
+
+        for( int j = 0; j < L.kmn1; ++j )
+            col.push_back( j << 1 );
+
+        for( int j = 0; j < L.kmn2; ++j )
+            col.push_back( (j << 1) | 1 );
+
+        for( int j = 0; j < L.kma1; ++j )
+            col.push_back( ((L.kmn1 + j) << 1) );
+
+        for( int j = 0; j < L.kma2; ++j )
+            col.push_back( ((L.kmn2 + j) << 1) | 1 );
+
+        for( int j = 0; j < L.kxa1; ++j )
+            xa.push_back( (L.kmn1 + L.kma1 + j) << 1 );
+
+        for( int j = 0; j < L.kxa2; ++j )
+            xa.push_back( ((L.kmn2 + L.kma2 + j) << 1) | 1 );
+    }
+
+    step[0] = L.kmux * row[0];
+    step[1] = L.kmux * row[1];
+
+// -----------
+// SIMD blocks
+// -----------
+
+#ifdef DEMUX_SSE2
+    if( simd && L.kmux >= 8 ) {
+
+        for( int i = 0, n = col.size(); i + 8 <= n; ) {
+
+            if( col[i + 7] == col[i] + (7 << 1) ) {
+                blk.push_back( i );
+                i += 8;
+            }
+            else
+                ++i;
+        }
+    }
+#else
+    Q_UNUSED( simd )
+#endif
+
+// ------------
+// Digital plan
+// ------------
+
+    nXD     = (1 + L.kxd1 + L.kxd2) / 2;
+    msk1    = (L.kxd1 >= 4 ? 0xFFFFFFFF : (1U << (8 * L.kxd1)) - 1);
+    msk2    = (L.kxd2 >= 4 ? 0xFFFFFFFF : (1U << (8 * L.kxd2)) - 1);
+    sh2     = 8 * L.kxd1;
+}
+
+
+#ifdef DEMUX_SSE2
+
+// Store 8 columns (s[0..7], rows spaced r) of kmux rows to dst,
+// column-major (column c at dst + c*kmux).
+//
+static void transpose8( qint16 *dst, const qint16 *s, int r, int kmux )
+{
+    int Y = 0;
+
+    for( ; Y + 8 <= kmux; Y += 8, s += 8 * r ) {
+
+        __m128i a0 = _mm_loadu_si128( (const __m128i*)(s) ),
+                a1 = _mm_loadu_si128( (const __m128i*)(s + r) ),
+                a2 = _mm_loadu_si128( (const __m128i*)(s + 2*r) ),
+                a3 = _mm_loadu_si128( (const __m128i*)(s + 3*r) ),
+                a4 = _mm_loadu_si128( (const __m128i*)(s + 4*r) ),
+                a5 = _mm_loadu_si128( (const __m128i*)(s + 5*r) ),
+                a6 = _mm_loadu_si128( (const __m128i*)(s + 6*r) ),
+                a7 = _mm_loadu_si128( (const __m128i*)(s + 7*r) );
+
+        __m128i t0 = _mm_unpacklo_epi16( a0, a1 ),
+                t1 = _mm_unpackhi_epi16( a0, a1 ),
+                t2 = _mm_unpacklo_epi16( a2, a3 ),
+                t3 = _mm_unpackhi_epi16( a2, a3 ),
+                t4 = _mm_unpacklo_epi16( a4, a5 ),
+                t5 = _mm_unpackhi_epi16( a4, a5 ),
+                t6 = _mm_unpacklo_epi16( a6, a7 ),
+                t7 = _mm_unpackhi_epi16( a6, a7 );
+
+        __m128i u0 = _mm_unpacklo_epi32( t0, t2 ),
+                u1 = _mm_unpackhi_epi32( t0, t2 ),
+                u2 = _mm_unpacklo_epi32( t1, t3 ),
+                u3 = _mm_unpackhi_epi32( t1, t3 ),
+                u4 = _mm_unpacklo_epi32( t4, t6 ),
+                u5 = _mm_unpackhi_epi32( t4, t6 ),
+                u6 = _mm_unpacklo_epi32( t5, t7 ),
+                u7 = _mm_unpackhi_epi32( t5, t7 );
+
+        qint16  *d = dst + Y;
+
+        _mm_storeu_si128( (__m128i*)(d),
+            _mm_unpacklo_epi64( u0, u4 ) );
+        _mm_storeu_si128( (__m128i*)(d + kmux),
+            _mm_unpackhi_epi64( u0, u4 ) );
+        _mm_storeu_si128( (__m128i*)(d + 2*kmux),
+            _mm_unpacklo_epi64( u1, u5 ) );
+        _mm_storeu_si128( (__m128i*)(d + 3*kmux),
+            _mm_unpackhi_epi64( u1, u5 ) );
+        _mm_storeu_si128( (__m128i*)(d + 4*kmux),
+            _mm_unpacklo_epi64( u2, u6 ) );
+        _mm_storeu_si128( (__m128i*)(d + 5*kmux),
+            _mm_unpackhi_epi64( u2, u6 ) );
+        _mm_storeu_si128( (__m128i*)(d + 6*kmux),
+            _mm_unpacklo_epi64( u3, u7 ) );
+        _mm_storeu_si128( (__m128i*)(d + 7*kmux),
+            _mm_unpackhi_epi64( u3, u7 ) );
+    }
+
+    // Leftover rows
+
+    for( ; Y < kmux; ++Y, s += r ) {
+
+        for( int c = 0; c < 8; ++c )
+            dst[c*kmux + Y] = s[c];
+    }
+}
+
+#endif
+
+
+void NIDemux::apply(
+    qint16          *dst,
+    const qint16    *sA1,
+    const qint16    *sA2,
+    const quint32   *sD1,
+    const quint32   *sD2,
+    int             nwhole ) const
+{
+    static const quint32    zero = 0;
+
+    const qint16    *src[2] = {sA1, sA2};
+    const quint32   *d1     = (L.kxd1 ? sD1 : &zero),
+                    *d2     = (L.kxd2 ? sD2 : &zero);
+    int             kmux    = L.kmux,
+                    ncol    = col.size(),
+                    nxa     = xa.size(),
+                    nblk    = blk.size(),
+                    dStep1  = (L.kxd1 ? kmux : 0),
+                    dStep2  = (L.kxd2 ? kmux : 0);
+
+    for( int w = 0; w < nwhole; ++w ) {
+
+        if( kmux == 1 ) {
+
+            // Copy XA
+
+            if( L.kxa1 ) {
+                memcpy( dst, src[0], L.kxa1*sizeof(qint16) );
+                dst += L.kxa1;
+            }
+
+            if( L.kxa2 ) {
+                memcpy( dst, src[1], L.kxa2*sizeof(qint16) );
+                dst += L.kxa2;
+            }
+        }
+        else {
+
+            // Gather MN, MA (transposed): each muxer column
+            // is a strided walk down the kmux rows.
+
+            for( int i = 0, ib = 0; i < ncol; ) {
+
+                int             g   = col[i],
+                                r   = row[g & 1];
+                const qint16    *s  = src[g & 1] + (g >> 1);
+
+#ifdef DEMUX_SSE2
+                if( ib < nblk && blk[ib] == i ) {
+                    transpose8( dst, s, r, kmux );
+                    dst += 8 * kmux;
+                    i   += 8;
+                    ++ib;
+                    continue;
+                }
+#endif
+
+                for( int Y = 0; Y < kmux; ++Y, s += r )
+                    *dst++ = *s;
+
+                ++i;
+            }
+
+            // Average XA
+
+            for( int i = 0; i < nxa; ++i ) {
+
+                int             g   = xa[i],
+                                r   = row[g & 1];
+                const qint16    *s  = src[g & 1] + (g >> 1);
+                long            sum = 0;
+
+                for( int Y = 0; Y < kmux; ++Y, s += r )
+                    sum += *s;
+
+                *dst++ = sum / kmux;
+            }
+        }
+
+        src[0] += step[0];
+        src[1] += step[1];
+
+        // Pack XD
+
+        if( nXD ) {
+
+            quint64 v = (*d1 & msk1) | (quint64(*d2 & msk2) << sh2);
+
+            for( int k = 0; k < nXD; ++k, v >>= 16 )
+                *dst++ = quint16(v);
+
+            d1 += dStep1;
+            d2 += dStep2;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* niDemuxRef ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+static void packXDRef(
+    const NIDemuxLayout &L,
+    qint16              *&dst,
+    const quint32       *&sD1,
+    const quint32       *&sD2 )
+{
+    quint16 W = 0;
+    bool    F = 0;   // filling F: {0=empty,1=lsb,2=full}
+
+    if( L.kxd1 == 4 ) {
+        *dst++ = *sD1;
+        *dst++ = *sD1 >> 16;
+        ++sD1;
+    }
+    if( L.kxd1 == 3 ) {
+        *dst++ = *sD1;
+        W = (*sD1 >> 16) & 0xFF;
+        F = 1;
+        ++sD1;
+    }
+    else if( L.kxd1 == 2 ) {
+        *dst++ = *sD1++;
+    }
+    else if( L.kxd1 == 1 ) {
+        W = *sD1++ & 0xFF;
+        F = 1;
+    }
+
+    if( L.kxd2 == 0 ) {
+
+        if( F > 0 )
+            *dst++ = W;
+    }
+    else if( L.kxd2 == 1 ) {
+
+        if( F == 0 )
+            *dst++ = *sD2++ & 0xFF;
+        else
+            *dst++ = W + (*sD2++ << 8);
+    }
+    else if( L.kxd2 == 2 ) {
+
+        if( F == 0 )
+            *dst++ = *sD2++;
+        else {
+            *dst++ = W + (*sD2 << 8);
+            *dst++ = (*sD2 >> 8) & 0xFF;
+            ++sD2;
+        }
+    }
+    else if( L.kxd2 == 3 ) {
+
+        if( F == 0 ) {
+            *dst++ = *sD2;
+            *dst++ = (*sD2 >> 16) & 0xFF;
+            ++sD2;
+        }
+        else {
+            *dst++ = W + (*sD2 << 8);
+            *dst++ = *sD2 >> 8;
+            ++sD2;
+        }
+    }
+    else if( L.kxd2 == 4 ) {
+
+        if( F == 0 ) {
+            *dst++ = *sD2;
+            *dst++ = *sD2 >> 16;
+            ++sD2;
+        }
+        else {
+            *dst++ = W + (*sD2 << 8);
+            *dst++ = *sD2 >> 8;
+            *dst++ = *sD2 >> 24;
+            ++sD2;
+        }
+    }
+}
+
+
+// - Merge data from 2 devices.
+// - Group by whole timepoints.
+// - Subgroup (mn0 | mn1 |...| ma0 | ma1 |...| xa | xd).
+// - Average oversampled xa chans.
+// - Downsample oversampled xd and pack bytes into low-order bits.
+//
+void niDemuxRef(
+    const NIDemuxLayout &L,
+    qint16              *dst,
+    const qint16        *sA1,
+    const qint16        *sA2,
+    const quint32       *sD1,
+    const quint32       *sD2,
+    int                 nwhole )
+{
+    int kmux = L.kmux,
+        kmn1 = L.kmn1, kma1 = L.kma1, kxa1 = L.kxa1, kxd1 = L.kxd1,
+        kmn2 = L.kmn2, kma2 = L.kma2, kxa2 = L.kxa2, kxd2 = L.kxd2;
+
+// ----------
+// Not muxing
+// ----------
+
+    if( kmux == 1 ) {
+
+        for( int w = 0; w < nwhole; ++w ) {
+
+            // Copy XA
+
+            if( kxa1 ) {
+                memcpy( dst, sA1, kxa1*sizeof(qint16) );
+                dst += kxa1;
+                sA1 += kxa1;
+            }
+
+            if( kxa2 ) {
+                memcpy( dst, sA2, kxa2*sizeof(qint16) );
+                dst += kxa2;
+                sA2 += kxa2;
+            }
+
+            // Copy XD
+
+            if( kxd1 + kxd2 == 0 )
+                continue;
+
+            packXDRef( L, dst, sD1, sD2 );
+        }
+
+        return;
+    }
+
+// ------
+// Muxing
+// ------
+
+    int     ncol    = kmn1 + kmn2 + kma1 + kma2,
+            nrow    = kmux,
+            ntmp    = nrow * ncol;
+    vec_i16 vtmp( ntmp );
+
+    for( int w = 0; w < nwhole; ++w ) {
+
+        std::vector<long>   sumxa1( kxa1, 0 ),
+                            sumxa2( kxa2, 0 );
+        qint16              *tmp = &vtmp[0];
+
+        for( int s = 0; s < kmux; ++s ) {
+
+            // Fill MN, MA matrix
+
+            if( kmn1 ) {
+                memcpy( tmp, sA1, kmn1*sizeof(qint16) );
+                tmp += kmn1;
+                sA1 += kmn1;
+            }
+
+            if( kmn2 ) {
+                memcpy( tmp, sA2, kmn2*sizeof(qint16) );
+                tmp += kmn2;
+                sA2 += kmn2;
+            }
+
+            if( kma1 ) {
+                memcpy( tmp, sA1, kma1*sizeof(qint16) );
+                tmp += kma1;
+                sA1 += kma1;
+            }
+
+            if( kma2 ) {
+                memcpy( tmp, sA2, kma2*sizeof(qint16) );
+                tmp += kma2;
+                sA2 += kma2;
+            }
+
+            // Sum XA
+
+            for( int x = 0; x < kxa1; ++x )
+                sumxa1[x] += *sA1++;
+
+            for( int x = 0; x < kxa2; ++x )
+                sumxa2[x] += *sA2++;
+        }
+
+        // Transpose and store MN, MA:
+        // Original element address is [ncol*Y + X].
+        // Swap roles X <-> Y and row <-> col.
+
+        for( int iacq = 0; iacq < ntmp; ++iacq ) {
+
+            int Y = iacq / ncol,
+                X = iacq - ncol * Y;
+
+            dst[nrow*X + Y] = vtmp[iacq];
+        }
+
+        dst += ntmp;
+
+        // Copy XA averages
+
+        for( int x = 0; x < kxa1; ++x )
+            *dst++ = sumxa1[x] / kmux;
+
+        for( int x = 0; x < kxa2; ++x )
+            *dst++ = sumxa2[x] / kmux;
+
+        // Copy XD
+
+        if( kxd1 + kxd2 == 0 )
+            continue;
+
+        packXDRef( L, dst, sD1, sD2 );
+
+        if( kxd1 )
+            sD1 += (kmux - 1);
+
+        if( kxd2 )
+            sD2 += (kmux - 1);
+    }
+}
+
+/* ---------------------------------------------------------------- */
+/* Self-check and bench ------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+struct DmxTestBufs
+{
+    vec_i16                 A1, A2,
+                            out1, out2;
+    std::vector<quint32>    D1, D2;
+
+    void fill( const NIDemuxLayout &L, int nwhole, quint32 seed );
+    const qint16 *a1() const    {return (A1.size() ? &A1[0] : 0);}
+    const qint16 *a2() const    {return (A2.size() ? &A2[0] : 0);}
+    const quint32 *d1( const NIDemuxLayout &L ) const
+        {return (L.kxd1 ? &D1[0] : 0);}
+    const quint32 *d2( const NIDemuxLayout &L ) const
+        {return (L.kxd2 ? &D2[0] : 0);}
+};
+
+
+// Digital words get random high bytes too, to check masking.
+//
+void DmxTestBufs::fill( const NIDemuxLayout &L, int nwhole, quint32 seed )
+{
+    A1.resize( nwhole * L.srcPerWhole1() );
+    A2.resize( nwhole * L.srcPerWhole2() );
+    D1.resize( nwhole * L.kmux );
+    D2.resize( nwhole * L.kmux );
+
+    KTRand  R( seed );
+
+    R.fill( A1 );
+    R.fill( A2 );
+
+    for( int i = 0, n = D1.size(); i < n; ++i ) {
+        D1[i] = R.next();
+        D2[i] = R.next();
+    }
+
+    out1.assign( nwhole * L.dstPerWhole(), 0 );
+    out2.assign( nwhole * L.dstPerWhole(), 0 );
+}
+
+
+// Wide layouts give 8-column blocks, and windows that straddle
+// devices, which must not be blocks. kmux 12 leaves rows over
+// after the 8-row transposes.
+//
+bool niDemuxSelfCheck( QString &err )
+{
+    const int   vmux[]  = {1, 2, 8, 12, 16, 32},
+                nmux    = sizeof(vmux) / sizeof(int),
+                nwhole  = 7;
+
+    DmxTestBufs B;
+    NIDemux     D;
+
+    for( int im = 0; im < nmux; ++im ) {
+
+        for( int wide = 0; wide < 2; ++wide ) {
+
+            for( int dev2 = 0; dev2 < 2; ++dev2 ) {
+
+                for( int kxd1 = 0; kxd1 <= 4; ++kxd1 ) {
+
+                    for( int kxd2 = 0; kxd2 <= 4; ++kxd2 ) {
+
+                        NIDemuxLayout   L;
+
+                        L.kmux = vmux[im];
+                        L.kxa1 = 3;
+                        L.kxd1 = kxd1;
+                        L.kxd2 = kxd2;
+
+                        if( L.kmux > 1 ) {
+                            L.kmn1 = (wide ? 9 : 2);
+                            L.kma1 = (wide ? 8 : 1);
+                        }
+
+                        if( dev2 ) {
+
+                            L.kxa2 = 2;
+
+                            if( L.kmux > 1 ) {
+                                L.kmn2 = (wide ? 8 : 1);
+                                L.kma2 = (wide ? 3 : 2);
+                            }
+                        }
+
+                        B.fill( L, nwhole, 12345 + kxd1 + 5*kxd2 );
+
+                        niDemuxRef(
+                            L, &B.out1[0], B.a1(), B.a2(),
+                            B.d1( L ), B.d2( L ), nwhole );
+
+                        for( int simd = 0; simd < 2; ++simd ) {
+
+                            B.out2.assign( B.out2.size(), 0 );
+
+                            D.init( L, simd );
+                            D.apply(
+                                &B.out2[0], B.a1(), B.a2(),
+                                B.d1( L ), B.d2( L ), nwhole );
+
+                            if( !ktCompare(
+                                    err, "NI demux", B.out1, B.out2,
+                                    L.dstPerWhole() ) ) {
+
+                                err += QString(
+                                    " Layout: kmux %1 wide %2 dev2 %3"
+                                    " kxd1 %4 kxd2 %5 simd %6.")
+                                    .arg( L.kmux ).arg( wide ).arg( dev2 )
+                                    .arg( kxd1 ).arg( kxd2 )
+                                    .arg( D.usesSIMD() );
+                                return false;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+
+// Whisper-style layout: 32 muxers x 8 inputs, 4 XA, 1 XD byte.
+//
+void niDemuxBench( QStringList &sl )
+{
+    const int   nwhole  = 1000,
+                nReps   = 200;
+
+    NIDemuxLayout   L;
+    DmxTestBufs     B;
+    NIDemux         D;
+    KTTimer         T;
+    double          usRef, usPlan[2];
+    bool            simd = false;
+
+    L.kmux = 32;
+    L.kmn1 = 8;
+    L.kxa1 = 4;
+    L.kxd1 = 1;
+
+    B.fill( L, nwhole, 12345 );
+
+    T.start();
+
+    for( int r = 0; r < nReps; ++r ) {
+        niDemuxRef(
+            L, &B.out1[0], B.a1(), B.a2(),
+            B.d1( L ), B.d2( L ), nwhole );
+    }
+
+    usRef = T.usPer( nReps );
+
+    for( int k = 0; k < 2; ++k ) {
+
+        D.init( L, k );
+        simd = simd || D.usesSIMD();
+
+        T.start();
+
+        for( int r = 0; r < nReps; ++r ) {
+            D.apply(
+                &B.out2[0], B.a1(), B.a2(),
+                B.d1( L ), B.d2( L ), nwhole );
+        }
+
+        usPlan[k] = T.usPer( nReps );
+    }
+
+    sl.append(
+        QString("  NI demux ref %1 us, plan %2 us, %3 %4 us"
+                " per %5 timepoints")
+        .arg( usRef, 0, 'f', 1 )
+        .arg( usPlan[0], 0, 'f', 1 )
+        .arg( simd ? "sse2" : "(no simd)" )
+        .arg( usPlan[1], 0, 'f', 1 )
+        .arg( nwhole ) );
+}
+
+
@@ -0,0 +1,108 @@
+#ifndef NIDEMUX_H
+#define NIDEMUX_H
+
+#include "SGLTypes.h"
+
+#include <QStringList>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Channel counts for one NI acquisition: muxing factor and,
+// per device, MN, MA, XA channels and XD bytes.
+//
+struct NIDemuxLayout
+{
+    int kmux,
+        kmn1, kma1, kxa1, kxd1,
+        kmn2, kma2, kxa2, kxd2;
+
+    NIDemuxLayout()
+    :   kmux(1),
+        kmn1(0), kma1(0), kxa1(0), kxd1(0),
+        kmn2(0), kma2(0), kxa2(0), kxd2(0)  {}
+
+    int srcPerWhole1() const    {return kmux*(kmn1+kma1+kxa1);}
+    int srcPerWhole2() const    {return kmux*(kmn2+kma2+kxa2);}
+    int dstPerWhole() const
+        {return kmux*(kmn1+kma1+kmn2+kma2)+kxa1+kxa2+(1+kxd1+kxd2)/2;}
+};
+
+
+// Precomputed demux/merge plan for CniAcqDmx.
+//
+// Raw device buffers hold, per whole timepoint, kmux rows of
+// (mn | ma | xa) from each device, and kmux digital words.
+// Output, per whole timepoint, is:
+// (mn0 | mn1 |...| ma0 | ma1 |...| xa averages | xd packed).
+//
+// init() builds, once per run, a table of row-0 sources for the
+// MN/MA columns (in output order) and XA sums, and masks/word
+// count for the XD bytes. apply() then has no per-sample index
+// arithmetic or layout branches.
+//
+// With simd (x86-64, SSE2), each run of 8 output columns that
+// are adjacent in one device's rows is transposed 8 rows at a
+// time with 8x8 int16 register transposes.
+//
+// Output is identical to niDemuxRef(), the original code.
+//
+class NIDemux
+{
+private:
+    NIDemuxLayout       L;
+    std::vector<int>    col,        // MN/MA row-0 src: (off << 1) | dev
+                        xa,         // XA row-0 src: (off << 1) | dev
+                        blk;        // col indices starting 8-col blocks
+    int                 row[2],     // src per mux row
+                        step[2],    // src per whole
+                        nXD;        // XD output words
+    quint32             msk1,
+                        msk2;
+    int                 sh2;        // bit offset of dev2 XD bytes
+
+public:
+    NIDemux() : nXD(0), msk1(0), msk2(0), sh2(0)
+        {row[0] = row[1] = step[0] = step[1] = 0;}
+
+    void init( const NIDemuxLayout &L, bool simd = true );
+    const NIDemuxLayout &layout() const {return L;}
+    bool usesSIMD() const               {return !blk.empty();}
+
+    void apply(
+        qint16          *dst,
+        const qint16    *sA1,
+        const qint16    *sA2,
+        const quint32   *sD1,
+        const quint32   *sD2,
+        int             nwhole ) const;
+};
+
+/* ---------------------------------------------------------------- */
+/* Functions ------------------------------------------------------ */
+/* ---------------------------------------------------------------- */
+
+// Reference implementation; the original demuxMerge loop.
+void niDemuxRef(
+    const NIDemuxLayout &L,
+    qint16              *dst,
+    const qint16        *sA1,
+    const qint16        *sA2,
+    const quint32       *sD1,
+    const quint32       *sD2,
+    int                 nwhole );
+
+// Compare NIDemux, scalar and SIMD, to niDemuxRef over all
+// kmux/kxd combinations on narrow and wide (8-column block)
+// layouts of synthetic data. Return false and describe first
+// mismatch. Run by the KernelChecks test app.
+bool niDemuxSelfCheck( QString &err );
+
+// Time ref and plan (scalar, SIMD) on a typical muxed layout;
+// append report lines to sl.
+void niDemuxBench( QStringList &sl );
+
+#endif  // NIDEMUX_H
+
+
@@ -3,6 +3,7 @@
 #include "Util.h"
 #include "CniAcqDmx.h"
 #include "CniAcqSim.h"
+#include "CniAcqFile.h"
 
 #include <QThread>
 
@@ -14,6 +15,14 @@
 NIReaderWorker::NIReaderWorker( const DAQ::Params &p, AIQ *niQ )
     :   QObject(0), niQ(niQ)
 {
+    ReplayParams    R;
+    R.loadSettings();
+
+    if( R.isEnabled() ) {
+        niAcq = new CniAcqFile( this, p, R );
+        return;
+    }
+
 #ifdef HAVE_NIDAQmx
     niAcq = new CniAcqDmx( this, p );
 #else
@@ -54,6 +63,7 @@ void NIReaderWorker::stop()
 
 void NIReaderWorker::run()
 {
+    niQ->prefault();
     niAcq->run();
 
     emit finished();
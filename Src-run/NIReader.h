@@ -18,6 +18,7 @@ class NIReaderWorker : public QObject
 
     friend class CniAcqDmx;
     friend class CniAcqSim;
+    friend class CniAcqFile;
 
 private:
     CniAcq  *niAcq;
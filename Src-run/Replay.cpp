@@ -0,0 +1,320 @@
+
+#include "Replay.h"
+#include "Util.h"
+#include "DataFile.h"
+#include "Instr.h"
+
+#include <QBitArray>
+#include <QSettings>
+#include <QThread>
+
+
+#define BLOCKSECS   0.02
+#define AHEADSECS   1.0
+
+
+static QString  sessionBin;     // not persisted
+
+static QMutex           loopMtx;
+static std::vector<int> loopArrived;    // [id] last loop reached
+static int              loopCur = 0,
+                        loopNArrived = 0;
+
+
+/* ---------------------------------------------------------------- */
+/* ReplayParams --------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+void ReplayParams::loadSettings()
+{
+    STDSETTINGS( settings, "replay" );
+    settings.beginGroup( "Replay" );
+
+    binFile = sessionBin;
+    lastBin = settings.value( "lastBinFile", "" ).toString();
+    speed   = qBound( 0.1, settings.value( "speed", 1.0 ).toDouble(), 100.0 );
+    loop    = settings.value( "loop", true ).toBool();
+}
+
+
+void ReplayParams::saveSettings() const
+{
+    STDSETTINGS( settings, "replay" );
+    settings.beginGroup( "Replay" );
+
+    sessionBin = binFile;
+
+    if( !binFile.isEmpty() )
+        settings.setValue( "lastBinFile", binFile );
+
+    settings.remove( "binFile" );
+    settings.setValue( "speed", speed );
+    settings.setValue( "loop", loop );
+}
+
+/* ---------------------------------------------------------------- */
+/* ReplayLoop ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Call at run start, before any stream joins.
+//
+void ReplayLoop::reset()
+{
+    QMutexLocker    ml( &loopMtx );
+
+    loopArrived.clear();
+    loopCur         = 0;
+    loopNArrived    = 0;
+}
+
+
+// Return id for arrive().
+//
+int ReplayLoop::join()
+{
+    QMutexLocker    ml( &loopMtx );
+
+    loopArrived.push_back( -1 );
+    return loopArrived.size() - 1;
+}
+
+
+bool ReplayLoop::arrive( int id, int iLoop )
+{
+    QMutexLocker    ml( &loopMtx );
+
+    if( loopArrived[id] < iLoop ) {
+
+        loopArrived[id] = iLoop;
+
+        if( ++loopNArrived >= int(loopArrived.size()) ) {
+            ++loopCur;
+            loopNArrived = 0;
+        }
+    }
+
+    return loopCur > iLoop;
+}
+
+/* ---------------------------------------------------------------- */
+/* ReplayFeedWorker ----------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+ReplayFeedWorker::ReplayFeedWorker( DataFile *df, double speed )
+    :   QObject(0), df(df), pos(0), gen(0), eof(false),
+        pleaseStop(false)
+{
+    double  srate = df->samplingRateHz();
+
+    blkScans    = qMax( 1, int(BLOCKSECS * srate) );
+    maxBlocks   = qMax( 8, int(speed * AHEADSECS / BLOCKSECS) );
+}
+
+
+ReplayFeedWorker::~ReplayFeedWorker()
+{
+}
+
+
+// At EOF we idle until stopped or rewound, rather than finishing,
+// so the consumer can keep draining queued blocks.
+//
+// pos, eof and gen change only under blkMtx; the file is read
+// outside it, from a snapshot of (pos, gen).
+//
+void ReplayFeedWorker::run()
+{
+    while( !isStopped() ) {
+
+        quint64 P;
+        int     G;
+
+        // -------------
+        // Wait for room
+        // -------------
+
+        blkMtx.lock();
+            while( (eof || (int)blocks.size() >= maxBlocks)
+                    && !isStopped() ) {
+
+                condRoom.wait( &blkMtx, 50 );
+            }
+
+            P = pos;
+            G = gen;
+        blkMtx.unlock();
+
+        if( isStopped() )
+            break;
+
+        // ----------
+        // Read block
+        // ----------
+
+        vec_i16 B;
+        qint64  n = 0;
+
+        if( P < df->scanCount() )
+            n = df->readScans( B, P, blkScans, QBitArray() );
+
+        QMutexLocker    ml( &blkMtx );
+
+        if( G != gen )
+            continue;   // rewound meanwhile
+
+        if( n <= 0 ) {
+            eof = true;
+            continue;
+        }
+
+        pos = P + n;
+        blocks.push_back( vec_i16() );
+        blocks.back().swap( B );
+    }
+
+    emit finished();
+}
+
+/* ---------------------------------------------------------------- */
+/* ReplayFeed ----------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+ReplayFeed::~ReplayFeed()
+{
+    if( thread ) {
+
+        if( thread->isRunning() ) {
+            worker->stop();
+            thread->wait();
+        }
+
+        delete thread;
+    }
+
+    if( df )
+        delete df;
+}
+
+
+// Takes ownership of df, which must be unopened.
+//
+bool ReplayFeed::open(
+    QString         &err,
+    DataFile        *df,
+    const QString   &bin,
+    int             maxAcqChan,
+    double          speed )
+{
+    this->df = df;
+
+    if( !df->openForRead( bin, err ) )
+        return false;
+
+    if( !df->scanCount() ) {
+        err = QString("Replay file '%1' is empty.").arg( bin );
+        return false;
+    }
+
+    ids = df->channelIDs();
+    nC  = df->numChans();
+
+    for( int i = 0; i < nC; ++i ) {
+
+        if( (int)ids[i] >= maxAcqChan ) {
+            err =
+                QString("Replay file '%1' channel %2 not in current"
+                " configuration (%3 channels).")
+                .arg( bin ).arg( ids[i] ).arg( maxAcqChan );
+            return false;
+        }
+    }
+
+    cUnder = Instr::counter( df->fileLblFromObj() + ".replayUnderruns" );
+
+    thread  = new QThread;
+    worker  = new ReplayFeedWorker( df, speed );
+
+    worker->moveToThread( thread );
+
+    Connect( thread, SIGNAL(started()), worker, SLOT(run()) );
+    Connect( worker, SIGNAL(finished()), worker, SLOT(deleteLater()) );
+    Connect( worker, SIGNAL(destroyed()), thread, SLOT(quit()), Qt::DirectConnection );
+
+    thread->start();
+
+    Log() <<
+        QString("Replay %1: %2 s from '%3'.")
+        .arg( df->fileLblFromObj() )
+        .arg( df->fileTimeSecs(), 0, 'f', 1 )
+        .arg( bin );
+
+    return true;
+}
+
+
+double ReplayFeed::srate() const
+{
+    return (df ? df->samplingRateHz() : 0);
+}
+
+
+// Return pointer to current scan, or 0 if none queued.
+//
+const qint16 *ReplayFeed::curScan()
+{
+    if( iCur >= nCur ) {
+
+        QMutexLocker    ml( &worker->blkMtx );
+
+        if( worker->blocks.empty() ) {
+
+            if( !worker->eof && Instr::isEnabled() )
+                cUnder->add();
+
+            return 0;
+        }
+
+        cur.swap( worker->blocks.front() );
+        worker->blocks.pop_front();
+        worker->condRoom.wakeAll();
+
+        iCur = 0;
+        nCur = cur.size() / nC;
+
+        if( !nCur )
+            return 0;
+    }
+
+    return &cur[iCur * nC];
+}
+
+
+bool ReplayFeed::atEOF() const
+{
+    if( iCur < nCur )
+        return false;
+
+    QMutexLocker    ml( &worker->blkMtx );
+
+    return worker->eof && worker->blocks.empty();
+}
+
+
+// Restart from scan zero, at EOF or not. Queued blocks are
+// dropped, and so is any read in flight (new generation).
+//
+void ReplayFeed::rewind()
+{
+    QMutexLocker    ml( &worker->blkMtx );
+
+    ++worker->gen;
+    worker->blocks.clear();
+    worker->pos = 0;
+    worker->eof = false;
+    worker->condRoom.wakeAll();
+
+    iCur = 0;
+    nCur = 0;
+}
+
+
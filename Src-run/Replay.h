@@ -0,0 +1,156 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "SGLTypes.h"
+
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <deque>
+
+class DataFile;
+class InstrCounter;
+
+class QSettings;
+class QThread;
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Replay source selection.
+//
+// When binFile is set, IMReader and NIReader stream the recorded
+// run set containing binFile instead of acquiring from hardware
+// or generating simulated data:
+// - imec probe ip: run_gN_tM.imec{ip}.ap.bin (+ lf.bin if present),
+// - nidq:          run_gN_tM.nidq.bin.
+//
+// speed = 1 replays at the configured sample rate; speed = N
+// enqueues N times faster. Files must have been recorded with
+// the same channel configuration as the current run.
+//
+// binFile lasts only for this session; it is never restored at
+// startup, so a forgotten replay can't masquerade as hardware.
+// Recordings made during replay get replaySource=binFile in
+// their metadata. lastBin only seeds the file dialog.
+//
+struct ReplayParams {
+    QString binFile,    // empty = replay off
+            lastBin;
+    double  speed;
+    bool    loop;
+
+    ReplayParams() : speed(1.0), loop(true) {}
+
+    bool isEnabled() const  {return !binFile.isEmpty();}
+
+    void loadSettings();
+    void saveSettings() const;
+};
+
+
+// All-streams loop decision for a replay run.
+//
+// Feeds never loop on their own. Each replayed stream (imec, nidq)
+// joins once before the run starts. When all of a stream's feeds
+// are at EOF it polls arrive( id, iLoop ); once every joined stream
+// has arrived at loop iLoop, arrive() returns true to each, which
+// then rewinds its feeds and counts ++iLoop. Streams thus restart
+// together and stay aligned across loops.
+//
+class ReplayLoop
+{
+public:
+    static void reset();
+    static int join();
+    static bool arrive( int id, int iLoop );
+};
+
+
+// Prefetching reader for one .bin file.
+//
+// The worker keeps up to about one second of replay time
+// queued in blocks, so file I/O never stalls the consumer.
+//
+// Each read is tagged with the generation current when it began;
+// rewind() bumps the generation, so a read in flight across a
+// rewind is dropped rather than queued.
+//
+class ReplayFeedWorker : public QObject
+{
+    Q_OBJECT
+
+    friend class ReplayFeed;
+
+private:
+    DataFile                *df;
+    std::deque<vec_i16>     blocks;
+    mutable QMutex          blkMtx,
+                            runMtx;
+    QWaitCondition          condRoom;
+    quint64                 pos;
+    int                     blkScans,
+                            maxBlocks,
+                            gen;
+    bool                    eof;
+    volatile bool           pleaseStop;
+
+public:
+    ReplayFeedWorker( DataFile *df, double speed );
+    virtual ~ReplayFeedWorker();
+
+    void stop()
+        {
+            runMtx.lock(); pleaseStop = true; runMtx.unlock();
+            condRoom.wakeAll();
+        }
+    bool isStopped() const  {QMutexLocker ml( &runMtx ); return pleaseStop;}
+
+signals:
+    void finished();
+
+public slots:
+    void run();
+};
+
+
+class ReplayFeed
+{
+private:
+    QThread             *thread;
+    ReplayFeedWorker    *worker;
+    DataFile            *df;
+    InstrCounter        *cUnder;
+    vec_i16             cur;
+    QVector<uint>       ids;
+    int                 nC,
+                        iCur,
+                        nCur;
+
+public:
+    ReplayFeed() : thread(0), worker(0), df(0), nC(0), iCur(0), nCur(0)   {}
+    virtual ~ReplayFeed();
+
+    bool open(
+        QString         &err,
+        DataFile        *df,
+        const QString   &bin,
+        int             maxAcqChan,
+        double          speed );
+
+    double srate() const;
+
+    const qint16 *curScan();
+    void advance()  {++iCur;}
+    void scatter( qint16 *dstScan, const qint16 *src ) const
+        {for( int i = 0; i < nC; ++i ) dstScan[ids[i]] = src[i];}
+
+    bool atEOF() const;
+    void rewind();
+};
+
+#endif  // REPLAY_H
+
+
@@ -5,15 +5,18 @@
 #include "ConfigCtl.h"
 #include "IMReader.h"
 #include "NIReader.h"
+#include "EdgeIndex.h"
 #include "GateTCP.h"
 #include "TrigTCP.h"
 #include "GraphsWindow.h"
 #include "GraphFetcher.h"
 #include "AOCtl.h"
+#include "Replay.h"
 #include "Version.h"
 
 #include <QAction>
 #include <QMessageBox>
+#include <QSettings>
 
 
 
@@ -117,12 +120,20 @@ void Run::GWPair::stopFetching()
 /* ---------------------------------------------------------------- */
 
 Run::Run( MainApp *app )
-    :   QObject(0), app(app), niQ(0),
+    :   QObject(0), app(app), niQ(0), edges(0),
         imReader(0), niReader(0),
-        gate(0), trg(0), running(false)
+        gate(0), trg(0), resT0(0), resCPU0(0),
+        tStopped(0), allocSecsPerByte(0),
+        running(false), headless(false), keepBuffers(false)
 {
 }
 
+
+Run::~Run()
+{
+    qDeleteAll( warmQ );
+}
+
 /* ---------------------------------------------------------------- */
 /* Owned GraphsWindow ops ----------------------------------------- */
 /* ---------------------------------------------------------------- */
@@ -461,6 +472,14 @@ const AIQ* Run::getNiQ() const
 }
 
 
+EdgeIndex* Run::getEdgeIndex() const
+{
+    QMutexLocker    ml( &runMtx );
+
+    return edges;
+}
+
+
 // Get a stream-based time for profiling lag in imec streams.
 // NO MUTEX: Should only be called by imec worker thread.
 //
@@ -515,31 +534,56 @@ bool Run::startRun( QString &errTitle, QString &errMsg )
 
     setPreciseTiming( true );
 
+    resT0   = getTime();
+    resCPU0 = getProcessCPUSecs();
+
+// Warm restart: idle stream buffers are kept for the next run
+// (runwarm.ini, group RunWarm, keepBuffers; default false).
+
+    {
+        STDSETTINGS( settings, "runwarm" );
+        settings.beginGroup( "RunWarm" );
+        keepBuffers = settings.value( "keepBuffers", false ).toBool();
+    }
+
+// Replay is session-only; say so every run
+
+    {
+        ReplayParams    R;
+        R.loadSettings();
+
+        ReplayLoop::reset();
+
+        if( R.isEnabled() ) {
+            Log() <<
+                QString("Replay run: source '%1' at %2x (not hardware).")
+                .arg( R.binFile ).arg( R.speed );
+        }
+    }
+
 // ------
 // Graphs
 // ------
 
-    vGW.push_back( GWPair( p, 0 ) );
+    headless = app->isHeadless();
+
+    if( !headless )
+        vGW.push_back( GWPair( p, 0 ) );
+    else
+        Log() << "Headless run: no graphs windows or fetchers.";
+
+// -------
+// Buffers
+// -------
+
+    aiqAlloc( p, streamSpanMax( p ) );
 
 // -----------
 // IMEC stream
 // -----------
 
-    int streamSecs = streamSpanMax( p );
-
     if( p.im.enabled ) {
 
-        for( int ip = 0, np = p.im.get_nProbes(); ip < np; ++ip ) {
-
-            const CimCfg::AttrEach  &E = p.im.each[ip];
-
-            imQ.push_back(
-                new AIQ(
-                    E.srate,
-                    E.imCumTypCnt[CimCfg::imSumAll],
-                    streamSecs ) );
-        }
-
         imReader = new IMReader( p, imQ );
         ConnectUI( imReader->worker, SIGNAL(daqError(QString)), app, SLOT(runDaqError(QString)) );
         ConnectUI( imReader->worker, SIGNAL(finished()), this, SLOT(workerStopsRun()) );
@@ -551,22 +595,22 @@ bool Run::startRun( QString &errTitle, QString &errMsg )
 
     if( p.ni.enabled ) {
 
-        niQ =
-            new AIQ(
-                p.ni.srate,
-                p.ni.niCumTypCnt[CniCfg::niSumAll],
-                streamSecs );
-
         niReader = new NIReader( p, niQ );
         ConnectUI( niReader->worker, SIGNAL(daqError(QString)), app, SLOT(runDaqError(QString)) );
         ConnectUI( niReader->worker, SIGNAL(finished()), this, SLOT(workerStopsRun()) );
     }
 
+// ----------
+// Edge index
+// ----------
+
+    edges = new EdgeIndex;
+
 // -------
 // Trigger
 // -------
 
-    trg = new Trigger( p, vGW[0].gw, imQ, niQ );
+    trg = new Trigger( p, (headless ? 0 : vGW[0].gw), imQ, niQ, edges );
     ConnectUI( trg->worker, SIGNAL(daqError(QString)), app, SLOT(runDaqError(QString)) );
     ConnectUI( trg->worker, SIGNAL(finished()), this, SLOT(workerStopsRun()) );
 
@@ -633,13 +677,15 @@ void Run::stopRun()
         imReader = 0;
     }
 
-    if( niQ ) {
-        delete niQ;
-        niQ = 0;
+    if( edges ) {
+        delete edges;
+        edges = 0;
     }
 
+    aiqRelease( niQ );
+
     for( int ip = 0, np = imQ.size(); ip < np; ++ip )
-        delete imQ[ip];
+        aiqRelease( imQ[ip] );
 
     imQ.clear();
 
@@ -656,6 +702,10 @@ void Run::stopRun()
 
     setPreciseTiming( false );
 
+    logResourceUse();
+
+    tStopped = getTime();
+
     QString s = "Acquisition stopped.";
 
     Systray() << s;
@@ -783,7 +833,10 @@ void Run::dfSetRecordingEnabled( bool enabled, bool remote )
 {
     QMutexLocker    ml( &runMtx );
 
-    if( remote ) {
+    // Graphs window owns the run-name/recording UI state;
+    // headless runs set the gate directly.
+
+    if( remote && !vGW.empty() ) {
 
         for( int igw = 0, ngw = vGW.size(); igw < ngw; ++igw ) {
 
@@ -922,11 +975,19 @@ void Run::gettingSamples()
     if( !running )
         return;
 
-    vGW[0].startFetching( runMtx );
+    if( !headless )
+        vGW[0].startFetching( runMtx );
 
     if( app->getAOCtl()->doAutoStart() )
         QMetaObject::invokeMethod( this, "aoStart", Qt::QueuedConnection );
 
+    if( tStopped > 0 ) {
+        Log() <<
+            QString("Run startup %1 s; dead time since last run %2 s.")
+            .arg( getTime() - resT0, 0, 'f', 3 )
+            .arg( getTime() - tStopped, 0, 'f', 3 );
+    }
+
     app->runStarted();
 }
 
@@ -951,6 +1012,207 @@ void Run::aoStartDev()
 }
 
 
+// Fill imQ and niQ, reusing idle buffers of identical shape.
+// Unmatched idle buffers are freed before any new allocation.
+//
+void Run::aiqAlloc( const DAQ::Params &p, int streamSecs )
+{
+    double  t0      = getTime();
+    qint64  bReuse  = 0,
+            bNew    = 0,
+            bHuge   = 0,
+            bLate   = 0;
+    int     np      = (p.im.enabled ? p.im.get_nProbes() : 0),
+            hugePages;
+
+// Huge pages (aiqalloc.ini, group AIQAlloc, hugePages):
+// {0=off, 1=transparent (default), 2=explicit}. Windows: 1 or 2
+// asks for large pages, taken later on each filling thread.
+
+    {
+        STDSETTINGS( settings, "aiqalloc" );
+        settings.beginGroup( "AIQAlloc" );
+        hugePages = qBound( 0, settings.value( "hugePages", 1 ).toInt(), 2 );
+    }
+
+// -----
+// Reuse
+// -----
+
+    imQ.fill( 0, np );
+
+    for( int ip = 0; ip < np; ++ip ) {
+
+        const CimCfg::AttrEach  &E = p.im.each[ip];
+
+        imQ[ip] = aiqTakeWarm(
+                    E.srate, E.imCumTypCnt[CimCfg::imSumAll], streamSecs );
+    }
+
+    if( p.ni.enabled ) {
+        niQ = aiqTakeWarm(
+                p.ni.srate, p.ni.niCumTypCnt[CniCfg::niSumAll], streamSecs );
+    }
+
+    qDeleteAll( warmQ );
+    warmQ.clear();
+
+// --------
+// Allocate
+// --------
+
+    for( int ip = 0; ip < np; ++ip ) {
+
+        if( imQ[ip] ) {
+            bReuse += imQ[ip]->bufBytes();
+            continue;
+        }
+
+        const CimCfg::AttrEach  &E = p.im.each[ip];
+
+        imQ[ip] =
+            new AIQ(
+                E.srate,
+                E.imCumTypCnt[CimCfg::imSumAll],
+                streamSecs,
+                hugePages );
+
+        bNew += imQ[ip]->bufBytes();
+
+        if( imQ[ip]->hugePages() )
+            bHuge += imQ[ip]->bufBytes();
+        else if( imQ[ip]->hugePending() )
+            bLate += imQ[ip]->bufBytes();
+    }
+
+    if( p.ni.enabled ) {
+
+        if( niQ )
+            bReuse += niQ->bufBytes();
+        else {
+            niQ =
+                new AIQ(
+                    p.ni.srate,
+                    p.ni.niCumTypCnt[CniCfg::niSumAll],
+                    streamSecs,
+                    hugePages );
+
+            bNew += niQ->bufBytes();
+
+            if( niQ->hugePages() )
+                bHuge += niQ->bufBytes();
+            else if( niQ->hugePending() )
+                bLate += niQ->bufBytes();
+        }
+    }
+
+// ------
+// Report
+// ------
+
+    if( bNew ) {
+
+        QString late;
+
+        if( bLate ) {
+            late = QString(", %1 MB requested at prefault")
+                    .arg( bLate / (1024*1024) );
+        }
+
+        Log() <<
+            QString("Stream buffers: %1 MB new (%2 MB huge pages%3), %4 s.")
+            .arg( bNew / (1024*1024) )
+            .arg( bHuge / (1024*1024) )
+            .arg( late )
+            .arg( getTime() - t0, 0, 'f', 3 );
+    }
+
+    if( bReuse ) {
+
+        QString saved;
+
+        if( allocSecsPerByte > 0 ) {
+            saved = QString(", ~%1 s allocation saved")
+                    .arg( bReuse * allocSecsPerByte, 0, 'f', 3 );
+        }
+
+        Log() <<
+            QString("Warm restart: reused %1 MB of stream buffers%2.")
+            .arg( bReuse / (1024*1024) )
+            .arg( saved );
+    }
+}
+
+
+// Remove and reset an idle buffer matching shape; else return 0.
+//
+AIQ* Run::aiqTakeWarm( double srate, int nchans, int streamSecs )
+{
+    for( int i = 0, n = warmQ.size(); i < n; ++i ) {
+
+        AIQ *Q = warmQ[i];
+
+        if( Q->sameShape( srate, nchans, streamSecs ) ) {
+            warmQ.remove( i );
+            Q->reset();
+            return Q;
+        }
+    }
+
+    return 0;
+}
+
+
+// Keep Q for the next run, or free it.
+//
+void Run::aiqRelease( AIQ* &Q )
+{
+    if( !Q )
+        return;
+
+    if( keepBuffers ) {
+
+        // Learn cold setup cost (page faulting) from big ones only
+
+        if( Q->prefaultSecs() > 0 && Q->bufBytes() >= 64*1024*1024 )
+            allocSecsPerByte = Q->prefaultSecs() / Q->bufBytes();
+
+        // Park empty; dropping any shm mirror now tells its
+        // clients (live=0) that the stream has ended.
+
+        Q->reset();
+        warmQ.push_back( Q );
+    }
+    else
+        delete Q;
+
+    Q = 0;
+}
+
+
+// Report process CPU and memory over the run, so graphs and
+// headless runs can be compared on the same rig.
+//
+void Run::logResourceUse()
+{
+    double  wall = getTime() - resT0,
+            cpu  = getProcessCPUSecs() - resCPU0;
+
+    if( wall <= 0 )
+        return;
+
+    Log() <<
+        QString("Run resources (%1): CPU %2 s = %3% of one core"
+        " over %4 s; memory %5 MB now, %6 MB peak.")
+        .arg( headless ? "headless" : "graphs" )
+        .arg( cpu, 0, 'f', 1 )
+        .arg( 100 * cpu / wall, 0, 'f', 0 )
+        .arg( wall, 0, 'f', 1 )
+        .arg( getProcessMemBytes() / (1024*1024), 0, 'f', 0 )
+        .arg( getProcessMemBytes( true ) / (1024*1024), 0, 'f', 0 );
+}
+
+
 // Return true if was running.
 //
 bool Run::aoStopDev()
@@ -21,6 +21,7 @@ class IMReader;
 class NIReader;
 class Gate;
 class Trigger;
+class EdgeIndex;
 class AIQ;
 
 class QFileInfo;
@@ -52,17 +53,25 @@ private:
     MainApp             *app;
     QVector<AIQ*>       imQ;            // guarded by runMtx
     AIQ*                niQ;            // guarded by runMtx
+    QVector<AIQ*>       warmQ;          // idle, guarded by runMtx
+    EdgeIndex           *edges;         // guarded by runMtx
     std::vector<GWPair> vGW;            // guarded by runMtx
     IMReader            *imReader;      // guarded by runMtx
     NIReader            *niReader;      // guarded by runMtx
     Gate                *gate;          // guarded by runMtx
     Trigger             *trg;           // guarded by runMtx
     mutable QMutex      runMtx;
+    double              resT0,          // resource use at start
+                        resCPU0,
+                        tStopped,       // end of previous run
+                        allocSecsPerByte;
     bool                running,        // guarded by runMtx
-                        dumx[3];
+                        headless,       // guarded by runMtx
+                        keepBuffers;    // guarded by runMtx
 
 public:
     Run( MainApp *app );
+    virtual ~Run();
 
 // Owned GraphsWindow ops
     bool grfIsUsrOrder( int ip );
@@ -83,6 +92,7 @@ public:
     quint64 getScanCount( int ip ) const;
     const AIQ* getImQ( uint ip ) const;
     const AIQ* getNiQ() const;
+    EdgeIndex* getEdgeIndex() const;
     double getStreamTime() const;
 
 // Run control
@@ -124,7 +134,11 @@ private slots:
 private:
     void aoStartDev();
     bool aoStopDev();
+    void aiqAlloc( const DAQ::Params &p, int streamSecs );
+    AIQ* aiqTakeWarm( double srate, int nchans, int streamSecs );
+    void aiqRelease( AIQ* &Q );
     void createGraphsWindow( const DAQ::Params &p );
+    void logResourceUse();
 };
 
 #endif  // RUN_H
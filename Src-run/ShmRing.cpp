@@ -0,0 +1,144 @@
+
+#include "ShmRing.h"
+#include "Util.h"
+
+#include <QCoreApplication>
+#include <QDir>
+
+#include <new>
+#include <string.h>
+
+
+/* ---------------------------------------------------------------- */
+/* ShmRing -------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+ShmRing::~ShmRing()
+{
+    if( H )
+        H->live.storeRelease( 0 );
+}
+
+
+// Native key, unique per process/stream/segment:
+// - Windows: file-mapping name "SpikeGLX_<pid>_<stream>_<gen>".
+// - Unix: same name as a file in the temp dir (SysV ftok key).
+//
+bool ShmRing::create(
+    QString         &err,
+    const QString   &stream,
+    double          srate,
+    double          tZero,
+    int             nchans,
+    int             capScans,
+    quint64         endCt )
+{
+    static QAtomicInt   genCtr;
+
+    quint32 gen = genCtr.fetchAndAddRelaxed( 1 ) + 1;
+    QString name =
+        QString("SpikeGLX_%1_%2_%3")
+        .arg( QCoreApplication::applicationPid() )
+        .arg( stream )
+        .arg( gen );
+
+#ifdef Q_OS_WIN
+    shm.setNativeKey( name );
+#else
+    shm.setNativeKey( QDir::tempPath() + "/" + name );
+#endif
+
+    qint64  bytes = sizeof(Hdr) + qint64(capScans) * nchans * sizeof(qint16);
+
+    if( !shm.create( bytes ) ) {
+        err = QString("SHM: Can't create %1 MB segment for %2 [%3].")
+                .arg( bytes / (1024*1024) )
+                .arg( stream )
+                .arg( shm.errorString() );
+        return false;
+    }
+
+    this->nchans    = nchans;
+    this->cap       = capScans;
+
+    H       = new (shm.data()) Hdr;
+    ring    = (qint16*)((char*)shm.data() + sizeof(Hdr));
+
+    memset( H->magic, 0, sizeof(H->magic) );
+    memcpy( H->magic, "SGLSHM1", 7 );
+    memset( H->rsv, 0, sizeof(H->rsv) );
+
+    H->hdrBytes     = sizeof(Hdr);
+    H->nChans       = nchans;
+    H->capScans     = capScans;
+    H->sRate        = srate;
+    H->tZero        = tZero;
+    H->firstCt      = endCt;
+    H->generation   = gen;
+    H->rsv0         = 0;
+    H->wrCt.store( endCt );
+    H->endCt.store( endCt );
+    H->live.storeRelease( 1 );
+
+    Log() << QString("SHM: %1 mirror %2 (%3 scans).")
+                .arg( stream ).arg( name ).arg( capScans );
+
+    return true;
+}
+
+
+// Full barrier after wrCt so readers never see
+// new data without the overwrite warning.
+//
+void ShmRing::write( const qint16 *src, int nCts )
+{
+    quint64 e   = H->endCt.load(),
+            end = e + nCts;
+
+    if( nCts > cap ) {
+        src += qint64(nCts - cap) * nchans;
+        e   += nCts - cap;
+        nCts = cap;
+    }
+
+    H->wrCt.fetchAndStoreOrdered( end );
+
+    int pos = e % cap,
+        n1  = qMin( nCts, cap - pos );
+
+    memcpy( ring + qint64(pos) * nchans, src, n1 * nchans * sizeof(qint16) );
+
+    if( nCts -= n1 ) {
+        memcpy(
+            ring, src + qint64(n1) * nchans,
+            nCts * nchans * sizeof(qint16) );
+    }
+
+    H->endCt.storeRelease( end );
+}
+
+
+void ShmRing::writeZero( int nCts )
+{
+    quint64 e   = H->endCt.load(),
+            end = e + nCts;
+
+    if( nCts > cap ) {
+        e   += nCts - cap;
+        nCts = cap;
+    }
+
+    H->wrCt.fetchAndStoreOrdered( end );
+
+    int pos = e % cap,
+        n1  = qMin( nCts, cap - pos );
+
+    memset( ring + qint64(pos) * nchans, 0, n1 * nchans * sizeof(qint16) );
+
+    if( nCts -= n1 )
+        memset( ring, 0, nCts * nchans * sizeof(qint16) );
+
+    H->endCt.storeRelease( end );
+}
+
+
@@ -0,0 +1,85 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <QAtomicInteger>
+#include <QSharedMemory>
+
+/* ---------------------------------------------------------------- */
+/* Types ---------------------------------------------------------- */
+/* ---------------------------------------------------------------- */
+
+// Shared-memory mirror of one AIQ stream, for local clients that
+// read data in place instead of via FETCH over TCP.
+//
+// The segment is a fixed header (hdrBytes) followed by a ring of
+// capScans scans of nChans int16. Scan ct lives at ring index
+// (ct % capScans). Only scans enqueued after creation are mirrored;
+// firstCt is the earliest ever written.
+//
+// Writer (acquisition thread, under AIQ lock):
+//  1) wrCt  = end after this write
+//  2) copy data
+//  3) endCt = wrCt
+//
+// Reader, lock-free:
+//  1) e = endCt; pick [from, to) with to <= e
+//  2) copy/consume ring scans
+//  3) valid if wrCt - capScans <= from; else overwritten, retry
+//
+// live goes to 0 when the run ends; the next run creates a new
+// segment with a new key (from CmdServer GETSHMINFO). generation
+// is that segment's sequence number in this process (from 1, also
+// the key's suffix), so a client can tell segments apart.
+//
+// Reference readers: Python-SDK/sglx_shm.py; MATLAB GetShmInfo.
+//
+class ShmRing
+{
+public:
+    struct Hdr {                            // offset
+        char                    magic[8];   // 0  "SGLSHM1"
+        quint32                 hdrBytes,   // 8
+                                nChans,     // 12
+                                capScans;   // 16
+        QAtomicInt              live;       // 20
+        double                  sRate,      // 24
+                                tZero;      // 32
+        quint64                 firstCt;    // 40
+        QAtomicInteger<quint64> wrCt,       // 48
+                                endCt;      // 56
+        quint32                 generation, // 64
+                                rsv0;       // 68
+        char                    rsv[56];    // 72
+    };
+
+private:
+    QSharedMemory   shm;
+    Hdr             *H;
+    qint16          *ring;
+    int             nchans,
+                    cap;
+
+public:
+    ShmRing() : H(0), ring(0), nchans(0), cap(0)    {}
+    virtual ~ShmRing();
+
+    bool create(
+        QString         &err,
+        const QString   &stream,
+        double          srate,
+        double          tZero,
+        int             nchans,
+        int             capScans,
+        quint64         endCt );
+
+    QString key() const     {return shm.nativeKey();}
+    int hdrBytes() const    {return sizeof(Hdr);}
+    int capScans() const    {return cap;}
+
+    void write( const qint16 *src, int nCts );
+    void writeZero( int nCts );
+};
+
+#endif  // SHMRING_H
+
+
@@ -1,34 +1,54 @@
 
 HEADERS += \
     $$PWD/AIQ.h \
+    $$PWD/BenchRun.h \
     $$PWD/CalSRate.h \
     $$PWD/CalSRateCtl.h \
     $$PWD/CimAcq.h \
+    $$PWD/CimAcqFile.h \
     $$PWD/CimAcqImec.h \
     $$PWD/CimAcqSim.h \
     $$PWD/CniAcq.h \
     $$PWD/CniAcqDmx.h \
+    $$PWD/CniAcqFile.h \
     $$PWD/CniAcqSim.h \
+    $$PWD/EdgeIndex.h \
+    $$PWD/ImAPI.h \
     $$PWD/IMBISTCtl.h \
     $$PWD/IMFirmCtl.h \
+    $$PWD/ImProbeCfg.h \
+    $$PWD/ImUnpack.h \
     $$PWD/IMReader.h \
+    $$PWD/NIDemux.h \
     $$PWD/NIReader.h \
+    $$PWD/Replay.h \
     $$PWD/Run.h \
+    $$PWD/ShmRing.h \
     $$PWD/Sync.h
 
 SOURCES += \
     $$PWD/AIQ.cpp \
+    $$PWD/BenchRun.cpp \
     $$PWD/CalSRate.cpp \
     $$PWD/CalSRateCtl.cpp \
+    $$PWD/CimAcqFile.cpp \
     $$PWD/CimAcqImec.cpp \
     $$PWD/CimAcqSim.cpp \
     $$PWD/CniAcqDmx.cpp \
+    $$PWD/CniAcqFile.cpp \
     $$PWD/CniAcqSim.cpp \
+    $$PWD/EdgeIndex.cpp \
+    $$PWD/ImAPI.cpp \
     $$PWD/IMBISTCtl.cpp \
     $$PWD/IMFirmCtl.cpp \
+    $$PWD/ImProbeCfg.cpp \
+    $$PWD/ImUnpack.cpp \
     $$PWD/IMReader.cpp \
+    $$PWD/NIDemux.cpp \
     $$PWD/NIReader.cpp \
+    $$PWD/Replay.cpp \
     $$PWD/Run.cpp \
+    $$PWD/ShmRing.cpp \
     $$PWD/Sync.cpp
 
 
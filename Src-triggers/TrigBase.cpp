@@ -31,6 +31,7 @@ TrigBase::TrigBase(
     const AIQ           *niQ )
     :   QObject(0), dfNi(0),
         ovr(p), startT(-1), gateHiT(-1), gateLoT(-1), trigHiT(-1),
+        cpu("trig"),
         firstCtNi(0), offHertz(0), offmsec(0), onHertz(0), onmsec(0),
         iGate(-1), iTrig(-1), gateHi(false), pleaseStop(false),
         p(p), gw(gw), imQ(imQ), niQ(niQ), statusT(-1), nImQ(imQ.size())
@@ -48,6 +49,13 @@ TrigBase::TrigBase(
 
     tLastReport = getTime();
     tLastProf.assign( nImQ + 1, 0 );
+
+    gLag.push_back( Instr::gauge( "nidq.trigLagPct" ) );
+
+    for( int ip = 0; ip < nImQ; ++ip ) {
+        gLag.push_back(
+            Instr::gauge( QString("imec%1.trigLagPct").arg( ip ) ) );
+    }
 }
 
 
@@ -176,10 +184,12 @@ void TrigBase::setGate( bool hi )
 
     gateHi = hi;
 
-    QMetaObject::invokeMethod(
-        gw, "setGateLED",
-        Qt::QueuedConnection,
-        Q_ARG(bool, hi) );
+    if( gw ) {
+        QMetaObject::invokeMethod(
+            gw, "setGateLED",
+            Qt::QueuedConnection,
+            Q_ARG(bool, hi) );
+    }
 }
 
 
@@ -230,10 +240,12 @@ void TrigBase::endTrig()
 
         trigHiT = -1;
 
-        QMetaObject::invokeMethod(
-            gw, "setTriggerLED",
-            Qt::QueuedConnection,
-            Q_ARG(bool, false) );
+        if( gw ) {
+            QMetaObject::invokeMethod(
+                gw, "setTriggerLED",
+                Qt::QueuedConnection,
+                Q_ARG(bool, false) );
+        }
 
         if( freq > 0 )
             Beep( freq, msec );
@@ -320,7 +332,7 @@ bool TrigBase::newTrig( int &ig, int &it, bool trigLED )
 
     trigHiT = nowCalibrated();
 
-    if( trigLED ) {
+    if( trigLED && gw ) {
         QMetaObject::invokeMethod(
             gw, "setTriggerLED",
             Qt::QueuedConnection,
@@ -329,10 +341,12 @@ bool TrigBase::newTrig( int &ig, int &it, bool trigLED )
 
     QString sGT = QString("<G%1 T%2>").arg( ig ).arg( it );
 
-    QMetaObject::invokeMethod(
-        gw, "updateGT",
-        Qt::QueuedConnection,
-        Q_ARG(QString, sGT) );
+    if( gw ) {
+        QMetaObject::invokeMethod(
+            gw, "updateGT",
+            Qt::QueuedConnection,
+            Q_ARG(QString, sGT) );
+    }
 
     QMetaObject::invokeMethod(
         mainApp()->metrics(),
@@ -395,6 +409,9 @@ bool TrigBase::nScansFromCt(
 
     ret = Q->getNScansFromCtProfile( pct, data, fromCt, nMax );
 
+    if( Instr::isEnabled() && ret > 0 )
+        gLag[ip+1]->set( qMax( 0, int(100.0 - pct) ) );
+
     if( tProf - tLastProf[ip+1] >= 2.0 ) {
 
         QMetaObject::invokeMethod(
@@ -469,10 +486,12 @@ void TrigBase::endRun( const QString &err )
 {
     quint32 freq, msec;
 
-    QMetaObject::invokeMethod(
-        gw, "setTriggerLED",
-        Qt::QueuedConnection,
-        Q_ARG(bool, false) );
+    if( gw ) {
+        QMetaObject::invokeMethod(
+            gw, "setTriggerLED",
+            Qt::QueuedConnection,
+            Q_ARG(bool, false) );
+    }
 
     dfMtx.lock();
         freq = offHertz;
@@ -678,10 +697,12 @@ void TrigBase::statusOnSince( QString &s )
     else
         sGW = "--:--:--";
 
-    QMetaObject::invokeMethod(
-        gw, "updateOnTime",
-        Qt::QueuedConnection,
-        Q_ARG(QString, sGW) );
+    if( gw ) {
+        QMetaObject::invokeMethod(
+            gw, "updateOnTime",
+            Qt::QueuedConnection,
+            Q_ARG(QString, sGW) );
+    }
 
 // RunToolbar::Rec-time
 
@@ -701,10 +722,12 @@ void TrigBase::statusOnSince( QString &s )
     else
         sGW = "--:--:--";
 
-    QMetaObject::invokeMethod(
-        gw, "updateRecTime",
-        Qt::QueuedConnection,
-        Q_ARG(QString, sGW) );
+    if( gw ) {
+        QMetaObject::invokeMethod(
+            gw, "updateRecTime",
+            Qt::QueuedConnection,
+            Q_ARG(QString, sGW) );
+    }
 }
 
 
@@ -714,9 +737,13 @@ void TrigBase::statusWrPerf( QString &s )
             imFull  = 0.0,
             niFull  = 0.0,
             wbps    = 0.0,
-            rbps    = 0.0;
+            rbps    = 0.0,
+            lat     = 0.0;
+    quint64 drop    = 0;
     int     np      = firstCtIm.size();
 
+    cpu.sample();
+
     if( dfNi || np ) {
 
         tReport = getTime();
@@ -729,12 +756,16 @@ void TrigBase::statusWrPerf( QString &s )
                 imFull   = qMax( imFull, dfImAp[ip]->percentFull() );
                 wbps    += dfImAp[ip]->writtenBytes();
                 rbps    += dfImAp[ip]->requiredBps();
+                lat      = qMax( lat, dfImAp[ip]->wrQueuePeakLatency() );
+                drop    += dfImAp[ip]->droppedScans();
             }
 
             if( dfImLf[ip] ) {
                 imFull  = qMax( imFull, dfImLf[ip]->percentFull() );
                 wbps   += dfImLf[ip]->writtenBytes();
                 rbps   += dfImLf[ip]->requiredBps();
+                lat     = qMax( lat, dfImLf[ip]->wrQueuePeakLatency() );
+                drop   += dfImLf[ip]->droppedScans();
             }
         }
 
@@ -742,6 +773,8 @@ void TrigBase::statusWrPerf( QString &s )
             niFull  = dfNi->percentFull();
             wbps   += dfNi->writtenBytes();
             rbps   += dfNi->requiredBps();
+            lat     = qMax( lat, dfNi->wrQueuePeakLatency() );
+            drop   += dfNi->droppedScans();
         }
 
         wbps /= (tReport - tLastReport);
@@ -749,11 +782,15 @@ void TrigBase::statusWrPerf( QString &s )
         rbps /= 1024*1024;
         tLastReport = tReport;
 
-        s = QString(" FileQFill%=(%1,%2) MB/s=%3 (%4 req)")
+        s = QString(" FileQFill%=(%1,%2) MB/s=%3 (%4 req) QLat=%5ms")
             .arg( imFull, 0, 'f', 1 )
             .arg( niFull, 0, 'f', 1 )
             .arg( wbps, 0, 'f', 1 )
-            .arg( rbps, 0, 'f', 1 );
+            .arg( rbps, 0, 'f', 1 )
+            .arg( 1000 * lat, 0, 'f', 0 );
+
+        if( drop )
+            s += QString(" Dropped=%1").arg( drop );
     }
     else
         s = QString::null;
@@ -979,7 +1016,8 @@ Trigger::Trigger(
     const DAQ::Params   &p,
     GraphsWindow        *gw,
     const QVector<AIQ*> &imQ,
-    const AIQ           *niQ )
+    const AIQ           *niQ,
+    EdgeIndex           *edges )
 {
     thread = new QThread;
 
@@ -988,7 +1026,7 @@ Trigger::Trigger(
     else if( p.mode.mTrig == DAQ::eTrigTimed )
         worker = new TrigTimed( p, gw, imQ, niQ );
     else if( p.mode.mTrig == DAQ::eTrigTTL )
-        worker = new TrigTTL( p, gw, imQ, niQ );
+        worker = new TrigTTL( p, gw, imQ, niQ, edges );
     else if( p.mode.mTrig == DAQ::eTrigSpike )
         worker = new TrigSpike( p, gw, imQ, niQ );
     else
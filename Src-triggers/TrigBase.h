@@ -5,8 +5,10 @@
 #include "DataFileIMLF.h"
 #include "DataFileNI.h"
 #include "Sync.h"
+#include "Instr.h"
 
 class GraphsWindow;
+class EdgeIndex;
 
 class QFileInfo;
 
@@ -50,6 +52,8 @@ private:
                                 trigHiT,    // stream time
                                 tLastReport;
     std::vector<double>         tLastProf;
+    std::vector<InstrGauge*>    gLag;       // AIQ fill behind reader
+    InstrThreadCPU              cpu;
     std::vector<quint64>        firstCtIm;
     quint64                     firstCtNi;
     quint32                     offHertz,
@@ -70,7 +74,7 @@ protected:
 
 protected:
     const DAQ::Params       &p;
-    GraphsWindow            *gw;
+    GraphsWindow            *gw;        // null if headless
     const QVector<AIQ*>     &imQ;
     const AIQ               *niQ;
     std::vector<SyncStream> vS;
@@ -181,7 +185,8 @@ public:
         const DAQ::Params   &p,
         GraphsWindow        *gw,
         const QVector<AIQ*> &imQ,
-        const AIQ           *niQ );
+        const AIQ           *niQ,
+        EdgeIndex           *edges );
     virtual ~Trigger();
 };
 
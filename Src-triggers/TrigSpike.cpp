@@ -382,9 +382,11 @@ void TrigSpike::run()
                     goto next_loop;
             }
 
-            QMetaObject::invokeMethod(
-                gw, "blinkTrigger",
-                Qt::QueuedConnection );
+            if( gw ) {
+                QMetaObject::invokeMethod(
+                    gw, "blinkTrigger",
+                    Qt::QueuedConnection );
+            }
 
             // ---------------
             // Start new files
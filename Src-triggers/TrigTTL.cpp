@@ -3,6 +3,7 @@
 #include "Util.h"
 #include "MainApp.h"
 #include "Run.h"
+#include "EdgeIndex.h"
 
 #include <QThread>
 
@@ -449,14 +450,17 @@ TrigTTL::TrigTTL(
     const DAQ::Params   &p,
     GraphsWindow        *gw,
     const QVector<AIQ*> &imQ,
-    const AIQ           *niQ )
+    const AIQ           *niQ,
+    EdgeIndex           *edges )
     :   TrigBase( p, gw, imQ, niQ ),
+        edges(edges),
         imCnt( p ),
         niCnt( p ),
         highsMax(p.trgTTL.isNInf ? UNSET64 : p.trgTTL.nH),
         aEdgeCtNext(0),
         thresh(p.trigThreshAsInt()),
-        digChan(p.trgTTL.isAnalog ? -1 : p.trigChan())
+        digChan(p.trgTTL.isAnalog ? -1 : p.trigChan()),
+        iWatch(-1)
 {
     vEdge.resize( vS.size() );
 }
@@ -492,6 +496,8 @@ void TrigTTL::run()
 
     ME = this;
 
+    watchSrcEdges();
+
 // Create worker threads
 
     const int                   nPrbPerThd = 2;
@@ -729,6 +735,8 @@ next_loop:
         delete trT[iThd];
     }
 
+    edges->unwatch( iWatch );
+
 // Done
 
     endRun( err );
@@ -797,6 +805,29 @@ void TrigTTL::initState()
 }
 
 
+// Source channel edges are detected by the shared EdgeIndex,
+// which also serves ColorTTL event marking in the graphs.
+//
+void TrigTTL::watchSrcEdges()
+{
+    const AIQ   *Q;
+
+    if( p.trgTTL.stream == "nidq" )
+        Q = niQ;
+    else
+        Q = imQ[imCnt.iTrk];
+
+    if( digChan < 0 ) {
+        iWatch = edges->watch(
+                    Q, p.trgTTL.chan, -1, thresh, p.trgTTL.inarow );
+    }
+    else {
+        iWatch = edges->watch(
+                    Q, digChan, p.trgTTL.bit % 16, 0, p.trgTTL.inarow );
+    }
+}
+
+
 // Find rising edge in source stream;
 // translate to all streams 'vEdge'.
 //
@@ -821,23 +852,7 @@ bool TrigTTL::_getRiseEdge( quint64 &srcNextCt, int iSrc )
         found = true;
     else {
 
-        if( digChan < 0 ) {
-
-            found = vS[iSrc].Q->findRisingEdge(
-                        aEdgeCtNext,
-                        srcNextCt,
-                        p.trgTTL.chan,
-                        thresh,
-                        p.trgTTL.inarow );
-        }
-        else {
-            found = vS[iSrc].Q->findBitRisingEdge(
-                        aEdgeCtNext,
-                        srcNextCt,
-                        digChan,
-                        p.trgTTL.bit % 16,
-                        p.trgTTL.inarow );
-        }
+        found = edges->nextRise( aEdgeCtNext, iWatch, srcNextCt );
 
         if( !found ) {
             srcNextCt   = aEdgeCtNext;  // pick up search here
@@ -887,23 +902,7 @@ bool TrigTTL::_getFallEdge( quint64 srcEdgeCt, int iSrc )
     if( !aFallCtNext )
         aFallCtNext = srcEdgeCt;
 
-    if( digChan < 0 ) {
-
-        found = vS[iSrc].Q->findFallingEdge(
-                    aFallCtNext,
-                    aFallCtNext,
-                    p.trgTTL.chan,
-                    thresh,
-                    p.trgTTL.inarow );
-    }
-    else {
-        found = vS[iSrc].Q->findBitFallingEdge(
-                    aFallCtNext,
-                    aFallCtNext,
-                    digChan,
-                    p.trgTTL.bit % 16,
-                    p.trgTTL.inarow );
-    }
+    found = edges->nextFall( aFallCtNext, iWatch, aFallCtNext );
 
     vEdge[iSrc] = aFallCtNext;
 
@@ -152,6 +152,7 @@ private:
     };
 
 private:
+    EdgeIndex               *edges;
     CountsIm                imCnt;
     CountsNi                niCnt;
     std::vector<quint64>    vEdge;
@@ -160,7 +161,8 @@ private:
                             aFallCtNext;
     const int               thresh,
                             digChan;
-    int                     nThd,
+    int                     iWatch,
+                            nThd,
                             nHighs,
                             state;
 
@@ -169,7 +171,8 @@ public:
         const DAQ::Params   &p,
         GraphsWindow        *gw,
         const QVector<AIQ*> &imQ,
-        const AIQ           *niQ );
+        const AIQ           *niQ,
+        EdgeIndex           *edges );
 
 public slots:
     virtual void run();
@@ -181,6 +184,7 @@ private:
     void SETSTATE_PostMarg();
     void SETSTATE_Done();
     void initState();
+    void watchSrcEdges();
 
     bool _getRiseEdge( quint64 &srcNextCt, int iSrc );
     bool _getFallEdge( quint64 srcEdgeCt, int iSrc );